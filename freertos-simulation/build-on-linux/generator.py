@@ -12,6 +12,7 @@ import yaml
 import os
 from pathlib import Path, PurePosixPath, WindowsPath
 import sys
+import layout_planner
 
 
 CC = '-gcc'
@@ -105,3 +106,6 @@ def gen_aux_config_files():
 
 if __name__ == '__main__':
     gen_aux_config_files()
+    # the layout goes into the build directory, so that configuring a build does not modify the sources
+    build_directory = sys.argv[1] if len(sys.argv) > 1 else 'generated'
+    layout_planner.generate(destination=os.path.join(build_directory, 'configurations', 'MemoryLayoutConfig.h'))
@@ -0,0 +1,154 @@
+import os
+import sys
+import yaml
+
+# Plans the user data sector sizes of the flash memory from the logging rates in memory-layout.yaml and writes them
+# into configurations/MemoryLayoutConfig.h of the build directory. It is the compile time twin of memory_manager_plan_layout ( ) in
+# memory_manager.c: both have to produce the same layout, so keep the two in sync.
+
+# flash.h: FLASH_SIZE_BYTES, FLASH_64KB_SECTOR_SIZE
+FLASH_SIZE_BYTES = 0x800000
+BLOCK_SIZE = 0x10000
+
+# memory_manager.c: DATA_SECTORS_BASE, where the user data sectors start
+DATA_SECTORS_BASE = 0x20F000
+
+# memory_manager.h: the record size of every sector of MEMORY_USER_DATA_SECTORS, in its order. The sizes are written
+# into the header as well and memory_manager.c checks them against the records when it is built
+SECTORS = [
+    # name           size  interval                           sample rate
+    ('GYRO',         10,   ['gyroscope'],                     'gyroscope'),
+    ('ACCEL',        10,   ['accelerometer'],                 'accelerometer'),
+    ('MAG',          10,   ['magnetometer'],                  'magnetometer'),
+    ('PRESSURE',     8,    ['pressure'],                      'pressure'),
+    ('TEMPERATURE',  8,    ['temperature'],                   'temperature'),
+    ('CONTINUITY',   256,  ['drogue_continuity', 'main_continuity'], 'continuity'),
+    ('FLIGHT_EVENT', 256,  None,                              None),
+]
+
+# event_detector.h: FLIGHT_STATE_COUNT, a flight event is logged once per flight state
+FLIGHT_STATE_COUNT = 8
+
+PHASES = ['pre_launch', 'pre_apogee', 'post_apogee', 'ground']
+
+INTERVALS = ['accelerometer', 'gyroscope', 'magnetometer', 'pressure', 'altitude', 'temperature', 'flight_state',
+             'drogue_continuity', 'main_continuity']
+
+
+def align_up(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def rate_control_interval_ms(intervals, keys, multiplier):
+    # rate_control_get_interval ( ) in rate_control.c, the logging interval of a channel in a flight phase: continuity
+    # is logged as often as the more demanding of the two channels asks for
+    values = [intervals[key] for key in keys if intervals[key] != 0]
+    interval_ms = min(values) if values else 0
+    return interval_ms * max(multiplier, 1)
+
+
+def channel_rate_mhz(interval_ms, sample_rate_hz):
+    if interval_ms == 0:
+        return sample_rate_hz * 1000
+    return min(sample_rate_hz * 1000, 1000000 // interval_ms)
+
+
+def plan(config):
+    multipliers = config['write_multipliers']
+    intervals = config['write_intervals_ms']
+    rates = config['sample_rates_hz']
+    durations = config['phase_durations_s']
+
+    needed = []
+    for name, size, interval_keys, rate_key in SECTORS:
+        if interval_keys is None:
+            needed.append(FLIGHT_STATE_COUNT * size)
+            continue
+
+        entries_mhz = 0
+        for phase in PHASES:
+            interval = rate_control_interval_ms(intervals, interval_keys, multipliers[phase])
+            entries_mhz += channel_rate_mhz(interval, rates[rate_key]) * durations[phase]
+        needed.append(entries_mhz * size // 1000)
+
+    blocks = [max(1, align_up(need, BLOCK_SIZE) // BLOCK_SIZE) for need in needed]
+    available = (FLASH_SIZE_BYTES - align_up(DATA_SECTORS_BASE, BLOCK_SIZE)) // BLOCK_SIZE
+
+    if sum(blocks) > available:
+        raise Exception("The expected mission needs " + str(sum(blocks)) + " blocks of 64KB, only " + str(available) +
+                        " are available: lower the logging rates or the phase durations in memory-layout.yaml")
+
+    # the spare blocks are shared in proportion to what the sectors need, the blocks the rounding down leaves over go
+    # to the largest remainders
+    total = sum(needed[index] for index, sector in enumerate(SECTORS) if sector[2] is not None)
+    spare = available - sum(blocks)
+    if total > 0 and spare > 0:
+        remainders = [0] * len(SECTORS)
+        for index, (name, size, interval_keys, rate_key) in enumerate(SECTORS):
+            if interval_keys is None:
+                continue
+            blocks[index] += spare * needed[index] // total
+            remainders[index] = spare * needed[index] % total
+
+        for _ in range(available - sum(blocks)):
+            largest = remainders.index(max(remainders))
+            blocks[largest] += 1
+            remainders[largest] = 0
+
+    return needed, blocks
+
+
+def write_header(config, needed, blocks, path):
+    with open(path, 'w') as header:
+        header.write('// Generated by build-on-linux/layout_planner.py from build-on-linux/memory-layout.yaml, do not edit.\n')
+        header.write('#ifndef AVIONICS_MEMORY_LAYOUT_CONFIG_H\n')
+        header.write('#define AVIONICS_MEMORY_LAYOUT_CONFIG_H\n\n')
+
+        header.write('// logging rates, the defaults of MemoryManagerConfiguration\n')
+        for phase in PHASES:
+            header.write('#define userconf_MEM_WRITE_' + phase.upper() + '_MULTIPLIER ' +
+                         str(config['write_multipliers'][phase]) + '\n')
+        for key in INTERVALS:
+            header.write('#define userconf_MEM_WRITE_INTERVAL_' + key.upper() + '_MS ' +
+                         str(config['write_intervals_ms'][key]) + '\n')
+
+        header.write('\n// how often the sensors deliver a new sample, in Hz\n')
+        for key, value in config['sample_rates_hz'].items():
+            header.write('#define userconf_MEM_SAMPLE_RATE_' + key.upper() + '_HZ ' + str(value) + '\n')
+
+        header.write('\n// how long the flight phases are expected to last, in seconds\n')
+        for phase in PHASES:
+            header.write('#define userconf_MEM_PHASE_DURATION_' + phase.upper() + '_S ' +
+                         str(config['phase_durations_s'][phase]) + '\n')
+
+        header.write('\n// planned user data sector sizes: 64KB aligned, the expected mission needs the bytes in the comments\n')
+        for index, (name, size, interval_keys, rate_key) in enumerate(SECTORS):
+            header.write('#define userconf_MEM_SECTOR_SIZE_' + name + ' ' + '0x{:06X}'.format(blocks[index] * BLOCK_SIZE) +
+                         ' // ' + str(needed[index]) + '\n')
+
+        header.write('\n// the record sizes the sectors were planned with\n')
+        for name, size, interval_keys, rate_key in SECTORS:
+            header.write('#define userconf_MEM_SECTOR_ENTRY_SIZE_' + name + ' ' + str(size) + '\n')
+
+        header.write('\n#endif // AVIONICS_MEMORY_LAYOUT_CONFIG_H\n')
+
+
+def generate(source='memory-layout.yaml', destination='generated/configurations/MemoryLayoutConfig.h'):
+    with open(source) as f:
+        config = yaml.safe_load(f)
+
+    if config is None:
+        raise Exception("Configuration file \"" + source + "\" is empty!")
+
+    needed, blocks = plan(config)
+    os.makedirs(os.path.dirname(destination), exist_ok=True)
+    write_header(config, needed, blocks, destination)
+
+    print("Memory layout planned into " + destination + ":")
+    for index, (name, size, interval_keys, rate_key) in enumerate(SECTORS):
+        print("    " + name.lower().ljust(14) + str(blocks[index] * 64).rjust(6) + " KB, expected " +
+              str(needed[index] // 1024) + " KB")
+
+
+if __name__ == '__main__':
+    generate(*sys.argv[1:])
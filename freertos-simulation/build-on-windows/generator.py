@@ -12,6 +12,10 @@ import os
 from pathlib import Path, PurePosixPath, WindowsPath
 import sys
 
+# the flash layout planner is shared with the linux build
+sys.path.append(os.path.join('..', 'build-on-linux'))
+import layout_planner
+
 
 CC = '-gcc'
 CXX = '-g++'
@@ -118,4 +122,8 @@ def gen_aux_config_files():
 
 
 if __name__ == '__main__':
-    gen_aux_config_files()
\ No newline at end of file
+    gen_aux_config_files()
+    # the layout goes into the build directory, so that configuring a build does not modify the sources
+    build_directory = sys.argv[1] if len(sys.argv) > 1 else 'generated'
+    layout_planner.generate(os.path.join('..', 'build-on-linux', 'memory-layout.yaml'),
+                            os.path.join(build_directory, 'configurations', 'MemoryLayoutConfig.h'))
\ No newline at end of file
@@ -42,7 +42,11 @@
 
 #define configUSE_PREEMPTION			1
 #define configMAX_PRIORITIES			( 7 )
-#define configTICK_RATE_HZ				( ( TickType_t ) 10 ) /* In this non-real time simulated environment the tick frequency has to be at least a multiple of the Win32 tick frequency, and therefore very slow. */
+#if (userconf_FREE_RTOS_SIMULATOR_MODE_ON == 1)
+#define configTICK_RATE_HZ				( ( TickType_t ) userconf_SIMULATOR_TICK_RATE_HZ ) /* The POSIX port raises the tick from a dedicated thread sleeping on absolute deadlines, so flight-rate ticks are reproduced without spinning the host. */
+#else
+#define configTICK_RATE_HZ				( ( TickType_t ) 10 )
+#endif
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 512 ) /* In this simulated case, the stack only has to hold one small structure as the real stack is part of the Win32 thread. */
 #define configTOTAL_HEAP_SIZE			( ( size_t ) ( 70360U ) )
 #define configUSE_TRACE_FACILITY		1
@@ -58,7 +62,7 @@
 
 #define configUSE_PREEMPTION					1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
-#define configUSE_IDLE_HOOK						0
+#define configUSE_IDLE_HOOK						userconf_FREE_RTOS_SIMULATOR_MODE_ON /* The simulator sleeps the idle task until the next tick. */
 #define configUSE_TICK_HOOK						0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK		0
 #define configMAX_TASK_NAME_LEN					( 12 )
@@ -2,6 +2,19 @@
 #define AVIONICS_USERCONFIG_H
 
 #define userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON       1
+// low-pass filtering of the sensor channels in front of the event detector, the coefficients are in event_detector_core.c
+#define userconf_EVENT_DETECTION_FILTERING_ON               1
+
+// 64KB blocks the memory manager keeps erased ahead of the write cursor of every data sector
+#define userconf_MEM_ERASE_AHEAD_BLOCKS                     2
+// a fresh memory layout wraps around the data sectors (pad holds, static fires, soak tests) instead of filling them once
+#define userconf_MEM_CIRCULAR_LOGGING_ON                    0
+
+// the IMU task drains the FIFO of the sensor in one burst per wake-up instead of reading a single sample
+#define userconf_IMU_FIFO_MODE_ON                           1
+// sample rate divider of the IMU in FIFO mode, the output data rate is 1100Hz / (1 + divider). The task drains the
+// FIFO at half the time it takes to fill (IMU_SENSOR_FIFO_FRAME_COUNT frames, 76ms at the default 550Hz)
+#define userconf_IMU_FIFO_SAMPLE_RATE_DIVIDER               1
 
 // Simulation
 #define userconf_FREE_RTOS_SIMULATOR_MODE_ON                0
@@ -9,6 +22,8 @@
 #if (userconf_FREE_RTOS_SIMULATOR_MODE_ON == 1)
     #define userconf_FLASH_DISK_SIMULATION_ON               1
     #define userconf_USE_COTS_DATA                          1
+    // Kernel tick of the simulator, the POSIX port keeps it drift free
+    #define userconf_SIMULATOR_TICK_RATE_HZ                 1000
 #else
 
 #endif
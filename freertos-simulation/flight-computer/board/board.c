@@ -2,8 +2,15 @@
 #include "hardware_definitions.h"
 #include "protocols/UART.h"
 
+#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON == 1 )
+#include <time.h>
+#endif
+
 static BoardStatus system_clock_config ( void );
 static void GPIO_init ( void );
+static void timestamp_timer_init ( void );
+
+static uint32_t prvEpochUs = 0;
 
 BoardStatus board_init ( void )
 {
@@ -22,10 +29,29 @@ BoardStatus board_init ( void )
 
     /* Initialize all configured peripherals */
     GPIO_init ( );
+    timestamp_timer_init ( );
+
+    prvEpochUs = board_get_timestamp_us ( );
 
     return BOARD_OK;
 }
 
+uint32_t board_get_timestamp_us ( void )
+{
+#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON == 0 )
+    return TIM5->CNT;
+#else
+    struct timespec now;
+    clock_gettime ( CLOCK_MONOTONIC, &now );
+    return ( uint32_t ) ( ( uint64_t ) now.tv_sec * 1000000 + now.tv_nsec / 1000 );
+#endif
+}
+
+uint32_t board_get_epoch_us ( void )
+{
+    return prvEpochUs;
+}
+
 void board_delay ( uint32_t ms )
 {
     if ( taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState() )
@@ -111,6 +137,27 @@ void GPIO_init ( void )
     HAL_GPIO_Init ( USR_PB_PORT, &GPIO_InitStruct2 );
 }
 
+// TIM5 is one of the two 32 bit timers, counting microseconds it runs for 71 minutes before it wraps
+void timestamp_timer_init ( void )
+{
+#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON == 0 )
+    __HAL_RCC_TIM5_CLK_ENABLE( );
+
+    // the timers of APB1 run at twice its clock when the bus is divided
+    uint32_t clock = HAL_RCC_GetPCLK1Freq ( );
+    if ( ( RCC->CFGR & RCC_CFGR_PPRE1 ) != RCC_CFGR_PPRE1_DIV1 )
+    {
+        clock *= 2;
+    }
+
+    TIM5->CR1 = 0;
+    TIM5->PSC = clock / 1000000 - 1;
+    TIM5->ARR = 0xFFFFFFFF;
+    TIM5->EGR = TIM_EGR_UG; // loads the prescaler
+    TIM5->CR1 = TIM_CR1_CEN;
+#endif
+}
+
 void board_error_handler ( const char * file, uint32_t line )
 {
     DISPLAY_LINE( "%s:%lu:ERROR!", file, line );
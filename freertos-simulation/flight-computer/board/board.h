@@ -3,6 +3,10 @@
 
 #include <inttypes.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum
 {
     BOARD_OK = 0, BOARD_ERROR = 1, BOARD_BUSY = 2, BOARD_TIMEOUT = 3, BOARD_SYS_CLOCK_CONFIG_ERROR = 4
@@ -14,5 +18,43 @@ void        board_error_handler ( const char* file, uint32_t line);
 void        board_delay         ( uint32_t ms);
 void        board_led_blink     ( uint32_t ms);
 
+// free running microseconds since the board was initialized, wraps after 71 minutes. Cheap enough for an interrupt
+// handler: the data ready interrupts take the time of a sample with it instead of the tick count.
+uint32_t    board_get_timestamp_us ( void );
+
+// board_get_timestamp_us when board_init ( ) was done, the epoch of every time stamp in ms
+uint32_t    board_get_epoch_us ( void );
+
+// Milliseconds since board_init ( ), out of board_get_timestamp_us. The wrap around of the microseconds is carried over
+// as long as two updates are less than 71 minutes apart, the milliseconds last 49 days. Every task that time stamps
+// samples (the sensors, the continuity checks of the flight controller) keeps a clock of its own, all of them count
+// from the same epoch so that the time stamps of the sensors compare. At the resolution of the timer whatever the
+// tick rate.
+typedef struct
+{
+    uint32_t last_us;   // the microsecond the milliseconds were last advanced to
+    uint32_t ms;
+
+} BoardMillisecondClock;
+
+static inline void board_ms_clock_start ( BoardMillisecondClock * clock )
+{
+    clock->last_us = board_get_epoch_us ( );
+    clock->ms      = 0;
+}
+
+static inline uint32_t board_ms_clock_update ( BoardMillisecondClock * clock, uint32_t now_us )
+{
+    const uint32_t elapsed_ms = ( now_us - clock->last_us ) / 1000;
+
+    clock->last_us += elapsed_ms * 1000;
+    clock->ms      += elapsed_ms;
+
+    return clock->ms;
+}
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif //AVIONICS_BOARD_H
@@ -0,0 +1,31 @@
+#ifndef AVIONICS_BMI088_IMU_SENSOR_H
+#define AVIONICS_BMI088_IMU_SENSOR_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include "board/components/icm20948_imu_sensor.h"
+
+// BMI088 backend of the IMU sensor (IMU_SENSOR_BACKEND_BMI088_DATA_SYNC), see DataSync.md of the BMI08x API.
+//
+// The gyroscope data ready (INT3) is wired to the accelerometer input INT1, the accelerometer interpolates its data to
+// the instants of the gyroscope and raises INT2 (IMU_ACC_INT_PIN) once a synchronized sample is ready. The interrupt
+// only stamps the time and wakes the reader task, which takes the sample into a ring that imu_read empties.
+
+// samples the ring holds, a power of two: 32ms at 2kHz
+#define BMI088_IMU_SENSOR_RING_LENGTH   64
+
+int      bmi088_imu_sensor_init             ( void );
+int      bmi088_imu_sensor_configure        ( IMUSensorConfiguration * parameters );
+int      bmi088_imu_sensor_start            ( void );
+void     bmi088_imu_sensor_stop             ( void );
+bool     bmi088_imu_sensor_is_running       ( void );
+bool     bmi088_imu_sensor_read             ( IMUSensorData * buffer );
+IMUSensorScale bmi088_imu_sensor_get_scale  ( void );
+
+// to be called from the EXTI interrupt of IMU_ACC_INT_PIN
+void     bmi088_imu_sensor_data_ready_isr   ( void );
+
+// data ready interrupts that came before the previous sample was read, and samples lost to a full ring
+uint32_t bmi088_imu_sensor_get_overruns     ( void );
+
+#endif //AVIONICS_BMI088_IMU_SENSOR_H
@@ -18,6 +18,7 @@ typedef enum flash_command_t
     FLASH_WRITE_ENABLE        = 0x06, // Write Enable
     FLASH_WRITE               = 0x02, // Page Program Command (write)
     FLASH_READ                = 0x03,
+    FLASH_FAST_READ           = 0x0B, // Read at the fast clock, one dummy byte after the address
     FLASH_ERASE_64KB_SECTOR   = 0xD8,
     FLASH_ERASE_4KB_SECTOR    = 0x20,
     FLASH_GET_STATUS_REGISTER = 0x05,
@@ -25,6 +26,19 @@ typedef enum flash_command_t
 } FlashCommand;
 
 
+// a chunk of the stream is far below this at either SPI clock
+#define FLASH_STREAM_TIMEOUT_MS    100
+
+// chunks of the stream, the sink has one while the DMA fills the other. Words, for the erased checks.
+static uint32_t prvStreamBuffers [ 2 ] [ FLASH_STREAM_CHUNK_SIZE / sizeof ( uint32_t ) ];
+
+typedef struct
+{
+    const uint8_t * expected;
+    bool            match;
+} FlashVerifyContext;
+
+
 static FlashReturnType prvExecuteCommand ( uint32_t address, FlashCommand command, uint8_t * data_buffer, uint16_t num_bytes );
 
 
@@ -110,6 +124,11 @@ static FlashReturnType prvExecuteCommand ( uint32_t address, FlashCommand comman
                 return FLASH_ERR;
             }
         }
+        case FLASH_FAST_READ:
+        {
+            // the data of the command is streamed, see flash_read_stream
+            return FLASH_ERR;
+        }
         case FLASH_WRITE:
         {
             if ( FLASH_OK != prvExecuteCommand ( 0, FLASH_WRITE_ENABLE, NULL, 0 ) )
@@ -298,6 +317,152 @@ FlashReturnType flash_read ( uint32_t address, uint8_t * data_buffer, uint16_t n
 }
 
 
+static bool prvStreamStart ( SPITransfer * transfer, uint32_t length, uint32_t * started )
+{
+    const uint32_t remaining = length - *started;
+    transfer->size = remaining < FLASH_STREAM_CHUNK_SIZE ? remaining : FLASH_STREAM_CHUNK_SIZE;
+
+    if ( SPI_OK != spi_transfer_start ( transfer ) )
+    {
+        // gives the bus back
+        spi_transfer_wait ( transfer, 0 );
+        return false;
+    }
+
+    *started += transfer->size;
+    return true;
+}
+
+
+FlashStatus flash_read_stream ( uint32_t address, uint32_t length, FlashStreamSink sink, void * context )
+{
+    if ( sink == NULL || address > FLASH_END_ADDRESS )
+    {
+        return FLASH_ERR;
+    }
+
+    if ( length > FLASH_SIZE_BYTES - address )
+    {
+        length = FLASH_SIZE_BYTES - address;
+    }
+
+    if ( length == 0 )
+    {
+        return FLASH_OK;
+    }
+
+    if ( FLASH_OK != prvWaitForLastOperationToFinish ( ) )
+    {
+        return FLASH_ERR;
+    }
+
+    uint8_t command_buffer[] = {
+            FLASH_FAST_READ, ( address & ( FLASH_HIGH_BYTE_MASK_32B ) ) >> 24, ( address & ( FLASH_MIDHIGH_BYTE_MASK_32B ) ) >> 16,
+            ( address & ( FLASH_MIDLOW_BYTE_MASK_32B ) ) >> 8, address & ( FLASH_LOW_BYTE_MASK_32B ), 0x00
+    };
+
+    // one command for the whole stream, the chip select stays low from chunk to chunk
+    SPITransfer transfers [ 2 ] = {
+            { .bus = SPI_BUS_1, .cmd_buffer = command_buffer, .cmd_buffer_size = sizeof ( command_buffer ),
+              .rx_buffer = ( uint8_t * ) prvStreamBuffers [ 0 ], .keep_selected = 1, .fast_clock = 1 },
+            { .bus = SPI_BUS_1, .rx_buffer = ( uint8_t * ) prvStreamBuffers [ 1 ], .keep_selected = 1, .fast_clock = 1 },
+    };
+
+    uint32_t started = 0;
+    uint32_t offset  = 0;
+    int      current = 0;
+    bool     going   = true;
+
+    if ( ! prvStreamStart ( &transfers [ 0 ], length, &started ) )
+    {
+        return FLASH_ERR;
+    }
+
+    while ( offset < started )
+    {
+        SPITransfer * chunk = &transfers [ current ];
+
+        // a failed transfer raises the chip select and gives the bus back
+        if ( SPI_OK != spi_transfer_wait ( chunk, FLASH_STREAM_TIMEOUT_MS ) )
+        {
+            return FLASH_ERR;
+        }
+
+        chunk->cmd_buffer_size = 0;
+
+        // the next chunk is on the wire while the sink has this one
+        if ( going && started < length && ! prvStreamStart ( &transfers [ current ^ 1 ], length, &started ) )
+        {
+            return FLASH_ERR;
+        }
+
+        if ( going )
+        {
+            going = sink ( address + offset, chunk->rx_buffer, chunk->size, context );
+        }
+
+        offset += chunk->size;
+        current ^= 1;
+    }
+
+    // ends the command, the chip select goes high and the bus is given back
+    SPITransfer end = { .bus = SPI_BUS_1 };
+    return SPI_OK == spi_transfer ( &end, FLASH_STREAM_TIMEOUT_MS ) ? FLASH_OK : FLASH_ERR;
+}
+
+
+// erased NOR flash reads all ones, the data is word aligned
+static bool prvIsErased ( const uint8_t * data, uint32_t size )
+{
+    const uint32_t * words = ( const uint32_t * ) data;
+    uint32_t ones = 0xFFFFFFFF;
+    uint32_t i;
+
+    for ( i = 0; i < size / sizeof ( uint32_t ); i++ )
+    {
+        ones &= words [ i ];
+    }
+
+    for ( i *= sizeof ( uint32_t ); i < size; i++ )
+    {
+        ones &= 0xFFFFFF00 | data [ i ];
+    }
+
+    return ones == 0xFFFFFFFF;
+}
+
+
+static bool prvVerifySink ( uint32_t address, const uint8_t * data, uint32_t size, void * context )
+{
+    FlashVerifyContext * verify = context;
+
+    if ( verify->expected == NULL )
+    {
+        verify->match = prvIsErased ( data, size );
+    }
+    else
+    {
+        verify->match = 0 == memcmp ( data, verify->expected, size );
+        verify->expected += size;
+    }
+
+    return verify->match;
+}
+
+
+FlashStatus flash_verify ( uint32_t address, const uint8_t * expected, uint32_t length )
+{
+    FlashVerifyContext verify = { .expected = expected, .match = true };
+
+    if ( FLASH_OK != flash_read_stream ( address, length, prvVerifySink, &verify ) )
+    {
+        return FLASH_ERR;
+    }
+
+    return verify.match ? FLASH_OK : FLASH_ERR;
+}
+
+
 FlashStatus flash_erase_device ( )
 {
     if ( FLASH_OK != prvWaitForLastOperationToFinish ( ) )
@@ -378,48 +543,30 @@ FlashStatus flash_init ( )
 }
 
 
-size_t flash_scan ( )
+// the stream starts on a page, so do the chunks
+static bool prvScanSink ( uint32_t address, const uint8_t * data, uint32_t size, void * context )
 {
-    if ( FLASH_OK != prvWaitForLastOperationToFinish ( ) )
-    {
-        return FLASH_ERR;
-    }
-
-    size_t  result = 0;
-    uint8_t dataRX[256];
-    size_t  i;
-    int     j;
-    i = FLASH_START_ADDRESS;
-    while ( i < FLASH_SIZE_BYTES )
+    for ( uint32_t page = 0; page + FLASH_PAGE_SIZE <= size; page += FLASH_PAGE_SIZE )
     {
-        FlashStatus status;
-        for ( j = 0; j < 256; j++ )
+        if ( prvIsErased ( &data [ page ], FLASH_PAGE_SIZE ) )
         {
-            dataRX[ j ] = 0;
+            *( size_t * ) context = address + page;
+            return false;
         }
+    }
 
-        status = flash_read ( i, dataRX, 256 );
-        uint16_t empty = 0xFFFF;
-        for ( j = 0; j < 256; j++ )
-        {
-            if ( dataRX[ j ] != 0xFF )
-            {
-                empty--;
-            }
-        }
+    return true;
+}
 
-        if ( empty == 0xFFFF )
-        {
-            result = i;
-            break;
-        }
 
-        i = i + 256;
-    }
+size_t flash_scan ( )
+{
+    // a full flash memory has no erased page, an erased first page is an empty one
+    size_t result = FLASH_SIZE_BYTES;
 
-    if ( result == 0 )
+    if ( FLASH_OK != flash_read_stream ( FLASH_START_ADDRESS, FLASH_SIZE_BYTES, prvScanSink, &result ) )
     {
-        result = FLASH_SIZE_BYTES;
+        return FLASH_ERR;
     }
 
     return result;
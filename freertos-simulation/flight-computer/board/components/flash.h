@@ -45,6 +45,7 @@
 #define FLASH_START_ADDRESS            ( 0x00000000 )
 #define FLASH_END_ADDRESS              ( 0x7FFFFF )
 #define FLASH_SIZE_BYTES               ( FLASH_END_ADDRESS + 1 )
+#define FLASH_STREAM_CHUNK_SIZE        ( FLASH_PAGE_SIZE * 8 )
 
 /*
  *  Status Reg. Bits
@@ -76,6 +77,16 @@ typedef FlashStatus FlashReturnType;
 typedef uint32_t FlashReturnType;
 #endif
 
+/**
+ * @brief Receives the data of @c flash_read_stream one chunk at a time.
+ * @param address Flash address of the first byte of the chunk.
+ * @param data The chunk, only valid until the sink returns.
+ * @param size Bytes in the chunk, @c FLASH_STREAM_CHUNK_SIZE but for the last one.
+ * @param context The context given to @c flash_read_stream.
+ * @return @c true to go on, @c false to end the stream early.
+ */
+typedef bool ( * FlashStreamSink ) ( uint32_t address, const uint8_t * data, uint32_t size, void * context );
+
 /**
  * @brief Flash structure that holds a communication handler
  */
@@ -127,6 +138,29 @@ FlashReturnType flash_write ( uint32_t address, uint8_t * data_buffer, uint16_t
  */
 FlashReturnType flash_read ( uint32_t address, uint8_t * data_buffer, uint16_t num_bytes );
 
+/**
+ * @brief
+ * This streams any length of the flash memory to a sink with a single Fast Read command.
+ * The command is sent once and the data is clocked out at the fast SPI clock into two chunk buffers by DMA, the sink
+ * is given one chunk while the next one is on the wire. The bus is held for the whole stream.
+ * @param address Where the stream starts.
+ * @param length Bytes to stream, the stream ends at the end of the memory whatever the length.
+ * @param sink Called for every chunk, in order.
+ * @param context Given to the sink as is.
+ * @return @c FlashStatus. @c FLASH_OK if the sink ended the stream early as well.
+ */
+FlashStatus flash_read_stream ( uint32_t address, uint32_t length, FlashStreamSink sink, void * context );
+
+/**
+ * @brief
+ * This compares a range of the flash memory to the expected data, streamed by @c flash_read_stream.
+ * @param address Where the range starts.
+ * @param expected The data the range should hold, @c NULL to check that the range is erased.
+ * @param length Bytes in the range.
+ * @return @c FLASH_OK if the range matches, @c FLASH_ERR if it does not or could not be read.
+ */
+FlashStatus flash_verify ( uint32_t address, const uint8_t * expected, uint32_t length );
+
 /**
  * @brief
  * This erases a specified sector(64 kb) in the flash memory. Will take up to 2 seconds.
@@ -168,7 +202,7 @@ FlashStatus flash_erase_device ( );
 /**
  * @brief
  * This returns the address of the first empty page in memory.
- * Assumes continuous block of memory used.
+ * Assumes continuous block of memory used. The memory is streamed until the empty page comes.
  * @param p_flash Pointer to @c Flash structure
  * @return @c uint32_t
  * The address value (32 bits)
@@ -11,6 +11,23 @@
 
 #define IMU_STR_VAL_LENGTH 6
 
+// FIFO of the sensor: frames of the accelerometer then the gyroscope outputs, x, y, z, 16 bits big endian each
+#define IMU_SENSOR_FIFO_SIZE            512
+#define IMU_SENSOR_FIFO_FRAME_SIZE      12
+#define IMU_SENSOR_FIFO_FRAME_COUNT     ( IMU_SENSOR_FIFO_SIZE / IMU_SENSOR_FIFO_FRAME_SIZE )
+// the FIFO is drained twice in the time it takes to fill at the output data rate, the other half absorbs a late wake-up
+#define IMU_SENSOR_FIFO_DRAIN_PERIOD_MS( odr_hz )   ( IMU_SENSOR_FIFO_FRAME_COUNT * 1000UL / ( 2UL * ( odr_hz ) ) )
+
+// samples handed to imu_read: a full FIFO drained in one wake-up, rounded up to a power of two for the ring
+#define IMU_SENSOR_RING_LENGTH          64
+
+// how the samples are acquired, selected by the backend field of the configuration
+typedef enum
+{
+    IMU_SENSOR_BACKEND_ICM20948          = 0, // polled by the IMU task, from the output registers or the FIFO
+    IMU_SENSOR_BACKEND_BMI088_DATA_SYNC  = 1, // synchronized accelerometer and gyroscope at 2kHz, one interrupt per sample
+} IMUSensorBackend;
+
 typedef struct imu_sensor_configuration
 {
 
@@ -24,6 +41,8 @@ typedef struct imu_sensor_configuration
     uint8_t     gyro_range;
     uint8_t     gyro_power;
 
+    uint8_t     backend;
+
 } IMUSensorConfiguration;
 
 typedef union
@@ -37,21 +56,29 @@ typedef union
 
 typedef enum { IMU_ERR = 0, IMU_OK = 1 } IMUStatus;
 
-//Groups both sensor readings and a time stamp.
+//Groups both sensor readings and a time stamp. The readings are the raw counts of the sensor, they are logged as they
+//are and converted only where a unit is needed, with the scale of imu_sensor_get_scale.
 typedef struct imu_sensor_data
 {
-    uint32_t timestamp; // time of sensor reading in ticks.
+    uint32_t timestamp; // time of sensor reading in ms since board_init ( ).
 
-    float acc_x;
-    float acc_y;
-    float acc_z;
+    int16_t acc_x;
+    int16_t acc_y;
+    int16_t acc_z;
 
-    float gyro_x;
-    float gyro_y;
-    float gyro_z;
+    int16_t gyro_x;
+    int16_t gyro_y;
+    int16_t gyro_z;
 
 } IMUSensorData;
 
+// what a count of the readings is worth, from the full scale ranges the sensor runs at
+typedef struct imu_sensor_scale
+{
+    float acc;  // [g]
+    float gyro; // [deg/s]
+} IMUSensorScale;
+
 typedef union
 {
     struct
@@ -75,8 +102,13 @@ void imu_sensor_stop           ();
 IMUSensorConfiguration imu_sensor_get_default_configuration();
 
 IMUSensorConfiguration imu_sensor_get_current_configuration();
+IMUSensorScale imu_sensor_get_scale();
 
+// period of the reads in ms when the sensor is polled, the FIFO is drained at the period its output data rate needs
 void imu_sensor_set_desired_processing_data_rate(uint32_t rate);
 
+// times the FIFO filled up between two wake-ups of the task and samples were lost
+uint32_t imu_sensor_get_fifo_overflows();
+
 
 #endif //AVIONICS_ICM20948_IMU_SENSOR_H
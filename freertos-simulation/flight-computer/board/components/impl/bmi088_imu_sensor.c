@@ -0,0 +1,349 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS Google Drive: UMSATS/Guides and HowTos.../Command and Data Handling (CDH)/Coding Standards
+//
+// File Description:
+//  BMI088 in data synchronization mode: time aligned accelerometer and gyroscope samples at 2kHz, read on the data ready
+//  interrupt of the accelerometer.
+//
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "board/components/bmi088_imu_sensor.h"
+#include "protocols/SPI.h"
+#include "cmsis_os.h"
+#include "utilities/common.h"
+#include "utilities/spsc_ring.h"
+#include "board/hardware_definitions.h"
+#include "board/board.h"
+#include "bmi08x.h"
+#include "bmi088.h"
+
+// the device ids tell the SPI callbacks which chip select to use, the SPI driver takes it from the timeout: 10 for the
+// accelerometer, anything else for the gyroscope
+#define BMI088_ACCEL_ID                                 0
+#define BMI088_GYRO_ID                                  1
+#define BMI088_ACCEL_SPI_TIMEOUT                        10
+#define BMI088_GYRO_SPI_TIMEOUT                         100
+
+#define BMI088_ACCEL_FULL_SCALE                         24.0f   // [g], BMI088_ACCEL_RANGE_24G
+#define BMI088_GYRO_FULL_SCALE                          2000.0f // [deg/s], BMI08X_GYRO_RANGE_2000_DPS
+
+// longest wait for a data ready before the task checks whether it was stopped
+#define BMI088_DATA_READY_TIMEOUT_MS                    100
+
+typedef struct
+{
+    uint32_t                    timestamp;
+    struct bmi08x_sensor_data   acc;
+    struct bmi08x_sensor_data   gyro;
+} BMI088Sample;
+
+SPSC_RING( bmi088_sample, BMI088Sample, BMI088_IMU_SENSOR_RING_LENGTH )
+
+typedef struct
+{
+    uint8_t isInitialized       ;
+    uint8_t isRunning           ;
+
+    xTaskHandle taskHandle      ;
+} BMI088TaskState;
+
+static BMI088TaskState prvController = {};
+
+static struct bmi08x_dev prvDevice;
+
+// filled by the reader task, emptied by imu_read
+static bmi088_sample_ring       prvRing;
+
+// board_get_timestamp_us of the latest data ready, and the clock of the time stamps in ms
+static volatile uint32_t        prvDataReadyTimestamp = 0;
+static uint32_t                 prvOverruns = 0;
+static BoardMillisecondClock    prvClock = { 0 };
+
+
+static int8_t prv_bmi088_spi_read  ( uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len );
+static int8_t prv_bmi088_spi_write ( uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len );
+static void   prv_bmi088_delay_ms  ( uint32_t period );
+
+
+
+int bmi088_imu_sensor_init ( void )
+{
+    if ( 0 != spi3_init ( ) )
+    {
+        return IMU_ERR;
+    }
+
+    prvDevice.accel_id          = BMI088_ACCEL_ID;
+    prvDevice.gyro_id           = BMI088_GYRO_ID;
+    prvDevice.intf              = BMI08X_SPI_INTF;
+    prvDevice.read              = prv_bmi088_spi_read;
+    prvDevice.write             = prv_bmi088_spi_write;
+    prvDevice.delay_ms          = prv_bmi088_delay_ms;
+    prvDevice.read_write_len    = 32;
+
+    if ( BMI08X_OK != bmi088_init ( &prvDevice ) )
+    {
+        return IMU_ERR;
+    }
+
+    // the data ready of the synchronized samples, INT2 of the accelerometer
+    GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+    GPIO_InitStruct.Pin     = IMU_ACC_INT_PIN;
+    GPIO_InitStruct.Mode    = GPIO_MODE_IT_RISING;
+    GPIO_InitStruct.Pull    = GPIO_NOPULL;
+    HAL_GPIO_Init ( IMU_ACC_INT_PORT, &GPIO_InitStruct );
+
+    // the interrupt calls into the kernel, so it cannot be above the highest priority the kernel masks. The line is
+    // shared with the pressure sensor and stays enabled, the handler drops the edges while no task is running.
+    HAL_NVIC_SetPriority ( EXTI9_5_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0 );
+    HAL_NVIC_EnableIRQ ( EXTI9_5_IRQn );
+
+    prvController.isInitialized = 1;
+
+    return IMU_OK;
+}
+
+
+
+int bmi088_imu_sensor_configure ( IMUSensorConfiguration * parameters )
+{
+    (void) parameters;
+
+    if ( ! prvController.isInitialized )
+    {
+        return IMU_ERR;
+    }
+
+    if ( BMI08X_OK != bmi08a_soft_reset ( &prvDevice ) )
+    {
+        return IMU_ERR;
+    }
+
+    prvDevice.accel_cfg.power = BMI08X_ACCEL_PM_ACTIVE;
+    prvDevice.gyro_cfg.power  = BMI08X_GYRO_PM_NORMAL;
+    if ( BMI08X_OK != bmi08a_set_power_mode ( &prvDevice ) || BMI08X_OK != bmi08g_set_power_mode ( &prvDevice ) )
+    {
+        return IMU_ERR;
+    }
+
+    // the synchronization is a feature of the accelerometer firmware, uploaded here (150ms)
+    if ( BMI08X_OK != bmi088_apply_config_file ( &prvDevice ) )
+    {
+        return IMU_ERR;
+    }
+
+    // the output data rates and bandwidths are set by the synchronization mode
+    prvDevice.accel_cfg.range = BMI088_ACCEL_RANGE_24G;
+    prvDevice.gyro_cfg.range  = BMI08X_GYRO_RANGE_2000_DPS;
+
+    struct bmi08x_data_sync_cfg sync = { .mode = BMI08X_ACCEL_DATA_SYNC_MODE_2000HZ };
+    if ( BMI08X_OK != bmi088_configure_data_synchronization ( sync, &prvDevice ) )
+    {
+        return IMU_ERR;
+    }
+
+    struct bmi08x_int_cfg interrupts = { 0 };
+
+    // INT1 of the accelerometer takes the data ready of the gyroscope
+    interrupts.accel_int_config_1.int_channel                   = BMI08X_INT_CHANNEL_1;
+    interrupts.accel_int_config_1.int_type                      = BMI08X_ACCEL_SYNC_INPUT;
+    interrupts.accel_int_config_1.int_pin_cfg.output_mode       = BMI08X_INT_MODE_PUSH_PULL;
+    interrupts.accel_int_config_1.int_pin_cfg.lvl               = BMI08X_INT_ACTIVE_HIGH;
+    interrupts.accel_int_config_1.int_pin_cfg.enable_int_pin    = BMI08X_ENABLE;
+
+    // INT2 of the accelerometer tells the host that a synchronized sample is ready
+    interrupts.accel_int_config_2.int_channel                   = BMI08X_INT_CHANNEL_2;
+    interrupts.accel_int_config_2.int_type                      = BMI08X_ACCEL_SYNC_DATA_RDY_INT;
+    interrupts.accel_int_config_2.int_pin_cfg.output_mode       = BMI08X_INT_MODE_PUSH_PULL;
+    interrupts.accel_int_config_2.int_pin_cfg.lvl               = BMI08X_INT_ACTIVE_HIGH;
+    interrupts.accel_int_config_2.int_pin_cfg.enable_int_pin    = BMI08X_ENABLE;
+
+    // INT3 of the gyroscope drives the synchronization, INT4 is not used
+    interrupts.gyro_int_config_1.int_channel                    = BMI08X_INT_CHANNEL_3;
+    interrupts.gyro_int_config_1.int_type                       = BMI08X_GYRO_DATA_RDY_INT;
+    interrupts.gyro_int_config_1.int_pin_cfg.output_mode        = BMI08X_INT_MODE_PUSH_PULL;
+    interrupts.gyro_int_config_1.int_pin_cfg.lvl                = BMI08X_INT_ACTIVE_HIGH;
+    interrupts.gyro_int_config_1.int_pin_cfg.enable_int_pin     = BMI08X_ENABLE;
+
+    interrupts.gyro_int_config_2.int_channel                    = BMI08X_INT_CHANNEL_4;
+    interrupts.gyro_int_config_2.int_type                       = BMI08X_GYRO_DATA_RDY_INT;
+    interrupts.gyro_int_config_2.int_pin_cfg.output_mode        = BMI08X_INT_MODE_PUSH_PULL;
+    interrupts.gyro_int_config_2.int_pin_cfg.lvl                = BMI08X_INT_ACTIVE_HIGH;
+    interrupts.gyro_int_config_2.int_pin_cfg.enable_int_pin     = BMI08X_DISABLE;
+
+    if ( BMI08X_OK != bmi088_set_data_sync_int_config ( &interrupts, &prvDevice ) )
+    {
+        return IMU_ERR;
+    }
+
+    return IMU_OK;
+}
+
+
+
+void bmi088_imu_sensor_data_ready_isr ( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if ( prvController.taskHandle == NULL )
+    {
+        return;
+    }
+
+    prvDataReadyTimestamp = board_get_timestamp_us ( );
+
+    vTaskNotifyGiveFromISR ( prvController.taskHandle, &xHigherPriorityTaskWoken );
+    portYIELD_FROM_ISR ( xHigherPriorityTaskWoken );
+}
+
+
+
+static void prv_bmi088_imu_sensor_task ( void * pvParams )
+{
+    (void) pvParams;
+
+    board_ms_clock_start ( &prvClock );
+    prvController.isRunning = true;
+
+    while ( prvController.isRunning )
+    {
+        uint32_t pending = ulTaskNotifyTake ( pdTRUE, pdMS_TO_TICKS ( BMI088_DATA_READY_TIMEOUT_MS ) );
+        if ( pending == 0 )
+        {
+            continue;
+        }
+
+        // the sample of an earlier interrupt was replaced before it could be read
+        prvOverruns += pending - 1;
+
+        // the sample is read straight into the ring
+        BMI088Sample * sample = bmi088_sample_ring_reserve ( &prvRing );
+        if ( sample == NULL )
+        {
+            prvOverruns++;
+            continue;
+        }
+
+        // in ms as the other samples, from the time of the interrupt rather than of the read
+        sample->timestamp = board_ms_clock_update ( &prvClock, prvDataReadyTimestamp );
+        if ( BMI08X_OK != bmi088_get_synchronized_data ( &sample->acc, &sample->gyro, &prvDevice ) )
+        {
+            continue;
+        }
+
+        bmi088_sample_ring_commit ( &prvRing );
+    }
+
+    DISPLAY_LINE( "[INFO]: BMI088 sensor task has been stopped");
+    prvController.taskHandle = NULL;
+    vTaskDelete ( NULL );
+}
+
+
+
+int bmi088_imu_sensor_start ( void )
+{
+    if ( ! prvController.isInitialized )
+    {
+        return IMU_ERR;
+    }
+
+    // above the other sensors: a sample waits in the registers for 0.5ms only
+    if ( pdFALSE == xTaskCreate ( prv_bmi088_imu_sensor_task, "bmi088-manager", configMINIMAL_STACK_SIZE, NULL, 6, &prvController.taskHandle ) )
+    {
+        return IMU_ERR;
+    }
+
+    return IMU_OK;
+}
+
+void bmi088_imu_sensor_stop ( void )
+{
+    prvController.isRunning = false;
+}
+
+bool bmi088_imu_sensor_is_running ( void )
+{
+    return prvController.isRunning;
+}
+
+
+
+// the samples are handed over in counts, bmi088_imu_sensor_get_scale has what they are worth
+bool bmi088_imu_sensor_read ( IMUSensorData * buffer )
+{
+    const BMI088Sample * sample = bmi088_sample_ring_peek ( &prvRing );
+    if ( sample == NULL )
+    {
+        return false;
+    }
+
+    buffer->timestamp = sample->timestamp;
+    buffer->acc_x     = sample->acc.x;
+    buffer->acc_y     = sample->acc.y;
+    buffer->acc_z     = sample->acc.z;
+    buffer->gyro_x    = sample->gyro.x;
+    buffer->gyro_y    = sample->gyro.y;
+    buffer->gyro_z    = sample->gyro.z;
+
+    bmi088_sample_ring_release ( &prvRing );
+
+    return true;
+}
+
+IMUSensorScale bmi088_imu_sensor_get_scale ( void )
+{
+    IMUSensorScale scale = { BMI088_ACCEL_FULL_SCALE / 32768, BMI088_GYRO_FULL_SCALE / 32768 };
+    return scale;
+}
+
+uint32_t bmi088_imu_sensor_get_overruns ( void )
+{
+    return prvOverruns;
+}
+
+
+
+static int8_t prv_bmi088_spi_read ( uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len )
+{
+    const uint32_t select = dev_addr == BMI088_ACCEL_ID ? BMI088_ACCEL_SPI_TIMEOUT : BMI088_GYRO_SPI_TIMEOUT;
+
+    // the read bit is already set in the address by the API
+    if ( SPI_OK != spi3_receive ( &reg_addr, 1, data, len, select ) )
+    {
+        return BMI08X_E_COM_FAIL;
+    }
+
+    return BMI08X_OK;
+}
+
+static int8_t prv_bmi088_spi_write ( uint8_t dev_addr, uint8_t reg_addr, uint8_t * data, uint16_t len )
+{
+    const uint32_t select = dev_addr == BMI088_ACCEL_ID ? BMI088_ACCEL_SPI_TIMEOUT : BMI088_GYRO_SPI_TIMEOUT;
+
+    if ( SPI_OK != spi3_send ( &reg_addr, 1, data, len, select ) )
+    {
+        return BMI08X_E_COM_FAIL;
+    }
+
+    return BMI08X_OK;
+}
+
+static void prv_bmi088_delay_ms ( uint32_t period )
+{
+    // the configuration runs before the scheduler as well as from tasks
+    if ( xTaskGetSchedulerState ( ) == taskSCHEDULER_RUNNING )
+    {
+        vTaskDelay ( pdMS_TO_TICKS ( period ) );
+    }
+    else
+    {
+        HAL_Delay ( period );
+    }
+}
@@ -19,11 +19,15 @@
 // INCLUDES
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "board/components/icm20948_imu_sensor.h"
+#include "board/components/bmi088_imu_sensor.h"
 #include "protocols/SPI.h"
 #include "cmsis_os.h"
 #include "utilities/common.h"
+#include "utilities/spsc_ring.h"
 #include "math.h"
 #include "board/hardware_definitions.h"
+#include "board/board.h"
+#include "configurations/UserConfig.h"
 #include <stdio.h>
 
 #define INTERNAL_ERROR -127
@@ -33,6 +37,35 @@
 #define ACC_LENGTH                                      6 // Length of a accelerometer measurement in bytes.
 #define GYRO_LENGTH                                     6 // Length of a gyroscope measurement in bytes.
 
+// the output registers of the accelerometer and the gyroscope follow each other (bank 0), so one burst reads both
+#define ACCEL_XOUT_H                                    45
+#define GYRO_XOUT_H                                     51
+#define ACCEL_GYRO_LENGTH                               ( ACC_LENGTH + GYRO_LENGTH )
+
+// FIFO registers (bank 0 unless noted)
+#define USER_CTRL                                       0x03
+#define USER_CTRL_FIFO_EN                               0x40
+#define FIFO_EN_2                                       0x67
+#define FIFO_EN_2_ACCEL_GYRO                            0x1E // accelerometer, gyroscope z, y and x
+#define FIFO_RST                                        0x68
+#define FIFO_MODE                                       0x69 // 0: stream, the oldest data is overwritten when full
+#define FIFO_COUNTH                                     0x70
+#define FIFO_R_W                                        0x72
+#define GYRO_SMPLRT_DIV                                 0x00 // bank 2
+#define ACCEL_SMPLRT_DIV_2                              0x11 // bank 2
+
+#define GYRO_BASE_RATE_HZ                               1100
+#define ACCEL_BASE_RATE_HZ                              1125
+// the FIFO fills at the rate of the faster of the two sensors
+#define FIFO_FILL_RATE_HZ                               ( ACCEL_BASE_RATE_HZ / ( 1 + userconf_IMU_FIFO_SAMPLE_RATE_DIVIDER ) )
+#define FIFO_DRAIN_PERIOD_MS                            IMU_SENSOR_FIFO_DRAIN_PERIOD_MS ( FIFO_FILL_RATE_HZ )
+// frames taken from the FIFO per SPI transaction
+#define FIFO_BURST_FRAMES                               8
+
+// full scale selections programmed by accel_config and gyro_config
+#define ACCEL_FULL_SCALE_SELECT                         3 // +/- 16g
+#define GYRO_FULL_SCALE_SELECT                          3 // +/- 2000dps
+
 //#define CONFIG_IMU_SENSOR_DEFAULT_ACC_BANDWIDTH	        BMI08X_ACCEL_BW_NORMAL
 //#define CONFIG_IMU_SENSOR_DEFAULT_ACC_ODR			    BMI08X_ACCEL_ODR_100_HZ
 //#define CONFIG_IMU_SENSOR_DEFAULT_ACC_RANGE		        BMI088_ACCEL_RANGE_12G
@@ -47,8 +80,10 @@
 #define SWO_GPIO_Port GPIOB     // if this value is changed make sure it is changed in the IMU.c file (readIMU and writeIMU) TODO: change
                                 // if theres a way of automating that change I didnt know it
 
-double SENSSCALEGYRO = 16.4;    // the IMU is programmed to have +/- 2000dps range so this is the sensitivity scale at that range
-double SENSSCALEACCEL = 2048.0; // the IMU is programmed to have +/- 16g range so this is the sensitivity scale at that range
+// sensitivities of the programmed ranges, set once by imu_sensor_configure. The samples stay in counts, these go into
+// the system configuration so that whoever needs the units can get them
+static float prvAccelScale = 16.0f   / 32768; // [g / LSB]
+static float prvGyroScale  = 2000.0f / 32768; // [deg/s / LSB]
 
 typedef struct
 {
@@ -62,14 +97,29 @@ typedef struct
 static IMUSensorTaskState prvController     = {};
 
 
-static QueueHandle_t s_queue = {0};
-static uint8_t s_desired_processing_data_rate = 50;
+SPSC_RING( imu_sample, IMUSensorData, IMU_SENSOR_RING_LENGTH )
+
+// filled by the IMU task, emptied by imu_read
+static imu_sample_ring s_ring;
+static uint8_t s_desired_processing_data_rate = 50; // ms between two polled reads
+static uint32_t prvFifoOverflows = 0;
 
 // Wrapper functions for read and write
 int icm20948_get_data ( uint8_t regAddress, int numBytes, uint8_t * dReturned );
 int icm20948_set_data ( uint8_t regAddress, int numBytes, const uint8_t * dBuffer );
+int icm20948_get_burst_data ( uint8_t regAddress, int numBytes, uint8_t * dReturned );
 int icm20948_get_accel_data ( IMUSensorData * data );
 int icm20948_get_gyro_data ( IMUSensorData * data );
+int icm20948_get_accel_gyro_data ( IMUSensorData * data );
+
+static void prv_imu_sensor_unpack_frame ( const uint8_t * frame, IMUSensorData * data );
+#if ( userconf_IMU_FIFO_MODE_ON == 1 )
+_Static_assert ( pdMS_TO_TICKS ( FIFO_DRAIN_PERIOD_MS ) >= 1, "the tick is too coarse to drain the IMU FIFO before it fills: raise configTICK_RATE_HZ or userconf_IMU_FIFO_SAMPLE_RATE_DIVIDER" );
+
+static int  prv_imu_sensor_fifo_configure ( void );
+static int  prv_imu_sensor_fifo_reset     ( void );
+static int  prv_imu_sensor_fifo_drain     ( uint32_t timestamp );
+#endif
 
 void delay_ms(uint32_t period_ms);
 
@@ -112,15 +162,12 @@ static struct imu_sensor_configuration s_current_configuration = {
 
 static float imu_sensor_acc2g ( int16_t acc_value )
 {
-    const int16_t range = pow (2, ( s_current_configuration.accel_range + 1 ) ) * 1.5;
-    const float result = (float) acc_value / 32768  * range;
-    return result;
+    return acc_value * prvAccelScale;
 }
 
 static float imu_sensor_g2acc ( float g )
 {
-    const uint16_t  result = (int16_t ) ( g * 32768 / ( pow ( 2, ( s_current_configuration.accel_range + 1 ) ) * 1.5 ) );
-    return result;
+    return ( int16_t ) ( g / prvAccelScale );
 }
 
 static float imu_sensor_rot2deg_per_sec ( int16_t gyro_value )
@@ -143,14 +190,12 @@ static float imu_sensor_rot2deg_per_sec ( int16_t gyro_value )
 //    container.value = gyro_value;
 //    int16_t actual_value = to_int16_t( container.bytes );
 
-    const int16_t range = pow (2, ( s_current_configuration.gyro_range + 1 ) ) * 1.5;
-    const float result = (float) gyro_value / 32768  * range;
-    return result;
+    return gyro_value * prvGyroScale;
 }
 
 static float imu_sensor_deg_per_sec2rot     ( float deg_per_sec )
 {
-    return (int16_t ) ( deg_per_sec * 32768 ) / ( pow (2, (s_current_configuration.gyro_range + 1) ) * 1.5 );
+    return ( int16_t ) ( deg_per_sec / prvGyroScale );
 }
 
 
@@ -167,6 +212,17 @@ int imu_sensor_configure (IMUSensorConfiguration * parameters )
 
     int status = IMU_OK;
 
+    if ( s_current_configuration.backend == IMU_SENSOR_BACKEND_BMI088_DATA_SYNC )
+    {
+        status = bmi088_imu_sensor_init ( );
+        if(status != IMU_OK)
+        {
+            return status;
+        }
+
+        return bmi088_imu_sensor_configure ( &s_current_configuration );
+    }
+
     select_active_bank (0 );
     uint8_t pwrMGMT[1] = {1};
 
@@ -188,6 +244,17 @@ int imu_sensor_configure (IMUSensorConfiguration * parameters )
         return status;
     }
 
+    // full scale of the range over the 16 bits of the output registers: 2g << FS_SEL and 250dps << FS_SEL
+    prvAccelScale = ( float ) ( 2    << ACCEL_FULL_SCALE_SELECT ) / 32768;
+    prvGyroScale  = ( float ) ( 250  << GYRO_FULL_SCALE_SELECT  ) / 32768;
+
+#if ( userconf_IMU_FIFO_MODE_ON == 1 )
+    status = prv_imu_sensor_fifo_configure ( );
+    if(status != IMU_OK)
+    {
+        return status;
+    }
+#endif
 
     return IMU_OK;
 }
@@ -201,13 +268,7 @@ int imu_sensor_init()
         return IMU_ERR;
     }
 
-    s_queue = xQueueCreate (10, sizeof ( IMUSensorData ) );
-    if ( s_queue == NULL )
-    {
-        return IMU_ERR;
-    }
-
-    vQueueAddToRegistry ( s_queue, "bmi088_queue" );
+    imu_sample_ring_reset ( &s_ring );
 
     prvController.isInitialized = 1;
 
@@ -229,28 +290,42 @@ static void prv_imu_sensor_controller_task(void * pvParams)
 
     TickType_t start_timestamp =  xTaskGetTickCount();
 
+    // the samples are time stamped in ms since board_init ( ), at the resolution of the timer
+    BoardMillisecondClock clock;
+    board_ms_clock_start ( &clock );
+
     prvController.isRunning = true;
 
+#if ( userconf_IMU_FIFO_MODE_ON == 1 )
+    // the sensor samples at its own rate, every wake-up takes all the frames it buffered since the last one
+    TickType_t wakeup = start_timestamp;
+    prv_imu_sensor_fifo_reset ( );
+
     while(prvController.isRunning)
     {
-        result_flag = icm20948_get_accel_data (&dataStruct);
-        if(SPI_OK != result_flag)
-        {
-            continue;
-        }
+        vTaskDelayUntil(&wakeup, pdMS_TO_TICKS ( FIFO_DRAIN_PERIOD_MS ));
+
+        prv_imu_sensor_fifo_drain ( board_ms_clock_update ( &clock, board_get_timestamp_us ( ) ) );
+    }
+#else
+    TickType_t wakeup = start_timestamp;
 
-        result_flag = icm20948_get_gyro_data (&dataStruct);
-        if(SPI_OK != result_flag)
+    while(prvController.isRunning)
+    {
+        // both sensors in one transaction, so that they are sampled at the same instant
+        result_flag = icm20948_get_accel_gyro_data (&dataStruct);
+        if(IMU_OK != result_flag)
         {
             continue;
         }
 
-        dataStruct.timestamp = xTaskGetTickCount() - start_timestamp;
+        dataStruct.timestamp = board_ms_clock_update ( &clock, board_get_timestamp_us ( ) );
 
         imu_add_measurement(&dataStruct);
 
-        vTaskDelayUntil(&dataStruct.timestamp, s_desired_processing_data_rate);
+        vTaskDelayUntil(&wakeup, pdMS_TO_TICKS ( s_desired_processing_data_rate ));
     }
+#endif
 
     prvController.isRunning = false;
     DISPLAY_LINE( "[INFO]: IMU sensor task has been stopped");
@@ -269,6 +344,11 @@ int imu_sensor_start(void * const param)
 
     prvController.taskParameters = param;
 
+    if ( s_current_configuration.backend == IMU_SENSOR_BACKEND_BMI088_DATA_SYNC )
+    {
+        return bmi088_imu_sensor_start ( );
+    }
+
     if ( pdFALSE == xTaskCreate ( prv_imu_sensor_controller_task, "imu-manager", configMINIMAL_STACK_SIZE, prvController.taskParameters, 5, &prvController.taskHandle ) )
     {
         return IMU_ERR;
@@ -279,18 +359,24 @@ int imu_sensor_start(void * const param)
 
 bool imu_sensor_is_running     ()
 {
-    return prvController.isRunning;
+    return prvController.isRunning || bmi088_imu_sensor_is_running ( );
 }
 
 void imu_sensor_stop           ()
 {
     prvController.isRunning = false;
+    bmi088_imu_sensor_stop ( );
 }
 
 
 bool imu_read(IMUSensorData * buffer)
 {
-    return pdPASS == xQueueReceive(s_queue, buffer, 0);
+    if ( s_current_configuration.backend == IMU_SENSOR_BACKEND_BMI088_DATA_SYNC )
+    {
+        return bmi088_imu_sensor_read ( buffer );
+    }
+
+    return imu_sample_ring_pop ( &s_ring, buffer );
 }
 
 void imu_sensor_data_pack(IMUSensorData reading, uint8_t* buffer, uint32_t timestamp)
@@ -313,7 +399,7 @@ int8_t accel_config(IMUSensorConfiguration * configParams)
 
     uint8_t prevSettings [ 2 ];
     icm20948_get_data ( (uint8_t) 0x140000, 2, prevSettings );
-    prevSettings [ 0 ] |= 6;
+    prevSettings [ 0 ] |= ACCEL_FULL_SCALE_SELECT << 1;
     icm20948_set_data ( (uint8_t) 0x140000, 2, prevSettings );
 
     select_active_bank(0);
@@ -327,7 +413,7 @@ int8_t gyro_config(IMUSensorConfiguration * configParams)
 
     uint8_t prevSettings [ 2 ];
     icm20948_get_data ( (uint8_t) 0x100000, 2, prevSettings );
-    prevSettings [ 0 ] |= 6;
+    prevSettings [ 0 ] |= GYRO_FULL_SCALE_SELECT << 1;
     icm20948_set_data ( (uint8_t) 0x100000, 2, prevSettings );
 
     select_active_bank (0 );
@@ -352,6 +438,17 @@ IMUSensorConfiguration imu_sensor_get_current_configuration ( )
     return s_current_configuration;
 }
 
+IMUSensorScale imu_sensor_get_scale ( )
+{
+    if ( s_current_configuration.backend == IMU_SENSOR_BACKEND_BMI088_DATA_SYNC )
+    {
+        return bmi088_imu_sensor_get_scale ( );
+    }
+
+    IMUSensorScale scale = { prvAccelScale, prvGyroScale };
+    return scale;
+}
+
 void imu_sensor_set_desired_processing_data_rate(uint32_t rate)
 {
     s_desired_processing_data_rate = rate;
@@ -359,7 +456,12 @@ void imu_sensor_set_desired_processing_data_rate(uint32_t rate)
 
 bool imu_add_measurement (IMUSensorData * _data)
 {
-    return pdTRUE == xQueueSend(s_queue, (void *) _data,0);
+    return imu_sample_ring_push ( &s_ring, _data );
+}
+
+uint32_t imu_sensor_get_fifo_overflows ( )
+{
+    return prvFifoOverflows;
 }
 
 
@@ -391,6 +493,21 @@ int icm20948_get_data ( uint8_t regAddress, int numBytes, uint8_t * dReturned )
 }
 
 
+// reads consecutive registers in a single transaction: the address is sent once and the IMU increments it by itself
+int icm20948_get_burst_data ( uint8_t regAddress, int numBytes, uint8_t * dReturned )
+{
+    uint8_t dataTx [ 1 ];
+    dataTx [ 0 ] = regAddress | 0x80; // make the 7th bit high to show its a read op
+
+    if ( SPI_OK != spi3_receive ( dataTx, 1, dReturned, numBytes, 100 ) )
+    {
+        return IMU_ERR;
+    }
+
+    return IMU_OK;
+}
+
+
 int icm20948_set_data ( uint8_t regAddress, int numBytes, const uint8_t * dBuffer )
 {
     for ( int i = 0; i < numBytes; i++ )
@@ -415,11 +532,11 @@ int icm20948_set_data ( uint8_t regAddress, int numBytes, const uint8_t * dBuffe
 int icm20948_get_accel_data ( IMUSensorData * data )
 {
     //data is in x,y,z order
-    float dBuffer   [ 3 ];
+    int16_t dBuffer [ 3 ];
     uint8_t rawData [ 6 ];
     IMUStatus status;
 
-    status = icm20948_get_data ( 45, 6, rawData );
+    status = icm20948_get_burst_data ( ACCEL_XOUT_H, ACC_LENGTH, rawData );
     if ( status != IMU_OK )
     {
         return IMU_ERR;
@@ -427,21 +544,20 @@ int icm20948_get_accel_data ( IMUSensorData * data )
 
     for ( int i = 0; i < 6; i = i + 2 )
     {
-        int16_t combinedVal = ( int16_t ) ( ( ( ( uint16_t ) rawData [ i ] ) << 8 ) | rawData [ i + 1 ] );
-        dBuffer [ i/2 ] = combinedVal / SENSSCALEACCEL; // data sheet says to do this
+        dBuffer [ i/2 ] = ( int16_t ) ( ( ( ( uint16_t ) rawData [ i ] ) << 8 ) | rawData [ i + 1 ] );
     }
 
-    memcpy ( &data->acc_x, dBuffer, sizeof ( float ) * 3 );
+    memcpy ( &data->acc_x, dBuffer, sizeof ( int16_t ) * 3 );
     return IMU_OK;
 }
 
 int icm20948_get_gyro_data ( IMUSensorData * data )
 {
-    float dBuffer   [ 3 ];
+    int16_t dBuffer [ 3 ];
     uint8_t rawData [ 6 ];
     IMUStatus status;
 
-    status = icm20948_get_data ( 51, 6, rawData );
+    status = icm20948_get_burst_data ( GYRO_XOUT_H, GYRO_LENGTH, rawData );
     if ( status != IMU_OK )
     {
         return IMU_ERR;
@@ -449,14 +565,152 @@ int icm20948_get_gyro_data ( IMUSensorData * data )
 
     for ( int i = 0; i < 6; i = i + 2 )
     {
-        int16_t combinedVal = ( int16_t ) ( ( ( ( uint16_t ) rawData [ i ] ) << 8 ) | rawData [ i + 1 ] );
-        dBuffer [ i/2 ] = combinedVal / SENSSCALEGYRO; // data sheet says to do this
+        dBuffer [ i/2 ] = ( int16_t ) ( ( ( ( uint16_t ) rawData [ i ] ) << 8 ) | rawData [ i + 1 ] );
+    }
+
+    memcpy ( &data->gyro_x, dBuffer, sizeof ( int16_t ) * 3 );
+    return IMU_OK;
+}
+
+int icm20948_get_accel_gyro_data ( IMUSensorData * data )
+{
+    uint8_t rawData [ ACCEL_GYRO_LENGTH ];
+
+    if ( IMU_OK != icm20948_get_burst_data ( ACCEL_XOUT_H, ACCEL_GYRO_LENGTH, rawData ) )
+    {
+        return IMU_ERR;
     }
 
-    memcpy ( &data->gyro_x, dBuffer, sizeof ( float ) * 3 );
+    prv_imu_sensor_unpack_frame ( rawData, data );
     return IMU_OK;
 }
 
+// the output registers and the FIFO frames share the layout: big endian, x, y, z of the accelerometer then of the gyroscope
+static void prv_imu_sensor_unpack_frame ( const uint8_t * frame, IMUSensorData * data )
+{
+    int16_t values [ ACCEL_GYRO_LENGTH / 2 ];
+    for ( int i = 0; i < ACCEL_GYRO_LENGTH / 2; i++ )
+    {
+        values [ i ] = ( int16_t ) ( ( ( ( uint16_t ) frame [ 2 * i ] ) << 8 ) | frame [ 2 * i + 1 ] );
+    }
+
+    data->acc_x  = values [ 0 ];
+    data->acc_y  = values [ 1 ];
+    data->acc_z  = values [ 2 ];
+    data->gyro_x = values [ 3 ];
+    data->gyro_y = values [ 4 ];
+    data->gyro_z = values [ 5 ];
+}
+
+#if ( userconf_IMU_FIFO_MODE_ON == 1 )
+static int prv_imu_sensor_fifo_configure ( void )
+{
+    // the gyroscope samples at 1100Hz / (1 + divider) and the accelerometer at 1125Hz / (1 + divider), the time stamps
+    // of the frames follow the gyroscope
+    uint8_t divider [ 1 ] = { userconf_IMU_FIFO_SAMPLE_RATE_DIVIDER };
+
+    select_active_bank ( 2 );
+    if ( IMU_OK != icm20948_set_data ( GYRO_SMPLRT_DIV, 1, divider ) ||
+         IMU_OK != icm20948_set_data ( ACCEL_SMPLRT_DIV_2, 1, divider ) )
+    {
+        select_active_bank ( 0 );
+        return IMU_ERR;
+    }
+    select_active_bank ( 0 );
+
+    uint8_t fifoMode [ 1 ]    = { 0 };
+    uint8_t fifoSources [ 1 ] = { FIFO_EN_2_ACCEL_GYRO };
+    uint8_t userCtrl [ 1 ];
+
+    if ( IMU_OK != icm20948_get_data ( USER_CTRL, 1, userCtrl ) )
+    {
+        return IMU_ERR;
+    }
+    userCtrl [ 0 ] |= USER_CTRL_FIFO_EN;
+
+    if ( IMU_OK != icm20948_set_data ( FIFO_MODE, 1, fifoMode ) ||
+         IMU_OK != icm20948_set_data ( FIFO_EN_2, 1, fifoSources ) ||
+         IMU_OK != icm20948_set_data ( USER_CTRL, 1, userCtrl ) )
+    {
+        return IMU_ERR;
+    }
+
+    return prv_imu_sensor_fifo_reset ( );
+}
+
+static int prv_imu_sensor_fifo_reset ( void )
+{
+    uint8_t hold [ 1 ]    = { 0x1F };
+    uint8_t release [ 1 ] = { 0x00 };
+
+    if ( IMU_OK != icm20948_set_data ( FIFO_RST, 1, hold ) ||
+         IMU_OK != icm20948_set_data ( FIFO_RST, 1, release ) )
+    {
+        return IMU_ERR;
+    }
+
+    return IMU_OK;
+}
+
+// Takes every complete frame out of the FIFO. The frames were sampled one period of the output data rate apart and
+// the last one just before the read, so their time stamps are counted back from the time of the wake-up.
+static int prv_imu_sensor_fifo_drain ( uint32_t timestamp )
+{
+    static uint8_t frames [ FIFO_BURST_FRAMES * IMU_SENSOR_FIFO_FRAME_SIZE ];
+    uint8_t count [ 2 ];
+
+    if ( IMU_OK != icm20948_get_burst_data ( FIFO_COUNTH, 2, count ) )
+    {
+        return IMU_ERR;
+    }
+
+    const uint16_t bytes = ( ( ( uint16_t ) count [ 0 ] & 0x1F ) << 8 ) | count [ 1 ];
+
+    // a full FIFO in stream mode overwrote its oldest data, the frame boundaries are lost with it: start over
+    if ( bytes > IMU_SENSOR_FIFO_SIZE - IMU_SENSOR_FIFO_FRAME_SIZE )
+    {
+        prvFifoOverflows++;
+        return prv_imu_sensor_fifo_reset ( );
+    }
+
+    const uint32_t frameCount     = bytes / IMU_SENSOR_FIFO_FRAME_SIZE;
+    const uint32_t periodMicroSec = ( 1 + userconf_IMU_FIFO_SAMPLE_RATE_DIVIDER ) * 1000000UL / GYRO_BASE_RATE_HZ;
+
+    uint32_t frame = 0;
+
+    while ( frame < frameCount )
+    {
+        uint32_t burst = frameCount - frame;
+        if ( burst > FIFO_BURST_FRAMES )
+        {
+            burst = FIFO_BURST_FRAMES;
+        }
+
+        if ( IMU_OK != icm20948_get_burst_data ( FIFO_R_W, burst * IMU_SENSOR_FIFO_FRAME_SIZE, frames ) )
+        {
+            return IMU_ERR;
+        }
+
+        for ( uint32_t i = 0; i < burst; i++, frame++ )
+        {
+            // unpacked straight into the ring, a frame that finds it full is lost
+            IMUSensorData * sample = imu_sample_ring_reserve ( &s_ring );
+            if ( sample == NULL )
+            {
+                continue;
+            }
+
+            prv_imu_sensor_unpack_frame ( &frames [ i * IMU_SENSOR_FIFO_FRAME_SIZE ], sample );
+            sample->timestamp = timestamp - ( frameCount - 1 - frame ) * periodMicroSec / 1000;
+
+            imu_sample_ring_commit ( &s_ring );
+        }
+    }
+
+    return IMU_OK;
+}
+#endif
+
 
 int select_active_bank ( int bank )
 {
@@ -471,14 +725,7 @@ bool imu_sensor_test ()
     int8_t result_flag;
     IMUSensorData dataStruct = {};
 
-    result_flag = icm20948_get_accel_data (&dataStruct);
-    if(IMU_OK != result_flag)
-    {
-        DISPLAY_LINE( "[ERROR]: IMU sensor acquisition failed \r\n");
-        return false;
-    }
-
-    result_flag = icm20948_get_gyro_data (&dataStruct);
+    result_flag = icm20948_get_accel_gyro_data (&dataStruct);
     if(IMU_OK != result_flag)
     {
         DISPLAY_LINE( "[ERROR]: IMU sensor acquisition failed \r\n");
@@ -488,13 +735,13 @@ bool imu_sensor_test ()
     char bufx[IMU_STR_VAL_LENGTH+1];
     char bufy[IMU_STR_VAL_LENGTH+1];
     char bufz[IMU_STR_VAL_LENGTH+1];
-    gcvt(dataStruct.acc_x, IMU_STR_VAL_LENGTH, bufx);
-    gcvt(dataStruct.acc_y, IMU_STR_VAL_LENGTH, bufy);
-    gcvt(dataStruct.acc_z, IMU_STR_VAL_LENGTH, bufz);
+    gcvt(imu_sensor_acc2g(dataStruct.acc_x), IMU_STR_VAL_LENGTH, bufx);
+    gcvt(imu_sensor_acc2g(dataStruct.acc_y), IMU_STR_VAL_LENGTH, bufy);
+    gcvt(imu_sensor_acc2g(dataStruct.acc_z), IMU_STR_VAL_LENGTH, bufz);
     DISPLAY_LINE( "[SUCCESS]: Accel value (x,y,z): (%s, %s, %s) \r\n", bufx, bufy, bufz);
-    gcvt(dataStruct.gyro_x, IMU_STR_VAL_LENGTH, bufx);
-    gcvt(dataStruct.gyro_y, IMU_STR_VAL_LENGTH, bufy);
-    gcvt(dataStruct.gyro_z, IMU_STR_VAL_LENGTH, bufz);
+    gcvt(imu_sensor_rot2deg_per_sec(dataStruct.gyro_x), IMU_STR_VAL_LENGTH, bufx);
+    gcvt(imu_sensor_rot2deg_per_sec(dataStruct.gyro_y), IMU_STR_VAL_LENGTH, bufy);
+    gcvt(imu_sensor_rot2deg_per_sec(dataStruct.gyro_z), IMU_STR_VAL_LENGTH, bufz);
     DISPLAY_LINE( "[SUCCESS]: Gyro value (x,y,z): (%s, %s, %s) \r\n", bufx, bufy, bufz);
 
     return true;
@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include "board/components/pressure_sensor.h"
 #include "board/board.h"
+#include "board/hardware_definitions.h"
 
 #include "board-hardware-drivers/BMI08x-Sensor-API/Inc/bmp3.h"
 #include <cmsis_os.h>
@@ -28,6 +29,7 @@
 #include "core/system_configuration.h"
 #include "protocols/UART.h"
 #include "utilities/common.h"
+#include "utilities/spsc_ring.h"
 
 #include "event-detection/event_detector.h"
 
@@ -36,6 +38,9 @@
 
 #define TIMEOUT             100 // milliseconds
 
+// longest wait for a data ready before the task checks whether it was stopped
+#define DATA_READY_TIMEOUT_MS   100
+
 #define GND_ALT             0
 #define GND_PRES            101325
 
@@ -58,10 +63,16 @@ static PressureSensorTaskState prvController     = {};
 
 static char buf[128];
 
-static QueueHandle_t s_queue = {0};
+SPSC_RING( pressure_sample, PressureSensorData, PRESSURE_SENSOR_RING_LENGTH )
+
+// filled by the pressure task, emptied by pressure_sensor_read
+static pressure_sample_ring s_ring;
 static struct bmp3_data s_data = {0};
 static uint8_t s_desired_processing_data_rate = 50;
 
+// board_get_timestamp_us of the latest data ready
+static volatile uint32_t s_data_ready_timestamp = 0;
+
 static void     delay_ms                    (uint32_t period_ms);
 static int8_t   spi_reg_write               (uint8_t cs, uint8_t reg_addr, uint8_t *reg_data, uint16_t length);
 static int8_t   spi_reg_read                (uint8_t cs, uint8_t reg_addr, uint8_t *reg_data, uint16_t length);
@@ -119,14 +130,19 @@ int pressure_sensor_configure ( PressureSensorConfiguration * parameters )
     s_device.settings.odr_filter.temp_os    = s_current_configuration.temperature_oversampling;
     s_device.settings.odr_filter.odr        = s_current_configuration.output_data_rate;
     s_device.settings.odr_filter.iir_filter = s_current_configuration.infinite_impulse_response_filter_coefficient;
+    /* Raise INT on every new measurement, a pulse that needs no clearing */
+    s_device.settings.int_settings.drdy_en      = BMP3_ENABLE;
+    s_device.settings.int_settings.output_mode  = BMP3_INT_PIN_PUSH_PULL;
+    s_device.settings.int_settings.level        = BMP3_INT_PIN_ACTIVE_HIGH;
+    s_device.settings.int_settings.latch        = BMP3_INT_PIN_NON_LATCH;
     /* Assign the settings which needs to be set in the sensor */
     settings_sel = BMP3_PRESS_EN_SEL | BMP3_TEMP_EN_SEL | BMP3_PRESS_OS_SEL | BMP3_TEMP_OS_SEL | BMP3_ODR_SEL |
-                   BMP3_IIR_FILTER_SEL;
+                   BMP3_IIR_FILTER_SEL | BMP3_DRDY_EN_SEL | BMP3_OUTPUT_MODE_SEL | BMP3_LEVEL_SEL | BMP3_LATCH_SEL;
 
     result = bmp3_set_sensor_settings ( settings_sel, &s_device );
-    if ( BMP3_OK == result )
+    if ( BMP3_OK != result )
     {
-        return BMP3_OK;
+        return result;
     }
 
     /* Set the power mode to normal mode */
@@ -156,13 +172,19 @@ int pressure_sensor_init ( )
         return PRESS_SENSOR_ERR;
     }
 
-    s_queue = xQueueCreate( 10, sizeof ( PressureSensorData ) );
-    if ( s_queue == NULL )
-    {
-        return PRESS_SENSOR_ERR;
-    }
+    // the data ready of the sensor, see pressure_sensor_configure
+    __HAL_RCC_GPIOC_CLK_ENABLE ( );
+    GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+    GPIO_InitStruct.Pin     = PRES_INT_PIN;
+    GPIO_InitStruct.Mode    = GPIO_MODE_IT_RISING;
+    GPIO_InitStruct.Pull    = GPIO_NOPULL;
+    HAL_GPIO_Init ( PRES_INT_PORT, &GPIO_InitStruct );
+
+    // shared with the IMU, the handler drops the edges while no task is running
+    HAL_NVIC_SetPriority ( EXTI9_5_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0 );
+    HAL_NVIC_EnableIRQ ( EXTI9_5_IRQn );
 
-    vQueueAddToRegistry ( s_queue, "bmp3_queue" );
+    pressure_sample_ring_reset ( &s_ring );
 
     prvController.isInitialized = true;
 
@@ -177,8 +199,8 @@ float pressure_sensor_calculate_altitude ( PressureSensorData * reading, float g
         return 0.0;
     }
 
-    float p_term = powf ( ( ground_pressure / ( reading->pressure / 100 ) ), ( 1 / 5.257F ) ) - 1;
-    float t_term = ( reading->temperature / 100 ) + 273.15F;
+    float p_term = powf ( ( ground_pressure / ( reading->pressure * PRESSURE_SENSOR_PASCAL_PER_COUNT ) ), ( 1 / 5.257F ) ) - 1;
+    float t_term = ( reading->temperature * PRESSURE_SENSOR_CELSIUS_PER_COUNT ) + 273.15F;
     return ( uint32_t ) ( p_term * t_term ) / 0.0065F + ground_altitude;
 }
 
@@ -195,33 +217,58 @@ static void prv_pressure_sensor_controller_task ( void * pvParams )
     /* Variable used to store the compensated data */
     PressureSensorData dataStruct;
 
-    TickType_t start_timestamp = xTaskGetTickCount ( );
+    BoardMillisecondClock clock;
+    board_ms_clock_start ( &clock );
 
     int8_t result_flag;
     prvController.isRunning = true;
 
     while ( prvController.isRunning )
     {
+        // asleep until the sensor has a measurement, at its own output data rate
+        if ( 0 == ulTaskNotifyTake ( pdTRUE, pdMS_TO_TICKS ( DATA_READY_TIMEOUT_MS ) ) )
+        {
+            continue;
+        }
+
         result_flag = get_sensor_data ( &s_data );
         if ( BMP3_E_NULL_PTR == result_flag )
         {
             continue;
         }
 
-        dataStruct.pressure    = s_data.pressure;
-        dataStruct.temperature = s_data.temperature;
-        dataStruct.timestamp   = xTaskGetTickCount ( ) - start_timestamp;
+        // the fixed point output of the integer compensation is the sample, it is not converted on the flight computer
+        dataStruct.pressure    = ( int32_t ) s_data.pressure;
+        dataStruct.temperature = ( int32_t ) s_data.temperature;
+        // in ms, from the time of the interrupt rather than of the read
+        dataStruct.timestamp   = board_ms_clock_update ( &clock, s_data_ready_timestamp );
 
         pressure_sensor_add_measurement ( &dataStruct );
 
-        vTaskDelayUntil ( &dataStruct.timestamp, s_desired_processing_data_rate );
         memset ( &s_data, 0, sizeof ( struct bmp3_data ) );
     }
 
     prvController.isRunning = false;
 
     DISPLAY_LINE( "[INFO]: Pressure sensor task has been stopped");
-    vTaskDelete( prvController.taskHandle );
+    xTaskHandle self = prvController.taskHandle;
+    prvController.taskHandle = NULL;
+    vTaskDelete( self );
+}
+
+void pressure_sensor_data_ready_isr ( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if ( prvController.taskHandle == NULL )
+    {
+        return;
+    }
+
+    s_data_ready_timestamp = board_get_timestamp_us ( );
+
+    vTaskNotifyGiveFromISR ( prvController.taskHandle, &xHigherPriorityTaskWoken );
+    portYIELD_FROM_ISR ( xHigherPriorityTaskWoken );
 }
 
 int pressure_sensor_start ( void * const pvParameters )
@@ -405,7 +452,7 @@ bool pressure_sensor_test ( void )
 
 bool pressure_sensor_read ( PressureSensorData * buffer )
 {
-    return pdPASS == xQueueReceive( s_queue, buffer, 0 );
+    return pressure_sample_ring_pop ( &s_ring, buffer );
 }
 
 
@@ -424,7 +471,7 @@ void pressure_sensor_data_pack ( PressureSensorData bmp_reading, float ground_pr
 
 bool pressure_sensor_add_measurement ( PressureSensorData * _data )
 {
-    return pdTRUE == xQueueSend( s_queue, (void *) _data, 0 );
+    return pressure_sample_ring_push ( &s_ring, _data );
 }
 
 PressureSensorConfiguration pressure_sensor_get_default_configuration ( )
@@ -10,6 +10,9 @@ extern "C" {
 #include <stdbool.h>
 #include "protocols/UART.h"
 
+// readings handed to pressure_sensor_read, a power of two
+#define PRESSURE_SENSOR_RING_LENGTH     16
+
 
 typedef struct pressure_sensor_configuration
 {
@@ -31,14 +34,19 @@ typedef union
 } PressureSensorConfigurationU;
 
 
+// The readings are the fixed point output of the integer compensation of the BMP3, logged as they are and converted
+// only where a unit is needed
+#define PRESSURE_SENSOR_PASCAL_PER_COUNT    0.01f
+#define PRESSURE_SENSOR_CELSIUS_PER_COUNT   0.01f
+
 //Groups a time stamp with the reading.
 typedef struct pressure_sensor_data
 {
-    uint32_t timestamp; // time of sensor reading in ticks.
-    /*! Compensated temperature */
-    float temperature;
-    /*! Compensated pressure */
-    float pressure;
+    uint32_t timestamp; // time of sensor reading in ms since board_init ( ).
+    /*! Compensated temperature [0.01 deg C] */
+    int32_t temperature;
+    /*! Compensated pressure [0.01 Pa] */
+    int32_t pressure;
 } PressureSensorData;
 
 typedef union
@@ -61,6 +69,9 @@ bool    pressure_sensor_add_measurement     ( PressureSensorData * _data );
 bool    pressure_sensor_is_running          ();
 void    pressure_sensor_stop                ();
 
+// to be called from the EXTI interrupt of PRES_INT_PIN: stamps the time of the measurement and wakes the task
+void    pressure_sensor_data_ready_isr      ( void );
+
 
 PressureSensorConfiguration pressure_sensor_get_default_configuration ( );
 PressureSensorConfiguration pressure_sensor_get_current_configuration ( );
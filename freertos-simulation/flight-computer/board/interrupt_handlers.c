@@ -13,9 +13,20 @@
 
 #include "board/board.h"
 #include "board/components/buzzer.h"
+#if (userconf_FREE_RTOS_SIMULATOR_MODE_ON == 0)
+#include "board/components/bmi088_imu_sensor.h"
+#include "board/components/pressure_sensor.h"
+#include "board/hardware_definitions.h"
+#endif
 
 /* External variables --------------------------------------------------------*/
 extern TIM_HandleTypeDef htim1;
+#if (userconf_FREE_RTOS_SIMULATOR_MODE_ON == 0)
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
+extern DMA_HandleTypeDef hdma_spi3_rx;
+extern DMA_HandleTypeDef hdma_spi3_tx;
+#endif
 
 /* USER CODE BEGIN EV */
 
@@ -172,3 +183,61 @@ void TIM1_UP_TIM10_IRQHandler(void)
 
     /* USER CODE END TIM1_UP_TIM10_IRQn 1 */
 }
+
+#if (userconf_FREE_RTOS_SIMULATOR_MODE_ON == 0)
+/**
+  * @brief This function handles EXTI line[9:5] interrupts.
+  */
+void EXTI9_5_IRQHandler(void)
+{
+    HAL_GPIO_EXTI_IRQHandler(IMU_ACC_INT_PIN);
+    HAL_GPIO_EXTI_IRQHandler(PRES_INT_PIN);
+}
+
+/**
+  * @brief Dispatches the data ready lines of the sensors.
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if ( GPIO_Pin == IMU_ACC_INT_PIN )
+    {
+        bmi088_imu_sensor_data_ready_isr ( );
+    }
+    else if ( GPIO_Pin == PRES_INT_PIN )
+    {
+        pressure_sensor_data_ready_isr ( );
+    }
+}
+
+/**
+  * @brief This function handles DMA2 stream0 global interrupt, SPI1 RX.
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi1_rx);
+}
+
+/**
+  * @brief This function handles DMA2 stream3 global interrupt, SPI1 TX.
+  */
+void DMA2_Stream3_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi1_tx);
+}
+
+/**
+  * @brief This function handles DMA1 stream0 global interrupt, SPI3 RX.
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi3_rx);
+}
+
+/**
+  * @brief This function handles DMA1 stream5 global interrupt, SPI3 TX.
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi3_tx);
+}
+#endif
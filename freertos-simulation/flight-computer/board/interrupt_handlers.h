@@ -13,6 +13,11 @@ void BusFault_Handler ( void );
 void UsageFault_Handler ( void );
 void DebugMon_Handler ( void );
 void TIM1_UP_TIM10_IRQHandler ( void );
+void EXTI9_5_IRQHandler ( void );
+void DMA2_Stream0_IRQHandler ( void );
+void DMA2_Stream3_IRQHandler ( void );
+void DMA1_Stream0_IRQHandler ( void );
+void DMA1_Stream5_IRQHandler ( void );
 
 
 #endif //AVIONICS_INTERRUPT_HANDLERS_H
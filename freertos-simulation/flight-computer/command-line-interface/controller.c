@@ -114,6 +114,7 @@ static const CLI_Command_Definition_t xConfigureCommand =
         "[set_accel_odr]            - Set accelerometer odr (12,25,50,100,200,400,800,1600)\r\n "
         "[set_gyro_bw]              - Set gyro bandwidth and odr (32_100,64_200,12_100,23_200,47_400,116_1000,230_2000,532_2000)\t\t\t      [Enter the number (1-8) for the option to select]\r\n "
         "[set_gyro_range]           - Set gyro range (125,250,500,1000,2000)\r\n "
+        "[set_imu_backend]          - Set IMU acquisition (0: ICM-20948, 1: BMI088 synchronized at 2kHz)\r\n "
         "[set_press_odr]            - Set BMP388 odr (1,12,25,50,100,200) \r\n "
         "[set_press_os]             - Set pressure oversampling (0,2,4,8,16,32) \r\n "
         "[set_temp_os]              - Set temperature oversampling (0,2,4,8,16,32) \r\n "
@@ -155,7 +156,13 @@ static const CLI_Command_Definition_t xMemoryCommand =
         "[read_cont_index]          - Read Continuity Status entry with a specified index.\r\n "
         "[read_flight_event_index]  - Read Flight Event entry with a specified index.\r\n "
         "[read_configuration]       - Read Configuration entry.\r\n "
-        "[stats]                    - List Data Sections and show their info.\r\n "
+        "[read_range]               - Dump the entries of a time range (<sector>-<begin>-<end>).\r\n "
+        "[stats]                    - List Data Sections, their info and the storage throughput.\r\n "
+        "[plan]                     - Plan the data section sizes from the logging rates (plan=apply to store them).\r\n "
+        "[mode]                     - Show or set the logging mode (mode=linear|circular, data sections empty).\r\n "
+        "[sessions]                 - List the recorded sessions.\r\n "
+        "[session]                  - Limit the reads to a session (session=<index>|all).\r\n "
+        "[summary]                  - Show the flight summary (summary=previous for the last flight).\r\n "
         "[read]                     - Read 256 bytes (hex address 0-7FFFFF).\r\n "
         "[scan]                     - Scan Memory\r\n "
         "[erase_data_section]       - Erase data section\r\n "
@@ -194,7 +201,8 @@ static const CLI_Command_Definition_t xSystemCtlCommand =
         "[fl]               - flight controller <enable>\\<disable> or <1>\\<0>.\r\n "
         "[imu]              - IMU sensor <enable>\\<disable> or <1>\\<0>.\r\n "
         "[press]            - pressure sensor <enable>\\<disable> or <1>\\<0>.\r\n "
-        "[df]               - datafeeder <enable>\\<disable> or <1>\\<0>.\r\n\n",
+        "[df]               - datafeeder <enable>\\<disable> or <1>\\<0>.\r\n "
+        "[synth]            - synthetic flight into the datafeeder, <IMU rate in Hz> or <0> to stop.\r\n\n",
 
         prvSystemCtlCommand, /* The function to run. */
         -1 /* No parameters are expected. */
@@ -25,6 +25,7 @@ static bool cli_tools_configure_set_accel_odr                  (char* pcWriteBuf
 static bool cli_tools_configure_set_gyro_bw                    (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 static bool cli_tools_configure_set_gyro_bw                    (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 static bool cli_tools_configure_set_gyro_range                 (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
+static bool cli_tools_configure_set_imu_backend                (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 static bool cli_tools_configure_set_press_odr                  (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 static bool cli_tools_configure_set_press_os                   (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 static bool cli_tools_configure_set_temp_os                    (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
@@ -80,6 +81,11 @@ bool cli_tools_configure ( char * pcWriteBuffer, size_t xWriteBufferLen, const c
         return cli_tools_configure_set_gyro_range ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
     }
 
+    if ( strcmp ( cmd_option, "set_imu_backend" ) == 0 )
+    {
+        return cli_tools_configure_set_imu_backend ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
+    }
+
     if ( strcmp ( cmd_option, "set_press_odr" ) == 0 )
     {
         return cli_tools_configure_set_press_odr ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
@@ -458,6 +464,32 @@ bool cli_tools_configure_set_gyro_range ( char * pcWriteBuffer, size_t xWriteBuf
 
 //Pressure config-------------------------------------------------------------------------------------------------------
 
+bool cli_tools_configure_set_imu_backend ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    const char * cmd_option = "set_imu_backend";
+    uint8_t value = atoi ( str_option_arg );
+    FlightSystemConfiguration configuration;
+
+    switch ( value )
+    {
+        case IMU_SENSOR_BACKEND_ICM20948:
+        case IMU_SENSOR_BACKEND_BMI088_DATA_SYNC:
+            if ( MEM_OK == memory_manager_get_system_configurations ( &configuration ) )
+            {
+                configuration.imu_sensor_configuration.backend = value;
+                memory_manager_set_system_configurations(&configuration);
+                sprintf ( pcWriteBuffer, "Setting IMU backend to %d\n", value );
+                return true;
+            }
+
+            sprintf ( pcWriteBuffer, "[%s]: Failed to read system configurations! Abort...\n", cmd_option );
+            return false;
+        default:
+            sprintf ( pcWriteBuffer, "[%s]: Argument [%s] is invalid.", cmd_option, str_option_arg );
+            return false;
+    }
+}
+
 bool cli_tools_configure_set_press_odr ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
 {
     const char * cmd_option = "set_press_odr";
@@ -28,6 +28,12 @@ static bool cli_tools_mem_read_cont_index                (char* pcWriteBuffer, s
 static bool cli_tools_mem_read_flight_event_index        (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 static bool cli_tools_mem_read_configuration_index       (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 static bool cli_tools_mem_stats                          (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
+static bool cli_tools_mem_plan                           (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
+static bool cli_tools_mem_read_range                     (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
+static bool cli_tools_mem_mode                           (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
+static bool cli_tools_mem_sessions                       (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
+static bool cli_tools_mem_session                        (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
+static bool cli_tools_mem_summary                        (char* pcWriteBuffer, size_t xWriteBufferLen, const char* str_option_arg);
 
 
 bool cli_tools_mem ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * cmd_option, const char * str_option_arg )
@@ -68,6 +74,36 @@ bool cli_tools_mem ( char * pcWriteBuffer, size_t xWriteBufferLen, const char *
         return cli_tools_mem_stats ( pcWriteBuffer, xWriteBufferLen, NULL );
     }
 
+    if ( strcmp ( cmd_option, "plan" ) == 0 )
+    {
+        return cli_tools_mem_plan ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
+    }
+
+    if ( strcmp ( cmd_option, "read_range" ) == 0 )
+    {
+        return cli_tools_mem_read_range ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
+    }
+
+    if ( strcmp ( cmd_option, "mode" ) == 0 )
+    {
+        return cli_tools_mem_mode ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
+    }
+
+    if ( strcmp ( cmd_option, "sessions" ) == 0 )
+    {
+        return cli_tools_mem_sessions ( pcWriteBuffer, xWriteBufferLen, NULL );
+    }
+
+    if ( strcmp ( cmd_option, "session" ) == 0 )
+    {
+        return cli_tools_mem_session ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
+    }
+
+    if ( strcmp ( cmd_option, "summary" ) == 0 )
+    {
+        return cli_tools_mem_summary ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
+    }
+
     if ( strcmp ( cmd_option, "read" ) == 0 )
     {
         return cli_tools_mem_read ( pcWriteBuffer, xWriteBufferLen, NULL );
@@ -156,50 +192,10 @@ bool cli_tools_mem_scan ( char * pcWriteBuffer, size_t xWriteBufferLen, const ch
 
 bool cli_tools_mem_erase_data_section ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
 {
-    uint8_t dataRX [ FLASH_PAGE_SIZE ];
-
     sprintf ( pcWriteBuffer, "Erasing data section ...\r\n" );
 
-    uint32_t    address = FLASH_START_ADDRESS;
-    FlashStatus stat    = FLASH_ERR;
-
-    while ( address <= FLASH_END_ADDRESS )
-    {
-
-        //if(address > FLASH_PARAM_END_ADDRESS)
-        {
-            // stat = flash_erase_sector(address);
-            // address += FLASH_SECTOR_SIZE;
-        }
-        //else
-        {
-            // stat = flash_erase_param_sector(address);
-            //address += FLASH_PARAM_SECTOR_SIZE;
-        }
-
-//        HAL_GPIO_TogglePin(USR_LED_PORT,USR_LED_PIN);
-        sprintf ( pcWriteBuffer, "Erasing sector %lu ...\r\n", address );
-    }
-
-    flash_read ( FLASH_START_ADDRESS, dataRX, 256 );
-    uint16_t empty = 0xFFFF;
-    int      i;
-    for ( i = 0; i < 256; i++ )
-    {
-
-        if ( dataRX[ i ] != 0xFF )
-        {
-            empty--;
-        }
-    }
-
-    if ( empty == 0xFFFF )
-    {
-
-        sprintf ( pcWriteBuffer, "Flash Erased Success!\r\n" );
-    }
-
-    if ( stat == FLASH_OK )
+    // through the memory manager, which keeps the system sectors and forgets its write cursors
+    if ( MEM_OK == memory_manager_erase_data_section ( ) )
     {
         sprintf ( pcWriteBuffer, "Success!\r\n" );
     }
@@ -252,7 +248,7 @@ static bool cli_tools_mem_read_imu_index ( char * pcWriteBuffer, size_t xWriteBu
     IMUDataU dst = { };
     if ( MEM_OK == memory_manager_get_single_data_entry ( MemoryUserDataSectorGyro, &dst, value ) )
     {
-        sprintf ( pcWriteBuffer, "[%s]: timestamp=%lu: gyro=[%f, %f, %f]\n", cmd_option, dst.values.timestamp, dst.values.data[ 0 ], dst.values.data[ 1 ], dst.values.data[ 2 ] );
+        sprintf ( pcWriteBuffer, "[%s]: timestamp=%lu: gyro=[%i, %i, %i]\n", cmd_option, dst.values.timestamp, dst.values.data[ 0 ], dst.values.data[ 1 ], dst.values.data[ 2 ] );
 
         return true;
     }
@@ -260,7 +256,7 @@ static bool cli_tools_mem_read_imu_index ( char * pcWriteBuffer, size_t xWriteBu
     memset ( &dst, 0, sizeof ( IMUDataU ) );
     if ( MEM_OK == memory_manager_get_single_data_entry ( MemoryUserDataSectorAccel, &dst, value ) )
     {
-        sprintf ( pcWriteBuffer, "[%s]: timestamp=%lu: acc=[%f, %f, %f]\n", cmd_option, dst.values.timestamp, dst.values.data[ 0 ], dst.values.data[ 1 ], dst.values.data[ 2 ] );
+        sprintf ( pcWriteBuffer, "[%s]: timestamp=%lu: acc=[%i, %i, %i]\n", cmd_option, dst.values.timestamp, dst.values.data[ 0 ], dst.values.data[ 1 ], dst.values.data[ 2 ] );
 
         return true;
     }
@@ -278,7 +274,7 @@ static bool cli_tools_mem_read_press_index ( char * pcWriteBuffer, size_t xWrite
     PressureDataU dst = { };
     if ( MEM_OK == memory_manager_get_single_data_entry ( MemoryUserDataSectorPressure, &dst, value ) )
     {
-        sprintf ( pcWriteBuffer, "[%s]: timestamp=%lu, pressure=%f\n", cmd_option, dst.values.timestamp, dst.values.data );
+        sprintf ( pcWriteBuffer, "[%s]: timestamp=%lu, pressure=%li\n", cmd_option, dst.values.timestamp, ( long ) dst.values.data );
         return true;
     }
 
@@ -363,6 +359,8 @@ static bool cli_tools_mem_read_configuration_index ( char * pcWriteBuffer, size_
         " e_match_line_keep_active_for            = %i\r\n"
         " imu_data_needs_to_be_converted          = %i\r\n"
         " pressure_data_needs_to_be_converted     = %i\r\n"
+        " imu_acc_g_per_count                     = %f\r\n"
+        " imu_gyro_deg_per_sec_per_count          = %f\r\n"
         "\r\n"
         "IMU:\r\n"
         " accel_bandwidth        = %i\r\n"
@@ -373,6 +371,7 @@ static bool cli_tools_mem_read_configuration_index ( char * pcWriteBuffer, size_
         " gyro_output_data_rate  = %i\r\n"
         " gyro_range             = %i\r\n"
         " gyro_power             = %i\r\n"
+        " backend                = %i\r\n"
         "\r\n"
         "Pressure:\r\n"
         " output_data_rate                             = %i\r\n"
@@ -413,6 +412,8 @@ static bool cli_tools_mem_read_configuration_index ( char * pcWriteBuffer, size_
         dst.values.system.e_match_line_keep_active_for,
         dst.values.system.imu_data_needs_to_be_converted,
         dst.values.system.pressure_data_needs_to_be_converted,
+        dst.values.system.imu_acc_g_per_count,
+        dst.values.system.imu_gyro_deg_per_sec_per_count,
 
         dst.values.system.imu_sensor_configuration.accel_bandwidth,
         dst.values.system.imu_sensor_configuration.accel_output_data_rate,
@@ -422,6 +423,7 @@ static bool cli_tools_mem_read_configuration_index ( char * pcWriteBuffer, size_
         dst.values.system.imu_sensor_configuration.gyro_output_data_rate,
         dst.values.system.imu_sensor_configuration.gyro_range,
         dst.values.system.imu_sensor_configuration.gyro_power,
+        dst.values.system.imu_sensor_configuration.backend,
 
         dst.values.system.pressure_sensor_configuration.output_data_rate,
         dst.values.system.pressure_sensor_configuration.temperature_oversampling,
@@ -454,4 +456,229 @@ static bool cli_tools_mem_stats ( char * pcWriteBuffer, size_t xWriteBufferLen,
     return false;
 }
 
+static bool cli_tools_mem_plan ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    const char * cmd_option = "plan";
+    bool apply = false;
+
+    if ( str_option_arg != NULL && strlen ( str_option_arg ) > 0 )
+    {
+        if ( strcmp ( str_option_arg, "apply" ) != 0 )
+        {
+            sprintf ( pcWriteBuffer, "[%s]: Argument [%s] is not recognized\r\n", cmd_option, str_option_arg );
+            return false;
+        }
+
+        apply = true;
+    }
+
+    if ( MEM_OK == memory_manager_get_layout_plan ( pcWriteBuffer, xWriteBufferLen, apply ) )
+    {
+        return true;
+    }
+
+    return false;
+}
+
+// mode=linear|circular, only while the data sections are empty. Without an argument prints the current mode
+static bool cli_tools_mem_mode ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    const char * cmd_option = "mode";
+    MemoryLoggingMode mode;
+
+    if ( str_option_arg == NULL || strlen ( str_option_arg ) == 0 )
+    {
+        sprintf ( pcWriteBuffer, "[%s]: %s\r\n", cmd_option, memory_manager_get_logging_mode ( ) == MemoryLoggingModeCircular ? "circular" : "linear" );
+        return true;
+    }
+
+    if ( strcmp ( str_option_arg, "linear" ) == 0 )
+    {
+        mode = MemoryLoggingModeLinear;
+    }
+    else if ( strcmp ( str_option_arg, "circular" ) == 0 )
+    {
+        mode = MemoryLoggingModeCircular;
+    }
+    else
+    {
+        sprintf ( pcWriteBuffer, "[%s]: Argument [%s] is not recognized\r\n", cmd_option, str_option_arg );
+        return false;
+    }
+
+    if ( MEM_OK != memory_manager_set_logging_mode ( mode ) )
+    {
+        sprintf ( pcWriteBuffer, "[%s]: Failure! The mode can only be changed while the data sections are empty\r\n", cmd_option );
+        return false;
+    }
+
+    sprintf ( pcWriteBuffer, "[%s]: %s\r\n", cmd_option, str_option_arg );
+    return true;
+}
+
+static bool cli_tools_mem_sessions ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    if ( MEM_OK == memory_manager_get_sessions ( pcWriteBuffer, xWriteBufferLen ) )
+    {
+        return true;
+    }
+
+    sprintf ( pcWriteBuffer, "Failure!\r\n" );
+    return false;
+}
+
+// session=<index> limits the reads (read_range, read_*_index) to a single session, session=all lifts the limit
+static bool cli_tools_mem_session ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    const char * cmd_option = "session";
+    uint32_t session = MEMORY_SESSION_ALL;
+
+    if ( str_option_arg == NULL || strlen ( str_option_arg ) == 0 )
+    {
+        sprintf ( pcWriteBuffer, "[%s]: Argument is missing (session=<index> or session=all)\r\n", cmd_option );
+        return false;
+    }
+
+    if ( strcmp ( str_option_arg, "all" ) != 0 )
+    {
+        char * end = NULL;
+        session = strtoul ( str_option_arg, &end, 10 );
+        if ( end == str_option_arg || *end != '\0' )
+        {
+            sprintf ( pcWriteBuffer, "[%s]: Argument [%s] is not recognized\r\n", cmd_option, str_option_arg );
+            return false;
+        }
+    }
+
+    if ( MEM_OK != memory_manager_select_session ( session ) )
+    {
+        sprintf ( pcWriteBuffer, "[%s]: Failure! There are %lu sessions\r\n", cmd_option, ( unsigned long ) memory_manager_get_session_count ( ) );
+        return false;
+    }
+
+    sprintf ( pcWriteBuffer, "[%s]: %s\r\n", cmd_option, str_option_arg );
+    return true;
+}
+
+// summary prints the flight summary of the current flight, summary=previous the one of the flight before the power-on
+static bool cli_tools_mem_summary ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    const char * cmd_option = "summary";
+    bool previous = false;
+
+    if ( str_option_arg != NULL && strlen ( str_option_arg ) != 0 )
+    {
+        if ( strcmp ( str_option_arg, "previous" ) != 0 )
+        {
+            sprintf ( pcWriteBuffer, "[%s]: Argument [%s] is not recognized\r\n", cmd_option, str_option_arg );
+            return false;
+        }
+
+        previous = true;
+    }
+
+    if ( MEM_OK == memory_manager_get_summary ( pcWriteBuffer, xWriteBufferLen, previous ) )
+    {
+        return true;
+    }
+
+    sprintf ( pcWriteBuffer, "[%s]: Failure!\r\n", cmd_option );
+    return false;
+}
+
+// prints every entry of the range as soon as it is read, the range can be far larger than the command output buffer
+static bool cli_tools_mem_dump_entry ( MemorySector sector, const uint8_t * entry, void * arg )
+{
+    uint32_t * count = ( uint32_t * ) arg;
+    ( *count )++;
+
+    switch ( sector )
+    {
+        case MemoryUserDataSectorGyro:
+        case MemoryUserDataSectorAccel:
+        case MemoryUserDataSectorMag:
+        {
+            IMUDataU imu;
+            memcpy ( imu.bytes, entry, sizeof ( IMUDataU ) );
+            // in counts, the scale is in the system configuration
+            DISPLAY_LINE ( "%lu,%i,%i,%i", ( unsigned long ) imu.values.timestamp, imu.values.data[ 0 ], imu.values.data[ 1 ], imu.values.data[ 2 ] );
+            break;
+        }
+        case MemoryUserDataSectorPressure:
+        case MemoryUserDataSectorTemperature:
+        {
+            PressureDataU pressure;
+            memcpy ( pressure.bytes, entry, sizeof ( PressureDataU ) );
+            DISPLAY_LINE ( "%lu,%li", ( unsigned long ) pressure.values.timestamp, ( long ) pressure.values.data );
+            break;
+        }
+        case MemoryUserDataSectorContinuity:
+        {
+            ContinuityU continuity;
+            memcpy ( continuity.bytes, entry, sizeof ( ContinuityU ) );
+            DISPLAY_LINE ( "%lu,%i,%i", ( unsigned long ) continuity.values.timestamp, continuity.values.status[ 0 ], continuity.values.status[ 1 ] );
+            break;
+        }
+        case MemoryUserDataSectorFlightEvent:
+        {
+            FlightEventU event;
+            memcpy ( event.bytes, entry, sizeof ( FlightEventU ) );
+            DISPLAY_LINE ( "%lu,%i", ( unsigned long ) event.values.timestamp, event.values.status );
+            break;
+        }
+        default:
+            break;
+    }
+
+    return true;
+}
+
+// read_range=<sector>-<begin>-<end>, e.g. read_range=accel-1000-5000 dumps the accelerometer entries of that time range
+static bool cli_tools_mem_read_range ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    const char * cmd_option = "read_range";
+
+    static const struct
+    {
+        const char * name;
+        MemorySector sector;
+    } sectors [ ] = {
+        { "gyro",  MemoryUserDataSectorGyro        },
+        { "accel", MemoryUserDataSectorAccel       },
+        { "mag",   MemoryUserDataSectorMag         },
+        { "press", MemoryUserDataSectorPressure    },
+        { "temp",  MemoryUserDataSectorTemperature },
+        { "cont",  MemoryUserDataSectorContinuity  },
+        { "event", MemoryUserDataSectorFlightEvent },
+    };
+
+    char          name [ 16 ] = { 0 };
+    unsigned long begin       = 0;
+    unsigned long end         = 0;
+
+    if ( str_option_arg == NULL || sscanf ( str_option_arg, "%15[a-z]-%lu-%lu", name, &begin, &end ) != 3 )
+    {
+        sprintf ( pcWriteBuffer, "[%s]: Argument [%s] is not <sector>-<begin>-<end>\r\n", cmd_option, str_option_arg );
+        return false;
+    }
+
+    for ( size_t i = 0; i < sizeof ( sectors ) / sizeof ( sectors [ 0 ] ); i++ )
+    {
+        if ( strcmp ( name, sectors[ i ].name ) == 0 )
+        {
+            uint32_t count = 0;
+            if ( MEM_OK != memory_manager_read_range ( sectors[ i ].sector, begin, end, cli_tools_mem_dump_entry, &count ) )
+            {
+                sprintf ( pcWriteBuffer, "Failure!\r\n" );
+                return false;
+            }
+
+            sprintf ( pcWriteBuffer, "[%s]: %lu entries of [%s] between %lu and %lu\r\n", cmd_option, ( unsigned long ) count, name, begin, end );
+            return true;
+        }
+    }
+
+    sprintf ( pcWriteBuffer, "[%s]: Sector [%s] is not one of gyro, accel, mag, press, temp, cont, event\r\n", cmd_option, name );
+    return false;
+}
 
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <memory.h>
 #include "core/flight_controller.h"
 #include "board/components/icm20948_imu_sensor.h"
@@ -23,6 +24,7 @@ static bool cli_tools_sysctl_fl    ( char * pcWriteBuffer, size_t xWriteBufferLe
 static bool cli_tools_sysctl_imu   ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg );
 static bool cli_tools_sysctl_press ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg );
 static bool cli_tools_sysctl_df    ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg );
+static bool cli_tools_sysctl_synth ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg );
 
 
 bool cli_tools_sysctl ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * cmd_option, const char * str_option_arg )
@@ -53,6 +55,11 @@ bool cli_tools_sysctl ( char * pcWriteBuffer, size_t xWriteBufferLen, const char
         return cli_tools_sysctl_df ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
     }
 
+    if ( strcmp ( cmd_option, "synth" ) == 0 )
+    {
+        return cli_tools_sysctl_synth ( pcWriteBuffer, xWriteBufferLen, str_option_arg );
+    }
+
     sprintf ( pcWriteBuffer, "Command [%s] not recognized\r\n", cmd_option );
     return false;
 }
@@ -239,5 +246,47 @@ static bool cli_tools_sysctl_df ( char * pcWriteBuffer, size_t xWriteBufferLen,
 }
 
 
+static bool cli_tools_sysctl_synth ( char * pcWriteBuffer, size_t xWriteBufferLen, const char * str_option_arg )
+{
+    const char * cmd_option = "synth";
+
+#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON )
+    char * end = NULL;
+    unsigned long rate = strtoul ( str_option_arg, &end, 10 );
+    if ( end == str_option_arg || *end != '\0' )
+    {
+        sprintf ( pcWriteBuffer, "[%s]: Argument [%s] is invalid.\r\n", cmd_option, str_option_arg );
+        return false;
+    }
+
+    if ( rate == 0 )
+    {
+        data_feeder_stop ( );
+        sprintf ( pcWriteBuffer, "Success!\n" );
+        return true;
+    }
+
+    if ( data_feeder_is_running ( ) )
+    {
+        sprintf ( pcWriteBuffer, "[%s]: The datafeeder is already running.\r\n", cmd_option );
+        return false;
+    }
+
+    TrajectoryConfiguration configuration;
+    trajectory_get_default_configuration ( &configuration );
 
+    // the rate given is the one of the IMU, the barometer cannot go faster than its default
+    configuration.imu_rate = rate;
+    if ( configuration.pressure_rate > rate )
+    {
+        configuration.pressure_rate = rate;
+    }
 
+    data_feeder_start_synthetic ( &configuration );
+    sprintf ( pcWriteBuffer, "Success!\n" );
+    return true;
+#else
+    sprintf ( pcWriteBuffer, "[%s]: Synthetic flights are only available in the simulator.\r\n", cmd_option );
+    return false;
+#endif
+}
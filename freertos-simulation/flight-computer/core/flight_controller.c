@@ -20,10 +20,6 @@
 #endif
 
 
-static int prvLastRecoverContinuityStatus  [ RecoveryContinuityStatusCount  ] = { RecoveryContinuityStatusOpenCircuit,    RecoveryContinuityStatusOpenCircuit    };
-static int prvLastRecoverOverCurrentStatus [ RecoveryOverCurrentStatusCount ] = { RecoveryOverCurrentStatusNoOverCurrent, RecoveryOverCurrentStatusNoOverCurrent };
-
-
 typedef struct
 {
     uint8_t isInitialized       ;
@@ -35,9 +31,12 @@ typedef struct
 
 static FlightControllerState prvTaskState     = {};
 
+// the continuity samples are time stamped on the epoch of the sensors
+static BoardMillisecondClock prvClock         = { 0 };
+
 
 static void prv_flight_controller_task(void * pvParams);
-static void get_sensor_data_update(DataContainer * data);
+static uint32_t get_sensor_data_update(DataContainer * data, uint32_t capacity);
 FlightControllerStatus flight_controller_init(void * pvParams)
 {
     prvTaskState.taskParameters = pvParams;
@@ -191,6 +190,11 @@ void flight_sensor_setup(FlightSystemConfiguration *system_configurations, Memor
     }
 
 #endif
+
+    // the samples are logged in counts, what they are worth goes along with them
+    IMUSensorScale imuScale = imu_sensor_get_scale ( );
+    system_configurations->imu_acc_g_per_count            = imuScale.acc;
+    system_configurations->imu_gyro_deg_per_sec_per_count = imuScale.gyro;
 }
 
 static void prv_flight_controller_task(void * pvParams)
@@ -226,8 +230,8 @@ static void prv_flight_controller_task(void * pvParams)
         while ( ! pressure_sensor_read ( &initialGroundPressureData ) );
         DEBUG_LINE( "Flight Controller: ground pressure & temperature have been set!");
 
-        system_configurations.ground_pressure    = initialGroundPressureData.pressure;
-        system_configurations.ground_temperature = initialGroundPressureData.temperature;
+        system_configurations.ground_pressure    = initialGroundPressureData.pressure    * PRESSURE_SENSOR_PASCAL_PER_COUNT;
+        system_configurations.ground_temperature = initialGroundPressureData.temperature * PRESSURE_SENSOR_CELSIUS_PER_COUNT;
 
         // # 1 set the flight state to launchpad, grab the current tick count that is ~ 0;
         // set the starting power mode that is supposed to be low power mode
@@ -257,10 +261,11 @@ static void prv_flight_controller_task(void * pvParams)
         DEBUG_LINE( "Flight State Machine has been set.");
     }
 
-    static DataContainer flightData = {0};
+    static DataContainer flightData [ EVENT_DETECTOR_BLOCK_SIZE ] = {0};
     static FlightState flightState;
 
     prvTaskState.isRunning    = 1;
+    board_ms_clock_start ( &prvClock );
 
     int start_time  = 0;
     int last_time   = 0;
@@ -270,15 +275,36 @@ static void prv_flight_controller_task(void * pvParams)
     {
 //        flightData.timestamp = xTaskGetTickCount ( ) - start_time;
 
-        get_sensor_data_update ( &flightData );
+        // everything the sensors have queued since the last pass, the detector filters it as one block
+        uint32_t count = get_sensor_data_update ( flightData, EVENT_DETECTOR_BLOCK_SIZE );
+
+        event_detector_feed ( flightData, count );
+
+        for ( uint32_t entry = 0; entry < count; entry++ )
+        {
+            // each entry runs in the state the detector was in at it, a transition is in the entry it happened at
+            if ( flightData[ entry ].event.updated )
+            {
+                flightState = flightData[ entry ].event.data.values.status;
+            }
+
+            flight_state_machine_tick ( flightState, &flightData[ entry ] );
 
-        event_detector_feed ( &flightData, &flightState );
+            memory_manager_user_data_update ( &flightData[ entry ] );
+        }
 
-        flight_state_machine_tick ( flightState, &flightData );
+        memset ( flightData, 0, count * sizeof ( DataContainer ) );
 
-        memory_manager_user_data_update ( &flightData );
+        // the rocket is down and the mission is over: close the session so that the next boot finds it complete
+        if ( flightState == FLIGHT_STATE_EXIT )
+        {
+            if ( memory_manager_stop ( ) != MEM_OK )
+            {
+                board_error_handler ( __FILE__, __LINE__ );
+            }
 
-        memset ( &flightData, 0, sizeof ( DataContainer ) );
+            prvTaskState.isRunning = 0;
+        }
 
         if ( ( xTaskGetTickCount ( ) - last_time ) / configTICK_RATE_HZ >= 1 )
         {
@@ -291,50 +317,62 @@ static void prv_flight_controller_task(void * pvParams)
 
     prvTaskState.isRunning = false;
 
+    vTaskDelete ( NULL );
 }
 
 
-static void get_sensor_data_update ( DataContainer * data )
+// one entry per IMU sample, the pressure samples go into the entries from the first one on. There is always at least
+// one entry, an empty one keeps the delayed transitions of the detector going
+static uint32_t get_sensor_data_update ( DataContainer * data, uint32_t capacity )
 {
     IMUSensorData      imu_data;
     PressureSensorData pressure_data;
+    uint32_t           imu_count      = 0;
+    uint32_t           pressure_count = 0;
 
-    if ( imu_read ( &imu_data ) )
+    while ( imu_count < capacity && imu_read ( &imu_data ) )
     {
-        data->acc.data.values.timestamp = imu_data.timestamp;
-        memcpy ( &data->acc.data.values.data, &imu_data.acc_x, sizeof ( float ) * 3 );
+        DataContainer * entry = &data[ imu_count++ ];
 
-        data->gyro.data.values.timestamp = imu_data.timestamp;
-        memcpy ( &data->gyro.data.values.data, &imu_data.gyro_x, sizeof ( float ) * 3 );
-        data->gyro.updated = true;
-        data->acc.updated  = true;
+        entry->acc.data.values.timestamp = imu_data.timestamp;
+        memcpy ( &entry->acc.data.values.data, &imu_data.acc_x, sizeof ( int16_t ) * 3 );
+
+        entry->gyro.data.values.timestamp = imu_data.timestamp;
+        memcpy ( &entry->gyro.data.values.data, &imu_data.gyro_x, sizeof ( int16_t ) * 3 );
+        entry->gyro.updated = true;
+        entry->acc.updated  = true;
     }
 
-    if ( pressure_sensor_read ( &pressure_data ) )
+    while ( pressure_count < capacity && pressure_sensor_read ( &pressure_data ) )
     {
-        data->press.data.values.timestamp = pressure_data.timestamp;
-        data->press.data.values.data      = pressure_data.pressure;
-        data->press.updated               = true;
+        DataContainer * entry = &data[ pressure_count++ ];
+
+        entry->press.data.values.timestamp = pressure_data.timestamp;
+        entry->press.data.values.data      = pressure_data.pressure;
+        entry->press.updated               = true;
 
-        data->temp.data.values.timestamp   = pressure_data.timestamp;
-        data->temp.data.values.data        = pressure_data.temperature;
-        data->temp.updated                 = true;
+        entry->temp.data.values.timestamp   = pressure_data.timestamp;
+        entry->temp.data.values.data        = pressure_data.temperature;
+        entry->temp.updated                 = true;
     }
+
+    const uint32_t count = imu_count > pressure_count ? imu_count : pressure_count;
+    return count > 0 ? count : 1;
 }
 
-void prvCheckRecoveryStatusAndNotifyIfChanged ( DataContainer * data )
+void prvCheckRecoveryStatusAndNotifyIfChanged ( FlightStateMachine * machine, DataContainer * data )
 {
     for ( RecoverySelect recovery = RecoverySelectDrogueParachute; recovery < RecoverySelectCount; recovery++ )
     {
         RecoveryContinuityStatus currentContinuityStatus = recoveryCheckContinuity  ( recovery );
 
-        if ( prvLastRecoverContinuityStatus [ recovery ] !=  currentContinuityStatus )
+        if ( machine->lastContinuityStatus [ recovery ] !=  currentContinuityStatus )
         {
-            prvLastRecoverContinuityStatus [ recovery ] = currentContinuityStatus ;
+            machine->lastContinuityStatus [ recovery ] = currentContinuityStatus ;
 
             data->cont.updated = true;
-            data->cont.data.values.timestamp = xTaskGetTickCount ( );
-            data->cont.data.values.status [ recovery ] = prvLastRecoverContinuityStatus [ recovery ];
+            data->cont.data.values.timestamp = board_ms_clock_update ( &prvClock, board_get_timestamp_us ( ) );
+            data->cont.data.values.status [ recovery ] = machine->lastContinuityStatus [ recovery ];
 
         }
     }
@@ -350,19 +388,17 @@ void prvCheckRecoveryStatusAndNotifyIfChanged ( DataContainer * data )
 typedef struct
 {
     FlightState state;
-    int (*function)(DataContainer *);
+    int (*function)(FlightStateMachine *, DataContainer *);
 } state_machine_type;
 
-uint8_t isInitialized = 0;
-
-int sm_STATE_LAUNCHPAD   (DataContainer*);
-int sm_STATE_PRE_APOGEE  (DataContainer*);
-int sm_STATE_APOGEE      (DataContainer*);
-int sm_STATE_POST_APOGEE (DataContainer*);
-int sm_STATE_MAIN_CHUTE  (DataContainer*);
-int sm_STATE_POST_MAIN   (DataContainer*);
-int sm_STATE_LANDED      (DataContainer*);
-int sm_STATE_EXIT        (DataContainer*);
+int sm_STATE_LAUNCHPAD   (FlightStateMachine*, DataContainer*);
+int sm_STATE_PRE_APOGEE  (FlightStateMachine*, DataContainer*);
+int sm_STATE_APOGEE      (FlightStateMachine*, DataContainer*);
+int sm_STATE_POST_APOGEE (FlightStateMachine*, DataContainer*);
+int sm_STATE_MAIN_CHUTE  (FlightStateMachine*, DataContainer*);
+int sm_STATE_POST_MAIN   (FlightStateMachine*, DataContainer*);
+int sm_STATE_LANDED      (FlightStateMachine*, DataContainer*);
+int sm_STATE_EXIT        (FlightStateMachine*, DataContainer*);
 
 state_machine_type state_machine[] =
 {
@@ -376,36 +412,66 @@ state_machine_type state_machine[] =
         {FLIGHT_STATE_EXIT,             sm_STATE_EXIT          }
 };
 
-static FlightState sm_state;
+// the state machine of the flight computer
+static FlightStateMachine prvStateMachine = { 0 };
 
 FlightControllerStatus flight_state_machine_init ( FlightState state )
 {
-    sm_state = state;
+    return flight_state_machine_context_init ( &prvStateMachine, state );
+}
+
+
+
+FlightControllerStatus flight_state_machine_tick ( FlightState state, DataContainer * data )
+{
+    return flight_state_machine_context_tick ( &prvStateMachine, state, data );
+}
+
+
+FlightControllerStatus flight_state_machine_context_init ( FlightStateMachine * machine, FlightState state )
+{
+    if ( machine == NULL )
+    {
+        return FLIGHT_CONTROLLER_ERR;
+    }
 
-    isInitialized = 1;
+    machine->state = state;
+
+    for ( size_t recovery = 0; recovery < RecoveryContinuityStatusCount; recovery++ )
+    {
+        machine->lastContinuityStatus [ recovery ] = RecoveryContinuityStatusOpenCircuit;
+    }
+
+    for ( size_t recovery = 0; recovery < RecoveryOverCurrentStatusCount; recovery++ )
+    {
+        machine->lastOverCurrentStatus [ recovery ] = RecoveryOverCurrentStatusNoOverCurrent;
+    }
+
+    machine->isInitialized = 1;
 
     return FLIGHT_CONTROLLER_OK;
 }
 
 
 
-FlightControllerStatus flight_state_machine_tick ( FlightState state, DataContainer * data )
+FlightControllerStatus flight_state_machine_context_tick ( FlightStateMachine * machine, FlightState state, DataContainer * data )
 {
-    if ( data == NULL )
+    if ( machine == NULL || data == NULL )
     {
         return FLIGHT_CONTROLLER_ERR;
     }
 
-    if ( !isInitialized )
+    if ( !machine->isInitialized )
     {
         DISPLAY_LINE("Flight Controller has not been initialized.");
         return FLIGHT_CONTROLLER_ERR;
     }
 
     // Check to make sure that the state is being entered is valid
-    if ( sm_state < FLIGHT_STATE_COUNT )
+    machine->state = state;
+    if ( machine->state < FLIGHT_STATE_COUNT )
     {
-        return state_machine [ state ].function ( data );
+        return state_machine [ state ].function ( machine, data );
     }
     else
     {
@@ -415,81 +481,61 @@ FlightControllerStatus flight_state_machine_tick ( FlightState state, DataContai
 }
 
 
-int sm_STATE_LAUNCHPAD ( DataContainer * data )
+int sm_STATE_LAUNCHPAD ( FlightStateMachine * machine, DataContainer * data )
 {
     return 0;
 }
 
-int sm_STATE_PRE_APOGEE ( DataContainer * data )
+int sm_STATE_PRE_APOGEE ( FlightStateMachine * machine, DataContainer * data )
 {
-    prvCheckRecoveryStatusAndNotifyIfChanged ( data );
+    prvCheckRecoveryStatusAndNotifyIfChanged ( machine, data );
 
     return 0;
 }
 
-int sm_STATE_APOGEE ( DataContainer * data )
+int sm_STATE_APOGEE ( FlightStateMachine * machine, DataContainer * data )
 {
     recoveryEnableMOSFET ( RecoverySelectDrogueParachute );
     recoveryActivateMOSFET ( RecoverySelectDrogueParachute );
 
 
-    prvCheckRecoveryStatusAndNotifyIfChanged ( data );
+    prvCheckRecoveryStatusAndNotifyIfChanged ( machine, data );
 
     return 0;
 }
 
-int sm_STATE_POST_APOGEE ( DataContainer * data )
+int sm_STATE_POST_APOGEE ( FlightStateMachine * machine, DataContainer * data )
 {
-    prvCheckRecoveryStatusAndNotifyIfChanged ( data );
+    prvCheckRecoveryStatusAndNotifyIfChanged ( machine, data );
     return 0;
 }
 
-int sm_STATE_MAIN_CHUTE ( DataContainer * data )
+int sm_STATE_MAIN_CHUTE ( FlightStateMachine * machine, DataContainer * data )
 {
     recoveryEnableMOSFET ( RecoverySelectMainParachute );
     recoveryActivateMOSFET ( RecoverySelectMainParachute );
 
-    prvCheckRecoveryStatusAndNotifyIfChanged ( data );
+    prvCheckRecoveryStatusAndNotifyIfChanged ( machine, data );
 
     return 0;
 }
 
-int sm_STATE_POST_MAIN ( DataContainer * data )
+int sm_STATE_POST_MAIN ( FlightStateMachine * machine, DataContainer * data )
 {
-    prvCheckRecoveryStatusAndNotifyIfChanged ( data );
+    prvCheckRecoveryStatusAndNotifyIfChanged ( machine, data );
 
     return 0;
 }
 
-int sm_STATE_LANDED ( DataContainer * data )
+int sm_STATE_LANDED ( FlightStateMachine * machine, DataContainer * data )
 {
-    prvCheckRecoveryStatusAndNotifyIfChanged ( data );
+    prvCheckRecoveryStatusAndNotifyIfChanged ( machine, data );
 
     return 0;
 }
 
-int sm_STATE_EXIT ( DataContainer * data )
+int sm_STATE_EXIT ( FlightStateMachine * machine, DataContainer * data )
 {
 
     return 0;
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
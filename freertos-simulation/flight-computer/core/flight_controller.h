@@ -3,12 +3,23 @@
 
 #include "system_configuration.h"
 #include "../memory-management/memory_manager.h"
+#include "board/components/recovery.h"
 
 typedef enum FlightState FlightState;
 typedef struct DataContainer DataContainer;
 
 typedef enum { FLIGHT_CONTROLLER_OK = 0, FLIGHT_CONTROLLER_ERR = 1 } FlightControllerStatus;
 
+// state of the flight state machine of one flight, flight_state_machine_init/tick drive the one of the flight computer
+typedef struct FlightStateMachine
+{
+    FlightState state;
+    uint8_t     isInitialized;
+
+    int         lastContinuityStatus  [ RecoveryContinuityStatusCount  ];
+    int         lastOverCurrentStatus [ RecoveryOverCurrentStatusCount ];
+} FlightStateMachine;
+
 FlightControllerStatus flight_controller_init  ( void * pvParams );
 void flight_sensor_setup(FlightSystemConfiguration *system_configurations, MemoryManagerConfiguration *memoryConfigurations);
 FlightControllerStatus flight_controller_start ( );
@@ -18,4 +29,7 @@ void flight_controller_stop();
 FlightControllerStatus flight_state_machine_init ( FlightState state );
 FlightControllerStatus flight_state_machine_tick ( FlightState state, DataContainer * data );
 
+FlightControllerStatus flight_state_machine_context_init ( FlightStateMachine * machine, FlightState state );
+FlightControllerStatus flight_state_machine_context_tick ( FlightStateMachine * machine, FlightState state, DataContainer * data );
+
 #endif // DATA_LOGGING_H
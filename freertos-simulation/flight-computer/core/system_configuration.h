@@ -42,8 +42,10 @@ typedef struct FlightSystemConfiguration
     uint16_t altitude_main_recovery_m;                // -
     float    ground_pressure;                         // -
     float    ground_temperature;                      // -
-    uint8_t  imu_data_needs_to_be_converted;
-    uint8_t  pressure_data_needs_to_be_converted;
+    uint8_t  imu_data_needs_to_be_converted;          // the logged readings are raw counts
+    uint8_t  pressure_data_needs_to_be_converted;     // of PRESSURE_SENSOR_PASCAL_PER_COUNT and _CELSIUS_PER_COUNT
+    float    imu_acc_g_per_count;                     // the IMUSensorScale the IMU ran at
+    float    imu_gyro_deg_per_sec_per_count;
 
     IMUSensorConfiguration      imu_sensor_configuration;
     PressureSensorConfiguration pressure_sensor_configuration;
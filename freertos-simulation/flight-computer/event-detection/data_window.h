@@ -47,7 +47,7 @@ static inline void data_window_init ( moving_data_buffer * queue )
     queue->first_lap = 1;
 }
 
-static void data_window_linearize ( moving_data_buffer * queue )
+static inline void data_window_linearize ( moving_data_buffer * queue )
 {
     assert ( queue != NULL );
 
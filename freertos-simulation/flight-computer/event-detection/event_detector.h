@@ -4,6 +4,12 @@
 #include <stdbool.h>
 #include <stdint-gcc.h>
 
+#include "configurations/UserConfig.h"
+#include "signal_filter.h"
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+#include "data_window.h"
+#endif
+
 
 // Detection Parameters
 struct DataContainer;
@@ -22,6 +28,30 @@ typedef enum FlightState
     FLIGHT_STATE_COUNT
 } FlightState;
 
+// the sensor channels the detector filters before it looks at them
+typedef enum EventDetectorChannel
+{
+    EVENT_DETECTOR_CHANNEL_ACC_X    = 0,
+    EVENT_DETECTOR_CHANNEL_ACC_Y    = 1,
+    EVENT_DETECTOR_CHANNEL_ACC_Z    = 2,
+    EVENT_DETECTOR_CHANNEL_GYRO_X   = 3,
+    EVENT_DETECTOR_CHANNEL_GYRO_Y   = 4,
+    EVENT_DETECTOR_CHANNEL_GYRO_Z   = 5,
+    EVENT_DETECTOR_CHANNEL_PRESSURE = 6,
+    EVENT_DETECTOR_CHANNEL_COUNT
+} EventDetectorChannel;
+
+// samples filtered at once, longer blocks are split
+#define EVENT_DETECTOR_BLOCK_SIZE   SIGNAL_FILTER_BLOCK_SIZE
+
+// what a count of the samples is worth, the detector is fed the raw counts of the sensors
+typedef struct EventDetectorScale
+{
+    float acc;          // [g]
+    float gyro;         // [deg/s]
+    float pressure;     // [Pa]
+} EventDetectorScale;
+
 typedef enum EventDetectorStatus
 {
     EVENT_DETECTOR_ERR = 0,
@@ -29,11 +59,69 @@ typedef enum EventDetectorStatus
 } EventDetectorStatus;
 
 
+// Everything the detection of one flight depends on. The detector does not touch the RTOS nor the memory manager: the
+// time comes from the caller, in ticks of ticks_per_second, so any number of detectors can run side by side, e.g. one
+// per simulated flight on a host machine. The event_detector_init/feed API below drives a single one for the flight
+// computer.
+typedef struct EventDetector
+{
+    FlightState state;
+    uint32_t    ticks_per_second;
+    EventDetectorScale scale;
+
+    uint32_t    ground_pressure;        // [Pa]
+    float       ground_altitude;
+    float       current_altitude;       // [m] above the ground
+
+    float       vertical_velocity;      // [m/s] from the altitude differences, smoothed
+    float       previous_altitude;
+    uint32_t    previous_altitude_time;
+    bool        has_previous_altitude;
+
+    uint32_t    time;                   // of the last entry that had a sample, in the time stamps of the samples
+    uint32_t    delay_start;            // when the last delayed transition (parachute deployments, landing) started
+
+    // the thresholds in counts, so that a sample is compared as it comes. The vector lengths are compared squared and
+    // the altitude bands as the pressures at their edges, the altitude is only calculated once per pressure sample
+    float       launch_acc;
+    float       apogee_acc_squared;
+    float       landing_rotation_squared;
+    float       main_chute_pressure_low;
+    float       main_chute_pressure_high;
+    float       landing_pressure_low;
+    float       landing_pressure_high;
+
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+    moving_data_buffer altitude_window;
+    moving_data_buffer vertical_acc_window;
+#endif
+
+    // the filtering stage, the detection only sees the filtered channels. The block is kept here and not on the stack
+    // of the caller, the flight controller task has little of it
+    SignalFilter filters  [ EVENT_DETECTOR_CHANNEL_COUNT ];
+    float        filtered [ EVENT_DETECTOR_CHANNEL_COUNT ][ EVENT_DETECTOR_BLOCK_SIZE ];
+    float        gathered [ EVENT_DETECTOR_BLOCK_SIZE ];
+} EventDetector;
+
+
+void event_detector_context_init ( EventDetector * detector, uint32_t ground_pressure, const EventDetectorScale * scale, FlightState state, uint32_t ticks_per_second );
+
+void event_detector_context_set_ground_pressure ( EventDetector * detector, uint32_t ground_pressure );
+
+// the time of an entry is the time stamp of its samples, a transition sets the event of the entry it happened at
+EventDetectorStatus event_detector_context_feed ( EventDetector * detector, struct DataContainer * data );
+
+// count samples read at the same time, filtered as a block and then detected on one by one
+EventDetectorStatus event_detector_context_feed_block ( EventDetector * detector, struct DataContainer * data, uint32_t count );
+
+
 EventDetectorStatus event_detector_init ( FlightSystemConfiguration * configurations );
 
 EventDetectorStatus event_detector_update_configurations ( FlightSystemConfiguration * configurations );
 
-EventDetectorStatus event_detector_feed ( struct DataContainer * data, FlightState * state );
+// every transition in the block is announced and left in the event of its entry, the entries before it are still in
+// the previous state
+EventDetectorStatus event_detector_feed ( struct DataContainer * data, uint32_t count );
 
 float event_detector_current_altitude ( );
 
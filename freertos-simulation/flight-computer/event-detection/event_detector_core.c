@@ -0,0 +1,487 @@
+#include "event_detector.h"
+
+#include <math.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include "configurations/UserConfig.h"
+#include "memory-management/memory_manager.h"
+
+// The detection logic of the flight events. It is kept free of any RTOS call and global state, everything lives in
+// the EventDetector given by the caller, so that it can also be built and run on a host, many flights at once.
+
+#define CRITICAL_VERTICAL_ACCELERATION  6.9 // [g]
+#define APOGEE_ACCELERATION             0.1 // [g]
+#define MAIN_CHUTE_ALTITUDE             381 // [m] (converted from 1,250ft)
+#define LANDING_ROTATION_SPEED          5   // [deg / s]
+
+#define ALTITUDE_SENSITIVITY_THRESHOLD  25
+
+// how long the parachute deployments and the landing are held before moving on
+#define TRANSITION_DELAY_MS             1000
+
+// vertical velocity from the altitude differences, smoothed since the barometer is noisy
+#define VERTICAL_VELOCITY_SMOOTHING     0.2f
+
+
+#if ( userconf_EVENT_DETECTION_FILTERING_ON == 1 )
+
+// so that a single noisy sample does not move the detector: an 8 tap Hamming windowed FIR with its cut-off at a tenth of
+// the sample rate of the IMU, and a second order Butterworth at a twentieth of the one of the barometer. Both have a
+// gain of one at DC
+static const float prvInertialCoefficients [ 8 ] =
+{
+    0.008754743f, 0.047948872f, 0.164024391f, 0.279271994f, 0.279271994f, 0.164024391f, 0.047948872f, 0.008754743f
+};
+
+static const float prvPressureCoefficients [ 5 ] =
+{
+    0.020083366f, 0.040166731f, 0.020083366f, 1.561018076f, -0.641351538f
+};
+
+static const SignalFilterConfiguration prvInertialFilter = { SIGNAL_FILTER_FIR,    8, prvInertialCoefficients };
+static const SignalFilterConfiguration prvPressureFilter = { SIGNAL_FILTER_BIQUAD, 1, prvPressureCoefficients };
+
+#else
+
+static const SignalFilterConfiguration prvInertialFilter = { SIGNAL_FILTER_NONE, 0, NULL };
+static const SignalFilterConfiguration prvPressureFilter = { SIGNAL_FILTER_NONE, 0, NULL };
+
+#endif
+
+
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+static float mean ( float * array, size_t length, size_t start, size_t end );
+#endif
+
+static float prvCalculateAltitude ( float pressure );
+static float prvCalculatePressure ( float altitude );
+static bool prvDetectLaunch    ( EventDetector * detector, float vertical_acceleration );
+static bool prvDetectApogee    ( EventDetector * detector, float acceleration_x, float acceleration_y, float acceleration_z );
+static bool prvDetectAltitude  ( float pressure_low, float pressure_high, float current_pressure );
+static bool prvDetectLanding   ( EventDetector * detector, float gyro_x, float gyro_y, float gyro_z );
+
+
+static EventDetectorStatus prvFeed ( EventDetector * detector, DataContainer * data, uint32_t index );
+
+
+static void prvMoveTo ( EventDetector * detector, FlightState state, DataContainer * data, uint32_t now )
+{
+    detector->state = state;
+
+    data->event.updated               = true;
+    data->event.data.values.status    = state;
+    data->event.data.values.timestamp = now;
+}
+
+// the samples of an entry are paired by their order rather than their time, an entry can be a little before the one
+// that started the delay: the difference is signed so that it is not taken for a very long one
+static bool prvDelayElapsed ( EventDetector * detector, uint32_t now )
+{
+    return ( int32_t ) ( now - detector->delay_start ) >= ( int32_t ) ( ( uint64_t ) TRANSITION_DELAY_MS * detector->ticks_per_second / 1000 );
+}
+
+// the time of the entry is the one of its samples, an entry without any keeps the time of the one before it
+static uint32_t prvEntryTime ( EventDetector * detector, const DataContainer * data )
+{
+    if ( data->press.updated )
+    {
+        detector->time = data->press.data.values.timestamp;
+    }
+    else if ( data->acc.updated )
+    {
+        detector->time = data->acc.data.values.timestamp;
+    }
+    else if ( data->gyro.updated )
+    {
+        detector->time = data->gyro.data.values.timestamp;
+    }
+
+    return detector->time;
+}
+
+
+void event_detector_context_init ( EventDetector * detector, uint32_t ground_pressure, const EventDetectorScale * scale, FlightState state, uint32_t ticks_per_second )
+{
+    memset ( detector, 0, sizeof ( EventDetector ) );
+
+    detector->state            = state;
+    detector->ticks_per_second = ticks_per_second;
+    detector->scale            = *scale;
+
+    const float apogee_acc       = APOGEE_ACCELERATION / scale->acc;
+    const float landing_rotation = LANDING_ROTATION_SPEED / scale->gyro;
+
+    detector->launch_acc               = CRITICAL_VERTICAL_ACCELERATION / scale->acc;
+    detector->apogee_acc_squared       = apogee_acc * apogee_acc;
+    detector->landing_rotation_squared = landing_rotation * landing_rotation;
+
+    event_detector_context_set_ground_pressure ( detector, ground_pressure );
+
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+    data_window_init ( &detector->altitude_window );
+    data_window_init ( &detector->vertical_acc_window );
+#endif
+
+    for ( EventDetectorChannel channel = EVENT_DETECTOR_CHANNEL_ACC_X; channel < EVENT_DETECTOR_CHANNEL_COUNT; channel++ )
+    {
+        signal_filter_init ( &detector->filters[ channel ], channel == EVENT_DETECTOR_CHANNEL_PRESSURE ? &prvPressureFilter : &prvInertialFilter );
+    }
+}
+
+
+void event_detector_context_set_ground_pressure ( EventDetector * detector, uint32_t ground_pressure )
+{
+    const float counts = 1 / detector->scale.pressure;
+
+    detector->ground_pressure = ground_pressure;
+    detector->ground_altitude = prvCalculateAltitude ( ground_pressure );
+
+    // the pressure falls with the altitude, the top of a band is its lowest pressure
+    detector->main_chute_pressure_low  = prvCalculatePressure ( detector->ground_altitude + MAIN_CHUTE_ALTITUDE + ALTITUDE_SENSITIVITY_THRESHOLD ) * counts;
+    detector->main_chute_pressure_high = prvCalculatePressure ( detector->ground_altitude + MAIN_CHUTE_ALTITUDE - ALTITUDE_SENSITIVITY_THRESHOLD ) * counts;
+    detector->landing_pressure_low     = prvCalculatePressure ( detector->ground_altitude + ALTITUDE_SENSITIVITY_THRESHOLD ) * counts;
+    detector->landing_pressure_high    = prvCalculatePressure ( detector->ground_altitude - ALTITUDE_SENSITIVITY_THRESHOLD ) * counts;
+}
+
+
+// the sample of the channel in the entry, if the entry has one
+static bool prvChannelSample ( const DataContainer * data, EventDetectorChannel channel, float * value )
+{
+    switch ( channel )
+    {
+        case EVENT_DETECTOR_CHANNEL_ACC_X:
+        case EVENT_DETECTOR_CHANNEL_ACC_Y:
+        case EVENT_DETECTOR_CHANNEL_ACC_Z:
+            *value = data->acc.data.values.data[ channel - EVENT_DETECTOR_CHANNEL_ACC_X ];
+            return data->acc.updated;
+
+        case EVENT_DETECTOR_CHANNEL_GYRO_X:
+        case EVENT_DETECTOR_CHANNEL_GYRO_Y:
+        case EVENT_DETECTOR_CHANNEL_GYRO_Z:
+            *value = data->gyro.data.values.data[ channel - EVENT_DETECTOR_CHANNEL_GYRO_X ];
+            return data->gyro.updated;
+
+        case EVENT_DETECTOR_CHANNEL_PRESSURE:
+            *value = data->press.data.values.data;
+            return data->press.updated;
+
+        default:
+            return false;
+    }
+}
+
+
+// every channel is gathered out of the entries that have a sample of it, filtered as one block and put back at the
+// index of its entry in detector->filtered
+static void prvFilterBlock ( EventDetector * detector, const DataContainer * data, uint32_t count )
+{
+    for ( EventDetectorChannel channel = EVENT_DETECTOR_CHANNEL_ACC_X; channel < EVENT_DETECTOR_CHANNEL_COUNT; channel++ )
+    {
+        float *  filtered = detector->filtered[ channel ];
+        uint32_t samples  = 0;
+        float    value;
+
+        for ( uint32_t index = 0; index < count; index++ )
+        {
+            if ( prvChannelSample ( &data[ index ], channel, &value ) )
+            {
+                detector->gathered[ samples++ ] = value;
+            }
+        }
+
+        signal_filter_process ( &detector->filters[ channel ], detector->gathered, filtered, samples );
+
+        // from the last one, an entry is never before the filtered sample that goes to it
+        for ( uint32_t index = count; index-- > 0 && samples > 0; )
+        {
+            if ( prvChannelSample ( &data[ index ], channel, &value ) )
+            {
+                filtered[ index ] = filtered[ --samples ];
+            }
+        }
+    }
+}
+
+
+EventDetectorStatus event_detector_context_feed ( EventDetector * detector, DataContainer * data )
+{
+    return event_detector_context_feed_block ( detector, data, 1 );
+}
+
+
+EventDetectorStatus event_detector_context_feed_block ( EventDetector * detector, DataContainer * data, uint32_t count )
+{
+    EventDetectorStatus status = EVENT_DETECTOR_OK;
+
+    for ( uint32_t first = 0; first < count; first += EVENT_DETECTOR_BLOCK_SIZE )
+    {
+        const uint32_t length = count - first < EVENT_DETECTOR_BLOCK_SIZE ? count - first : EVENT_DETECTOR_BLOCK_SIZE;
+
+        prvFilterBlock ( detector, &data[ first ], length );
+
+        for ( uint32_t index = 0; index < length; index++ )
+        {
+            status = prvFeed ( detector, &data[ first + index ], index );
+        }
+    }
+
+    return status;
+}
+
+
+// the detection on the entry at index of the block in detector->filtered
+static EventDetectorStatus prvFeed ( EventDetector * detector, DataContainer * data, uint32_t index )
+{
+    const uint32_t now = prvEntryTime ( detector, data );
+
+    const float pressure = detector->filtered[ EVENT_DETECTOR_CHANNEL_PRESSURE ][ index ];
+    const float acc_x    = detector->filtered[ EVENT_DETECTOR_CHANNEL_ACC_X ][ index ];
+    const float acc_y    = detector->filtered[ EVENT_DETECTOR_CHANNEL_ACC_Y ][ index ];
+    const float acc_z    = detector->filtered[ EVENT_DETECTOR_CHANNEL_ACC_Z ][ index ];
+    const float gyro_x   = detector->filtered[ EVENT_DETECTOR_CHANNEL_GYRO_X ][ index ];
+    const float gyro_y   = detector->filtered[ EVENT_DETECTOR_CHANNEL_GYRO_Y ][ index ];
+    const float gyro_z   = detector->filtered[ EVENT_DETECTOR_CHANNEL_GYRO_Z ][ index ];
+
+    if ( data->press.updated )
+    {
+        detector->current_altitude = prvCalculateAltitude ( pressure * detector->scale.pressure ) - detector->ground_altitude;
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+        data_window_insert ( &detector->altitude_window, &detector->current_altitude );
+#endif
+
+        // between two pressure samples, both on the clock of the barometer
+        const uint32_t time = data->press.data.values.timestamp;
+        if ( detector->has_previous_altitude && time != detector->previous_altitude_time )
+        {
+            float dt       = ( float ) ( time - detector->previous_altitude_time ) / detector->ticks_per_second;
+            float velocity = ( detector->current_altitude - detector->previous_altitude ) / dt;
+            detector->vertical_velocity += VERTICAL_VELOCITY_SMOOTHING * ( velocity - detector->vertical_velocity );
+        }
+
+        detector->previous_altitude      = detector->current_altitude;
+        detector->previous_altitude_time = time;
+        detector->has_previous_altitude  = true;
+    }
+
+    switch ( detector->state )
+    {
+        case FLIGHT_STATE_LAUNCHPAD:
+        {
+            if ( data->acc.updated )
+            {
+                if ( prvDetectLaunch ( detector, acc_x ) )
+                {
+                    prvMoveTo ( detector, FLIGHT_STATE_PRE_APOGEE, data, now );
+                }
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_PRE_APOGEE:
+        {
+            if ( data->acc.updated )
+            {
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+                // Here we need to start looking at the average altitude and see the differences in the gradient sign
+                // the idea is that if the gradient changes the sign then we reached the apogee since the altitude
+                // is now decreasing instead of increasing. Also to avoid mechanical errors if the sign changes
+                // dramatically then it cannot represent the real world scenario, as in the real world the inertia
+                // makes it stop really slowly as well as falling down, therefore the difference needs to be small.
+
+                moving_data_buffer * window = &detector->altitude_window;
+
+                float previous_average_altitude = mean ( window->linear_repr, sizeof ( window->linear_repr ), 0, MOVING_BUFFER_RANGE - 1 );
+                float last_average_altitude     = mean ( window->linear_repr, sizeof ( window->linear_repr ), 1, MOVING_BUFFER_RANGE );
+
+                float difference          = last_average_altitude - previous_average_altitude;
+                float absolute_difference = fabs ( fabs ( last_average_altitude ) - fabs ( previous_average_altitude ) );
+
+                if ( ( difference < 0 ) && absolute_difference < 5 && absolute_difference > 0.2 )
+                {
+                    prvMoveTo ( detector, FLIGHT_STATE_APOGEE, data, now );
+                    detector->delay_start = now;
+                }
+#else
+                if ( prvDetectApogee( detector, acc_x, acc_y, acc_z ) )
+                {
+                    prvMoveTo ( detector, FLIGHT_STATE_APOGEE, data, now );
+                }
+#endif
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_APOGEE:
+        {
+            if ( prvDelayElapsed ( detector, now ) )
+            {
+                prvMoveTo ( detector, FLIGHT_STATE_POST_APOGEE, data, now );
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_POST_APOGEE:
+        {
+            if ( data->press.updated )
+            {
+                if ( prvDetectAltitude ( detector->main_chute_pressure_low, detector->main_chute_pressure_high, pressure ) )
+                {
+                    prvMoveTo ( detector, FLIGHT_STATE_MAIN_CHUTE, data, now );
+                    detector->delay_start = now;
+                }
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_MAIN_CHUTE:
+        {
+            if ( prvDelayElapsed ( detector, now ) )
+            {
+                prvMoveTo ( detector, FLIGHT_STATE_POST_MAIN, data, now );
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_POST_MAIN:
+        {
+            if ( data->gyro.updated )
+            {
+                if ( prvDetectLanding ( detector, gyro_x, gyro_y, gyro_z ) )
+                {
+                    prvMoveTo ( detector, FLIGHT_STATE_LANDED, data, now );
+                    detector->delay_start = now;
+                    return EVENT_DETECTOR_OK;
+                }
+            }
+
+            // OR
+
+            if ( data->press.updated )
+            {
+                if ( prvDetectAltitude ( detector->landing_pressure_low, detector->landing_pressure_high, pressure ) )
+                {
+                    prvMoveTo ( detector, FLIGHT_STATE_LANDED, data, now );
+                    detector->delay_start = now;
+                    return EVENT_DETECTOR_OK;
+                }
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_LANDED:
+        {
+            if ( prvDelayElapsed ( detector, now ) )
+            {
+                prvMoveTo ( detector, FLIGHT_STATE_EXIT, data, now );
+                detector->delay_start = now;
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_EXIT:
+        {
+            if ( prvDelayElapsed ( detector, now ) )
+            {
+                prvMoveTo ( detector, FLIGHT_STATE_COUNT, data, now );
+            }
+
+            return EVENT_DETECTOR_OK;
+        }
+
+        case FLIGHT_STATE_COUNT:
+        default:
+            return EVENT_DETECTOR_ERR;
+    }
+}
+
+
+static bool prvDetectLaunch ( EventDetector * detector, float vertical_acceleration )
+{
+    return vertical_acceleration > detector->launch_acc;
+}
+
+
+static bool prvDetectApogee ( EventDetector * detector, float acceleration_x, float acceleration_y, float acceleration_z )
+{
+    const float ACCELERATION_VECTOR_SQUARED = acceleration_x * acceleration_x + acceleration_y * acceleration_y + acceleration_z * acceleration_z;
+    return ACCELERATION_VECTOR_SQUARED < detector->apogee_acc_squared;
+}
+
+
+static bool prvDetectAltitude ( float pressure_low, float pressure_high, float current_pressure )
+{
+    return current_pressure > pressure_low && current_pressure < pressure_high;
+}
+
+static bool prvDetectLanding ( EventDetector * detector, float gyro_x, float gyro_y, float gyro_z )
+{
+    float gyroscope_orientation_vector_squared = gyro_x * gyro_x + gyro_y * gyro_y + gyro_z * gyro_z;
+    return gyroscope_orientation_vector_squared < detector->landing_rotation_squared;
+}
+
+
+static float prvCalculateAltitude ( float pressure )
+{
+    /*
+     Pb = static pressure (pressure at sea level) [Pa]
+     Tb = standard temperature (temperature at sea level) [K]
+     Lb = standard temperature lapse rate [K/m] = -0.0065 [K/m]
+     h  = height about sea level [m]
+     hb = height at the bottom of atmospheric layer [m]
+     R  = universal gas constant = 8.31432
+     q0 = gravitational acceleration constant = 9.80665
+     M  = molar mass of Earth’s air = 0.0289644 [kg/mol]
+    */
+
+    static const float Pb = 101325.00f;
+    static const float Tb = 15.00 + 273.15;
+    static const float Lb = -0.0065;
+    static const int   hb = 0;
+    static const float R  = 8.31432;
+    static const float g0 = 9.80665;
+    static const float M  = 0.0289644;
+
+    return hb + ( Tb / Lb ) * ( pow ( ( pressure / Pb ), ( -R * Lb ) / ( g0 * M ) ) - 1 );
+}
+
+
+// the inverse of prvCalculateAltitude, with the same constants
+static float prvCalculatePressure ( float altitude )
+{
+    static const float Pb = 101325.00f;
+    static const float Tb = 15.00 + 273.15;
+    static const float Lb = -0.0065;
+    static const int   hb = 0;
+    static const float R  = 8.31432;
+    static const float g0 = 9.80665;
+    static const float M  = 0.0289644;
+
+    return Pb * pow ( 1 + ( altitude - hb ) * Lb / Tb, ( -g0 * M ) / ( R * Lb ) );
+}
+
+
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+
+static float mean ( float * array, size_t length, size_t start, size_t end )
+{
+    assert( end < length );
+    assert( start < end );
+
+    float sum = 0;
+    for ( size_t i   = start; i <= end; i++ )
+    {
+        sum += array[ i ];
+    }
+
+    return sum / ( end - start );
+}
+
+#endif
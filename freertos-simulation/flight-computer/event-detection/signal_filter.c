@@ -0,0 +1,198 @@
+#include "signal_filter.h"
+
+#include <string.h>
+
+#if defined ( ARM_MATH_CM4 )
+#include "stm32f4xx.h"
+#include "arm_math.h"
+#endif
+
+
+static void prvPrime ( SignalFilter * filter, float value )
+{
+    const SignalFilterConfiguration * configuration = &filter->configuration;
+
+    if ( configuration->type == SIGNAL_FILTER_BIQUAD )
+    {
+        // every stage settles at its DC gain times its input
+        for ( uint8_t stage = 0; stage < configuration->length; stage++ )
+        {
+            const float * coefficients = &configuration->coefficients[ 5 * stage ];
+            float *       state        = &filter->state[ 4 * stage ];
+            float         settled      = value * ( coefficients[ 0 ] + coefficients[ 1 ] + coefficients[ 2 ] ) / ( 1 - coefficients[ 3 ] - coefficients[ 4 ] );
+
+            state[ 0 ] = value;
+            state[ 1 ] = value;
+            state[ 2 ] = settled;
+            state[ 3 ] = settled;
+
+            value = settled;
+        }
+    }
+    else if ( configuration->type == SIGNAL_FILTER_FIR )
+    {
+        for ( uint8_t tap = 0; tap + 1 < configuration->length; tap++ )
+        {
+            filter->state[ tap ] = value;
+        }
+    }
+
+    filter->primed = true;
+}
+
+
+#if defined ( ARM_MATH_CM4 )
+
+static void prvBiquad ( SignalFilter * filter, const float * input, float * output, uint32_t count )
+{
+    // built on every call rather than kept in the filter, it points into the filter and the filter can be copied
+    arm_biquad_casd_df1_inst_f32 instance =
+    {
+        .numStages = filter->configuration.length,
+        .pState    = filter->state,
+        .pCoeffs   = ( float32_t * ) filter->configuration.coefficients,
+    };
+
+    arm_biquad_cascade_df1_f32 ( &instance, ( float32_t * ) input, output, count );
+}
+
+static void prvFir ( SignalFilter * filter, const float * input, float * output, uint32_t count )
+{
+    arm_fir_instance_f32 instance =
+    {
+        .numTaps = filter->configuration.length,
+        .pState  = filter->state,
+        .pCoeffs = ( float32_t * ) filter->configuration.coefficients,
+    };
+
+    arm_fir_f32 ( &instance, ( float32_t * ) input, output, count );
+}
+
+#else
+
+// reference of arm_biquad_cascade_df1_f32, the stages after the first one filter the output in place
+static void prvBiquad ( SignalFilter * filter, const float * input, float * output, uint32_t count )
+{
+    const float * source = input;
+
+    for ( uint8_t stage = 0; stage < filter->configuration.length; stage++ )
+    {
+        const float * coefficients = &filter->configuration.coefficients[ 5 * stage ];
+        float *       state        = &filter->state[ 4 * stage ];
+
+        float x1 = state[ 0 ], x2 = state[ 1 ], y1 = state[ 2 ], y2 = state[ 3 ];
+
+        for ( uint32_t n = 0; n < count; n++ )
+        {
+            const float x = source[ n ];
+            const float y = coefficients[ 0 ] * x + coefficients[ 1 ] * x1 + coefficients[ 2 ] * x2 + coefficients[ 3 ] * y1 + coefficients[ 4 ] * y2;
+
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+
+            output[ n ] = y;
+        }
+
+        state[ 0 ] = x1;
+        state[ 1 ] = x2;
+        state[ 2 ] = y1;
+        state[ 3 ] = y2;
+
+        source = output;
+    }
+}
+
+// reference of arm_fir_f32: the block is appended to the history, every output is the dot product of the reversed
+// coefficients with the window that ends at its input, and the last taps - 1 inputs become the history
+static void prvFir ( SignalFilter * filter, const float * input, float * output, uint32_t count )
+{
+    const uint8_t taps         = filter->configuration.length;
+    const float * coefficients = filter->configuration.coefficients;
+    float *       state        = filter->state;
+
+    memcpy ( &state[ taps - 1 ], input, count * sizeof ( float ) );
+
+    for ( uint32_t n = 0; n < count; n++ )
+    {
+        float sum = 0;
+        for ( uint8_t tap = 0; tap < taps; tap++ )
+        {
+            sum += coefficients[ tap ] * state[ n + tap ];
+        }
+
+        output[ n ] = sum;
+    }
+
+    memmove ( state, &state[ count ], ( taps - 1 ) * sizeof ( float ) );
+}
+
+#endif
+
+
+bool signal_filter_init ( SignalFilter * filter, const SignalFilterConfiguration * configuration )
+{
+    memset ( filter, 0, sizeof ( SignalFilter ) );
+
+    switch ( configuration->type )
+    {
+        case SIGNAL_FILTER_NONE:
+            break;
+
+        case SIGNAL_FILTER_BIQUAD:
+            if ( configuration->length == 0 || configuration->length > SIGNAL_FILTER_MAX_BIQUAD_STAGES || configuration->coefficients == NULL )
+            {
+                return false;
+            }
+            break;
+
+        case SIGNAL_FILTER_FIR:
+            if ( configuration->length == 0 || configuration->length > SIGNAL_FILTER_MAX_FIR_TAPS || configuration->coefficients == NULL )
+            {
+                return false;
+            }
+            break;
+
+        default:
+            return false;
+    }
+
+    filter->configuration = *configuration;
+    return true;
+}
+
+
+void signal_filter_process ( SignalFilter * filter, const float * input, float * output, uint32_t count )
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    if ( ! filter->primed )
+    {
+        prvPrime ( filter, input[ 0 ] );
+    }
+
+    for ( uint32_t first = 0; first < count; first += SIGNAL_FILTER_BLOCK_SIZE )
+    {
+        const uint32_t length = count - first < SIGNAL_FILTER_BLOCK_SIZE ? count - first : SIGNAL_FILTER_BLOCK_SIZE;
+
+        switch ( filter->configuration.type )
+        {
+            case SIGNAL_FILTER_BIQUAD:
+                prvBiquad ( filter, &input[ first ], &output[ first ], length );
+                break;
+
+            case SIGNAL_FILTER_FIR:
+                prvFir ( filter, &input[ first ], &output[ first ], length );
+                break;
+
+            case SIGNAL_FILTER_NONE:
+            default:
+                memcpy ( &output[ first ], &input[ first ], length * sizeof ( float ) );
+                break;
+        }
+    }
+}
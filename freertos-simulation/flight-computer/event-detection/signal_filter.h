@@ -0,0 +1,62 @@
+#ifndef AVIONICS_SIGNAL_FILTER_H
+#define AVIONICS_SIGNAL_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block filtering of a single sensor channel, a cascade of biquads or a FIR. With ARM_MATH_CM4 defined, set by the
+// build when the CMSIS-DSP library is linked, the blocks go through arm_biquad_cascade_df1_f32 and arm_fir_f32 and
+// their multiply-accumulates; anywhere else, the Linux simulation included, through the portable reference kernels in
+// signal_filter.c. Both keep the state the same way, so a filter can be primed without knowing which one runs.
+//
+// The coefficients are those of CMSIS-DSP:
+//  biquad  { b0, b1, b2, a1, a2 } per stage, y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2]
+//          (the feedback coefficients are negated compared to the usual form of the transfer function)
+//  FIR     { b[taps-1], ..., b[0] }, time reversed
+
+#define SIGNAL_FILTER_BLOCK_SIZE                    32 // samples per call of the kernels, longer blocks are split
+#define SIGNAL_FILTER_MAX_BIQUAD_STAGES             4
+#define SIGNAL_FILTER_MAX_FIR_TAPS                  16
+
+// the biquad state is { x[n-1], x[n-2], y[n-1], y[n-2] } per stage, the FIR state the last taps - 1 inputs, oldest
+// first, followed by the room arm_fir_f32 needs for a block
+#define SIGNAL_FILTER_STATE_LENGTH                  ( SIGNAL_FILTER_MAX_FIR_TAPS + SIGNAL_FILTER_BLOCK_SIZE - 1 )
+
+typedef enum SignalFilterType
+{
+    SIGNAL_FILTER_NONE   = 0, // the samples pass through
+    SIGNAL_FILTER_BIQUAD = 1,
+    SIGNAL_FILTER_FIR    = 2
+} SignalFilterType;
+
+typedef struct SignalFilterConfiguration
+{
+    SignalFilterType type;
+    uint8_t          length;        // stages of a biquad cascade, taps of a FIR
+    const float *    coefficients;
+} SignalFilterConfiguration;
+
+typedef struct SignalFilter
+{
+    SignalFilterConfiguration configuration;
+    bool                      primed;   // the first sample sets the state as if it had always been the input
+    float                     state [ SIGNAL_FILTER_STATE_LENGTH ];
+} SignalFilter;
+
+
+// false if the configuration does not fit the filter
+bool signal_filter_init ( SignalFilter * filter, const SignalFilterConfiguration * configuration );
+
+// the next count samples of the channel, input and output must not overlap
+void signal_filter_process ( SignalFilter * filter, const float * input, float * output, uint32_t count );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //AVIONICS_SIGNAL_FILTER_H
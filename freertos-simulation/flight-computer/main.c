@@ -496,6 +496,13 @@ void vApplicationIdleHook( void )
 	because it is the responsibility of the idle task to clean up memory
 	allocated by the kernel to any task that has since deleted itself. */
 
+#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON == 1 ) && !defined( _WIN32 )
+	/* Do not spin a host core while nothing is ready to run. The next tick
+	interrupts the sleep. Only the POSIX port has it, the target idles as
+	its port does. */
+	vPortIdleSleep();
+#endif
+
 	/* Uncomment the following code to allow the trace to be stopped with any
 	key press.  The code is commented out by default as the kbhit() function
 	interferes with the run time behaviour. */
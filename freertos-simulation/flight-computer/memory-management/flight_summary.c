@@ -0,0 +1,179 @@
+#include "flight_summary.h"
+
+#include <float.h>
+#include <string.h>
+
+
+// the summary channel of every user data sector: its axes and the size of the signed count of every axis, which follows
+// the timestamp of the record
+typedef struct FlightSummaryChannelLayout
+{
+    size_t axes;
+    size_t valueSize;
+
+} FlightSummaryChannelLayout;
+
+// the divisor never is 0, the compiler sees the division of the sectors without axes as well
+#define FLIGHT_SUMMARY_CHANNEL_VALUE_SIZE( entry, axes )    ( ( axes ) > 0 ? ( sizeof ( entry ) - sizeof ( uint32_t ) ) / ( ( axes ) + ( ( axes ) == 0 ) ) : 0 )
+
+#define FLIGHT_SUMMARY_CHANNEL_CHECK( name, NAME, entry, label, lane, member, rate, axes ) \
+    _Static_assert ( ( axes ) <= 3, "the " label " sector has more summary axes than a channel" ); \
+    _Static_assert ( ( axes ) == 0 || ( ( FLIGHT_SUMMARY_CHANNEL_VALUE_SIZE ( entry, axes ) == sizeof ( int16_t ) || FLIGHT_SUMMARY_CHANNEL_VALUE_SIZE ( entry, axes ) == sizeof ( int32_t ) ) \
+                     && FLIGHT_SUMMARY_CHANNEL_VALUE_SIZE ( entry, axes ) * ( axes ) + sizeof ( uint32_t ) == sizeof ( entry ) ), \
+                     "the " label " records are not a timestamp followed by a signed count of 16 or 32 bits per summary axis" );
+
+#define FLIGHT_SUMMARY_CHANNEL_LAYOUT( name, NAME, entry, label, lane, member, rate, axes ) \
+    { ( axes ), FLIGHT_SUMMARY_CHANNEL_VALUE_SIZE ( entry, axes ) },
+
+MEMORY_USER_DATA_SECTORS ( FLIGHT_SUMMARY_CHANNEL_CHECK )
+
+static const FlightSummaryChannelLayout prvChannelLayouts [ UserDataSectorCount ] =
+{
+    MEMORY_USER_DATA_SECTORS ( FLIGHT_SUMMARY_CHANNEL_LAYOUT )
+};
+
+// the channels are kept in the order of the sectors, for the sectors with summary axes only
+static size_t prvChannelIndex ( UserDataSector sector )
+{
+    size_t index = 0;
+    for ( UserDataSector previous = UserDataSectorGyro; previous < sector; previous++ )
+    {
+        index += prvChannelLayouts[ previous ].axes > 0;
+    }
+
+    return index;
+}
+
+
+void flight_summary_reset ( MemoryFlightSummaryU * summary, uint32_t session, FlightState state )
+{
+    // the signature is left blank, it is up to whoever stores the summary
+    memset ( summary->bytes, 0, sizeof ( MemoryFlightSummaryU ) );
+
+    summary->values.session      = session;
+    summary->values.flight_state = state;
+
+    for ( FlightState flightState = FLIGHT_STATE_LAUNCHPAD; flightState < FLIGHT_STATE_COUNT; flightState++ )
+    {
+        summary->values.state_timestamps[ flightState ] = UINT32_MAX;
+    }
+
+    // an empty channel has its minimum above its maximum
+    MemorySummaryChannel empty;
+    for ( size_t axis = 0; axis < 3; axis++ )
+    {
+        empty.min[ axis ] = INT32_MAX;
+        empty.max[ axis ] = INT32_MIN;
+    }
+
+    for ( size_t channel = 0; channel < MEMORY_SUMMARY_CHANNEL_COUNT; channel++ )
+    {
+        summary->values.channels[ channel ] = empty;
+    }
+
+    summary->values.max_altitude_m             = -FLT_MAX;
+    summary->values.peak_vertical_velocity_m_s = -FLT_MAX;
+}
+
+void flight_summary_mark_state ( MemoryFlightSummaryU * summary, FlightState state, uint32_t timestamp )
+{
+    if ( state < FLIGHT_STATE_COUNT )
+    {
+        summary->values.state_timestamps[ state ] = timestamp;
+    }
+
+    summary->values.flight_state = state;
+}
+
+size_t flight_summary_channel_axes ( UserDataSector sector )
+{
+    return sector < UserDataSectorCount ? prvChannelLayouts[ sector ].axes : 0;
+}
+
+bool flight_summary_get_channel ( const MemoryFlightSummaryU * summary, UserDataSector sector, MemorySummaryChannel * channel )
+{
+    if ( flight_summary_channel_axes ( sector ) == 0 )
+    {
+        return false;
+    }
+
+    *channel = summary->values.channels[ prvChannelIndex ( sector ) ];
+    return true;
+}
+
+void flight_summary_update_channel ( MemoryFlightSummaryU * summary, UserDataSector sector, const uint8_t * entry )
+{
+    const size_t axes = flight_summary_channel_axes ( sector );
+
+    if ( axes == 0 )
+    {
+        return;
+    }
+
+    const size_t valueSize = prvChannelLayouts[ sector ].valueSize;
+    const size_t index     = prvChannelIndex ( sector );
+
+    // copied out since the summary is packed
+    MemorySummaryChannel channel = summary->values.channels[ index ];
+
+    for ( size_t axis = 0; axis < axes; axis++ )
+    {
+        const uint8_t * source = entry + sizeof ( uint32_t ) + axis * valueSize;
+        int32_t         value;
+
+        if ( valueSize == sizeof ( int16_t ) )
+        {
+            int16_t count;
+            memcpy ( &count, source, sizeof ( int16_t ) );
+            value = count;
+        }
+        else
+        {
+            memcpy ( &value, source, sizeof ( int32_t ) );
+        }
+
+        channel.min[ axis ] = value < channel.min[ axis ] ? value : channel.min[ axis ];
+        channel.max[ axis ] = value > channel.max[ axis ] ? value : channel.max[ axis ];
+    }
+
+    summary->values.channels[ index ] = channel;
+}
+
+void flight_summary_update_dynamics ( MemoryFlightSummaryU * summary, FlightState state, float altitude_m, float vertical_velocity_m_s, uint32_t now )
+{
+    if ( altitude_m > summary->values.max_altitude_m )
+    {
+        summary->values.max_altitude_m         = altitude_m;
+        summary->values.max_altitude_timestamp = now;
+    }
+
+    if ( state == FLIGHT_STATE_LAUNCHPAD )
+    {
+        // the barometer noise on the pad is not a flight
+        return;
+    }
+
+    if ( vertical_velocity_m_s > summary->values.peak_vertical_velocity_m_s )
+    {
+        summary->values.peak_vertical_velocity_m_s = vertical_velocity_m_s;
+    }
+
+    // running means of the descent rate, the main parachute opens on the way from FLIGHT_STATE_MAIN_CHUTE to FLIGHT_STATE_POST_MAIN
+    float descent = -vertical_velocity_m_s;
+    switch ( state )
+    {
+        case FLIGHT_STATE_POST_APOGEE:
+        case FLIGHT_STATE_MAIN_CHUTE:
+            summary->values.descent_samples_drogue++;
+            summary->values.descent_rate_drogue_m_s += ( descent - summary->values.descent_rate_drogue_m_s ) / summary->values.descent_samples_drogue;
+            break;
+
+        case FLIGHT_STATE_POST_MAIN:
+            summary->values.descent_samples_main++;
+            summary->values.descent_rate_main_m_s += ( descent - summary->values.descent_rate_main_m_s ) / summary->values.descent_samples_main;
+            break;
+
+        default:
+            break;
+    }
+}
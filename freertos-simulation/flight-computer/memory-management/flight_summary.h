@@ -0,0 +1,27 @@
+#ifndef MEMORY_MANAGER_FLIGHT_SUMMARY_H
+#define MEMORY_MANAGER_FLIGHT_SUMMARY_H
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "memory_manager.h"
+
+// Accumulation of the flight summary (MemoryFlightSummaryU) sample by sample. Like the rate control it keeps no state
+// of its own, the summary belongs to the caller, so that every simulated flight can keep one.
+
+void flight_summary_reset ( MemoryFlightSummaryU * summary, uint32_t session, FlightState state );
+
+// records the time the flight entered the state
+void flight_summary_mark_state ( MemoryFlightSummaryU * summary, FlightState state, uint32_t timestamp );
+
+// entry is a record of the sector, the sectors without summary axes in MEMORY_USER_DATA_SECTORS are left out
+void flight_summary_update_channel ( MemoryFlightSummaryU * summary, UserDataSector sector, const uint8_t * entry );
+
+// the summary axes of the sector, 0 if it has no channel in the summary
+size_t flight_summary_channel_axes ( UserDataSector sector );
+
+// false if the sector has no channel in the summary
+bool flight_summary_get_channel ( const MemoryFlightSummaryU * summary, UserDataSector sector, MemorySummaryChannel * channel );
+
+void flight_summary_update_dynamics ( MemoryFlightSummaryU * summary, FlightState state, float altitude_m, float vertical_velocity_m_s, uint32_t now );
+
+#endif // MEMORY_MANAGER_FLIGHT_SUMMARY_H
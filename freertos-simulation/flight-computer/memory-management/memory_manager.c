@@ -1,6 +1,8 @@
 #include "memory_manager.h"
 
 #include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
 #include <memory.h>
 #include <stdbool.h>
 #include <string.h>
@@ -8,13 +10,18 @@
 #include <assert.h>
 
 #include <math.h>
+#include <float.h>
 #include <FreeRTOS.h>
 #include <task.h>
 #include <queue.h>
 
 #include "protocols/UART.h"
 #include "utilities/common.h"
+#include "utilities/spsc_ring.h"
 #include "board/components/flash.h"
+#include "configurations/MemoryLayoutConfig.h"
+#include "rate_control.h"
+#include "flight_summary.h"
 
 
 /* ------------------- This memory manager ic designed for Flash Memory Cypress S25FL064P0XMFA000 ------------------- */
@@ -68,6 +75,55 @@
  *     |_____________|___________|___________|___________|___________________|______________|_____________________|
  *
  * The first data sector is IMU:
+ *
+ * [Metadata sector]
+ * The metadata (the write cursors of the user data sectors and the logging mode) is appended a page at a time and wraps
+ * around at the end of its 464 4Kb sub-sectors. Whenever the writing enters a sub-sector the next one is erased, so the
+ * newest page is the last written one in front of the only erased sub-sector that follows a written one.
+ *
+ * [Diagnostics sector]
+ * The last 64Kb of the metadata region are reserved for the storage diagnostics: every few seconds (and when the memory
+ * manager is stopped) a snapshot of the throughput and back-pressure counters (see MemoryDiagnosticsU) is appended as a
+ * single page, so that after the flight we can tell whether the flash memory kept up with the sensors. Once the 256
+ * pages of the sector are used up no more snapshots are recorded.
+ *
+ * [User data sectors]
+ * The user data sectors start at the first 64Kb erase block after the diagnostics sector and their sizes are whole
+ * erase blocks. The sizes are planned from the logging rates and the expected flight phase durations, at compile time by
+ * build-on-linux/layout_planner.py (configurations/MemoryLayoutConfig.h of the build directory) and at runtime by memory_manager_plan_layout ( ).
+ * A configured layout that does not fit into the flash memory is replaced by the planned one on a fresh start.
+ *
+ * [Timestamp index sector]
+ * Between the diagnostics sector and the user data sectors there are 56Kb of timestamp index: 8Kb (2048 slots of 4 bytes)
+ * per user data sector. When the monitor flushes every n-th page of a sector, it programs the timestamp of the first entry
+ * of that page into the next slot, n being the number of pages of the sector divided by the slots, rounded up. The slots
+ * are sorted, so memory_manager_read_range ( ) finds the first page of a time range with a binary search over the slots
+ * and a scan of at most n pages, instead of reading the sector entry by entry. A 4Kb sub-sector of slots is erased
+ * together with the data block holding the first page it indexes, so a slot is always erased before it is programmed.
+ *
+ * [Circular logging]
+ * In the circular mode (MemoryLoggingModeCircular, for pad holds, static fires and soak tests) the data sectors wrap around:
+ * the first page of every 64Kb block is a header holding the sequence number of the block and the timestamp of its first
+ * entry, the 255 pages after it hold the data. Block n of a sector always lives in its physical block n % blocks, and
+ * the erase-ahead scheduler erases the oldest block just before the write cursor reaches it. The newest block is found
+ * with a binary search over the headers, the oldest one is the first valid block after it, and the time range queries
+ * search the headers instead of the timestamp index, which only serves the linear mode.
+ *
+ * [Session directory]
+ * Every memory_manager_start ( ) opens a new session that goes on recording into the same user data sectors right after
+ * the previous one, so that several sims, ground tests and flights share the flash memory without erasing it in between.
+ * The 64Kb between the metadata and the diagnostics sectors hold the session directory: one page per session with the
+ * write cursors of every sector at its start, the logging mode and the configuration it was recorded with. When the
+ * session is stopped its summary (the write cursors at its end, duration, last flight state) is programmed into the
+ * erased tail of the same page, a session cut short by a power loss ends where the next one starts. Once a session has
+ * been selected with memory_manager_select_session ( ) the reads only see its pages and start right at its first one.
+ *
+ * [Flight summary sector]
+ * The flight summary (MemoryFlightSummaryU) is kept up to date with every sample: the extremes of every sensor channel,
+ * the time of every flight state transition, the highest altitude, the peak vertical velocity and the mean descent rates
+ * under both parachutes (the last three fed by the event detector). A copy of it is appended to the 64Kb summary sector
+ * on every flight state change and when the memory manager is stopped, so that the numbers of a flight survive the
+ * power-off and can be read back right away, and a flight interrupted by a reboot carries on with its summary.
  * */
 
 
@@ -84,44 +140,120 @@
 #define GLOBAL_CONFIGURATION_SECTOR_OFFSET              RESERVED_SECTORS_BASE_ADDRESS + GLOBAL_CONFIGURATION_SECTOR_SIZE
 
 #define MEMORY_METADATA_SECTOR_BASE                     GLOBAL_CONFIGURATION_SECTOR_OFFSET
-#define MEMORY_METADATA_SECTOR_SUB_COUNT                512 // 2 MB
+#define MEMORY_METADATA_SECTOR_SUB_COUNT                464 // 1856 KB: the former 2 MB minus the session directory, summary, diagnostics and timestamp index sectors
 
-#define MEMORY_METADATA_SECTOR_SIZE                     RESERVED_SECTORS_BASE_ADDRESS + RESERVED_SECTOR_SUB_SIZE * MEMORY_METADATA_SECTOR_SUB_COUNT // 2 MB
+#define MEMORY_METADATA_SECTOR_SIZE                     RESERVED_SECTORS_BASE_ADDRESS + RESERVED_SECTOR_SUB_SIZE * MEMORY_METADATA_SECTOR_SUB_COUNT // 1856 KB
 #define MEMORY_METADATA_SECTOR_OFFSET                   GLOBAL_CONFIGURATION_SECTOR_OFFSET + MEMORY_METADATA_SECTOR_SIZE
+#define MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT           ( RESERVED_SECTOR_SUB_SIZE / PAGE_SIZE )
+#define MEMORY_METADATA_SECTOR_PAGE_COUNT               ( MEMORY_METADATA_SECTOR_SUB_COUNT * MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT )
+
+// define the basic information about the session directory sector
+#define SESSION_DIRECTORY_SECTOR_BASE                   MEMORY_METADATA_SECTOR_OFFSET
+#define SESSION_DIRECTORY_SECTOR_SUB_COUNT              16 // 64 KB
+
+#define SESSION_DIRECTORY_SECTOR_SIZE                   ( RESERVED_SECTOR_SUB_SIZE * SESSION_DIRECTORY_SECTOR_SUB_COUNT ) // 64 KB
+#define SESSION_DIRECTORY_SECTOR_OFFSET                 ( SESSION_DIRECTORY_SECTOR_BASE + SESSION_DIRECTORY_SECTOR_SIZE )
+#define SESSION_DIRECTORY_CAPACITY                      ( SESSION_DIRECTORY_SECTOR_SIZE / PAGE_SIZE ) // one page per session
+
+// define the basic information about the flight summary sector
+#define SUMMARY_SECTOR_BASE                             SESSION_DIRECTORY_SECTOR_OFFSET
+#define SUMMARY_SECTOR_SUB_COUNT                        16 // 64 KB
+
+#define SUMMARY_SECTOR_SIZE                             ( RESERVED_SECTOR_SUB_SIZE * SUMMARY_SECTOR_SUB_COUNT ) // 64 KB
+#define SUMMARY_SECTOR_OFFSET                           ( SUMMARY_SECTOR_BASE + SUMMARY_SECTOR_SIZE )
+
+// define the basic information about the diagnostics sector
+#define DIAGNOSTICS_SECTOR_BASE                         SUMMARY_SECTOR_OFFSET
+#define DIAGNOSTICS_SECTOR_SUB_COUNT                    16 // 64 KB
+
+#define DIAGNOSTICS_SECTOR_SIZE                         ( RESERVED_SECTOR_SUB_SIZE * DIAGNOSTICS_SECTOR_SUB_COUNT ) // 64 KB
+#define DIAGNOSTICS_SECTOR_OFFSET                       ( DIAGNOSTICS_SECTOR_BASE + DIAGNOSTICS_SECTOR_SIZE )
+
+// define the basic information about the timestamp index sector
+#define TIMESTAMP_INDEX_SECTOR_BASE                     DIAGNOSTICS_SECTOR_OFFSET
+#define TIMESTAMP_INDEX_SECTOR_SUB_COUNT                14 // 56 KB
+
+#define TIMESTAMP_INDEX_SECTOR_SIZE                     ( RESERVED_SECTOR_SUB_SIZE * TIMESTAMP_INDEX_SECTOR_SUB_COUNT ) // 56 KB
+#define TIMESTAMP_INDEX_SECTOR_OFFSET                   ( TIMESTAMP_INDEX_SECTOR_BASE + TIMESTAMP_INDEX_SECTOR_SIZE )
+#define TIMESTAMP_INDEX_SLICE_SIZE                      ( TIMESTAMP_INDEX_SECTOR_SIZE / UserDataSectorCount ) // 8 KB
+#define TIMESTAMP_INDEX_SLOTS_PER_SECTOR                ( TIMESTAMP_INDEX_SLICE_SIZE / sizeof ( uint32_t ) )
+#define TIMESTAMP_INDEX_SLOTS_PER_SUB_SECTOR            ( RESERVED_SECTOR_SUB_SIZE / sizeof ( uint32_t ) )
 
 // define the basic information about the data sectors
-#define DATA_SECTORS_BASE                               MEMORY_METADATA_SECTOR_OFFSET
+#define DATA_SECTORS_BASE                               TIMESTAMP_INDEX_SECTOR_OFFSET
+#define DATA_SECTORS_BLOCK_SIZE                         FLASH_64KB_SECTOR_SIZE
+#define DATA_SECTORS_ALIGNED_BASE                       ( ( DATA_SECTORS_BASE + DATA_SECTORS_BLOCK_SIZE - 1 ) / DATA_SECTORS_BLOCK_SIZE * DATA_SECTORS_BLOCK_SIZE )
+#define DATA_SECTORS_BLOCK_COUNT                        ( ( FLASH_SIZE_BYTES - DATA_SECTORS_ALIGNED_BASE ) / DATA_SECTORS_BLOCK_SIZE )
 #define PAGE_SIZE                                       FLASH_PAGE_SIZE
 
-#define IMU_ENTRIES_PER_PAGE                            ( ( int ) ( PAGE_SIZE / sizeof ( IMUDataU  ) ) )
-#define PRESSURE_ENTRIES_PER_PAGE                       ( ( int ) ( PAGE_SIZE / sizeof ( PressureDataU ) ) )
+#define toUserDataSector( memory_sector ) ( UserDataSector ) memory_sector - SystemSectorCount
+#define   toSystemSector( memory_sector ) ( SystemSector   ) memory_sector
+#define   toMemorySector( user_sector )   ( MemorySector   ) user_sector + SystemSectorCount
+
+// the layout of every sector is checked when it is built: a record has to fit a page, and the planned user data sectors
+// have to be made of whole blocks, fit the flash memory and have been planned with the records they hold
+#define MEMORY_SECTOR_CHECK( name, NAME, entry, label, lane, ... ) \
+    _Static_assert ( sizeof ( entry ) <= PAGE_SIZE, "a " label " record does not fit a page" );
 
-#define CONTINUITY_ENTRIES_PER_PAGE                     ( ( int ) ( PAGE_SIZE / sizeof ( ContinuityU ) ) )
-#define FLIGHT_EVENT_ENTRIES_PER_PAGE                   ( ( int ) ( PAGE_SIZE / sizeof ( FlightEventU ) ) )
+#define MEMORY_USER_DATA_SECTOR_CHECK( name, NAME, entry, label, lane, member, rate, axes ) \
+    _Static_assert ( sizeof ( entry ) == userconf_MEM_SECTOR_ENTRY_SIZE_##NAME, "layout_planner.py plans the " label " sector with another record size" ); \
+    _Static_assert ( userconf_MEM_SECTOR_SIZE_##NAME % DATA_SECTORS_BLOCK_SIZE == 0, "the " label " sector is not made of whole blocks" ); \
+    _Static_assert ( sizeof ( ( ( DataContainer * ) 0 )->member.data ) == sizeof ( entry ), "the " label " records do not come in by DataContainer." #member );
 
-#define GLOBAL_CONFIGURATION_ENTRIES_PER_PAGE           ( ( int ) ( PAGE_SIZE / sizeof ( GlobalConfigurationU ) ) )
-#define MEMORY_METADATA_ENTRIES_PER_PAGE                ( ( int ) ( PAGE_SIZE / sizeof ( MemoryLayoutMetaDataU ) ) )
+#define MEMORY_USER_DATA_SECTOR_PLANNED_SIZE( name, NAME, entry, label, lane, ... ) \
+    + ( uint64_t ) userconf_MEM_SECTOR_SIZE_##NAME
 
-#define toUserDataSector( memory_sector ) ( UserDataSector ) memory_sector - 2
-#define   toSystemSector( memory_sector ) ( SystemSector   ) memory_sector
-#define   toMemorySector( user_sector )   ( MemorySector   ) user_sector + 2
+MEMORY_SYSTEM_SECTORS ( MEMORY_SECTOR_CHECK )
+MEMORY_USER_DATA_SECTORS ( MEMORY_SECTOR_CHECK )
+MEMORY_USER_DATA_SECTORS ( MEMORY_USER_DATA_SECTOR_CHECK )
+_Static_assert ( 0 MEMORY_USER_DATA_SECTORS ( MEMORY_USER_DATA_SECTOR_PLANNED_SIZE ) <= ( uint64_t ) DATA_SECTORS_BLOCK_COUNT * DATA_SECTORS_BLOCK_SIZE,
+                 "the planned user data sectors do not fit the flash memory" );
 
 // signature sequence used as an identification of the flash memory data validity
-// the sequence is written at the beginning of the first or the second 4KB subsector of the flash memory
-const char * MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE = "6e2201ac6e0d";
+// the sequence is written at the beginning of the first or the second 4KB subsector of the flash memory. It has to be
+// changed with the layout of the flash memory, so that a memory written by another layout is not read as this one.
+// "6e2201ac6e0d" was the layout before:
+//  - the IMU records of 10 bytes instead of 16,
+//  - the logging mode in the meta data,
+//  - the system sectors at their new addresses,
+//  - the meta data written as a ring with its cursor, and the session directory with its summary closed at the stop,
+//  - the time stamps of the samples in ms instead of RTOS ticks
+const char * MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE = "7a41c3f05b92";
 #define MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH                           12
 
 // Variable used to control the initialization process of the memory manager to prevent any actions if this flag is not set
 static bool prvIsInitialized = { 0 };
 
-// a circular buffer queue is a processing queue that is used to temporarily store the pages of information to be fetched by a flash write monitor
-//static buffer_queue prvPageBuffer = { 0 };
+// the page writer keeps a queue (lane) per kind of page. The flight events, the continuity status, the configuration,
+// the metadata and the session directory have a lane of their own: it is always served first, so its pages wait for
+// no longer than the page program in progress and never compete with the sensor pages for room. The sensor and the
+// diagnostics pages share the bulk lanes, drained in a weighted round robin so that neither starves the other
+typedef enum
+{
+    PageLaneCritical                                                                    = 0,
+    PageLaneInertial                                                                    = 1, // gyroscope, accelerometer, magnetometer
+    PageLaneEnvironment                                                                 = 2, // pressure, temperature, diagnostics
+
+} PageLane;
 
-QueueHandle_t xPageQueue;
+#define PAGE_LANE_CRITICAL_LENGTH                                                       8
+#define PAGE_LANE_BULK_LENGTH                                                           8 // a power of two, the bulk lanes are rings
+#define PAGE_LANE_INERTIAL_LENGTH                                                       PAGE_LANE_BULK_LENGTH
+#define PAGE_LANE_ENVIRONMENT_LENGTH                                                    PAGE_LANE_BULK_LENGTH
+#define PAGE_QUEUE_LENGTH                                                               ( PAGE_LANE_CRITICAL_LENGTH + PAGE_LANE_INERTIAL_LENGTH + PAGE_LANE_ENVIRONMENT_LENGTH )
+
+// a full critical lane holds the producer for up to a couple of page programs instead of dropping the page right away
+#define PAGE_LANE_CRITICAL_SEND_TIMEOUT                                                 pdMS_TO_TICKS(5)
+
+static const uint8_t prvPageLaneWeights [ MEMORY_PAGE_LANE_COUNT ] = { 0, 3, 1 }; // pages in a row per round, the critical lane is not weighted
+static const char *  prvPageLaneNames   [ MEMORY_PAGE_LANE_COUNT ] = { "critical", "inertial", "environ" };
+static uint8_t       prvPageLaneCredits [ MEMORY_PAGE_LANE_COUNT ] = { 0 };
+static PageLane      prvPageLaneCursor = PageLaneInertial; // the bulk lane the round robin goes on with
 
 
 #define METADATA_AUTOSAVE_DATA_BASED_INTERVAL                                           200
 #define METADATA_AUTOSAVE_TIME_BASED_INTERVAL                                           pdMS_TO_TICKS(250) // milliseconds to ticks
+#define DIAGNOSTICS_AUTOSAVE_TIME_BASED_INTERVAL                                        pdMS_TO_TICKS(5000) // milliseconds to ticks
 
 // used as an up-to-date representation of the meta data sector to be written to flash
 // the state of this structure is written to flash for every X any sensor (IMU, Pressure) data updates or every N time
@@ -131,7 +263,7 @@ QueueHandle_t xPageQueue;
 static MemoryLayoutMetaDataU prvMemoryMetaDataFlashSnapshot = { 0 };
 
 // used as a counter that once it reaches CONFIGURATION_AUTOSAVE_INTERVAL, prvGlobalConfigurationDiskSnapshot is then sent to the
-// flash write monitor processing queue (prvPageBuffer)
+// flash write monitor processing queues (prvCriticalPageLane, prvBulkPageLanes)
 static size_t prvMetadataAutosaveDataBasedCounter = { 0 };
 static size_t prvMetadataAutosaveTimeBasedCounter = { 0 };
 
@@ -149,44 +281,215 @@ static MemorySectorBuffer prvCurrentMemoryUserDataSectorRAMBuffers [UserDataSect
 
 static uint8_t     is_queue_monitor_running  = { 0 };
 static xTaskHandle prvQueueMonitorTaskHandle = { 0 };
+// set by the monitor once it has written the last pages and is about to delete itself, see memory_manager_stop ( )
+static volatile bool prvQueueMonitorExited = { false };
 
 typedef struct
 {
-    int8_t  type;
-    uint8_t data[256];
+    int8_t     type;
+    TickType_t queued; // tick count when the page was queued, used to measure the flush latency
+    uint8_t    data[256];
 } page_buffer_item;
 
+// page_buffer_item type of a diagnostics snapshot, it does not belong to any of the memory sectors
+#define PAGE_BUFFER_ITEM_DIAGNOSTICS                                                    MemorySectorCount
+// page_buffer_item types of a session directory entry and of its summary, programmed into the tail of the entry
+#define PAGE_BUFFER_ITEM_SESSION                                                        ( MemorySectorCount + 1 )
+#define PAGE_BUFFER_ITEM_SESSION_SUMMARY                                                ( MemorySectorCount + 2 )
+// page_buffer_item type of a flight summary snapshot
+#define PAGE_BUFFER_ITEM_FLIGHT_SUMMARY                                                 ( MemorySectorCount + 3 )
+
+// The critical lane is fed by more than one task, the configuration comes from the CLI, and its producers wait for room:
+// it is a kernel queue. The bulk lanes are fed by the flight controller task only, through memory_manager_user_data_update,
+// and drained by the monitor only: they are lock-free rings and the sensor pages are copied into them in place
+SPSC_RING( page_lane, page_buffer_item, PAGE_LANE_BULK_LENGTH )
+
+static QueueHandle_t  prvCriticalPageLane = NULL;
+static page_lane_ring prvBulkPageLanes [ MEMORY_PAGE_LANE_COUNT - PageLaneInertial ];
+
 static int prvLastPageSearchResults [ MemorySectorCount ] = { 0 };
 
+// the page of the metadata sector the next snapshot goes to, see [Metadata sector]
+static uint32_t prvMetaDataNextPageIndex = { 0 };
+
+// live throughput and back-pressure counters, reported by memory_manager_get_stats ( ) and periodically appended to the
+// diagnostics sector. They are updated by every task that queues a page (the flight controller, the CLI) and by the
+// monitor, often in the same lane: every update and the copy of memory_manager_get_diagnostics ( ) are made in a
+// critical section
+static MemoryDiagnosticsU prvDiagnostics = { 0 };
+static TickType_t prvDiagnosticsStartTick = { 0 };
+static TickType_t prvDiagnosticsAutosaveTimeBasedCounter = { 0 };
+static uint32_t   prvDiagnosticsNextPageIndex = { 0 };
+
+// erase-ahead scheduler: in the idle gaps between page programs the monitor keeps userconf_MEM_ERASE_AHEAD_BLOCKS erased
+// blocks ahead of every write cursor, so that a page program never waits for a block erase. An erase is only started when
+// it is expected to be over before the next page is queued, the expected erase time being the longest one measured so far
+#define ERASE_AHEAD_BLOCK_SIZE                                                          FLASH_64KB_SECTOR_SIZE
+#define ERASE_AHEAD_IDLE_POLL_INTERVAL                                                  ( pdMS_TO_TICKS(10) > 0 ? pdMS_TO_TICKS(10) : 1 )
+#define ERASE_AHEAD_WORST_CASE_ERASE_TIME                                               pdMS_TO_TICKS(2000) // flash_erase_64kb_sector ( ) until one is measured
+static uint32_t   prvEraseAheadNextBlock [ UserDataSectorCount ] = { 0 }; // the first logical block of a sector not known to be erased
+static TickType_t prvEraseAheadEraseTime = ERASE_AHEAD_WORST_CASE_ERASE_TIME;
+static bool       prvEraseAheadEraseTimeMeasured = false;
+static TickType_t prvPageLastQueued [ UserDataSectorCount ] = { 0 };
+static TickType_t prvPageInterval   [ UserDataSectorCount ] = { 0 }; // moving average of the time between two pages of a sector
+
+// header page of a block in the circular mode, the rest of the page stays erased
+#define RING_BLOCK_HEADER_SIGNATURE                                                     "RING"
+#define RING_BLOCK_HEADER_SIGNATURE_LENGTH                                              4
+typedef union RingBlockHeaderU
+{
+    struct ring_block_header_values {
+        uint8_t  signature [ RING_BLOCK_HEADER_SIGNATURE_LENGTH ];
+        uint32_t sequence;          // the block number counted from the first block ever written into the sector
+        uint32_t first_timestamp;   // the timestamp of the first entry of the block
+    } __attribute__((packed)) values;
+
+    uint8_t bytes [ sizeof ( struct ring_block_header_values ) ];
+
+} RingBlockHeaderU;
+
+// the session directory: the sessions recorded so far, the one being recorded and the one the reads are limited to
+static uint32_t       prvSessionCount = { 0 };
+static uint32_t       prvSessionCurrent = MEMORY_SESSION_ALL;
+static MemorySessionU prvSessionCurrentEntry = { 0 };
+static TickType_t     prvSessionStartTick = { 0 };
+static uint32_t       prvSessionSelected = MEMORY_SESSION_ALL;
+static uint32_t       prvSessionSelectedBegin [ UserDataSectorCount ] = { 0 };
+static uint32_t       prvSessionSelectedEnd   [ UserDataSectorCount ] = { 0 };
+
+// the flight summary of the current flight, the next free page of the summary sector and the last page written before
+// this power-on (UINT32_MAX if there was none)
+static MemoryFlightSummaryU prvFlightSummary = { 0 };
+static uint32_t             prvSummaryNextPageIndex = { 0 };
+static uint32_t             prvSummaryPreviousPageIndex = UINT32_MAX;
+
+// pages memory_manager_read_range ( ) reads from the flash memory at once
+#define RANGE_READ_BURST_PAGES                                                          4
+static uint8_t prvRangeReadBuffer [ RANGE_READ_BURST_PAGES * PAGE_SIZE ] = { 0 };
+
+// upper bounds (exclusive, in milliseconds) of the page flush latency histogram buckets
+static const uint32_t prvFlushLatencyBucketBounds [ MEMORY_FLUSH_LATENCY_BUCKET_COUNT ] = { 1, 2, 5, 10, 20, 50, 100, UINT32_MAX };
+
+// what the memory manager needs to know of the records of a sector, a record is written and read by indexing this table
+typedef struct
+{
+    uint16_t     entrySize;         // bytes of a record
+    uint16_t     entriesPerPage;
+    uint16_t     alignedSize;       // bytes of a page the records fill, the rest of the page is left blank
+    PageLane     lane;
+    const char * label;
+
+} MemorySectorDescriptor;
+
+#define MEMORY_SECTOR_DESCRIPTOR( name, NAME, entry, label, lane, ... ) \
+    { sizeof ( entry ), PAGE_SIZE / sizeof ( entry ), PAGE_SIZE / sizeof ( entry ) * sizeof ( entry ), PageLane##lane, label },
+
+static const MemorySectorDescriptor prvMemorySectors [ MemorySectorCount ] =
+{
+    MEMORY_SYSTEM_SECTORS ( MEMORY_SECTOR_DESCRIPTOR )
+    MEMORY_USER_DATA_SECTORS ( MEMORY_SECTOR_DESCRIPTOR )
+};
+
+// the system sectors are where memory_manager.c puts them, the user data sectors where the metadata says
+#define MEMORY_SYSTEM_SECTOR_INFO( name, NAME, entry, label, lane ) \
+    { .size = ( NAME##_SECTOR_SIZE ), .startAddress = ( NAME##_SECTOR_BASE ), .endAddress = ( NAME##_SECTOR_OFFSET ) },
+
+static const MemorySectorInfo prvSystemSectorInfos [ SystemSectorCount ] =
+{
+    MEMORY_SYSTEM_SECTORS ( MEMORY_SYSTEM_SECTOR_INFO )
+};
+
+
+// the logging rate control engine of the flight, see rate_control.h
+// the entries are time stamped in ms, whatever the tick rate
+static MemoryRateControl prvRateControl = { .flight_state = FLIGHT_STATE_LAUNCHPAD, .ticks_per_second = 1000 };
+
+
+// The pre-trigger ring (black box) keeps the last PRE_TRIGGER_RING_DURATION_MS of full-rate IMU and pressure records
+// while the rocket sits on the launchpad. On the pad it works as a delay line in front of the rate control: a record
+// is handed over to the rate control only once it gets older than the ring duration. As soon as the launch is detected
+// the content of the ring is written at full rate, followed by the live data, so the recorded timeline goes from the
+// decimated pad data straight into the full-rate seconds before the launch and the flight, without a gap or overlap.
+// The ring is drained no faster than the page writer can keep up with, see prvMemoryUserDataSectorHasRoom ( )
+#define PRE_TRIGGER_RING_DURATION_MS                                                    1000
+// the ring has to hold the whole duration at the rate of its fastest channel, plus a slack for the bursts of the FIFO
+// drains and a sensor clock running a little fast
+#define PRE_TRIGGER_RING_SLACK_MS                                                       250
+#define PRE_TRIGGER_RING_MAX_OF( a, b )                                                 ( ( a ) > ( b ) ? ( a ) : ( b ) )
+#define PRE_TRIGGER_RING_MAX_SAMPLE_RATE_HZ                                             PRE_TRIGGER_RING_MAX_OF ( PRE_TRIGGER_RING_MAX_OF ( userconf_MEM_SAMPLE_RATE_GYROSCOPE_HZ, userconf_MEM_SAMPLE_RATE_ACCELEROMETER_HZ ), userconf_MEM_SAMPLE_RATE_PRESSURE_HZ )
+#define PRE_TRIGGER_RING_CAPACITY                                                       ( PRE_TRIGGER_RING_MAX_SAMPLE_RATE_HZ * ( PRE_TRIGGER_RING_DURATION_MS + PRE_TRIGGER_RING_SLACK_MS ) / 1000 ) // records per channel, bounds the RAM use
+
+// a record leaves the ring on the pad once it is older than the duration, so the ring holds one more than the duration
+_Static_assert ( PRE_TRIGGER_RING_CAPACITY > userconf_MEM_SAMPLE_RATE_GYROSCOPE_HZ * PRE_TRIGGER_RING_DURATION_MS / 1000, "the pre-trigger ring cannot hold its duration of gyroscope samples" );
+_Static_assert ( PRE_TRIGGER_RING_CAPACITY > userconf_MEM_SAMPLE_RATE_ACCELEROMETER_HZ * PRE_TRIGGER_RING_DURATION_MS / 1000, "the pre-trigger ring cannot hold its duration of accelerometer samples" );
+_Static_assert ( PRE_TRIGGER_RING_CAPACITY > userconf_MEM_SAMPLE_RATE_PRESSURE_HZ * PRE_TRIGGER_RING_DURATION_MS / 1000, "the pre-trigger ring cannot hold its duration of pressure samples" );
+
+typedef struct
+{
+    uint32_t timestamp;         // timestamp of the entry, copied out of it since the entry is packed
+    union
+    {
+        IMUDataU      imu;
+        PressureDataU pressure;
+    } entry;
+
+} PreTriggerRecord;
+
+typedef struct
+{
+    UserDataSector   sector;
+    uint32_t         head;      // index of the oldest record
+    uint32_t         count;
+    PreTriggerRecord records [ PRE_TRIGGER_RING_CAPACITY ];
+
+} PreTriggerRing;
+
+static PreTriggerRing prvPreTriggerRings [ ] = {
+        { .sector = UserDataSectorGyro },
+        { .sector = UserDataSectorAccel },
+        { .sector = UserDataSectorPressure },
+};
+
+#define PRE_TRIGGER_RING_COUNT                                                          ( sizeof ( prvPreTriggerRings ) / sizeof ( prvPreTriggerRings [ 0 ] ) )
+
 
 static const MemoryManagerConfiguration prvDefaultMemoryManagerConfiguration = {
         // TODO: to be edited from GUI
-        .write_pre_launch_multiplier         = 0,
-        .write_pre_apogee_multiplier         = 0,
-        .write_post_apogee_multiplier        = 0,
-        .write_ground_multiplier             = 0,
-        .write_interval_accelerometer_ms     = 0,
-        .write_interval_gyroscope_ms         = 0,
-        .write_interval_magnetometer_ms      = 0,
-        .write_interval_pressure_ms          = 0,
-        .write_interval_altitude_ms          = 0,
-        .write_interval_temperature_ms       = 0,
-        .write_interval_flight_state_ms      = 0,
-        .write_drogue_continuity_ms          = 0,
-        .write_main_continuity_ms            = 0,
-
-        .user_data_sector_sizes              = {
-                0xE00000  /* Gyro  - 14MB  */,
-                0xE00000  /* Accel - 14MB  */,
-                0x04EC00  /* Mag   - 315KB */,
-                0x07E400  /* Press - 505KB */,
-                0x07E400  /* Temp  - 505KB */,
-                0x028000  /* Cont  - 160KB */,
-                0x028000  /* Temp  - 160KB */
-        }
+        // the write intervals are multiplied by the multiplier of the current flight phase: spend the flash bandwidth
+        // and capacity on the ascent and the descent, not on hours spent on the launchpad. 0 logs every sample.
+        // The values come from build-on-linux/memory-layout.yaml, and so do the planned sector sizes
+        .write_pre_launch_multiplier         = userconf_MEM_WRITE_PRE_LAUNCH_MULTIPLIER,
+        .write_pre_apogee_multiplier         = userconf_MEM_WRITE_PRE_APOGEE_MULTIPLIER,
+        .write_post_apogee_multiplier        = userconf_MEM_WRITE_POST_APOGEE_MULTIPLIER,
+        .write_ground_multiplier             = userconf_MEM_WRITE_GROUND_MULTIPLIER,
+        .write_interval_accelerometer_ms     = userconf_MEM_WRITE_INTERVAL_ACCELEROMETER_MS,
+        .write_interval_gyroscope_ms         = userconf_MEM_WRITE_INTERVAL_GYROSCOPE_MS,
+        .write_interval_magnetometer_ms      = userconf_MEM_WRITE_INTERVAL_MAGNETOMETER_MS,
+        .write_interval_pressure_ms          = userconf_MEM_WRITE_INTERVAL_PRESSURE_MS,
+        .write_interval_altitude_ms          = userconf_MEM_WRITE_INTERVAL_ALTITUDE_MS,
+        .write_interval_temperature_ms       = userconf_MEM_WRITE_INTERVAL_TEMPERATURE_MS,
+        .write_interval_flight_state_ms      = userconf_MEM_WRITE_INTERVAL_FLIGHT_STATE_MS,
+        .write_drogue_continuity_ms          = userconf_MEM_WRITE_INTERVAL_DROGUE_CONTINUITY_MS,
+        .write_main_continuity_ms            = userconf_MEM_WRITE_INTERVAL_MAIN_CONTINUITY_MS,
+
+#define MEMORY_USER_DATA_SECTOR_SIZE( name, NAME, entry, label, lane, ... )  userconf_MEM_SECTOR_SIZE_##NAME,
+        .user_data_sector_sizes              = { MEMORY_USER_DATA_SECTORS ( MEMORY_USER_DATA_SECTOR_SIZE ) }
+#undef MEMORY_USER_DATA_SECTOR_SIZE
 
 };
 
+static const MemoryLayoutPhaseDurations prvDefaultPhaseDurations = {
+        .pre_launch_s                        = userconf_MEM_PHASE_DURATION_PRE_LAUNCH_S,
+        .pre_apogee_s                        = userconf_MEM_PHASE_DURATION_PRE_APOGEE_S,
+        .post_apogee_s                       = userconf_MEM_PHASE_DURATION_POST_APOGEE_S,
+        .ground_s                            = userconf_MEM_PHASE_DURATION_GROUND_S
+};
+
+// how often the sensors deliver a new sample, the flight events are logged once per flight state instead
+#define MEMORY_USER_DATA_SECTOR_SAMPLE_RATE( name, NAME, entry, label, lane, member, rate, axes )   rate,
+static const uint32_t prvLayoutSampleRatesHz [ UserDataSectorCount ] = { MEMORY_USER_DATA_SECTORS ( MEMORY_USER_DATA_SECTOR_SAMPLE_RATE ) };
+#undef MEMORY_USER_DATA_SECTOR_SAMPLE_RATE
+
 MemoryManagerConfiguration memory_manager_get_default_memory_configurations ( )
 {
     return prvDefaultMemoryManagerConfiguration;
@@ -197,9 +500,16 @@ void memory_manager_set_metadata_update_mode ( MetaDataUpdateFrequencyMode mode
     prvMetaDataUpdateMode = mode;
 }
 
+MemoryLayoutPhaseDurations memory_manager_get_default_phase_durations ( )
+{
+    return prvDefaultPhaseDurations;
+}
+
 static void prvQueueMonitorTask ( void * arg );
+static void prvQueueMonitorWritePage ( page_buffer_item * item );
 
 static uint32_t prvMemorySectorGetSize ( MemorySector sector );
+int prvMemorySectorGetPageCount ( MemorySector sector );
 static uint32_t prvMemorySectorGetDataEntriesPerPage ( MemorySector sector );
 static uint32_t prvMemorySectorGetDataStructSize ( MemorySector sector );
 static uint32_t prvMemorySectorGetAlignedDataStructSize ( MemorySector sector );
@@ -209,13 +519,82 @@ static MemoryManagerStatus prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserD
 static MemoryManagerStatus prvMemoryAsyncWriteAnyMemorySectorIfAvailable ( );
 static MemoryManagerStatus prvMemoryWriteAsyncMetaDataSector ( );
 static MemoryManagerStatus prvMemoryWriteAsyncGlobalConfigurationSector ( );
+static MemoryManagerStatus prvMemoryWriteAsyncDiagnosticsSector ( );
+static MemoryManagerStatus prvMemoryQueuePage ( page_buffer_item * item );
+static void prvMemoryRecordPageFlush ( page_buffer_item * item, MemoryManagerStatus status );
+static MemoryManagerStatus prvSearchForNextFreePage ( uint32_t base, uint32_t size, uint32_t * result );
+static MemoryManagerStatus prvMetaDataSearchForNewestPage ( uint32_t * result, bool * found );
 static MemoryManagerStatus prvVerifySystemSectorIntegrity ( SystemSector sector, uint8_t * data, bool * status );
 static MemoryManagerStatus prvMemoryAccessPage ( MemorySector sector, MemorySectorInfo info, int64_t pageIndex, uint8_t * dest );
 static MemoryManagerStatus prvMemorySystemSectorWritePageNow ( SystemSector sector, uint8_t * data );
 static MemoryManagerStatus prvMemoryWritePageNow ( MemorySectorInfo info, uint8_t * data );
-static MemoryManagerStatus prvMemoryAccessSectorSingleDataEntry ( MemorySector sector, MemorySectorInfo info, uint32_t index, void * dst );
+static MemoryManagerStatus prvMemoryAccessSectorSingleDataEntry ( MemorySector sector, MemorySectorInfo info, uint32_t firstPage, uint32_t index, void * dst );
 static MemoryManagerStatus prvMemoryAccessLastDataEntry ( MemorySector sector, MemorySectorInfo info, void * dst );
 static MemoryManagerStatus prvGetMemorySectorInfo ( MemorySector sector, MemorySectorInfo * info );
+static void prvMemoryLogRateControlled ( UserDataSector sector, uint8_t * entry );
+static void prvMemoryLogMeasurement ( UserDataSector sector, uint8_t * entry );
+static bool prvMemoryUserDataSectorHasRoom ( UserDataSector sector );
+static PreTriggerRing * prvPreTriggerRingGet ( UserDataSector sector );
+static uint64_t prvLayoutGetChannelRateMilliHz ( uint32_t interval_ms, uint32_t sample_rate_hz );
+static uint32_t prvTimestampIndexGetStride ( MemorySectorInfo info );
+static void prvTimestampIndexRecordPage ( UserDataSector sector, uint32_t pageIndex, uint8_t * page );
+static MemoryManagerStatus prvTimestampIndexSeek ( UserDataSector sector, MemorySectorInfo info, uint32_t firstPage, uint32_t t_begin, uint32_t * pageIndex );
+static MemoryManagerStatus prvTimestampIndexEraseForBlock ( UserDataSector sector, uint32_t block );
+static MemoryManagerStatus prvReadRangeWindow ( MemorySector sector, MemorySectorInfo info, uint32_t firstPage, uint32_t t_begin, uint32_t t_end, MemoryRangeCallback callback, void * arg, bool * stopped );
+static void prvEraseAheadInit ( );
+static bool prvEraseAheadIsEligible ( MemorySectorInfo info );
+static MemoryManagerStatus prvEraseAheadEraseNextBlock ( UserDataSector sector );
+static void prvEraseAheadRunIfIdle ( );
+static void prvEraseAheadEnsureErased ( UserDataSector sector );
+static bool prvMemoryIsCircular ( );
+static uint32_t prvMemoryDataPagesPerBlock ( );
+static uint32_t prvMemoryUserDataBlockAddress ( MemorySectorInfo info, uint32_t block );
+static uint32_t prvMemoryUserDataPageAddress ( MemorySectorInfo info, uint32_t page );
+static bool prvRingReadBlockHeader ( MemorySectorInfo info, uint32_t physical, RingBlockHeaderU * header );
+static MemoryManagerStatus prvRingWriteBlockHeader ( MemorySectorInfo info, uint32_t block, uint8_t * page );
+static bool prvRingFindNewestBlock ( MemorySectorInfo info, RingBlockHeaderU * newest );
+static bool prvRingFindOldestBlock ( MemorySectorInfo info, RingBlockHeaderU * oldest );
+static MemoryManagerStatus prvRingSeek ( MemorySectorInfo info, uint32_t firstPage, uint32_t t_begin, uint32_t * pageIndex );
+static void prvRingRestoreWriteCursors ( );
+static void prvLinearRestoreWriteCursors ( );
+static MemoryManagerStatus prvSessionOpen ( );
+static MemoryManagerStatus prvSessionClose ( );
+static MemoryManagerStatus prvSessionGetBounds ( uint32_t session, uint32_t * begin, uint32_t * end );
+static void prvSessionApplyWindow ( MemorySector sector, MemorySectorInfo * info, uint32_t * firstPage );
+static void prvSummaryReset ( );
+static MemoryManagerStatus prvSummaryWriteAsync ( );
+
+
+MemoryManagerStatus memory_manager_set_logging_mode ( MemoryLoggingMode mode )
+{
+    if ( ! prvIsInitialized || mode >= MemoryLoggingModeCount )
+    {
+        return MEM_ERR;
+    }
+
+    // the mode decides where the pages go, so it can only be changed while every data sector is still empty
+    MemoryLoggingMode previous = prvMemoryMetaDataFlashSnapshot.values.logging_mode;
+    prvMemoryMetaDataFlashSnapshot.values.logging_mode = mode;
+
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        MemorySectorInfo info = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
+        if ( info.bytesWritten != 0 || ( mode == MemoryLoggingModeCircular && ! prvEraseAheadIsEligible ( info ) ) )
+        {
+            prvMemoryMetaDataFlashSnapshot.values.logging_mode = previous;
+            return MEM_ERR;
+        }
+    }
+
+    prvEraseAheadInit ( );
+
+    return prvMemoryWriteAsyncMetaDataSector ( );
+}
+
+MemoryLoggingMode memory_manager_get_logging_mode ( )
+{
+    return prvMemoryIsCircular ( ) ? MemoryLoggingModeCircular : MemoryLoggingModeLinear;
+}
 
 MemoryManagerStatus memory_manager_init ( ) /* noexcept */
 {
@@ -241,7 +620,6 @@ MemoryManagerStatus memory_manager_init ( ) /* noexcept */
     }
 
     // important part of initialization is the buffer queue that will hold a page of information to be written to the flash memory
-    //buffer_queue_init ( &prvPageBuffer );
 
     bool isIntegrityOK = false;
 
@@ -287,13 +665,29 @@ MemoryManagerStatus memory_manager_init ( ) /* noexcept */
         // Thus, we need to set everything we read to zeros
         memset ( &prvMemoryMetaDataFlashSnapshot.bytes, 0, sizeof ( MemoryLayoutMetaDataU ) );
 
+        // the configured sector sizes are used as long as they fit into the flash memory, otherwise we fall back onto
+        // the layout planned from the configured logging rates
+        MemoryManagerConfiguration configuration = prvGlobalConfigurationDiskSnapshot.values.memory;
+        if ( ! memory_manager_validate_layout ( configuration ) )
+        {
+            MemoryLayoutPlan plan;
+            if ( ! memory_manager_plan_layout ( configuration, prvDefaultPhaseDurations, &plan ) )
+            {
+                // even the expected mission does not fit, the planned layout still covers the whole flash memory
+                DEBUG_LINE ( "memory layout: the expected mission needs %lu blocks, %lu available", ( unsigned long ) plan.blocks_needed, ( unsigned long ) plan.blocks_available );
+            }
+
+            memcpy ( configuration.user_data_sector_sizes, plan.sector_sizes, sizeof ( plan.sector_sizes ) );
+            prvGlobalConfigurationDiskSnapshot.values.memory = configuration;
+        }
+
         // for user data sectors
-        int32_t globalOffset = DATA_SECTORS_BASE;
+        int32_t globalOffset = DATA_SECTORS_ALIGNED_BASE;
         for ( UserDataSector sectorIndex  = UserDataSectorGyro; sectorIndex < UserDataSectorCount; sectorIndex++ )
         {
             MemorySectorInfo * sectorInfo = &prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sectorIndex ];
             sectorInfo->startAddress = globalOffset;
-            sectorInfo->size         = prvDefaultMemoryManagerConfiguration.user_data_sector_sizes[ sectorIndex ];
+            sectorInfo->size         = configuration.user_data_sector_sizes[ sectorIndex ];
 
             globalOffset += sectorInfo->size;
 
@@ -302,95 +696,190 @@ MemoryManagerStatus memory_manager_init ( ) /* noexcept */
             sectorInfo->bytesWritten = 0; /* nothing has been written to this memory sector, hence — 0 */
         }
 
+        prvMemoryMetaDataFlashSnapshot.values.logging_mode = userconf_MEM_CIRCULAR_LOGGING_ON ? MemoryLoggingModeCircular : MemoryLoggingModeLinear;
+
         // storing the signature number
         memcpy ( prvMemoryMetaDataFlashSnapshot.values.signature, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH );
         prvMemoryWriteAsyncGlobalConfigurationSector();
     }
 
-    xPageQueue = xQueueCreate ( 10, sizeof ( page_buffer_item ) );
+    // the next snapshot goes right after the newest page, whether or not it could be used
+    uint32_t newestMetaDataPage = 0;
+    bool     hasMetaDataPage    = false;
+    if ( ! prvMetaDataSearchForNewestPage ( &newestMetaDataPage, &hasMetaDataPage ) )
+    {
+        return MEM_ERR;
+    }
 
-    // initialization flag
-    prvIsInitialized = true;
+    prvMetaDataNextPageIndex = hasMetaDataPage ? ( newestMetaDataPage + 1 ) % MEMORY_METADATA_SECTOR_PAGE_COUNT : 0;
 
-    // returns OK status
-    return MEM_OK;
-}
+    // the metadata is only saved every so often, the pages written after it tell where the sectors really stopped.
+    // A fresh layout has nothing to restore, whatever is found in its sectors is left over from an older layout
+    if ( isIntegrityOK && prvMemoryIsCircular ( ) )
+    {
+        prvRingRestoreWriteCursors ( );
+    }
+    else if ( isIntegrityOK )
+    {
+        prvLinearRestoreWriteCursors ( );
+    }
 
-MemoryManagerStatus memory_manager_start ( )
-{
-    if ( ! prvIsInitialized )
+    // nothing is known to be erased past the write cursors yet
+    prvEraseAheadInit ( );
+
+    // find out where the previous sessions stopped recording their diagnostics
+    if ( ! prvSearchForNextFreePage ( DIAGNOSTICS_SECTOR_BASE, DIAGNOSTICS_SECTOR_SIZE, &prvDiagnosticsNextPageIndex ) )
     {
         return MEM_ERR;
     }
 
-    if ( pdFALSE == xTaskCreate ( prvQueueMonitorTask, "mem-manager", configMINIMAL_STACK_SIZE, NULL, 5, &prvQueueMonitorTaskHandle ) )
+    // and how many sessions have been recorded before this one
+    if ( ! prvSearchForNextFreePage ( SESSION_DIRECTORY_SECTOR_BASE, SESSION_DIRECTORY_SECTOR_SIZE, &prvSessionCount ) )
     {
         return MEM_ERR;
     }
 
-    return MEM_OK;
-}
+    // the last flight summary written before the power-on is the summary of the previous flight
+    if ( ! prvSearchForNextFreePage ( SUMMARY_SECTOR_BASE, SUMMARY_SECTOR_SIZE, &prvSummaryNextPageIndex ) )
+    {
+        return MEM_ERR;
+    }
 
-MemoryManagerStatus memory_manager_stop ( )
-{
-    is_queue_monitor_running = 0;
+    prvSummaryPreviousPageIndex = prvSummaryNextPageIndex > 0 ? prvSummaryNextPageIndex - 1 : UINT32_MAX;
+    prvSummaryReset ( );
+
+    prvCriticalPageLane = xQueueCreate ( PAGE_LANE_CRITICAL_LENGTH, sizeof ( page_buffer_item ) );
+    if ( prvCriticalPageLane == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    for ( PageLane lane = PageLaneInertial; lane < MEMORY_PAGE_LANE_COUNT; lane++ )
+    {
+        page_lane_ring_reset ( &prvBulkPageLanes[ lane - PageLaneInertial ] );
+    }
+
+    // initialization flag
+    prvIsInitialized = true;
+
+    // returns OK status
     return MEM_OK;
 }
 
-MemoryManagerStatus memory_manager_user_data_update ( DataContainer * _container )
+MemoryManagerStatus memory_manager_start ( )
 {
-    if ( prvIsInitialized == false )
+    if ( ! prvIsInitialized || is_queue_monitor_running )
     {
         return MEM_ERR;
     }
 
-    if ( _container == NULL )
+    // set before the monitor runs, so that a stop coming right after the start still closes the session
+    is_queue_monitor_running = 1;
+    prvQueueMonitorExited    = false;
+
+    if ( pdFALSE == xTaskCreate ( prvQueueMonitorTask, "mem-manager", configMINIMAL_STACK_SIZE, NULL, 5, &prvQueueMonitorTaskHandle ) )
     {
+        is_queue_monitor_running = 0;
         return MEM_ERR;
     }
 
-    if ( _container->gyro.updated )
+    // a full directory is not fatal: the recording goes on as a part of the last session
+    if ( ! prvSessionOpen ( ) )
     {
-        prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSectorGyro, _container->gyro.data.bytes );
-        _container->gyro.updated = 0;
+        DEBUG_LINE ( "memory manager: the session directory is full, %i sessions", SESSION_DIRECTORY_CAPACITY );
     }
 
-    if ( _container->acc.updated )
+    // a reboot in the middle of a flight carries on with the summary of that flight, otherwise a new summary begins
+    MemoryFlightSummaryU previous;
+    if ( prvSummaryPreviousPageIndex != UINT32_MAX &&
+         FLASH_OK == flash_read ( SUMMARY_SECTOR_BASE + prvSummaryPreviousPageIndex * PAGE_SIZE, previous.bytes, sizeof ( MemoryFlightSummaryU ) ) &&
+         memcmp ( previous.values.signature, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH ) == 0 &&
+         previous.values.flight_state >= FLIGHT_STATE_PRE_APOGEE && previous.values.flight_state < FLIGHT_STATE_LANDED )
     {
-        prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSectorAccel, _container->acc.data.bytes );
-        _container->acc.updated = 0;
+        prvFlightSummary = previous;
     }
 
-    if ( _container->mag.updated )
+    prvFlightSummary.values.session = prvSessionCurrent;
+
+    // the rates are measured from this point on
+    prvDiagnosticsStartTick                = xTaskGetTickCount ( );
+    prvDiagnosticsAutosaveTimeBasedCounter = prvDiagnosticsStartTick;
+
+    return MEM_OK;
+}
+
+MemoryManagerStatus memory_manager_stop ( )
+{
+    // stopping twice, or without a start, has nothing to close
+    if ( ! is_queue_monitor_running )
     {
-        prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSectorMag, _container->mag.data.bytes );
-        _container->mag.updated = 0;
+        return MEM_ERR;
     }
 
-    if ( _container->press.updated )
+    // leave the last word about the session in the diagnostics sector and the session directory
+    prvMemoryWriteAsyncDiagnosticsSector ( );
+    prvSummaryWriteAsync ( );
+    prvSessionClose ( );
+
+    // the monitor writes whatever is still queued before it exits, the next start must not find it running
+    is_queue_monitor_running = 0;
+    xTaskNotifyGive ( prvQueueMonitorTaskHandle );
+    while ( ! prvQueueMonitorExited )
     {
-        prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSectorPressure, _container->press.data.bytes );
-        _container->press.updated = 0;
+        vTaskDelay ( 1 );
     }
 
-    if ( _container->temp.updated )
+    prvQueueMonitorTaskHandle = NULL;
+
+    return MEM_OK;
+}
+
+MemoryManagerStatus memory_manager_user_data_update ( DataContainer * _container )
+{
+    if ( prvIsInitialized == false )
     {
-        prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSectorTemperature, _container->temp.data.bytes );
-        _container->temp.updated = 0;
+        return MEM_ERR;
     }
 
-    if ( _container->cont.updated )
+    if ( _container == NULL )
     {
-        prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSectorContinuity, _container->cont.data.bytes );
-        _container->cont.updated = 0;
+        return MEM_ERR;
     }
 
+    // the flight event goes first: a new flight phase applies its logging rates to the rest of this update already
     if ( _container->event.updated )
     {
+        if ( prvRateControl.flight_state == FLIGHT_STATE_LAUNCHPAD && _container->event.data.values.status != FLIGHT_STATE_LAUNCHPAD )
+        {
+            // lift-off: the pre-trigger rings are about to be written at full rate, so the averaging windows still
+            // holding older pad samples must not be emitted after them
+            for ( size_t ring = 0; ring < PRE_TRIGGER_RING_COUNT; ring++ )
+            {
+                rate_control_restart_channel ( &prvRateControl, prvPreTriggerRings [ ring ].sector );
+            }
+        }
+
+        prvRateControl.flight_state = _container->event.data.values.status;
         prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSectorFlightEvent, _container->event.data.bytes );
         _container->event.updated = 0;
+
+        // every flight state change is a milestone of the flight summary, it goes onto the flash memory right away
+        flight_summary_mark_state ( &prvFlightSummary, prvRateControl.flight_state, _container->event.data.values.timestamp );
+        prvSummaryWriteAsync ( );
     }
 
+    // the measurements, in the order of the sectors: the flight event is done already
+#define MEMORY_USER_DATA_SECTOR_LOG( name, NAME, entry, label, lane, member, rate, axes ) \
+    if ( UserDataSector##name != UserDataSectorFlightEvent && _container->member.updated ) \
+    { \
+        flight_summary_update_channel ( &prvFlightSummary, UserDataSector##name, _container->member.data.bytes ); \
+        prvMemoryLogMeasurement ( UserDataSector##name, _container->member.data.bytes ); \
+        _container->member.updated = 0; \
+    }
+
+    MEMORY_USER_DATA_SECTORS ( MEMORY_USER_DATA_SECTOR_LOG )
+#undef MEMORY_USER_DATA_SECTOR_LOG
+
     // of course we are not forgetting to check on the metadata entry whether it is the time to flush it onto the disk
     if ( prvMetaDataUpdateMode == MetaDataUpdateDataBasedFrequencyMode )
     {
@@ -418,812 +907,2679 @@ MemoryManagerStatus memory_manager_user_data_update ( DataContainer * _container
         }
     }
 
-    return MEM_OK;
-}
-
-MemoryManagerStatus memory_manager_get_system_configurations ( FlightSystemConfiguration * systemConfiguration )
-{
-    if ( systemConfiguration == NULL )
+    // the diagnostics are only interesting over seconds, so they are always saved based on time
+    if ( ( xTaskGetTickCount ( ) - prvDiagnosticsAutosaveTimeBasedCounter ) >= DIAGNOSTICS_AUTOSAVE_TIME_BASED_INTERVAL )
     {
-        return MEM_ERR;
+        prvMemoryWriteAsyncDiagnosticsSector ( );
+        prvDiagnosticsAutosaveTimeBasedCounter = xTaskGetTickCount ( );
     }
 
-    memcpy ( systemConfiguration, &prvGlobalConfigurationDiskSnapshot.values.system, sizeof ( FlightSystemConfiguration ) );
-
     return MEM_OK;
 }
 
-MemoryManagerStatus memory_manager_set_system_configurations ( FlightSystemConfiguration * systemConfiguration )
+// runs the entry through the rate control of its sector and adds it to the RAM buffer if it is to be logged
+static void prvMemoryLogRateControlled ( UserDataSector sector, uint8_t * entry )
 {
-    if ( systemConfiguration == NULL )
-    {
-        return MEM_ERR;
-    }
+    // copied out since the configuration is packed
+    MemoryManagerConfiguration configuration = prvGlobalConfigurationDiskSnapshot.values.memory;
 
-    if ( !prvIsInitialized )
+    // every user data entry starts with its timestamp: the windows follow the time of the samples, not of the logging
+    uint32_t timestamp;
+    memcpy ( &timestamp, entry, sizeof ( uint32_t ) );
+
+    if ( rate_control_accept ( &prvRateControl, configuration, sector, entry, timestamp ) )
     {
-        return MEM_ERR;
+        prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( sector, entry );
     }
-
-    memset ( &prvGlobalConfigurationDiskSnapshot.values.system, 0, sizeof ( FlightSystemConfiguration ) );
-    prvGlobalConfigurationDiskSnapshot.values.system = *systemConfiguration;
-
-    return prvMemoryWriteAsyncGlobalConfigurationSector ( );
 }
 
-MemoryManagerStatus memory_manager_get_memory_configurations ( MemoryManagerConfiguration * memoryConfiguration )
+// logs a new measurement, routing it through the pre-trigger ring of its sector if there is one in use
+static void prvMemoryLogMeasurement ( UserDataSector sector, uint8_t * entry )
 {
-    if ( memoryConfiguration == NULL )
-    {
-        return MEM_ERR;
-    }
+    PreTriggerRing * ring = prvPreTriggerRingGet ( sector );
+    bool onLaunchpad = prvRateControl.flight_state == FLIGHT_STATE_LAUNCHPAD;
 
-    if ( !prvIsInitialized )
+    // once the ring is drained after the launch the records go straight to the rate control
+    if ( ring == NULL || ( ! onLaunchpad && ring->count == 0 ) )
     {
-        return MEM_ERR;
+        prvMemoryLogRateControlled ( sector, entry );
+        return;
     }
 
-    memcpy ( memoryConfiguration, &prvGlobalConfigurationDiskSnapshot.values.memory, sizeof ( MemoryManagerConfiguration ) );
+    uint32_t size = prvMemorySectorGetDataStructSize ( toMemorySector ( sector ) );
 
-    return MEM_OK;
-}
+    // every user data entry starts with its timestamp: the window follows the time of the samples, which arrive in
+    // bursts from the FIFO drains
+    uint32_t now;
+    memcpy ( &now, entry, sizeof ( uint32_t ) );
 
-MemoryManagerStatus memory_manager_set_memory_configurations ( MemoryManagerConfiguration * memoryConfiguration )
-{
-    if ( memoryConfiguration == NULL )
+    if ( ring->count == PRE_TRIGGER_RING_CAPACITY )
     {
-        return MEM_ERR;
+        // bounded RAM: the oldest record has to go now, on the pad through the rate control, in flight as it is
+        PreTriggerRecord * oldest = &ring->records [ ring->head ];
+        if ( onLaunchpad )
+        {
+            prvMemoryLogRateControlled ( sector, oldest->entry.imu.bytes );
+        }
+        else
+        {
+            prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( sector, oldest->entry.imu.bytes );
+        }
+
+        ring->head = ( ring->head + 1 ) % PRE_TRIGGER_RING_CAPACITY;
+        ring->count--;
     }
 
-    memset ( &prvGlobalConfigurationDiskSnapshot.values.memory, 0, sizeof ( MemoryManagerConfiguration ) );
-    prvGlobalConfigurationDiskSnapshot.values.memory = *memoryConfiguration;
+    PreTriggerRecord * newest = &ring->records [ ( ring->head + ring->count ) % PRE_TRIGGER_RING_CAPACITY ];
+    newest->timestamp = now;
+    memcpy ( newest->entry.imu.bytes, entry, size );
+    ring->count++;
 
-    prvMemoryWriteAsyncGlobalConfigurationSector ( );
+    while ( ring->count > 0 )
+    {
+        PreTriggerRecord * oldest = &ring->records [ ring->head ];
 
-    return MEM_OK;
+        if ( onLaunchpad )
+        {
+            // on the pad only the records that went out of the pre-trigger window are logged, at the pad rate
+            if ( ( now - oldest->timestamp ) < PRE_TRIGGER_RING_DURATION_MS )
+            {
+                break;
+            }
+
+            prvMemoryLogRateControlled ( sector, oldest->entry.imu.bytes );
+        }
+        else
+        {
+            // in flight the ring is flushed at full rate, as fast as the page writer takes it
+            if ( ! prvMemoryUserDataSectorHasRoom ( sector ) )
+            {
+                break;
+            }
+
+            prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( sector, oldest->entry.imu.bytes );
+        }
+
+        ring->head = ( ring->head + 1 ) % PRE_TRIGGER_RING_CAPACITY;
+        ring->count--;
+    }
 }
 
-MemoryManagerStatus memory_manager_erase_configuration_section ( )
+// true if a new entry can be added to the RAM buffers of the sector without overwriting a page that was not flushed yet
+static bool prvMemoryUserDataSectorHasRoom ( UserDataSector sector )
 {
-    if ( FLASH_OK != flash_erase_4Kb_subsector ( GLOBAL_CONFIGURATION_SECTOR_BASE ) )
-    {
-        return MEM_ERR;
-    }
+    MemorySectorBuffer * buffer = &prvCurrentMemoryUserDataSectorRAMBuffers [ sector ];
 
-    return MEM_OK;
+    return buffer->write->info.bytesWritten < prvMemorySectorGetAlignedDataStructSize ( toMemorySector ( sector ) ) ||
+           buffer->read->info.bytesWritten == 0;
 }
 
-MemoryManagerStatus memory_manager_erase_everything ( )
+static PreTriggerRing * prvPreTriggerRingGet ( UserDataSector sector )
 {
-    if ( FLASH_OK != flash_erase_device ( ) )
+    for ( size_t ring = 0; ring < PRE_TRIGGER_RING_COUNT; ring++ )
     {
-        return MEM_ERR;
+        if ( prvPreTriggerRings [ ring ].sector == sector )
+        {
+            return &prvPreTriggerRings [ ring ];
+        }
     }
 
-    return MEM_OK;
+    return NULL;
 }
 
+void memory_manager_set_flight_state ( FlightState state )
+{
+    prvRateControl.flight_state = state;
+}
 
-MemoryManagerStatus prvVerifySystemSectorIntegrity ( SystemSector sector, uint8_t * data, bool * status )
+// the same planning is done at compile time by build-on-linux/layout_planner.py, keep the two in sync
+MemoryManagerStatus memory_manager_plan_layout ( MemoryManagerConfiguration configuration, MemoryLayoutPhaseDurations durations, MemoryLayoutPlan * plan )
 {
-    if ( data == NULL )
+    if ( plan == NULL )
     {
         return MEM_ERR;
     }
 
-    *status = false;
+    memset ( plan, 0, sizeof ( MemoryLayoutPlan ) );
 
-    MemorySectorInfo info = { 0 };
+    // the flight state every phase is logged in: the intervals come from the rate control itself, in milliseconds
+    const FlightState states  [ ] = { FLIGHT_STATE_LAUNCHPAD, FLIGHT_STATE_PRE_APOGEE, FLIGHT_STATE_POST_APOGEE, FLIGHT_STATE_LANDED };
+    const uint32_t    seconds [ ] = { durations.pre_launch_s, durations.pre_apogee_s, durations.post_apogee_s, durations.ground_s };
 
-    switch ( sector )
-    {
-        case SystemSectorGlobalConfigurationData:
-            info.startAddress = GLOBAL_CONFIGURATION_SECTOR_BASE;
-            info.endAddress   = GLOBAL_CONFIGURATION_SECTOR_OFFSET;
-            info.size         = GLOBAL_CONFIGURATION_SECTOR_SIZE;
-            break;
-        case SystemSectorUserDataSectorMetaData:
-            info.startAddress = MEMORY_METADATA_SECTOR_BASE;
-            info.endAddress   = MEMORY_METADATA_SECTOR_OFFSET;
-            info.size         = MEMORY_METADATA_SECTOR_SIZE;
-            break;
-        case SystemSectorCount:
-            return MEM_ERR;
-    }
+    MemoryRateControl control;
+    rate_control_init ( &control, 1000 );
 
-    MemoryBuffer buffer = { };
-    // try reading the metadata from flash before all (we first try the very first subsector)
-    if ( ! prvMemoryAccessPage ( ( MemorySector ) sector, info, -1, buffer.data ) )
-    {
-        return MEM_ERR;
-    }
+    uint32_t blocks [ UserDataSectorCount ] = { 0 };
 
-    memcpy ( data, buffer.data, prvMemorySectorGetDataStructSize ( ( MemorySector ) sector ) );
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        uint64_t size = prvMemorySectorGetDataStructSize ( toMemorySector ( sector ) );
 
+        if ( sector == UserDataSectorFlightEvent )
+        {
+            // a flight event is logged once per flight state
+            plan->bytes_needed[ sector ] = FLIGHT_STATE_COUNT * size;
+        }
+        else
+        {
+            uint64_t entries = 0; // in thousandths of an entry
 
-    // and then check whether that subsector is valid
-    if ( memcmp ( data, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH ) == 0 ) /* if signature sequences match */
-    {
-        *status = true;
-    }
-    else
-    {
-        *status = false;
-    }
+            for ( size_t phase = 0; phase < sizeof ( seconds ) / sizeof ( seconds [ 0 ] ); phase++ )
+            {
+                control.flight_state = states[ phase ];
+                entries += prvLayoutGetChannelRateMilliHz ( rate_control_get_interval ( &control, configuration, sector ), prvLayoutSampleRatesHz[ sector ] ) * seconds[ phase ];
+            }
 
-    return MEM_OK;
-}
+            uint64_t bytes = entries * size / 1000;
+            plan->bytes_needed[ sector ] = bytes > UINT32_MAX ? UINT32_MAX : ( uint32_t ) bytes;
+        }
 
+        uint32_t needed = ( uint32_t ) ( ( ( uint64_t ) plan->bytes_needed[ sector ] + DATA_SECTORS_BLOCK_SIZE - 1 ) / DATA_SECTORS_BLOCK_SIZE );
+        blocks[ sector ]     = needed > 0 ? needed : 1;
+        plan->blocks_needed += blocks[ sector ];
+    }
 
-MemoryManagerStatus prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSector sector, uint8_t * buffer )
-{
-    if ( prvIsInitialized == false )
+    plan->blocks_available = DATA_SECTORS_BLOCK_COUNT;
+
+    MemoryManagerStatus status = MEM_OK;
+    if ( plan->blocks_needed > plan->blocks_available )
     {
-        return MEM_ERR;
+        // the expected mission does not fit: start over from a block per sector and share the flash memory anyway,
+        // so that the caller still gets a usable layout
+        status = MEM_ERR;
+        for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+        {
+            blocks[ sector ] = 1;
+        }
     }
 
-    if ( buffer == NULL )
+    uint32_t used = 0;
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
     {
-        return MEM_ERR;
+        used += blocks[ sector ];
     }
 
-    uint32_t size = prvMemorySectorGetDataStructSize ( toMemorySector ( sector ) );
+    // the spare blocks are shared in proportion to what the sectors need, so that all of them run out at about the same
+    // time and as much of the flight as possible is recorded. The blocks the rounding down leaves over go to the largest
+    // remainders
+    uint64_t total = 0;
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        if ( sector != UserDataSectorFlightEvent )
+        {
+            total += plan->bytes_needed[ sector ];
+        }
+    }
 
-    int page_aligned_boundary = prvMemorySectorGetAlignedDataStructSize ( toMemorySector ( sector ) ) ;
-    // check whether the number of data entries filled up the page size, such that no more entries of this data type
-    // will fit into the page size without over-fitting.
-    if ( prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write->info.bytesWritten >= page_aligned_boundary )
+    if ( total > 0 && used < plan->blocks_available )
     {
-        // if there is no more room for another data entry then we signal to the monitor that it is time to take out this
-        // page and flush it ont ot the memory. To do that we swap the read and write buffer, so that the read buffer now
-        // contains that full page of data (write buffer), while the write buffer should be come empty and ready for new data
-        MemoryBuffer * temp_read = prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read;
-        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read  = prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write;
-        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write = temp_read;
+        uint32_t spare = plan->blocks_available - used;
+        uint64_t remainders [ UserDataSectorCount ] = { 0 };
 
-        // here's the signal to the monitor to process that page.
-        prvMemoryAsyncWriteAnyMemorySectorIfAvailable ( );
+        for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+        {
+            if ( sector == UserDataSectorFlightEvent )
+            {
+                continue;
+            }
 
-        // safeguard check: if the read buffer that was supposed to be processed by the monitor has actually been already processed or not yet
-        if ( temp_read->info.bytesWritten >= size )
+            uint64_t share = ( uint64_t ) spare * plan->bytes_needed[ sector ];
+            blocks[ sector ]     += ( uint32_t ) ( share / total );
+            used                 += ( uint32_t ) ( share / total );
+            remainders[ sector ]  = share % total;
+        }
+
+        for ( ; used < plan->blocks_available; used++ )
         {
-            // if not then the monitor did not manage to do it before we landed here. Maybe the producing data is faster than its consuming?
-            DEBUG_LINE ( "The page was not saved. Probably the monitor has stuck, or it ia just too slow for the data producer. Overwriting the page..." );
-            // resetting the current data pointer
-            prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write->info.bytesWritten = 0;
+            UserDataSector largest = UserDataSectorGyro;
+            for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+            {
+                if ( remainders[ sector ] > remainders[ largest ] )
+                {
+                    largest = sector;
+                }
+            }
+
+            blocks[ largest ]++;
+            remainders[ largest ] = 0;
         }
     }
 
-    // now that we emptied the write buffer and it is newly fresh and ready, we are copying the incoming data entry to it
-    MemoryBuffer * currentBuffer           = prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write;
-    uint8_t      * currWriteBufferPosition = &currentBuffer->data[ currentBuffer->info.bytesWritten ];
-    memcpy ( currWriteBufferPosition, buffer, size );
-    // and updating its current data pointer
-    currentBuffer->info.bytesWritten += size;
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        plan->sector_sizes[ sector ] = blocks[ sector ] * DATA_SECTORS_BLOCK_SIZE;
+    }
 
-    return MEM_OK;
+    return status;
 }
 
-MemoryManagerStatus prvMemoryWriteAsyncMetaDataSector ( )
+MemoryManagerStatus memory_manager_validate_layout ( MemoryManagerConfiguration configuration )
 {
-    if ( prvIsInitialized == false )
+    uint64_t total = 0;
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
     {
-        return MEM_ERR;
+        uint32_t size = configuration.user_data_sector_sizes[ sector ];
+        if ( size == 0 || size % DATA_SECTORS_BLOCK_SIZE != 0 )
+        {
+            return MEM_ERR;
+        }
+
+        total += size;
     }
 
-    page_buffer_item item = { };
-    item.type = MemorySystemSectorUserDataSectorMetaData;
-    memmove ( item.data, prvMemoryMetaDataFlashSnapshot.bytes, prvMemorySectorGetDataStructSize ( MemorySystemSectorUserDataSectorMetaData ) );
+    if ( total > ( uint64_t ) DATA_SECTORS_BLOCK_COUNT * DATA_SECTORS_BLOCK_SIZE )
+    {
+        return MEM_ERR;
+    }
 
-    return pdPASS == xQueueSend ( xPageQueue, (void *) &item, 0 ) ? MEM_OK : MEM_ERR;
+    return MEM_OK;
 }
 
-static MemoryManagerStatus prvMemoryWriteAsyncGlobalConfigurationSector ( )
+// logged entries per second, in thousandths, never more than the sensor delivers
+static uint64_t prvLayoutGetChannelRateMilliHz ( uint32_t interval_ms, uint32_t sample_rate_hz )
 {
-    if ( prvIsInitialized == false )
+    uint64_t rate = ( uint64_t ) sample_rate_hz * 1000;
+
+    if ( interval_ms == 0 )
     {
-        return MEM_ERR;
+        return rate;
     }
 
-    page_buffer_item item = { };
-    item.type = MemorySystemSectorGlobalConfigurationData;
-    memmove ( item.data, prvGlobalConfigurationDiskSnapshot.bytes, prvMemorySectorGetDataStructSize ( MemorySystemSectorGlobalConfigurationData ) );
-
-    return pdPASS == xQueueSend ( xPageQueue, (void *) &item, 0 ) ? MEM_OK : MEM_ERR;
+    return rate < 1000000 / interval_ms ? rate : 1000000 / interval_ms;
 }
 
-static MemoryManagerStatus  prvMemoryAsyncWriteAnyMemorySectorIfAvailable ( )
+MemoryManagerStatus memory_manager_get_system_configurations ( FlightSystemConfiguration * systemConfiguration )
 {
-    // free the read page
-    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    if ( systemConfiguration == NULL )
     {
-        int page_aligned_boundary = prvMemorySectorGetAlignedDataStructSize ( toMemorySector( sector ) );
-        if ( prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read->info.bytesWritten >= page_aligned_boundary )
-        {
-            page_buffer_item item = { } ;
-            item.type = toMemorySector ( sector ) ;
-            memcpy ( item.data, prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read->data, PAGE_SIZE ) ;
-
-            if ( pdPASS != xQueueSend ( xPageQueue, (void *) &item, 0 ) )
-            {
-                return MEM_ERR;
-            }
-        }
+        return MEM_ERR;
     }
 
+    memcpy ( systemConfiguration, &prvGlobalConfigurationDiskSnapshot.values.system, sizeof ( FlightSystemConfiguration ) );
+
     return MEM_OK;
 }
 
-MemoryManagerStatus prvMemoryWritePageNow ( MemorySectorInfo info, uint8_t * data )
+MemoryManagerStatus memory_manager_set_system_configurations ( FlightSystemConfiguration * systemConfiguration )
 {
-    if (prvIsInitialized == false)
+    if ( systemConfiguration == NULL )
     {
         return MEM_ERR;
     }
 
-    if (data == NULL)
+    if ( !prvIsInitialized )
     {
         return MEM_ERR;
     }
 
-    const uint32_t offset = info.startAddress + info.bytesWritten;
+    memset ( &prvGlobalConfigurationDiskSnapshot.values.system, 0, sizeof ( FlightSystemConfiguration ) );
+    prvGlobalConfigurationDiskSnapshot.values.system = *systemConfiguration;
 
-    return flash_write ( offset, data, PAGE_SIZE ) == FLASH_OK;
+    return prvMemoryWriteAsyncGlobalConfigurationSector ( );
 }
 
-
-MemoryManagerStatus prvMemorySystemSectorWritePageNow ( SystemSector sector, uint8_t * data )
+MemoryManagerStatus memory_manager_get_memory_configurations ( MemoryManagerConfiguration * memoryConfiguration )
 {
-    if ( data == NULL)
+    if ( memoryConfiguration == NULL )
     {
         return MEM_ERR;
     }
 
-    int offset = 0;
-
-    if ( sector == SystemSectorGlobalConfigurationData )
+    if ( !prvIsInitialized )
     {
+        return MEM_ERR;
+    }
 
-#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON == 0 )
-        memory_manager_erase_configuration_section ( );
-#else
-        offset = GLOBAL_CONFIGURATION_SECTOR_BASE;
-#endif
+    memcpy ( memoryConfiguration, &prvGlobalConfigurationDiskSnapshot.values.memory, sizeof ( MemoryManagerConfiguration ) );
 
-    }
+    return MEM_OK;
+}
 
-    else if ( sector == SystemSectorUserDataSectorMetaData )
+MemoryManagerStatus memory_manager_set_memory_configurations ( MemoryManagerConfiguration * memoryConfiguration )
+{
+    if ( memoryConfiguration == NULL )
     {
-        offset = MEMORY_METADATA_SECTOR_BASE + prvLastPageSearchResults [ MemorySystemSectorUserDataSectorMetaData ] * PAGE_SIZE;
+        return MEM_ERR;
     }
-    else
+
+    memset ( &prvGlobalConfigurationDiskSnapshot.values.memory, 0, sizeof ( MemoryManagerConfiguration ) );
+    prvGlobalConfigurationDiskSnapshot.values.memory = *memoryConfiguration;
+
+    prvMemoryWriteAsyncGlobalConfigurationSector ( );
+
+    return MEM_OK;
+}
+
+MemoryManagerStatus memory_manager_erase_configuration_section ( )
+{
+    if ( FLASH_OK != flash_erase_4Kb_subsector ( GLOBAL_CONFIGURATION_SECTOR_BASE ) )
     {
-        // we should not land here!
         return MEM_ERR;
     }
 
-    return flash_write ( offset, data, PAGE_SIZE ) == FLASH_OK;
+    return MEM_OK;
 }
 
-/**
- * @param sector: desired memory sector
- * @param pageIndex: -1 for the last available page in the given sector, 0-N to indicate the page index to be retrieved
- * @param dest: destination buffer (Note: MUST be at least 255 bytes of size)
- * @return MemoryManagerStatus: OK or ERR
- */
-static MemoryManagerStatus prvMemoryAccessPage ( MemorySector sector, MemorySectorInfo info, int64_t pageIndex, uint8_t * dest )
+MemoryManagerStatus memory_manager_erase_data_section ( )
 {
-    uint32_t PAGE_INDEX = 0;
+    // the monitor writes into the data sectors, they can only be erased while it is stopped
+    if ( ! prvIsInitialized || is_queue_monitor_running )
+    {
+        return MEM_ERR;
+    }
 
-    if ( pageIndex == -1 )
+    // the timestamp index and the session directory only describe the data, they go with it. The configuration, the
+    // metadata, the flight summaries and the diagnostics are kept
+    for ( uint32_t address = TIMESTAMP_INDEX_SECTOR_BASE; address < TIMESTAMP_INDEX_SECTOR_OFFSET; address += RESERVED_SECTOR_SUB_SIZE )
     {
-        if ( ! prvMemorySectorBinarySearchForLastWrittenPageIndex ( sector, info, &PAGE_INDEX ) )
+        if ( FLASH_OK != flash_erase_4Kb_subsector ( address ) )
         {
             return MEM_ERR;
         }
     }
-    else
+
+    for ( uint32_t address = SESSION_DIRECTORY_SECTOR_BASE; address < SESSION_DIRECTORY_SECTOR_OFFSET; address += RESERVED_SECTOR_SUB_SIZE )
     {
-        PAGE_INDEX = pageIndex;
+        if ( FLASH_OK != flash_erase_4Kb_subsector ( address ) )
+        {
+            return MEM_ERR;
+        }
     }
 
-    uint32_t address = info.startAddress + ( PAGE_INDEX * PAGE_SIZE );
+    for ( uint32_t address = DATA_SECTORS_ALIGNED_BASE; address < FLASH_SIZE_BYTES; address += DATA_SECTORS_BLOCK_SIZE )
+    {
+        if ( FLASH_OK != flash_erase_64kb_sector ( address ) )
+        {
+            return MEM_ERR;
+        }
+    }
 
-    if ( FLASH_OK != flash_read ( address, dest, PAGE_SIZE ) )
+    if ( FLASH_OK != flash_verify ( DATA_SECTORS_ALIGNED_BASE, NULL, FLASH_SIZE_BYTES - DATA_SECTORS_ALIGNED_BASE ) )
     {
         return MEM_ERR;
     }
 
-    return MEM_OK;
-}
-
-
-MemoryManagerStatus prvMemoryAccessSectorSingleDataEntry ( MemorySector sector, MemorySectorInfo info, uint32_t index, void * dst )
-{
-    uint8_t entries_per_page = prvMemorySectorGetDataEntriesPerPage ( sector );
-    uint8_t struct_size      = prvMemorySectorGetDataStructSize ( sector );
-
-    if ( PAGE_SIZE * trunc ( ( double ) index / prvMemorySectorGetDataEntriesPerPage ( sector ) ) > info.bytesWritten )
+    // and everything that remembers where the data went, as memory_manager_init ( ) finds it on an erased data section
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
     {
-        return MEM_ERR;
+        prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ].bytesWritten = 0;
+        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read->info.bytesWritten  = 0;
+        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write->info.bytesWritten = 0;
     }
 
-    if ( dst == NULL )
+    for ( size_t ring = 0; ring < PRE_TRIGGER_RING_COUNT; ring++ )
     {
-        return MEM_ERR;
+        prvPreTriggerRings [ ring ].head  = 0;
+        prvPreTriggerRings [ ring ].count = 0;
     }
 
-    MemoryBuffer buffer = { };
+    memset ( prvLastPageSearchResults, 0, sizeof ( prvLastPageSearchResults ) );
+    prvEraseAheadInit ( );
 
-    uint32_t pageIndex = ceil ( ( double ) index / entries_per_page );
+    prvSessionCount    = 0;
+    prvSessionCurrent  = MEMORY_SESSION_ALL;
+    prvSessionSelected = MEMORY_SESSION_ALL;
 
-    if ( ! prvMemoryAccessPage ( sector, info, pageIndex, buffer.data ) )
+    // the metadata is written right away, a power-on before the next start must not find the old write cursors
+    if ( ! prvMemorySystemSectorWritePageNow ( SystemSectorUserDataSectorMetaData, prvMemoryMetaDataFlashSnapshot.bytes ) )
     {
         return MEM_ERR;
     }
 
-    index = ( pageIndex * entries_per_page ) - index;
+    prvMetaDataNextPageIndex = ( prvMetaDataNextPageIndex + 1 ) % MEMORY_METADATA_SECTOR_PAGE_COUNT;
+
+    return MEM_OK;
+}
 
-    memcpy ( dst, &buffer.data [ index ], struct_size );
+MemoryManagerStatus memory_manager_erase_everything ( )
+{
+    if ( FLASH_OK != flash_erase_device ( ) )
+    {
+        return MEM_ERR;
+    }
 
     return MEM_OK;
 }
 
-static MemoryManagerStatus prvMemoryAccessLastDataEntry ( MemorySector sector, MemorySectorInfo info, void * dst )
+
+MemoryManagerStatus prvVerifySystemSectorIntegrity ( SystemSector sector, uint8_t * data, bool * status )
 {
-    if ( dst == NULL )
+    if ( data == NULL )
     {
         return MEM_ERR;
     }
 
-    if ( toSystemSector ( sector ) < SystemSectorCount )
+    *status = false;
+
+    MemorySectorInfo info = { 0 };
+
+    if ( sector >= SystemSectorCount )
     {
-        uint32_t lastPageIndex = 0;
-        if ( ! prvMemorySectorBinarySearchForLastWrittenPageIndex ( sector, info, &lastPageIndex ) )
-        {
-            return MEM_ERR;
-        }
+        return MEM_ERR;
+    }
 
-        if ( MEM_OK != prvMemoryAccessPage ( sector, info, lastPageIndex, dst ) )
-        {
-            return MEM_ERR;
-        }
+    info = prvSystemSectorInfos [ sector ];
+
+    MemoryBuffer buffer = { };
+    // try reading the metadata from flash before all (we first try the very first subsector)
+    if ( ! prvMemoryAccessPage ( ( MemorySector ) sector, info, -1, buffer.data ) )
+    {
+        return MEM_ERR;
     }
 
+    memcpy ( data, buffer.data, prvMemorySectorGetDataStructSize ( ( MemorySector ) sector ) );
+
+
+    // and then check whether that subsector is valid
+    if ( memcmp ( data, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH ) == 0 ) /* if signature sequences match */
+    {
+        *status = true;
+    }
     else
     {
-        uint32_t lastAddress = info.startAddress + info.bytesWritten - PAGE_SIZE +
-                               ( ( prvMemorySectorGetDataEntriesPerPage ( sector ) - 1 ) * prvMemorySectorGetDataStructSize ( sector ) );
-
-        if ( FLASH_OK != flash_read ( lastAddress, dst, prvMemorySectorGetDataStructSize ( sector ) ) )
-        {
-            return MEM_ERR;
-        }
+        *status = false;
     }
 
     return MEM_OK;
 }
 
-void prvQueueMonitorTask ( void * arg )
+
+MemoryManagerStatus prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( UserDataSector sector, uint8_t * buffer )
 {
-    ( void ) arg;
+    if ( prvIsInitialized == false )
+    {
+        return MEM_ERR;
+    }
+
+    if ( buffer == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    uint32_t size = prvMemorySectorGetDataStructSize ( toMemorySector ( sector ) );
+
+    int page_aligned_boundary = prvMemorySectorGetAlignedDataStructSize ( toMemorySector ( sector ) ) ;
+    // check whether the number of data entries filled up the page size, such that no more entries of this data type
+    // will fit into the page size without over-fitting.
+    if ( prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write->info.bytesWritten >= page_aligned_boundary )
+    {
+        // if there is no more room for another data entry then we signal to the monitor that it is time to take out this
+        // page and flush it ont ot the memory. To do that we swap the read and write buffer, so that the read buffer now
+        // contains that full page of data (write buffer), while the write buffer should be come empty and ready for new data
+        MemoryBuffer * temp_read = prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read;
+        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read  = prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write;
+        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write = temp_read;
+
+        // here's the signal to the monitor to process that page.
+        prvMemoryAsyncWriteAnyMemorySectorIfAvailable ( );
+
+        // safeguard check: if the read buffer that was supposed to be processed by the monitor has actually been already processed or not yet
+        if ( temp_read->info.bytesWritten >= size )
+        {
+            // if not then the monitor did not manage to do it before we landed here. Maybe the producing data is faster than its consuming?
+            DEBUG_LINE ( "The page was not saved. Probably the monitor has stuck, or it ia just too slow for the data producer. Overwriting the page..." );
+            taskENTER_CRITICAL ( );
+            prvDiagnostics.values.sectors[ toMemorySector ( sector ) ].pagesOverwritten++;
+            taskEXIT_CRITICAL ( );
+            // resetting the current data pointer
+            prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write->info.bytesWritten = 0;
+        }
+    }
+
+    // now that we emptied the write buffer and it is newly fresh and ready, we are copying the incoming data entry to it
+    MemoryBuffer * currentBuffer           = prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write;
+    uint8_t      * currWriteBufferPosition = &currentBuffer->data[ currentBuffer->info.bytesWritten ];
+    memcpy ( currWriteBufferPosition, buffer, size );
+    // and updating its current data pointer
+    currentBuffer->info.bytesWritten += size;
+
+    return MEM_OK;
+}
+
+MemoryManagerStatus prvMemoryWriteAsyncMetaDataSector ( )
+{
+    if ( prvIsInitialized == false )
+    {
+        return MEM_ERR;
+    }
 
-    is_queue_monitor_running = 1;
     page_buffer_item item = { };
-    MemoryManagerStatus status;
+    item.type = MemorySystemSectorUserDataSectorMetaData;
+    memmove ( item.data, prvMemoryMetaDataFlashSnapshot.bytes, prvMemorySectorGetDataStructSize ( MemorySystemSectorUserDataSectorMetaData ) );
 
-    while ( is_queue_monitor_running )
+    return prvMemoryQueuePage ( &item );
+}
+
+static MemoryManagerStatus prvMemoryWriteAsyncGlobalConfigurationSector ( )
+{
+    if ( prvIsInitialized == false )
+    {
+        return MEM_ERR;
+    }
+
+    page_buffer_item item = { };
+    item.type = MemorySystemSectorGlobalConfigurationData;
+    memmove ( item.data, prvGlobalConfigurationDiskSnapshot.bytes, prvMemorySectorGetDataStructSize ( MemorySystemSectorGlobalConfigurationData ) );
+
+    return prvMemoryQueuePage ( &item );
+}
+
+static MemoryManagerStatus prvMemoryWriteAsyncDiagnosticsSector ( )
+{
+    if ( prvIsInitialized == false )
+    {
+        return MEM_ERR;
+    }
+
+    page_buffer_item item = { };
+    item.type = PAGE_BUFFER_ITEM_DIAGNOSTICS;
+
+    MemoryDiagnosticsU diagnostics;
+    memory_manager_get_diagnostics ( &diagnostics );
+    memcpy ( item.data, diagnostics.bytes, sizeof ( MemoryDiagnosticsU ) );
+
+    return prvMemoryQueuePage ( &item );
+}
+
+static PageLane prvPageLaneOf ( int8_t type )
+{
+    if ( type >= 0 && type < MemorySectorCount )
+    {
+        return prvMemorySectors [ type ].lane;
+    }
+
+    return type == PAGE_BUFFER_ITEM_DIAGNOSTICS ? PageLaneEnvironment : PageLaneCritical;
+}
+
+static void prvMemoryDropPage ( int8_t type, PageLane lane )
+{
+    // the monitor does not keep up: the page is lost unless the caller retries it later
+    taskENTER_CRITICAL ( );
+
+    if ( type < MemorySectorCount )
+    {
+        prvDiagnostics.values.sectors[ type ].pagesDropped++;
+    }
+
+    prvDiagnostics.values.lanes[ lane ].pagesDropped++;
+
+    taskEXIT_CRITICAL ( );
+}
+
+static void prvMemoryPageQueued ( int8_t type, TickType_t queued )
+{
+    // the monitor polls the lanes anyway, the notification only saves it the wait
+    if ( prvQueueMonitorTaskHandle != NULL )
+    {
+        xTaskNotifyGive ( prvQueueMonitorTaskHandle );
+    }
+
+    if ( type >= MemoryUserDataSectorGyro && type < MemorySectorCount )
+    {
+        // the erase-ahead scheduler predicts the next page from the page rate of every sector
+        UserDataSector sector   = toUserDataSector ( type );
+        TickType_t     interval = queued - prvPageLastQueued[ sector ];
+
+        if ( prvPageLastQueued[ sector ] != 0 )
+        {
+            prvPageInterval[ sector ] = prvPageInterval[ sector ] == 0 ? interval : ( 3 * prvPageInterval[ sector ] + interval ) / 4;
+        }
+
+        prvPageLastQueued[ sector ] = queued;
+    }
+
+    uint32_t depth = uxQueueMessagesWaiting ( prvCriticalPageLane );
+    for ( PageLane waiting = PageLaneInertial; waiting < MEMORY_PAGE_LANE_COUNT; waiting++ )
+    {
+        depth += page_lane_ring_count ( &prvBulkPageLanes[ waiting - PageLaneInertial ] );
+    }
+
+    taskENTER_CRITICAL ( );
+    if ( depth > prvDiagnostics.values.queue_high_water_mark )
+    {
+        prvDiagnostics.values.queue_high_water_mark = depth;
+    }
+    taskEXIT_CRITICAL ( );
+}
+
+// the free item at the head of the bulk lane of the type, to be filled in place and queued by prvMemoryCommitPage
+static page_buffer_item * prvMemoryReservePage ( int8_t type )
+{
+    PageLane           lane = prvPageLaneOf ( type );
+    page_buffer_item * item = lane == PageLaneCritical ? NULL : page_lane_ring_reserve ( &prvBulkPageLanes[ lane - PageLaneInertial ] );
+
+    if ( item == NULL )
+    {
+        prvMemoryDropPage ( type, lane );
+        return NULL;
+    }
+
+    item->type = type;
+    return item;
+}
+
+static MemoryManagerStatus prvMemoryCommitPage ( page_buffer_item * item )
+{
+    const int8_t     type   = item->type;
+    const TickType_t queued = xTaskGetTickCount ( );
+
+    // the item belongs to the monitor once committed
+    item->queued = queued;
+    page_lane_ring_commit ( &prvBulkPageLanes[ prvPageLaneOf ( type ) - PageLaneInertial ] );
+
+    prvMemoryPageQueued ( type, queued );
+
+    return MEM_OK;
+}
+
+static MemoryManagerStatus prvMemoryQueuePage ( page_buffer_item * item )
+{
+    PageLane lane = prvPageLaneOf ( item->type );
+
+    if ( lane != PageLaneCritical )
     {
-        while ( pdPASS == xQueueReceive ( xPageQueue, &item,  portMAX_DELAY ) )
+        page_buffer_item * slot = prvMemoryReservePage ( item->type );
+        if ( slot == NULL )
         {
-            if ( item.type < SystemSectorCount )
+            return MEM_ERR;
+        }
+
+        memcpy ( slot->data, item->data, sizeof ( slot->data ) );
+        return prvMemoryCommitPage ( slot );
+    }
+
+    item->queued = xTaskGetTickCount ( );
+
+    if ( pdPASS != xQueueSend ( prvCriticalPageLane, (void *) item, PAGE_LANE_CRITICAL_SEND_TIMEOUT ) )
+    {
+        prvMemoryDropPage ( item->type, lane );
+        return MEM_ERR;
+    }
+
+    prvMemoryPageQueued ( item->type, item->queued );
+
+    return MEM_OK;
+}
+
+static bool prvPageLaneTake ( PageLane lane, page_buffer_item * item )
+{
+    const bool taken = lane == PageLaneCritical ? pdPASS == xQueueReceive ( prvCriticalPageLane, item, 0 )
+                                                : page_lane_ring_pop ( &prvBulkPageLanes[ lane - PageLaneInertial ], item );
+    if ( ! taken )
+    {
+        return false;
+    }
+
+    const uint32_t wait = ( xTaskGetTickCount ( ) - item->queued ) * portTICK_PERIOD_MS;
+
+    // the producers count the pages dropped in the same lane stats
+    taskENTER_CRITICAL ( );
+
+    MemoryPageLaneStats stats = prvDiagnostics.values.lanes[ lane ];
+
+    stats.pagesServed++;
+    stats.waitTotalMs += wait;
+    stats.waitMaxMs    = wait > stats.waitMaxMs ? wait : stats.waitMaxMs;
+
+    prvDiagnostics.values.lanes[ lane ] = stats;
+
+    taskEXIT_CRITICAL ( );
+
+    return true;
+}
+
+static bool prvPageLaneReceive ( page_buffer_item * item )
+{
+    if ( prvPageLaneTake ( PageLaneCritical, item ) )
+    {
+        return true;
+    }
+
+    // a bulk lane is served as many pages in a row as its weight. A lane found empty gives up the rest of its turn, and
+    // once every lane has used up its turn a new round starts
+    for ( int round = 0; round < 2; round++ )
+    {
+        for ( int visit = PageLaneInertial; visit < MEMORY_PAGE_LANE_COUNT; visit++ )
+        {
+            PageLane lane  = prvPageLaneCursor;
+            bool     taken = prvPageLaneCredits[ lane ] > 0 && prvPageLaneTake ( lane, item );
+
+            if ( taken && --prvPageLaneCredits[ lane ] > 0 )
             {
-                // it is a system sector
+                return true;
+            }
 
-//                DEBUG_LINE( "SystemSector: %i was flushed!",  toSystemSector ( item.type ) );
-                status = prvMemorySystemSectorWritePageNow ( item.type, &item.data[0] );
+            // the turn of the lane is over
+            prvPageLaneCredits[ lane ] = 0;
+            prvPageLaneCursor          = lane + 1 < MEMORY_PAGE_LANE_COUNT ? lane + 1 : PageLaneInertial;
+
+            if ( taken )
+            {
+                return true;
             }
-            else
+        }
+
+        for ( PageLane lane = PageLaneInertial; lane < MEMORY_PAGE_LANE_COUNT; lane++ )
+        {
+            prvPageLaneCredits[ lane ] = prvPageLaneWeights[ lane ];
+        }
+    }
+
+    return false;
+}
+
+static void prvMemoryRecordPageFlush ( page_buffer_item * item, MemoryManagerStatus status )
+{
+    if ( item->type >= MemorySectorCount )
+    {
+        return;
+    }
+
+    const uint32_t latency = ( xTaskGetTickCount ( ) - item->queued ) * portTICK_PERIOD_MS;
+
+    taskENTER_CRITICAL ( );
+
+    if ( status != MEM_OK )
+    {
+        prvDiagnostics.values.sectors[ item->type ].writeErrors++;
+    }
+    else
+    {
+        prvDiagnostics.values.sectors[ item->type ].pagesWritten++;
+
+        for ( uint32_t bucket = 0; bucket < MEMORY_FLUSH_LATENCY_BUCKET_COUNT; bucket++ )
+        {
+            if ( latency < prvFlushLatencyBucketBounds[ bucket ] )
+            {
+                prvDiagnostics.values.flush_latency[ bucket ]++;
+                break;
+            }
+        }
+    }
+
+    taskEXIT_CRITICAL ( );
+}
+
+static MemoryManagerStatus  prvMemoryAsyncWriteAnyMemorySectorIfAvailable ( )
+{
+    // free the read page
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        int page_aligned_boundary = prvMemorySectorGetAlignedDataStructSize ( toMemorySector( sector ) );
+        if ( prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read->info.bytesWritten >= page_aligned_boundary )
+        {
+            // copied straight into the lane
+            page_buffer_item * item = prvMemoryReservePage ( toMemorySector ( sector ) );
+            if ( item == NULL )
             {
-                // switch ( )
-                // it is a user data sector
-//                DEBUG_LINE( "UserSector: %i was flushed!", toUserDataSector ( item.type ) );
-                status = prvMemoryWritePageNow ( prvMemoryMetaDataFlashSnapshot.values.user_sectors [ toUserDataSector ( item.type ) ], item.data );
+                return MEM_ERR;
             }
 
-            if ( status )
+            memcpy ( item->data, prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read->data, PAGE_SIZE ) ;
+
+            if ( ! prvMemoryCommitPage ( item ) )
             {
-                if ( item.type < SystemSectorCount )
-                {
-                    // it is a system sector
+                return MEM_ERR;
+            }
+
+            // handed off: the lane has its own copy, the page is not queued again and is not lost when it is overwritten
+            prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read->info.bytesWritten = 0;
+        }
+    }
+
+    return MEM_OK;
+}
+
+MemoryManagerStatus prvMemoryWritePageNow ( MemorySectorInfo info, uint8_t * data )
+{
+    if (prvIsInitialized == false)
+    {
+        return MEM_ERR;
+    }
+
+    if (data == NULL)
+    {
+        return MEM_ERR;
+    }
+
+    const uint32_t offset = prvMemoryUserDataPageAddress ( info, info.bytesWritten / PAGE_SIZE );
+
+    // a full sector in the linear mode: there is nowhere to put the page
+    if ( offset + PAGE_SIZE > info.endAddress )
+    {
+        return MEM_ERR;
+    }
+
+    return flash_write ( offset, data, PAGE_SIZE ) == FLASH_OK;
+}
+
+
+MemoryManagerStatus prvMemorySystemSectorWritePageNow ( SystemSector sector, uint8_t * data )
+{
+    if ( data == NULL)
+    {
+        return MEM_ERR;
+    }
+
+    int offset = 0;
+
+    if ( sector == SystemSectorGlobalConfigurationData )
+    {
+
+#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON == 0 )
+        memory_manager_erase_configuration_section ( );
+#else
+        offset = GLOBAL_CONFIGURATION_SECTOR_BASE;
+#endif
+
+    }
+
+    else if ( sector == SystemSectorUserDataSectorMetaData )
+    {
+        // entering a sub-sector: the one after it is erased, it keeps the newest page findable once the sector wraps
+        if ( prvMetaDataNextPageIndex % MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT == 0 )
+        {
+            uint32_t ahead = ( prvMetaDataNextPageIndex + MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT ) % MEMORY_METADATA_SECTOR_PAGE_COUNT;
+            if ( FLASH_OK != flash_erase_4Kb_subsector ( MEMORY_METADATA_SECTOR_BASE + ahead * PAGE_SIZE ) )
+            {
+                return MEM_ERR;
+            }
+        }
+
+        offset = MEMORY_METADATA_SECTOR_BASE + prvMetaDataNextPageIndex * PAGE_SIZE;
+    }
+    else
+    {
+        // we should not land here!
+        return MEM_ERR;
+    }
+
+    return flash_write ( offset, data, PAGE_SIZE ) == FLASH_OK;
+}
+
+/**
+ * @param sector: desired memory sector
+ * @param pageIndex: -1 for the last available page in the given sector, 0-N to indicate the page index to be retrieved
+ * @param dest: destination buffer (Note: MUST be at least 255 bytes of size)
+ * @return MemoryManagerStatus: OK or ERR
+ */
+static MemoryManagerStatus prvMemoryAccessPage ( MemorySector sector, MemorySectorInfo info, int64_t pageIndex, uint8_t * dest )
+{
+    uint32_t PAGE_INDEX = 0;
+
+    if ( pageIndex == -1 )
+    {
+        if ( ! prvMemorySectorBinarySearchForLastWrittenPageIndex ( sector, info, &PAGE_INDEX ) )
+        {
+            return MEM_ERR;
+        }
+    }
+    else
+    {
+        PAGE_INDEX = pageIndex;
+    }
+
+    uint32_t address = info.startAddress + ( PAGE_INDEX * PAGE_SIZE );
+    if ( toSystemSector ( sector ) >= SystemSectorCount )
+    {
+        address = prvMemoryUserDataPageAddress ( info, PAGE_INDEX );
+    }
+
+    if ( FLASH_OK != flash_read ( address, dest, PAGE_SIZE ) )
+    {
+        return MEM_ERR;
+    }
+
+    return MEM_OK;
+}
+
+
+// index counts the entries from firstPage, or from the oldest page still in the sector if that comes later: in the
+// circular mode the oldest blocks have been written over
+MemoryManagerStatus prvMemoryAccessSectorSingleDataEntry ( MemorySector sector, MemorySectorInfo info, uint32_t firstPage, uint32_t index, void * dst )
+{
+    if ( dst == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    uint32_t entries_per_page = prvMemorySectorGetDataEntriesPerPage ( sector );
+    uint32_t struct_size      = prvMemorySectorGetDataStructSize ( sector );
+    uint32_t pages            = prvMemorySectorGetPageCount ( sector );
+
+    if ( toSystemSector ( sector ) >= SystemSectorCount )
+    {
+        // only the pages that reached the flash memory can be read
+        pages = info.bytesWritten / PAGE_SIZE;
+
+        RingBlockHeaderU oldest;
+        if ( prvMemoryIsCircular ( ) && prvRingFindOldestBlock ( info, &oldest ) )
+        {
+            uint32_t ringStart = oldest.values.sequence * prvMemoryDataPagesPerBlock ( );
+            firstPage = ringStart > firstPage ? ringStart : firstPage;
+        }
+    }
+
+    uint32_t pageIndex = firstPage + index / entries_per_page;
+    if ( pageIndex >= pages )
+    {
+        return MEM_ERR;
+    }
+
+    MemoryBuffer buffer = { };
+
+    if ( ! prvMemoryAccessPage ( sector, info, pageIndex, buffer.data ) )
+    {
+        return MEM_ERR;
+    }
+
+    memcpy ( dst, &buffer.data [ ( index % entries_per_page ) * struct_size ], struct_size );
+
+    return MEM_OK;
+}
+
+static MemoryManagerStatus prvMemoryAccessLastDataEntry ( MemorySector sector, MemorySectorInfo info, void * dst )
+{
+    if ( dst == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    if ( toSystemSector ( sector ) < SystemSectorCount )
+    {
+        uint32_t lastPageIndex = 0;
+        if ( ! prvMemorySectorBinarySearchForLastWrittenPageIndex ( sector, info, &lastPageIndex ) )
+        {
+            return MEM_ERR;
+        }
+
+        if ( MEM_OK != prvMemoryAccessPage ( sector, info, lastPageIndex, dst ) )
+        {
+            return MEM_ERR;
+        }
+    }
+
+    else
+    {
+        if ( info.bytesWritten < PAGE_SIZE )
+        {
+            return MEM_ERR;
+        }
+
+        uint32_t lastAddress = prvMemoryUserDataPageAddress ( info, info.bytesWritten / PAGE_SIZE - 1 ) +
+                               ( ( prvMemorySectorGetDataEntriesPerPage ( sector ) - 1 ) * prvMemorySectorGetDataStructSize ( sector ) );
+
+        if ( FLASH_OK != flash_read ( lastAddress, dst, prvMemorySectorGetDataStructSize ( sector ) ) )
+        {
+            return MEM_ERR;
+        }
+    }
+
+    return MEM_OK;
+}
+
+// writes a page taken off the page lanes to where it belongs
+static void prvQueueMonitorWritePage ( page_buffer_item * item )
+{
+    MemoryManagerStatus status;
+
+    if ( item->type == PAGE_BUFFER_ITEM_DIAGNOSTICS )
+    {
+        // a diagnostics snapshot: append it while there is still room in the diagnostics sector
+        if ( prvDiagnosticsNextPageIndex < DIAGNOSTICS_SECTOR_SIZE / PAGE_SIZE )
+        {
+            if ( FLASH_OK == flash_write ( DIAGNOSTICS_SECTOR_BASE + prvDiagnosticsNextPageIndex * PAGE_SIZE, item->data, PAGE_SIZE ) )
+            {
+                prvDiagnosticsNextPageIndex++;
+            }
+        }
+
+        return;
+    }
+
+    if ( item->type == PAGE_BUFFER_ITEM_FLIGHT_SUMMARY )
+    {
+        // a flight summary snapshot: append it while there is still room in the summary sector
+        if ( prvSummaryNextPageIndex < SUMMARY_SECTOR_SIZE / PAGE_SIZE )
+        {
+            if ( FLASH_OK == flash_write ( SUMMARY_SECTOR_BASE + prvSummaryNextPageIndex * PAGE_SIZE, item->data, PAGE_SIZE ) )
+            {
+                prvSummaryNextPageIndex++;
+            }
+        }
+
+        return;
+    }
+
+    if ( item->type == PAGE_BUFFER_ITEM_SESSION || item->type == PAGE_BUFFER_ITEM_SESSION_SUMMARY )
+    {
+        uint32_t address = SESSION_DIRECTORY_SECTOR_BASE + prvSessionCurrent * PAGE_SIZE;
+
+        if ( item->type == PAGE_BUFFER_ITEM_SESSION )
+        {
+            flash_write ( address, item->data, PAGE_SIZE );
+        }
+        else
+        {
+            // the pages queued before the summary have been written by now, so the write cursors are final
+            MemorySessionU * entry = ( MemorySessionU * ) item->data;
+            for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+            {
+                entry->values.summary.end_bytes[ sector ] = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ].bytesWritten;
+            }
+
+            // only the erased tail of the entry is programmed
+            const uint32_t offset = offsetof ( struct memory_session_values, summary );
+            flash_write ( address + offset, &item->data[ offset ], sizeof ( MemorySessionSummary ) );
+        }
+
+        return;
+    }
+
+    if ( item->type < SystemSectorCount )
+    {
+        // it is a system sector
+
+//        DEBUG_LINE( "SystemSector: %i was flushed!",  toSystemSector ( item->type ) );
+        status = prvMemorySystemSectorWritePageNow ( item->type, &item->data[0] );
+    }
+    else
+    {
+        // switch ( )
+        // it is a user data sector
+//        DEBUG_LINE( "UserSector: %i was flushed!", toUserDataSector ( item->type ) );
+        MemorySectorInfo info = prvMemoryMetaDataFlashSnapshot.values.user_sectors [ toUserDataSector ( item->type ) ];
+        uint32_t         page = info.bytesWritten / PAGE_SIZE;
+
+        prvEraseAheadEnsureErased ( toUserDataSector ( item->type ) );
+        status = MEM_OK;
+
+        if ( prvMemoryIsCircular ( ) && page % prvMemoryDataPagesPerBlock ( ) == 0 )
+        {
+            // the first page of a block in the circular mode: the block header goes in front of it
+            status = prvRingWriteBlockHeader ( info, page / prvMemoryDataPagesPerBlock ( ), item->data );
+        }
+
+        if ( status )
+        {
+            status = prvMemoryWritePageNow ( info, item->data );
+        }
+    }
+
+    prvMemoryRecordPageFlush ( item, status );
+
+    if ( status )
+    {
+        if ( item->type < SystemSectorCount )
+        {
+            // it is a system sector
+
+            if ( item->type == MemorySystemSectorUserDataSectorMetaData )
+            {
+                // update the page counter, so that the next time the data will not go to overwrite the existing page, instead it will go right after it
+                prvMetaDataNextPageIndex = ( prvMetaDataNextPageIndex + 1 ) % MEMORY_METADATA_SECTOR_PAGE_COUNT;
+            }
+        }
+        else
+        {
+            // it is a user data sector
+
+            // index the page by its first timestamp, so that the time range queries do not need to scan the sector
+            MemorySectorInfo info = prvMemoryMetaDataFlashSnapshot.values.user_sectors [ toUserDataSector ( item->type ) ];
+            prvTimestampIndexRecordPage ( toUserDataSector ( item->type ), info.bytesWritten / PAGE_SIZE, item->data );
+
+            // now start address should point to a page size away from the previous one
+            prvMemoryMetaDataFlashSnapshot.values.user_sectors [ toUserDataSector ( item->type ) ].bytesWritten += PAGE_SIZE;
+
+            // reset the read RAM buffer cursor
+            // flagging to the other components that this piece of data has been already processed and emptied
+            memset ( prvCurrentMemoryUserDataSectorRAMBuffers [ toUserDataSector ( item->type ) ].read, 0, PAGE_SIZE );
+        }
+    }
+}
+
+void prvQueueMonitorTask ( void * arg )
+{
+    ( void ) arg;
+
+    page_buffer_item item = { };
+
+    while ( is_queue_monitor_running )
+    {
+        // woken up by every queued page, otherwise every poll interval to look after the erase-ahead scheduler
+        ulTaskNotifyTake ( pdTRUE, ERASE_AHEAD_IDLE_POLL_INTERVAL );
+
+        while ( prvPageLaneReceive ( &item ) )
+        {
+            prvQueueMonitorWritePage ( &item );
+        }
+
+        // the page queue is empty: an idle gap between page programs
+        prvEraseAheadRunIfIdle ( );
+    }
+
+    // the pages memory_manager_stop ( ) queued last, such as the session summary, may have come after the last pass
+    while ( prvPageLaneReceive ( &item ) )
+    {
+        prvQueueMonitorWritePage ( &item );
+    }
+
+    DISPLAY_LINE( "monitor EXITED!" );
+
+    prvQueueMonitorExited = true;
+
+    // the queue is polled now, so the monitor does reach this point once stopped: a task must not return
+    vTaskDelete ( NULL );
+}
+
+
+MemoryManagerStatus memory_manager_read_range ( MemorySector sector, uint32_t t_begin, uint32_t t_end, MemoryRangeCallback callback, void * arg )
+{
+    if ( callback == NULL || sector < MemoryUserDataSectorGyro || sector >= MemorySectorCount || t_begin > t_end )
+    {
+        return MEM_ERR;
+    }
+
+    MemorySectorInfo info;
+    if ( ! prvGetMemorySectorInfo ( sector, &info ) )
+    {
+        return MEM_ERR;
+    }
+
+    // the timestamps start over with every session, so the seek and the scan stay within a single one: the selected
+    // one, or every session on its own when all of them are read
+    bool stopped = false;
+
+    if ( prvSessionSelected != MEMORY_SESSION_ALL || prvSessionCount == 0 )
+    {
+        uint32_t firstPage = 0;
+        prvSessionApplyWindow ( sector, &info, &firstPage );
+
+        return prvReadRangeWindow ( sector, info, firstPage, t_begin, t_end, callback, arg, &stopped );
+    }
+
+    for ( uint32_t session = 0; session < prvSessionCount && ! stopped; session++ )
+    {
+        uint32_t begin [ UserDataSectorCount ];
+        uint32_t end   [ UserDataSectorCount ];
+        if ( ! prvSessionGetBounds ( session, begin, end ) )
+        {
+            return MEM_ERR;
+        }
+
+        MemorySectorInfo window = info;
+        window.bytesWritten = info.bytesWritten < end[ toUserDataSector ( sector ) ] ? info.bytesWritten : end[ toUserDataSector ( sector ) ];
+
+        if ( ! prvReadRangeWindow ( sector, window, begin[ toUserDataSector ( sector ) ] / PAGE_SIZE, t_begin, t_end, callback, arg, &stopped ) )
+        {
+            return MEM_ERR;
+        }
+    }
+
+    return MEM_OK;
+}
+
+// reads the entries of the time range out of the pages from firstPage up to the write cursor of info, which belong to a
+// single session so that their timestamps only go up. Sets stopped once the callback asked for no more entries
+static MemoryManagerStatus prvReadRangeWindow ( MemorySector sector, MemorySectorInfo info, uint32_t firstPage, uint32_t t_begin, uint32_t t_end, MemoryRangeCallback callback, void * arg, bool * stopped )
+{
+    // only what has reached the flash memory can be read, the monitor may keep flushing in the meantime
+    uint32_t pages      = info.bytesWritten / PAGE_SIZE;
+    uint32_t structSize = prvMemorySectorGetDataStructSize ( sector );
+    uint32_t entries    = prvMemorySectorGetDataEntriesPerPage ( sector );
+    uint32_t pageIndex  = 0;
+
+    MemoryManagerStatus seek = prvMemoryIsCircular ( ) ? prvRingSeek ( info, firstPage, t_begin, &pageIndex )
+                                                       : prvTimestampIndexSeek ( toUserDataSector ( sector ), info, firstPage, t_begin, &pageIndex );
+    if ( ! seek )
+    {
+        return MEM_ERR;
+    }
+
+    pageIndex = pageIndex > firstPage ? pageIndex : firstPage;
+
+    while ( pageIndex < pages )
+    {
+        // a burst stays within a block, in the circular mode the next block is elsewhere and starts with a header
+        uint32_t burst = pages - pageIndex < RANGE_READ_BURST_PAGES ? pages - pageIndex : RANGE_READ_BURST_PAGES;
+        uint32_t left  = prvMemoryDataPagesPerBlock ( ) - pageIndex % prvMemoryDataPagesPerBlock ( );
+        burst = burst < left ? burst : left;
+
+        if ( FLASH_OK != flash_read ( prvMemoryUserDataPageAddress ( info, pageIndex ), prvRangeReadBuffer, burst * PAGE_SIZE ) )
+        {
+            return MEM_ERR;
+        }
+
+        for ( uint32_t page = 0; page < burst; page++ )
+        {
+            for ( uint32_t entry = 0; entry < entries; entry++ )
+            {
+                // every user data entry starts with its timestamp
+                const uint8_t * data = &prvRangeReadBuffer[ page * PAGE_SIZE + entry * structSize ];
+                uint32_t timestamp;
+                memcpy ( &timestamp, data, sizeof ( uint32_t ) );
+
+                if ( timestamp == UINT32_MAX || timestamp > t_end )
+                {
+                    // either the erased part of the sector or past the range: there is nothing more to read
+                    return MEM_OK;
+                }
+
+                if ( timestamp >= t_begin && ! callback ( sector, data, arg ) )
+                {
+                    *stopped = true;
+                    return MEM_OK;
+                }
+            }
+        }
+
+        pageIndex += burst;
+    }
+
+    return MEM_OK;
+}
+
+static uint32_t prvTimestampIndexGetStride ( MemorySectorInfo info )
+{
+    uint32_t pages  = info.size / PAGE_SIZE;
+    uint32_t stride = ( pages + TIMESTAMP_INDEX_SLOTS_PER_SECTOR - 1 ) / TIMESTAMP_INDEX_SLOTS_PER_SECTOR;
+
+    return stride > 0 ? stride : 1;
+}
+
+static void prvTimestampIndexRecordPage ( UserDataSector sector, uint32_t pageIndex, uint8_t * page )
+{
+    // the slots cannot follow a sector that wraps around, the block headers index it instead
+    if ( prvMemoryIsCircular ( ) )
+    {
+        return;
+    }
+
+    uint32_t stride = prvTimestampIndexGetStride ( prvMemoryMetaDataFlashSnapshot.values.user_sectors [ sector ] );
+    if ( pageIndex % stride != 0 )
+    {
+        return;
+    }
+
+    uint32_t slot = pageIndex / stride;
+    if ( slot >= TIMESTAMP_INDEX_SLOTS_PER_SECTOR )
+    {
+        return;
+    }
+
+    // a missing slot only makes the seek land earlier, the range read still scans forward to the right entry
+    flash_write ( TIMESTAMP_INDEX_SECTOR_BASE + sector * TIMESTAMP_INDEX_SLICE_SIZE + slot * sizeof ( uint32_t ), page, sizeof ( uint32_t ) );
+}
+
+static MemoryManagerStatus prvTimestampIndexSeek ( UserDataSector sector, MemorySectorInfo info, uint32_t firstPage, uint32_t t_begin, uint32_t * pageIndex )
+{
+    uint32_t stride = prvTimestampIndexGetStride ( info );
+    uint32_t pages  = info.bytesWritten / PAGE_SIZE;
+    uint32_t slots  = ( pages + stride - 1 ) / stride;
+
+    slots = slots < TIMESTAMP_INDEX_SLOTS_PER_SECTOR ? slots : TIMESTAMP_INDEX_SLOTS_PER_SECTOR;
+
+    // binary search for the last slot that starts at or before t_begin, the entries we are after begin in its pages.
+    // The slot holding the first page is never compared, it may still belong to the previous session
+    uint32_t low  = firstPage / stride;
+    uint32_t high = slots;
+    while ( low + 1 < high )
+    {
+        uint32_t middle = low + ( high - low ) / 2;
+        uint32_t timestamp;
+
+        if ( FLASH_OK != flash_read ( TIMESTAMP_INDEX_SECTOR_BASE + sector * TIMESTAMP_INDEX_SLICE_SIZE + middle * sizeof ( uint32_t ), ( uint8_t * ) &timestamp, sizeof ( uint32_t ) ) )
+        {
+            return MEM_ERR;
+        }
+
+        if ( timestamp <= t_begin )
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    *pageIndex = low * stride;
+
+    return MEM_OK;
+}
+
+// erases the sub-sectors of slots whose first slot indexes a page of the block: the slots of the block are programmed
+// right after its pages, so they are erased along with them
+static MemoryManagerStatus prvTimestampIndexEraseForBlock ( UserDataSector sector, uint32_t block )
+{
+    if ( prvMemoryIsCircular ( ) )
+    {
+        return MEM_OK;
+    }
+
+    uint32_t stride = prvTimestampIndexGetStride ( prvMemoryMetaDataFlashSnapshot.values.user_sectors [ sector ] );
+    uint32_t first  = ( block * prvMemoryDataPagesPerBlock ( ) + stride - 1 ) / stride;
+    uint32_t last   = ( ( block + 1 ) * prvMemoryDataPagesPerBlock ( ) + stride - 1 ) / stride;
+
+    first = ( first + TIMESTAMP_INDEX_SLOTS_PER_SUB_SECTOR - 1 ) / TIMESTAMP_INDEX_SLOTS_PER_SUB_SECTOR * TIMESTAMP_INDEX_SLOTS_PER_SUB_SECTOR;
+    last  = last < TIMESTAMP_INDEX_SLOTS_PER_SECTOR ? last : TIMESTAMP_INDEX_SLOTS_PER_SECTOR;
+
+    for ( uint32_t slot = first; slot < last; slot += TIMESTAMP_INDEX_SLOTS_PER_SUB_SECTOR )
+    {
+        if ( FLASH_OK != flash_erase_4Kb_subsector ( TIMESTAMP_INDEX_SECTOR_BASE + sector * TIMESTAMP_INDEX_SLICE_SIZE + slot * sizeof ( uint32_t ) ) )
+        {
+            return MEM_ERR;
+        }
+    }
+
+    return MEM_OK;
+}
+
+
+static void prvEraseAheadInit ( )
+{
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        // a partially written block has been erased before it was written, the blocks after it are unknown
+        uint32_t page = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ].bytesWritten / PAGE_SIZE;
+
+        prvEraseAheadNextBlock[ sector ] = ( page + prvMemoryDataPagesPerBlock ( ) - 1 ) / prvMemoryDataPagesPerBlock ( );
+    }
+}
+
+static bool prvEraseAheadIsEligible ( MemorySectorInfo info )
+{
+    // a block of a sector that is not aligned to the erase blocks would take some of its neighbour with it, and a sector
+    // wrapping around needs a block to write into while the other one is being erased
+    return info.size > 0 && info.startAddress % ERASE_AHEAD_BLOCK_SIZE == 0 && info.endAddress % ERASE_AHEAD_BLOCK_SIZE == 0 &&
+           ( ! prvMemoryIsCircular ( ) || info.size / ERASE_AHEAD_BLOCK_SIZE >= 2 );
+}
+
+static MemoryManagerStatus prvEraseAheadEraseNextBlock ( UserDataSector sector )
+{
+    TickType_t start = xTaskGetTickCount ( );
+
+    if ( FLASH_OK != flash_erase_64kb_sector ( prvMemoryUserDataBlockAddress ( prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ], prvEraseAheadNextBlock[ sector ] ) ) )
+    {
+        return MEM_ERR;
+    }
+
+    if ( ! prvTimestampIndexEraseForBlock ( sector, prvEraseAheadNextBlock[ sector ] ) )
+    {
+        return MEM_ERR;
+    }
+
+    prvEraseAheadNextBlock[ sector ]++;
+
+    // the first measurement replaces the worst case, after that the longest erase seen is the expected one
+    TickType_t elapsed = xTaskGetTickCount ( ) - start;
+    if ( ! prvEraseAheadEraseTimeMeasured || elapsed > prvEraseAheadEraseTime )
+    {
+        prvEraseAheadEraseTime         = elapsed;
+        prvEraseAheadEraseTimeMeasured = true;
+    }
+
+    taskENTER_CRITICAL ( );
+    if ( elapsed * portTICK_PERIOD_MS > prvDiagnostics.values.erase_time_max_ms )
+    {
+        prvDiagnostics.values.erase_time_max_ms = elapsed * portTICK_PERIOD_MS;
+    }
+    taskEXIT_CRITICAL ( );
+
+    return MEM_OK;
+}
+
+static void prvEraseAheadRunIfIdle ( )
+{
+    TickType_t now = xTaskGetTickCount ( );
+
+    // leave the flash memory alone if a page is expected before the erase would be over. The sectors that have been
+    // quiet for a couple of their page intervals are not producing anything at the moment
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        TickType_t interval = prvPageInterval[ sector ];
+        TickType_t elapsed  = now - prvPageLastQueued[ sector ];
+
+        if ( interval > 0 && elapsed < 2 * interval && ( int64_t ) interval - ( int64_t ) elapsed < ( int64_t ) prvEraseAheadEraseTime )
+        {
+            return;
+        }
+    }
+
+    // erase a single block for the sector with the fewest erased blocks ahead of its write cursor
+    int      candidate = -1;
+    uint32_t fewest    = UINT32_MAX;
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        MemorySectorInfo info = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
+        if ( ! prvEraseAheadIsEligible ( info ) )
+        {
+            continue;
+        }
+
+        uint32_t page    = info.bytesWritten / PAGE_SIZE;
+        uint32_t current = page / prvMemoryDataPagesPerBlock ( );
+        uint32_t first   = ( page + prvMemoryDataPagesPerBlock ( ) - 1 ) / prvMemoryDataPagesPerBlock ( );
+        uint32_t target  = first + userconf_MEM_ERASE_AHEAD_BLOCKS;
+
+        // a sector written once ends at its last block, a wrapping one keeps at least a block of its oldest data
+        uint32_t limit = prvMemoryIsCircular ( ) ? current + info.size / ERASE_AHEAD_BLOCK_SIZE - 1 : info.size / ERASE_AHEAD_BLOCK_SIZE;
+        target = target < limit ? target : limit;
+
+        if ( prvEraseAheadNextBlock[ sector ] < target && prvEraseAheadNextBlock[ sector ] - first < fewest )
+        {
+            fewest    = prvEraseAheadNextBlock[ sector ] - first;
+            candidate = sector;
+        }
+    }
+
+    if ( candidate >= 0 && prvEraseAheadEraseNextBlock ( candidate ) )
+    {
+        taskENTER_CRITICAL ( );
+        prvDiagnostics.values.blocks_erased_ahead++;
+        taskEXIT_CRITICAL ( );
+    }
+}
+
+static void prvEraseAheadEnsureErased ( UserDataSector sector )
+{
+    MemorySectorInfo info  = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
+    uint32_t         page  = info.bytesWritten / PAGE_SIZE;
+    uint32_t         block = page / prvMemoryDataPagesPerBlock ( );
+
+    if ( ! prvEraseAheadIsEligible ( info ) || block < prvEraseAheadNextBlock[ sector ] )
+    {
+        return;
+    }
+
+    if ( ! prvMemoryIsCircular ( ) && block >= info.size / ERASE_AHEAD_BLOCK_SIZE )
+    {
+        return;
+    }
+
+    // the scheduler fell behind: the page has to wait for its block to be erased
+    taskENTER_CRITICAL ( );
+    prvDiagnostics.values.erase_stalls++;
+    taskEXIT_CRITICAL ( );
+    prvEraseAheadNextBlock[ sector ] = block;
+    prvEraseAheadEraseNextBlock ( sector );
+}
+
+static bool prvMemoryIsCircular ( )
+{
+    return prvMemoryMetaDataFlashSnapshot.values.logging_mode == MemoryLoggingModeCircular;
+}
+
+static uint32_t prvMemoryDataPagesPerBlock ( )
+{
+    // in the circular mode the first page of every block is its header
+    return DATA_SECTORS_BLOCK_SIZE / PAGE_SIZE - ( prvMemoryIsCircular ( ) ? 1 : 0 );
+}
+
+static uint32_t prvMemoryUserDataBlockAddress ( MemorySectorInfo info, uint32_t block )
+{
+    uint32_t blocks = info.size / DATA_SECTORS_BLOCK_SIZE;
+    if ( prvMemoryIsCircular ( ) && blocks > 0 )
+    {
+        block %= blocks;
+    }
+
+    return info.startAddress + block * DATA_SECTORS_BLOCK_SIZE;
+}
+
+// pages are counted from the first page ever written into the sector, the header pages are not counted
+static uint32_t prvMemoryUserDataPageAddress ( MemorySectorInfo info, uint32_t page )
+{
+    uint32_t perBlock = prvMemoryDataPagesPerBlock ( );
+    uint32_t header   = prvMemoryIsCircular ( ) ? PAGE_SIZE : 0;
+
+    return prvMemoryUserDataBlockAddress ( info, page / perBlock ) + header + ( page % perBlock ) * PAGE_SIZE;
+}
+
+static bool prvRingReadBlockHeader ( MemorySectorInfo info, uint32_t physical, RingBlockHeaderU * header )
+{
+    uint32_t blocks = info.size / DATA_SECTORS_BLOCK_SIZE;
+
+    if ( FLASH_OK != flash_read ( info.startAddress + physical * DATA_SECTORS_BLOCK_SIZE, header->bytes, sizeof ( RingBlockHeaderU ) ) )
+    {
+        return false;
+    }
+
+    // an erased block, or one of the linear mode, has no valid header
+    return memcmp ( header->values.signature, RING_BLOCK_HEADER_SIGNATURE, RING_BLOCK_HEADER_SIGNATURE_LENGTH ) == 0 &&
+           header->values.sequence % blocks == physical;
+}
+
+static MemoryManagerStatus prvRingWriteBlockHeader ( MemorySectorInfo info, uint32_t block, uint8_t * page )
+{
+    RingBlockHeaderU header;
+    memcpy ( header.values.signature, RING_BLOCK_HEADER_SIGNATURE, RING_BLOCK_HEADER_SIGNATURE_LENGTH );
+    header.values.sequence = block;
+
+    // every user data entry starts with its timestamp
+    uint32_t timestamp;
+    memcpy ( &timestamp, page, sizeof ( uint32_t ) );
+    header.values.first_timestamp = timestamp;
+
+    return flash_write ( prvMemoryUserDataBlockAddress ( info, block ), header.bytes, sizeof ( RingBlockHeaderU ) ) == FLASH_OK;
+}
+
+static bool prvRingFindNewestBlock ( MemorySectorInfo info, RingBlockHeaderU * newest )
+{
+    uint32_t blocks = info.size / DATA_SECTORS_BLOCK_SIZE;
+    uint32_t first  = 0;
+
+    // only the blocks erased ahead of the write cursor can come before the first valid one
+    while ( first < blocks && ! prvRingReadBlockHeader ( info, first, newest ) )
+    {
+        if ( ++first > userconf_MEM_ERASE_AHEAD_BLOCKS + 1 )
+        {
+            return false;
+        }
+    }
+
+    if ( first >= blocks )
+    {
+        return false;
+    }
+
+    // from there on the blocks of the same lap come first, then the erased ones and the previous lap: a binary search
+    // for the last block of the lap finds the newest one
+    uint32_t lap  = newest->values.sequence / blocks;
+    uint32_t low  = first;
+    uint32_t high = blocks;
+    RingBlockHeaderU header;
+
+    while ( low + 1 < high )
+    {
+        uint32_t middle = low + ( high - low ) / 2;
+
+        if ( prvRingReadBlockHeader ( info, middle, &header ) && header.values.sequence / blocks == lap )
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return prvRingReadBlockHeader ( info, low, newest );
+}
+
+static bool prvRingFindOldestBlock ( MemorySectorInfo info, RingBlockHeaderU * oldest )
+{
+    uint32_t blocks = info.size / DATA_SECTORS_BLOCK_SIZE;
+
+    RingBlockHeaderU newest;
+    if ( ! prvRingFindNewestBlock ( info, &newest ) )
+    {
+        return false;
+    }
+
+    // the oldest block is the first valid one after the newest block and the blocks erased ahead of it
+    uint32_t physical = newest.values.sequence % blocks;
+    for ( uint32_t step = 1; step < blocks && step <= userconf_MEM_ERASE_AHEAD_BLOCKS + 2; step++ )
+    {
+        if ( prvRingReadBlockHeader ( info, ( physical + step ) % blocks, oldest ) )
+        {
+            return true;
+        }
+    }
+
+    // the sector has not wrapped around yet
+    return prvRingReadBlockHeader ( info, 0, oldest );
+}
+
+static MemoryManagerStatus prvRingSeek ( MemorySectorInfo info, uint32_t firstPage, uint32_t t_begin, uint32_t * pageIndex )
+{
+    uint32_t blocks = info.size / DATA_SECTORS_BLOCK_SIZE;
+
+    RingBlockHeaderU oldest;
+    RingBlockHeaderU newest;
+    if ( ! prvRingFindOldestBlock ( info, &oldest ) || ! prvRingFindNewestBlock ( info, &newest ) )
+    {
+        // nothing has been written yet
+        *pageIndex = info.bytesWritten / PAGE_SIZE;
+        return MEM_OK;
+    }
+
+    // binary search over the block headers for the last block that starts at or before t_begin. The search stays within
+    // the session, the block holding its first page is never compared as it may start with the previous session
+    uint32_t pages = info.bytesWritten / PAGE_SIZE;
+    uint32_t first = firstPage / prvMemoryDataPagesPerBlock ( );
+    uint32_t last  = pages > 0 ? ( pages - 1 ) / prvMemoryDataPagesPerBlock ( ) : 0;
+    uint32_t low   = oldest.values.sequence > first ? oldest.values.sequence : first;
+    uint32_t high  = ( newest.values.sequence < last ? newest.values.sequence : last ) + 1;
+    RingBlockHeaderU header;
+
+    while ( low + 1 < high )
+    {
+        uint32_t middle = low + ( high - low ) / 2;
+
+        if ( prvRingReadBlockHeader ( info, middle % blocks, &header ) && header.values.first_timestamp <= t_begin )
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    *pageIndex = low * prvMemoryDataPagesPerBlock ( );
+
+    return MEM_OK;
+}
+
+static void prvRingRestoreWriteCursors ( )
+{
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        MemorySectorInfo info = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
+        RingBlockHeaderU newest;
+
+        if ( ! prvEraseAheadIsEligible ( info ) || ! prvRingFindNewestBlock ( info, &newest ) )
+        {
+            continue;
+        }
+
+        // the pages of a block are written in order: a binary search for the first erased one
+        uint32_t low  = 0;
+        uint32_t high = prvMemoryDataPagesPerBlock ( );
+        while ( low < high )
+        {
+            uint32_t middle = low + ( high - low ) / 2;
+            uint32_t timestamp;
+
+            if ( FLASH_OK == flash_read ( prvMemoryUserDataPageAddress ( info, newest.values.sequence * prvMemoryDataPagesPerBlock ( ) + middle ), ( uint8_t * ) &timestamp, sizeof ( uint32_t ) ) &&
+                 timestamp != UINT32_MAX )
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        uint32_t bytesWritten = ( newest.values.sequence * prvMemoryDataPagesPerBlock ( ) + low ) * PAGE_SIZE;
+        if ( bytesWritten > info.bytesWritten )
+        {
+            prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ].bytesWritten = bytesWritten;
+        }
+    }
+}
+
+
+static void prvLinearRestoreWriteCursors ( )
+{
+    MemoryBuffer buffer = { 0 };
+
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        MemorySectorInfo info = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
+        uint32_t         page = info.bytesWritten / PAGE_SIZE;
+
+        // the pages flushed after the last metadata update directly follow the cursor, a session must not write over them
+        while ( page < info.size / PAGE_SIZE )
+        {
+            uint32_t timestamp;
+            if ( FLASH_OK != flash_read ( prvMemoryUserDataPageAddress ( info, page ), buffer.data, PAGE_SIZE ) )
+            {
+                break;
+            }
+
+            memcpy ( &timestamp, buffer.data, sizeof ( uint32_t ) );
+            if ( timestamp == UINT32_MAX || common_is_mem_empty ( buffer.data, PAGE_SIZE ) )
+            {
+                break;
+            }
+
+            page++;
+        }
+
+        prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ].bytesWritten = page * PAGE_SIZE;
+    }
+}
+
+static MemoryManagerStatus prvSessionOpen ( )
+{
+    if ( prvSessionCount >= SESSION_DIRECTORY_CAPACITY )
+    {
+        return MEM_ERR;
+    }
+
+    // the summary stays erased until the session is stopped
+    memset ( prvSessionCurrentEntry.bytes, 0, sizeof ( MemorySessionU ) );
+    memset ( &prvSessionCurrentEntry.values.summary, 0xFF, sizeof ( MemorySessionSummary ) );
+
+    memcpy ( prvSessionCurrentEntry.values.signature, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH );
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        prvSessionCurrentEntry.values.start_bytes[ sector ] = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ].bytesWritten;
+    }
+
+    prvSessionCurrentEntry.values.logging_mode = prvMemoryMetaDataFlashSnapshot.values.logging_mode;
+    prvSessionCurrentEntry.values.memory       = prvGlobalConfigurationDiskSnapshot.values.memory;
+    prvSessionCurrentEntry.values.system       = prvGlobalConfigurationDiskSnapshot.values.system;
+
+    page_buffer_item item = { };
+    item.type = PAGE_BUFFER_ITEM_SESSION;
+    memset ( item.data, 0xFF, PAGE_SIZE );
+    memcpy ( item.data, prvSessionCurrentEntry.bytes, sizeof ( MemorySessionU ) );
+
+    // the monitor writes the entry at the index of the current session
+    prvSessionCurrent   = prvSessionCount;
+    prvSessionStartTick = xTaskGetTickCount ( );
+
+    if ( ! prvMemoryQueuePage ( &item ) )
+    {
+        prvSessionCurrent = MEMORY_SESSION_ALL;
+        return MEM_ERR;
+    }
+
+    prvSessionCount++;
+
+    return MEM_OK;
+}
+
+static MemoryManagerStatus prvSessionClose ( )
+{
+    if ( prvSessionCurrent == MEMORY_SESSION_ALL || prvSessionCurrentEntry.values.summary.closed == 1 )
+    {
+        return MEM_ERR;
+    }
+
+    // the monitor fills in the write cursors once it gets to the summary
+    prvSessionCurrentEntry.values.summary.closed       = 1;
+    prvSessionCurrentEntry.values.summary.flight_state = prvRateControl.flight_state;
+    prvSessionCurrentEntry.values.summary.duration_ms  = ( xTaskGetTickCount ( ) - prvSessionStartTick ) * portTICK_PERIOD_MS;
+
+    page_buffer_item item = { };
+    item.type = PAGE_BUFFER_ITEM_SESSION_SUMMARY;
+    memcpy ( item.data, prvSessionCurrentEntry.bytes, sizeof ( MemorySessionU ) );
+
+    return prvMemoryQueuePage ( &item );
+}
+
+static MemoryManagerStatus prvSessionGetBounds ( uint32_t session, uint32_t * begin, uint32_t * end )
+{
+    MemorySessionU entry;
+    if ( ! memory_manager_get_session ( session, &entry ) )
+    {
+        return MEM_ERR;
+    }
+
+    // a session cut short by a power loss ends where the next one starts, the last one ends at the write cursors
+    MemorySessionU next;
+    bool hasNext = session + 1 < prvSessionCount && memory_manager_get_session ( session + 1, &next );
+
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        begin[ sector ] = entry.values.start_bytes[ sector ];
+
+        if ( entry.values.summary.closed == 1 )
+        {
+            end[ sector ] = entry.values.summary.end_bytes[ sector ];
+        }
+        else if ( hasNext )
+        {
+            end[ sector ] = next.values.start_bytes[ sector ];
+        }
+        else
+        {
+            end[ sector ] = UINT32_MAX;
+        }
+    }
+
+    return MEM_OK;
+}
+
+static void prvSessionApplyWindow ( MemorySector sector, MemorySectorInfo * info, uint32_t * firstPage )
+{
+    *firstPage = 0;
+
+    if ( prvSessionSelected == MEMORY_SESSION_ALL || sector < MemoryUserDataSectorGyro || sector >= MemorySectorCount )
+    {
+        return;
+    }
+
+    UserDataSector user = toUserDataSector ( sector );
+    *firstPage = prvSessionSelectedBegin[ user ] / PAGE_SIZE;
+
+    if ( info->bytesWritten > prvSessionSelectedEnd[ user ] )
+    {
+        info->bytesWritten = prvSessionSelectedEnd[ user ];
+    }
+}
+
+
+static void prvSummaryReset ( )
+{
+    flight_summary_reset ( &prvFlightSummary, prvSessionCurrent, prvRateControl.flight_state );
+    memcpy ( prvFlightSummary.values.signature, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH );
+}
+
+static MemoryManagerStatus prvSummaryWriteAsync ( )
+{
+    if ( prvIsInitialized == false )
+    {
+        return MEM_ERR;
+    }
+
+    page_buffer_item item = { };
+    item.type = PAGE_BUFFER_ITEM_FLIGHT_SUMMARY;
+    memcpy ( item.data, prvFlightSummary.bytes, sizeof ( MemoryFlightSummaryU ) );
+
+    return prvMemoryQueuePage ( &item );
+}
+
+
+MemoryManagerStatus prvGetMemorySectorInfo ( MemorySector sector, MemorySectorInfo * info)
+{
+    if ( info == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    if ( toSystemSector ( sector ) < SystemSectorCount )
+    {
+        // the bytes written are kept as they are, the caller tracks them
+        info->startAddress = prvSystemSectorInfos [ toSystemSector ( sector ) ].startAddress;
+        info->endAddress   = prvSystemSectorInfos [ toSystemSector ( sector ) ].endAddress;
+        info->size         = prvSystemSectorInfos [ toSystemSector ( sector ) ].size;
+    }
+    else if ( sector < MemorySectorCount )
+    {
+        if ( ! prvIsInitialized )
+        {
+            return MEM_ERR;
+        }
+
+        *info = prvMemoryMetaDataFlashSnapshot.values.user_sectors [ toUserDataSector ( sector ) ];
+    }
+
+    return MEM_OK;
+}
+
+static uint32_t prvMemorySectorGetDataEntriesPerPage ( MemorySector sector )
+{
+    return sector < MemorySectorCount ? prvMemorySectors [ sector ].entriesPerPage : 0;
+}
+
+static uint32_t prvMemorySectorGetDataStructSize ( MemorySector sector )
+{
+    return sector < MemorySectorCount ? prvMemorySectors [ sector ].entrySize : 0;
+}
+
+static uint32_t prvMemorySectorGetAlignedDataStructSize ( MemorySector sector )
+{
+    return sector < MemorySectorCount ? prvMemorySectors [ sector ].alignedSize : 0;
+}
+
+int prvMemorySectorGetPageCount ( MemorySector sector )
+{
+    if ( toSystemSector ( sector ) < SystemSectorCount )
+    {
+        // we are accessing the system sector where their sizes are predetermined
+        return prvSystemSectorInfos [ toSystemSector ( sector ) ].size / PAGE_SIZE;
+    }
+    else
+    {
+        // we are accessing the user data sector where the sizes are changed by user and not known before the configuration sector is read
+        // thus this function will not work for user data sections without prior call to memory_manager_configure () that was successful
+        // the indication of that can be checked with prvIsConfigured variable (true if successful, false, if not successful, or has not been called)
+        if ( prvIsInitialized == false )
+        {
+            // returning 0 makes sense because if everything goes right, there is no way that sector would have 0 pages
+            return 0;
+        }
+
+        // if prvIsConfigured == true, then we can freely use prvGlobalConfigurationDiskSnapshot variable and can safely use user_data_sector_sizes to
+        // find out the user sector sizes.
+        return ( prvGlobalConfigurationDiskSnapshot.values.memory.user_data_sector_sizes [ toUserDataSector ( sector ) ] / PAGE_SIZE );
+    }
+}
+
+static uint32_t prvMemorySectorGetSize ( MemorySector sector )
+{
+    if ( toSystemSector ( sector ) < SystemSectorCount )
+    {
+        // we are accessing the system sector where their sizes are predetermined
+        return prvSystemSectorInfos [ toSystemSector ( sector ) ].size;
+    }
+    else
+    {
+        // we are accessing the user data sector where the sizes are changed by user and not known before the configuration sector is read
+        // thus this function will not work for user data sections without prior call to memory_manager_configure () that was successful
+        // the indication of that can be checked with prvIsConfigured variable (true if successful, false, if not successful, or has not been called)
+        if ( prvIsInitialized == false )
+        {
+            // returning 0 makes sense because if everything goes right, there is no way that sector would have 0 pages
+            return 0;
+        }
+
+        // if prvIsConfigured == true, then we can freely use prvGlobalConfigurationDiskSnapshot variable and can safely use user_data_sector_sizes to
+        // find out the user sector sizes.
+        return prvGlobalConfigurationDiskSnapshot.values.memory.user_data_sector_sizes[ toUserDataSector ( sector ) ];
+    }
+}
+
+static MemoryManagerStatus prvMemorySectorBinarySearchForLastWrittenPageIndex ( MemorySector sector, MemorySectorInfo info, uint32_t * result )
+{
+    if ( result == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    if ( sector == MemorySystemSectorUserDataSectorMetaData )
+    {
+        // the metadata sector wraps around, the written pages are not all in front of the erased ones
+        bool found;
+        if ( ! prvMetaDataSearchForNewestPage ( result, &found ) )
+        {
+            return MEM_ERR;
+        }
+
+        prvLastPageSearchResults [ sector ] = *result;
+
+        return MEM_OK;
+    }
+
+    int sectorPageCount = prvMemorySectorGetPageCount ( sector );
+    // need to search the sector and find the latest record
+
+    MemoryBuffer data = { 0 };
+
+    // set the middle
+    int firstPage = 0 ;
+    int lastPage  = sectorPageCount - 1;
+    int middlePage = ( firstPage + lastPage ) / 2;
+
+    while ( firstPage <= lastPage )
+    {
+        memset ( data.data, 0, PAGE_SIZE );
+
+        if ( prvMemoryAccessPage ( sector, info, middlePage, data.data ) == MEM_ERR )
+        {
+            return MEM_ERR;
+        }
+
+        if ( common_is_mem_empty ( data.data, PAGE_SIZE ) )
+        {
+            lastPage = middlePage - 1;
+        }
+        else
+        {
+            firstPage = middlePage + 1;
+        }
+
+        middlePage = ( firstPage + lastPage ) / 2;
+    }
+
+    ( *result ) = middlePage ;
+
+    prvLastPageSearchResults [ sector ] = middlePage;
+
+    return MEM_OK;
+}
+
+static MemoryManagerStatus prvMemorySectorLinearSearchForLastWrittenPageIndex ( MemorySector sector, MemorySectorInfo info, uint32_t * result )
+{
+    if ( result == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    int pageIndex = 0;
+
+    int sectorPageCount = prvMemorySectorGetPageCount ( sector );
+    // need to search the sector and find the latest record
+
+    MemoryBuffer data = { 0 };
+
+    while ( pageIndex < sectorPageCount )
+    {
+        memset ( data.data, 0, PAGE_SIZE );
+
+        if ( prvMemoryAccessPage ( sector, info, pageIndex, data.data ) == MEM_ERR )
+        {
+            return MEM_ERR;
+        }
+
+        if ( common_is_mem_empty ( data.data, PAGE_SIZE ) )
+        {
+            if ( pageIndex != 0 )
+            {
+                pageIndex--;
+            }
+
+            break;
+        }
+
+        pageIndex++;
+    }
+
+    ( *result ) = pageIndex;
+
+    prvLastPageSearchResults[ sector ] = pageIndex;
+
+    return MEM_OK;
+}
+
+// finds the newest page of the metadata sector: the last written page of the sub-sector in front of the only erased
+// sub-sector that follows a written one. A sector without such a pair was never wrapped: either nothing has been
+// written yet, or it is full and the newest page is its last one
+static MemoryManagerStatus prvMetaDataSearchForNewestPage ( uint32_t * result, bool * found )
+{
+    MemorySectorInfo info = prvSystemSectorInfos [ SystemSectorUserDataSectorMetaData ];
+    MemoryBuffer     data = { 0 };
+
+    *result = 0;
+    *found  = false;
+
+    bool anyWritten = false;
+    bool previousWritten;
+
+    // the last sub-sector precedes the first one
+    if ( ! prvMemoryAccessPage ( MemorySystemSectorUserDataSectorMetaData, info, MEMORY_METADATA_SECTOR_PAGE_COUNT - MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT, data.data ) )
+    {
+        return MEM_ERR;
+    }
+    previousWritten = ! common_is_mem_empty ( data.data, PAGE_SIZE );
+
+    uint32_t written = MEMORY_METADATA_SECTOR_SUB_COUNT;
+    for ( uint32_t sub = 0; sub < MEMORY_METADATA_SECTOR_SUB_COUNT; sub++ )
+    {
+        if ( ! prvMemoryAccessPage ( MemorySystemSectorUserDataSectorMetaData, info, sub * MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT, data.data ) )
+        {
+            return MEM_ERR;
+        }
+
+        bool isWritten = ! common_is_mem_empty ( data.data, PAGE_SIZE );
+        anyWritten |= isWritten;
+
+        if ( previousWritten && ! isWritten )
+        {
+            written = ( sub + MEMORY_METADATA_SECTOR_SUB_COUNT - 1 ) % MEMORY_METADATA_SECTOR_SUB_COUNT;
+            break;
+        }
+
+        previousWritten = isWritten;
+    }
+
+    if ( ! anyWritten )
+    {
+        return MEM_OK;
+    }
+
+    if ( written == MEMORY_METADATA_SECTOR_SUB_COUNT )
+    {
+        *result = MEMORY_METADATA_SECTOR_PAGE_COUNT - 1;
+        *found  = true;
+        return MEM_OK;
+    }
+
+    // the pages of a sub-sector are written in order
+    uint32_t page = written * MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT;
+    for ( uint32_t index = 1; index < MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT; index++ )
+    {
+        if ( ! prvMemoryAccessPage ( MemorySystemSectorUserDataSectorMetaData, info, written * MEMORY_METADATA_SECTOR_SUB_PAGE_COUNT + index, data.data ) )
+        {
+            return MEM_ERR;
+        }
+
+        if ( common_is_mem_empty ( data.data, PAGE_SIZE ) )
+        {
+            break;
+        }
+
+        page++;
+    }
+
+    *result = page;
+    *found  = true;
+
+    return MEM_OK;
+}
+
+static MemoryManagerStatus prvSearchForNextFreePage ( uint32_t base, uint32_t size, uint32_t * result )
+{
+    if ( result == NULL )
+    {
+        return MEM_ERR;
+    }
+
+    // the pages are appended one after another, so the written pages always precede the empty ones
+    MemoryBuffer data = { 0 };
+
+    int firstPage = 0;
+    int lastPage  = size / PAGE_SIZE - 1;
+
+    while ( firstPage <= lastPage )
+    {
+        int middlePage = ( firstPage + lastPage ) / 2;
+
+        if ( FLASH_OK != flash_read ( base + middlePage * PAGE_SIZE, data.data, PAGE_SIZE ) )
+        {
+            return MEM_ERR;
+        }
+
+        if ( common_is_mem_empty ( data.data, PAGE_SIZE ) )
+        {
+            lastPage = middlePage - 1;
+        }
+        else
+        {
+            firstPage = middlePage + 1;
+        }
+    }
+
+    ( *result ) = firstPage;
+
+    return MEM_OK;
+}
 
-                    if ( item.type == MemorySystemSectorUserDataSectorMetaData )
-                    {
-                        // update the page counter, so that the next time the data will not go to overwrite the existing page, instead it will go right after it
-                        prvLastPageSearchResults [ toSystemSector ( item.type ) ]++;
-                    }
-                }
-                else
-                {
-                    // it is a user data sector
+MemoryManagerStatus memory_manager_get_single_data_entry ( MemorySector sector, void * dst, uint32_t entry_index )
+{
+    if ( dst == NULL )
+    {
+        return MEM_ERR;
+    }
 
-                    // now start address should point to a page size away from the previous one
-                    prvMemoryMetaDataFlashSnapshot.values.user_sectors [ toUserDataSector ( item.type ) ].bytesWritten += PAGE_SIZE;
+    MemorySectorInfo info = { 0 };
 
-                    // reset the read RAM buffer cursor
-                    // flagging to the other components that this piece of data has been already processed and emptied
-                    memset ( prvCurrentMemoryUserDataSectorRAMBuffers [ toUserDataSector ( item.type ) ].read, 0, PAGE_SIZE );
-                }
-            }
-        }
+    if ( !prvGetMemorySectorInfo ( sector, &info ) )
+    {
+        return MEM_ERR;
     }
 
-    DISPLAY_LINE( "monitor EXITED!" );
+    // the entries of the selected session are counted from its first page
+    uint32_t firstPage = 0;
+    prvSessionApplyWindow ( sector, &info, &firstPage );
+
+    return prvMemoryAccessSectorSingleDataEntry ( sector, info, firstPage, entry_index, dst );
 }
 
 
-MemoryManagerStatus prvGetMemorySectorInfo ( MemorySector sector, MemorySectorInfo * info)
+MemoryManagerStatus memory_manager_get_last_data_entry ( MemorySector sector, void * dst )
 {
-    if ( info == NULL )
+    if ( dst == NULL )
     {
         return MEM_ERR;
     }
 
-    switch ( sector )
-    {
+    MemorySectorInfo info = { 0 };
 
-        case MemorySystemSectorGlobalConfigurationData:
+    if ( !prvGetMemorySectorInfo ( sector, &info ) )
+    {
+        return MEM_ERR;
+    }
 
-            info->startAddress = GLOBAL_CONFIGURATION_SECTOR_BASE;
-            info->endAddress   = GLOBAL_CONFIGURATION_SECTOR_OFFSET;
-            info->size         = GLOBAL_CONFIGURATION_SECTOR_SIZE;
+    uint32_t firstPage = 0;
+    prvSessionApplyWindow ( sector, &info, &firstPage );
+    if ( info.bytesWritten < ( firstPage + 1 ) * PAGE_SIZE )
+    {
+        // the selected session has not written a page into the sector
+        return MEM_ERR;
+    }
 
-            break;
+    return prvMemoryAccessLastDataEntry ( sector, info, dst );
+}
 
-        case MemorySystemSectorUserDataSectorMetaData:
 
-            info->startAddress = MEMORY_METADATA_SECTOR_BASE;
-            info->endAddress   = MEMORY_METADATA_SECTOR_OFFSET;
-            info->size         = MEMORY_METADATA_SECTOR_SIZE;
+// set by memory_manager_print_stats ( ): the reports are printed a line at a time instead of being kept in the buffer
+static bool prvStatsPrintLines = false;
 
-            break;
+// prints the complete lines at the front of the buffer and returns the length of what is left of it
+static int prvStatsPrintCompleteLines ( char * buffer, size_t xBufferLen, int length )
+{
+    // a line longer than the buffer is printed cut short rather than held back
+    if ( ( size_t ) length >= xBufferLen )
+    {
+        length = xBufferLen - 1;
+        buffer[ length++ ] = '\n';
+    }
 
-        case MemoryUserDataSectorGyro:
-        case MemoryUserDataSectorAccel:
-        case MemoryUserDataSectorMag:
-        case MemoryUserDataSectorPressure:
-        case MemoryUserDataSectorTemperature:
-        case MemoryUserDataSectorContinuity:
-        case MemoryUserDataSectorFlightEvent:
+    int begin = 0;
+    for ( int end = 0; end < length; end++ )
+    {
+        if ( buffer[ end ] != '\n' )
+        {
+            continue;
+        }
 
-            if ( ! prvIsInitialized )
-            {
-                return MEM_ERR;
-            }
+        // the line breaks are added by DISPLAY_LINE
+        int last = end;
+        while ( last > begin && ( buffer[ last - 1 ] == '\r' || buffer[ last - 1 ] == '\n' ) )
+        {
+            last--;
+        }
 
-            *info = prvMemoryMetaDataFlashSnapshot.values.user_sectors [ toUserDataSector ( sector ) ];
+        if ( last > begin )
+        {
+            DISPLAY_LINE ( "%.*s", last - begin, &buffer[ begin ] );
+        }
 
-            break;
-        case MemorySectorCount:
-        default:
-            break;
+        begin = end + 1;
     }
 
-    return MEM_OK;
+    memmove ( buffer, &buffer[ begin ], length - begin );
+    return length - begin;
 }
 
-static uint32_t prvMemorySectorGetDataEntriesPerPage ( MemorySector sector )
+// appends formatted text at the given position of the buffer and returns the new position. Stops writing once the
+// buffer is full, so that the caller does not have to check every single line.
+static int prvStatsAppend ( char * buffer, size_t xBufferLen, int length, const char * format, ... )
 {
-    switch ( sector )
-    {
-        case MemorySystemSectorGlobalConfigurationData:
-            return GLOBAL_CONFIGURATION_ENTRIES_PER_PAGE;
-        case MemorySystemSectorUserDataSectorMetaData:
-            return MEMORY_METADATA_ENTRIES_PER_PAGE;
-        case MemoryUserDataSectorGyro:
-        case MemoryUserDataSectorAccel:
-        case MemoryUserDataSectorMag:
-            return IMU_ENTRIES_PER_PAGE;
-        case MemoryUserDataSectorPressure:
-        case MemoryUserDataSectorTemperature:
-            return PRESSURE_ENTRIES_PER_PAGE;
-        case MemoryUserDataSectorContinuity:
-            return CONTINUITY_ENTRIES_PER_PAGE;
-        case MemoryUserDataSectorFlightEvent:
-            return FLIGHT_EVENT_ENTRIES_PER_PAGE;
-        case MemorySectorCount:
-        default:
-            return 0;
+    if ( length < 0 || ( size_t ) length >= xBufferLen )
+    {
+        return length;
+    }
+
+    va_list args;
+    va_start ( args, format );
+    length += vsnprintf ( buffer + length, xBufferLen - length, format, args );
+    va_end ( args );
+
+    if ( prvStatsPrintLines )
+    {
+        length = prvStatsPrintCompleteLines ( buffer, xBufferLen, length );
     }
+
+    return length;
 }
 
-static uint32_t prvMemorySectorGetDataStructSize ( MemorySector sector )
+void memory_manager_update_flight_summary ( float altitude_m, float vertical_velocity_m_s, uint32_t timestamp )
 {
-    switch ( sector )
-    {
-        case MemorySystemSectorGlobalConfigurationData:
-            return sizeof ( GlobalConfigurationU );
-        case MemorySystemSectorUserDataSectorMetaData:
-            return sizeof ( MemoryLayoutMetaDataU );
-        case MemoryUserDataSectorGyro:
-        case MemoryUserDataSectorAccel:
-        case MemoryUserDataSectorMag:
-            return sizeof ( IMUDataU );
-        case MemoryUserDataSectorPressure:
-        case MemoryUserDataSectorTemperature:
-            return sizeof ( PressureDataU );
-        case MemoryUserDataSectorContinuity:
-            return sizeof ( ContinuityU );
-        case MemoryUserDataSectorFlightEvent:
-            return sizeof ( FlightEventU );
-        case MemorySectorCount:
-        default:
-            return 0;
-    }
+    flight_summary_update_dynamics ( &prvFlightSummary, prvRateControl.flight_state, altitude_m, vertical_velocity_m_s, timestamp );
 }
 
-static uint32_t prvMemorySectorGetAlignedDataStructSize ( MemorySector sector )
+MemoryManagerStatus memory_manager_get_flight_summary ( MemoryFlightSummaryU * summary )
 {
-    switch ( sector )
-    {
-        case MemorySystemSectorGlobalConfigurationData:
-            return trunc ( ( PAGE_SIZE / sizeof ( GlobalConfigurationU ) ) ) * sizeof ( GlobalConfigurationU );
-        case MemorySystemSectorUserDataSectorMetaData:
-            return trunc ( ( PAGE_SIZE / sizeof ( MemoryLayoutMetaDataU ) ) ) * sizeof ( MemoryLayoutMetaDataU );
-        case MemoryUserDataSectorGyro:
-        case MemoryUserDataSectorAccel:
-        case MemoryUserDataSectorMag:
-            return trunc ( ( PAGE_SIZE / sizeof ( IMUDataU ) ) ) * sizeof ( IMUDataU );
-        case MemoryUserDataSectorPressure:
-        case MemoryUserDataSectorTemperature:
-            return trunc ( ( PAGE_SIZE / sizeof ( PressureDataU ) ) ) * sizeof ( PressureDataU );
-        case MemoryUserDataSectorContinuity:
-            return trunc ( ( PAGE_SIZE / sizeof ( ContinuityU ) ) ) * sizeof ( ContinuityU );
-        case MemoryUserDataSectorFlightEvent:
-            return trunc ( ( PAGE_SIZE / sizeof ( FlightEventU ) ) ) * sizeof ( FlightEventU );
-        case MemorySectorCount:
-        default:
-            return 0;
+    if ( summary == NULL || prvIsInitialized == false )
+    {
+        return MEM_ERR;
     }
+
+    *summary = prvFlightSummary;
+
+    return MEM_OK;
 }
 
-int prvMemorySectorGetPageCount ( MemorySector sector )
+uint32_t memory_manager_get_session_count ( )
 {
-    if ( toSystemSector ( sector ) < SystemSectorCount )
+    return prvSessionCount;
+}
+
+MemoryManagerStatus memory_manager_get_session ( uint32_t session, MemorySessionU * entry )
+{
+    if ( entry == NULL || session >= prvSessionCount )
     {
-        // we are accessing the system sector where their sizes are predetermined
-        switch ( sector )
-        {
-            case SystemSectorGlobalConfigurationData:
-                return ( GLOBAL_CONFIGURATION_SECTOR_SIZE / PAGE_SIZE );
-            case SystemSectorUserDataSectorMetaData:
-                return ( MEMORY_METADATA_SECTOR_SIZE / PAGE_SIZE );
-            case SystemSectorCount:
-            default:
-                return 0;
-        }
+        return MEM_ERR;
     }
-    else
+
+    if ( FLASH_OK != flash_read ( SESSION_DIRECTORY_SECTOR_BASE + session * PAGE_SIZE, entry->bytes, sizeof ( MemorySessionU ) ) )
     {
-        // we are accessing the user data sector where the sizes are changed by user and not known before the configuration sector is read
-        // thus this function will not work for user data sections without prior call to memory_manager_configure () that was successful
-        // the indication of that can be checked with prvIsConfigured variable (true if successful, false, if not successful, or has not been called)
-        if ( prvIsInitialized == false )
-        {
-            // returning 0 makes sense because if everything goes right, there is no way that sector would have 0 pages
-            return 0;
-        }
+        return MEM_ERR;
+    }
 
-        // if prvIsConfigured == true, then we can freely use prvGlobalConfigurationDiskSnapshot variable and can safely use user_data_sector_sizes to
-        // find out the user sector sizes.
-        return ( prvGlobalConfigurationDiskSnapshot.values.memory.user_data_sector_sizes [ toUserDataSector ( sector ) ] / PAGE_SIZE );
+    // the entry of the session being recorded may still be waiting in the page queue
+    if ( session == prvSessionCurrent && prvSessionCurrentEntry.values.summary.closed != 1 )
+    {
+        *entry = prvSessionCurrentEntry;
+    }
+
+    if ( memcmp ( entry->values.signature, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH ) != 0 )
+    {
+        return MEM_ERR;
     }
+
+    return MEM_OK;
 }
 
-static uint32_t prvMemorySectorGetSize ( MemorySector sector )
+MemoryManagerStatus memory_manager_select_session ( uint32_t session )
 {
-    if ( toSystemSector ( sector ) < SystemSectorCount )
+    if ( session == MEMORY_SESSION_ALL )
     {
-        // we are accessing the system sector where their sizes are predetermined
-        switch ( sector )
-        {
-            case SystemSectorGlobalConfigurationData:
-                return ( GLOBAL_CONFIGURATION_SECTOR_SIZE );
-            case SystemSectorUserDataSectorMetaData:
-                return ( MEMORY_METADATA_SECTOR_SIZE );
-            case SystemSectorCount:
-            default:
-                return 0;
-        }
+        prvSessionSelected = MEMORY_SESSION_ALL;
+        return MEM_OK;
     }
-    else
-    {
-        // we are accessing the user data sector where the sizes are changed by user and not known before the configuration sector is read
-        // thus this function will not work for user data sections without prior call to memory_manager_configure () that was successful
-        // the indication of that can be checked with prvIsConfigured variable (true if successful, false, if not successful, or has not been called)
-        if ( prvIsInitialized == false )
-        {
-            // returning 0 makes sense because if everything goes right, there is no way that sector would have 0 pages
-            return 0;
-        }
 
-        // if prvIsConfigured == true, then we can freely use prvGlobalConfigurationDiskSnapshot variable and can safely use user_data_sector_sizes to
-        // find out the user sector sizes.
-        return prvGlobalConfigurationDiskSnapshot.values.memory.user_data_sector_sizes[ toUserDataSector ( sector ) ];
+    // the bounds are looked up once, the reads then go straight to the pages of the session
+    if ( ! prvSessionGetBounds ( session, prvSessionSelectedBegin, prvSessionSelectedEnd ) )
+    {
+        return MEM_ERR;
     }
+
+    prvSessionSelected = session;
+
+    return MEM_OK;
 }
 
-static MemoryManagerStatus prvMemorySectorBinarySearchForLastWrittenPageIndex ( MemorySector sector, MemorySectorInfo info, uint32_t * result )
+MemoryManagerStatus memory_manager_get_sessions ( char * buffer, size_t xBufferLen )
 {
-    if ( result == NULL )
+    if ( buffer == NULL )
     {
         return MEM_ERR;
     }
 
-    int sectorPageCount = prvMemorySectorGetPageCount ( sector );
-    // need to search the sector and find the latest record
-
-    MemoryBuffer data = { 0 };
-
-    // set the middle
-    int firstPage = 0 ;
-    int lastPage  = sectorPageCount - 1;
-    int middlePage = ( firstPage + lastPage ) / 2;
+    int length = 0;
+    length = prvStatsAppend ( buffer, xBufferLen, length, "\n----- Sessions (%lu of %i) -----\r\n", ( unsigned long ) prvSessionCount, SESSION_DIRECTORY_CAPACITY );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "session  mode      duration  state  pages per sector (gyro accel mag press temp cont event)\r\n" );
 
-    while ( firstPage <= lastPage )
+    for ( uint32_t session = 0; session < prvSessionCount; session++ )
     {
-        memset ( data.data, 0, PAGE_SIZE );
+        MemorySessionU entry;
+        uint32_t       begin [ UserDataSectorCount ];
+        uint32_t       end   [ UserDataSectorCount ];
 
-        if ( prvMemoryAccessPage ( sector, info, middlePage, data.data ) == MEM_ERR )
+        if ( ! memory_manager_get_session ( session, &entry ) || ! prvSessionGetBounds ( session, begin, end ) )
         {
-            return MEM_ERR;
+            length = prvStatsAppend ( buffer, xBufferLen, length, "%7lu  invalid entry\r\n", ( unsigned long ) session );
+            continue;
         }
 
-        if ( common_is_mem_empty ( data.data, PAGE_SIZE ) )
+        MemorySessionSummary summary = entry.values.summary;
+        if ( summary.closed == 1 )
         {
-            lastPage = middlePage - 1;
+            length = prvStatsAppend ( buffer, xBufferLen, length, "%7lu  %-8s %8lu ms %6i ", ( unsigned long ) session,
+                                      entry.values.logging_mode == MemoryLoggingModeCircular ? "circular" : "linear",
+                                      ( unsigned long ) summary.duration_ms, summary.flight_state );
         }
         else
         {
-            firstPage = middlePage + 1;
+            length = prvStatsAppend ( buffer, xBufferLen, length, "%7lu  %-8s %11s %6s ", ( unsigned long ) session,
+                                      entry.values.logging_mode == MemoryLoggingModeCircular ? "circular" : "linear",
+                                      session == prvSessionCurrent ? "recording" : "cut short", "-" );
         }
 
-        middlePage = ( firstPage + lastPage ) / 2;
-    }
+        for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+        {
+            uint32_t last = end[ sector ] != UINT32_MAX ? end[ sector ] : prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ].bytesWritten;
+            length = prvStatsAppend ( buffer, xBufferLen, length, " %lu", ( unsigned long ) ( ( last - begin[ sector ] ) / PAGE_SIZE ) );
+        }
 
-    ( *result ) = middlePage ;
+        length = prvStatsAppend ( buffer, xBufferLen, length, "\r\n" );
+    }
 
-    prvLastPageSearchResults [ sector ] = middlePage;
+    if ( prvSessionSelected != MEMORY_SESSION_ALL )
+    {
+        length = prvStatsAppend ( buffer, xBufferLen, length, "reads are limited to session %lu\r\n", ( unsigned long ) prvSessionSelected );
+    }
 
     return MEM_OK;
 }
 
-static MemoryManagerStatus prvMemorySectorLinearSearchForLastWrittenPageIndex ( MemorySector sector, MemorySectorInfo info, uint32_t * result )
+
+MemoryManagerStatus memory_manager_get_summary ( char * buffer, size_t xBufferLen, bool previous )
 {
-    if ( result == NULL )
+    if ( buffer == NULL || prvIsInitialized == false )
     {
         return MEM_ERR;
     }
 
-    int pageIndex = 0;
+    MemoryFlightSummaryU summary = prvFlightSummary;
+    if ( previous )
+    {
+        // the last summary written before this power-on
+        if ( prvSummaryPreviousPageIndex == UINT32_MAX ||
+             FLASH_OK != flash_read ( SUMMARY_SECTOR_BASE + prvSummaryPreviousPageIndex * PAGE_SIZE, summary.bytes, sizeof ( MemoryFlightSummaryU ) ) ||
+             memcmp ( summary.values.signature, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE, MEMORY_MANAGER_DATA_INTEGRITY_SIGNATURE_BUFFER_LENGTH ) != 0 )
+        {
+            return MEM_ERR;
+        }
+    }
 
-    int sectorPageCount = prvMemorySectorGetPageCount ( sector );
-    // need to search the sector and find the latest record
+    int length = 0;
+    length = prvStatsAppend ( buffer, xBufferLen, length, "\n----- Flight Summary (session %ld) -----\r\n",
+                              summary.values.session == MEMORY_SESSION_ALL ? -1l : ( long ) summary.values.session );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "flight state: %i\r\n", summary.values.flight_state );
 
-    MemoryBuffer data = { 0 };
+    length = prvStatsAppend ( buffer, xBufferLen, length, "state transitions (ms):" );
+    for ( FlightState state = FLIGHT_STATE_LAUNCHPAD; state < FLIGHT_STATE_COUNT; state++ )
+    {
+        if ( summary.values.state_timestamps[ state ] == UINT32_MAX )
+        {
+            length = prvStatsAppend ( buffer, xBufferLen, length, " %i:-", state );
+        }
+        else
+        {
+            length = prvStatsAppend ( buffer, xBufferLen, length, " %i:%lu", state, ( unsigned long ) summary.values.state_timestamps[ state ] );
+        }
+    }
+    length = prvStatsAppend ( buffer, xBufferLen, length, "\r\n" );
 
-    while ( pageIndex < sectorPageCount )
+    if ( summary.values.max_altitude_m > -FLT_MAX )
     {
-        memset ( data.data, 0, PAGE_SIZE );
+        length = prvStatsAppend ( buffer, xBufferLen, length, "max altitude:           %.1f m at %lu\r\n", summary.values.max_altitude_m, ( unsigned long ) summary.values.max_altitude_timestamp );
+    }
 
-        if ( prvMemoryAccessPage ( sector, info, pageIndex, data.data ) == MEM_ERR )
+    if ( summary.values.peak_vertical_velocity_m_s > -FLT_MAX )
+    {
+        length = prvStatsAppend ( buffer, xBufferLen, length, "peak vertical velocity: %.1f m/s\r\n", summary.values.peak_vertical_velocity_m_s );
+    }
+
+    length = prvStatsAppend ( buffer, xBufferLen, length, "descent rate:           drogue %.1f m/s (%lu samples), main %.1f m/s (%lu samples)\r\n",
+                              summary.values.descent_rate_drogue_m_s, ( unsigned long ) summary.values.descent_samples_drogue,
+                              summary.values.descent_rate_main_m_s, ( unsigned long ) summary.values.descent_samples_main );
+
+    length = prvStatsAppend ( buffer, xBufferLen, length, "channel  min (counts)                 max (counts)\r\n" );
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        MemorySummaryChannel channel;
+        size_t               axes = flight_summary_channel_axes ( sector );
+
+        if ( ! flight_summary_get_channel ( &summary, sector, &channel ) )
         {
-            return MEM_ERR;
+            continue;
         }
 
-        if ( common_is_mem_empty ( data.data, PAGE_SIZE ) )
+        if ( channel.min[ 0 ] > channel.max[ 0 ] )
         {
-            if ( pageIndex != 0 )
-            {
-                pageIndex--;
-            }
-
-            break;
+            length = prvStatsAppend ( buffer, xBufferLen, length, "%-8s no samples\r\n", prvMemorySectors[ toMemorySector ( sector ) ].label );
+            continue;
         }
 
-        pageIndex++;
-    }
+        length = prvStatsAppend ( buffer, xBufferLen, length, "%-8s", prvMemorySectors[ toMemorySector ( sector ) ].label );
+        for ( size_t axis = 0; axis < axes; axis++ )
+        {
+            length = prvStatsAppend ( buffer, xBufferLen, length, " %ld", ( long ) channel.min[ axis ] );
+        }
 
-    ( *result ) = pageIndex;
+        length = prvStatsAppend ( buffer, xBufferLen, length, "  |" );
+        for ( size_t axis = 0; axis < axes; axis++ )
+        {
+            length = prvStatsAppend ( buffer, xBufferLen, length, " %ld", ( long ) channel.max[ axis ] );
+        }
 
-    prvLastPageSearchResults[ sector ] = pageIndex;
+        length = prvStatsAppend ( buffer, xBufferLen, length, "\r\n" );
+    }
 
     return MEM_OK;
 }
 
-MemoryManagerStatus memory_manager_get_single_data_entry ( MemorySector sector, void * dst, uint32_t entry_index )
+MemoryManagerStatus memory_manager_get_stats ( char * buffer, size_t xBufferLen )
 {
-    if ( dst == NULL )
+    if ( buffer == NULL )
     {
         return MEM_ERR;
     }
 
-    MemorySectorInfo info = { 0 };
+    int length = 0;
+    length = prvStatsAppend ( buffer, xBufferLen, length, "\n----- Memory Statistics -----\r\n" );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "signature: %.12s\r\n", prvGlobalConfigurationDiskSnapshot.values.signature );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "logging mode: %s\r\n", prvMemoryIsCircular ( ) ? "circular" : "linear" );
 
-    if ( !prvGetMemorySectorInfo ( sector, &info ) )
+    // the layout: where each data sector lives and how much of it is in use
+    length = prvStatsAppend ( buffer, xBufferLen, length, "sector       begin       end      size   on disk   pages   entries\r\n" );
+
+    MemorySectorInfo     dataSector;
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
     {
-        return MEM_ERR;
+        dataSector = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
+        length = prvStatsAppend ( buffer, xBufferLen, length, "%-8s %9lu %9lu %9lu %9lu %7lu %9lu\r\n",
+                                  prvMemorySectors[ toMemorySector ( sector ) ].label,
+                                  ( unsigned long ) dataSector.startAddress,
+                                  ( unsigned long ) dataSector.endAddress,
+                                  ( unsigned long ) dataSector.size,
+                                  ( unsigned long ) dataSector.bytesWritten,
+                                  ( unsigned long ) ( dataSector.bytesWritten / PAGE_SIZE ),
+                                  ( unsigned long ) ( dataSector.bytesWritten / PAGE_SIZE * prvMemorySectorGetDataEntriesPerPage ( toMemorySector( sector ) ) ) );
+    }
+
+    // the throughput: how fast the pages reach the flash memory and how many of them never made it
+    MemoryDiagnosticsU diagnostics;
+    memory_manager_get_diagnostics ( &diagnostics );
+
+    // guarding against division by zero right after the start
+    uint64_t elapsed    = diagnostics.values.elapsed_ms > 0 ? diagnostics.values.elapsed_ms : 1;
+    uint32_t pagesTotal = 0;
+    uint32_t pagesMeta  = 0;
+
+    length = prvStatsAppend ( buffer, xBufferLen, length, "----- Throughput (%lu ms) -----\r\n", ( unsigned long ) diagnostics.values.elapsed_ms );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "sector      pages  pages/s  bytes/s  dropped  overwritten  errors\r\n" );
+
+    for ( MemorySector sector = MemorySystemSectorGlobalConfigurationData; sector < MemorySectorCount; sector++ )
+    {
+        MemorySectorIOStats io = diagnostics.values.sectors[ sector ];
+        length = prvStatsAppend ( buffer, xBufferLen, length, "%-8s %8lu %8lu %8lu %8lu %12lu %7lu\r\n",
+                                  prvMemorySectors[ sector ].label,
+                                  ( unsigned long ) io.pagesWritten,
+                                  ( unsigned long ) ( io.pagesWritten * 1000ull / elapsed ),
+                                  ( unsigned long ) ( io.pagesWritten * 1000ull * PAGE_SIZE / elapsed ),
+                                  ( unsigned long ) io.pagesDropped,
+                                  ( unsigned long ) io.pagesOverwritten,
+                                  ( unsigned long ) io.writeErrors );
+
+        pagesTotal += io.pagesWritten;
+        if ( sector <= MemorySystemSectorUserDataSectorMetaData )
+        {
+            pagesMeta += io.pagesWritten;
+        }
+    }
+
+    length = prvStatsAppend ( buffer, xBufferLen, length, "page queue high-water: %lu/%i\r\n", ( unsigned long ) diagnostics.values.queue_high_water_mark, PAGE_QUEUE_LENGTH );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "lane       pages  dropped  avg wait  max wait (ms)\r\n" );
+    for ( PageLane lane = PageLaneCritical; lane < MEMORY_PAGE_LANE_COUNT; lane++ )
+    {
+        MemoryPageLaneStats stats = diagnostics.values.lanes[ lane ];
+        length = prvStatsAppend ( buffer, xBufferLen, length, "%-8s %7lu %8lu %9lu %9lu\r\n", prvPageLaneNames[ lane ],
+                                  ( unsigned long ) stats.pagesServed, ( unsigned long ) stats.pagesDropped,
+                                  ( unsigned long ) ( stats.pagesServed > 0 ? stats.waitTotalMs / stats.pagesServed : 0 ),
+                                  ( unsigned long ) stats.waitMaxMs );
+    }
+    length = prvStatsAppend ( buffer, xBufferLen, length, "erase-ahead:           %lu blocks, %lu stalls, longest erase %lu ms\r\n",
+                              ( unsigned long ) diagnostics.values.blocks_erased_ahead,
+                              ( unsigned long ) diagnostics.values.erase_stalls,
+                              ( unsigned long ) diagnostics.values.erase_time_max_ms );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "metadata write share:  %lu%% (%lu of %lu pages)\r\n",
+                              ( unsigned long ) ( pagesTotal > 0 ? pagesMeta * 100ull / pagesTotal : 0 ),
+                              ( unsigned long ) pagesMeta, ( unsigned long ) pagesTotal );
+
+    length = prvStatsAppend ( buffer, xBufferLen, length, "flush latency (ms):" );
+    for ( uint32_t bucket = 0; bucket < MEMORY_FLUSH_LATENCY_BUCKET_COUNT; bucket++ )
+    {
+        if ( prvFlushLatencyBucketBounds[ bucket ] == UINT32_MAX )
+        {
+            length = prvStatsAppend ( buffer, xBufferLen, length, " >=%lu:%lu", ( unsigned long ) prvFlushLatencyBucketBounds[ bucket - 1 ], ( unsigned long ) diagnostics.values.flush_latency[ bucket ] );
+        }
+        else
+        {
+            length = prvStatsAppend ( buffer, xBufferLen, length, " <%lu:%lu", ( unsigned long ) prvFlushLatencyBucketBounds[ bucket ], ( unsigned long ) diagnostics.values.flush_latency[ bucket ] );
+        }
     }
 
-    return prvMemoryAccessSectorSingleDataEntry ( sector, info, entry_index, dst );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "\r\ndiagnostics pages on disk: %lu/%i\r\n", ( unsigned long ) prvDiagnosticsNextPageIndex, DIAGNOSTICS_SECTOR_SIZE / PAGE_SIZE );
+
+    return MEM_OK;
 }
 
+void memory_manager_print_stats ( )
+{
+    // a line of the report at a time: the report is longer than any print buffer
+    static char line [ 160 ];
+
+    prvStatsPrintLines = true;
+    memory_manager_get_stats ( line, sizeof ( line ) );
+    prvStatsPrintLines = false;
+}
 
-MemoryManagerStatus memory_manager_get_last_data_entry ( MemorySector sector, void * dst )
+MemoryManagerStatus memory_manager_get_diagnostics ( MemoryDiagnosticsU * diagnostics )
 {
-    if ( dst == NULL )
+    if ( diagnostics == NULL )
     {
         return MEM_ERR;
     }
 
-    MemorySectorInfo info = { 0 };
+    taskENTER_CRITICAL ( );
+    *diagnostics = prvDiagnostics;
+    taskEXIT_CRITICAL ( );
 
-    if ( !prvGetMemorySectorInfo ( sector, &info ) )
+    diagnostics->values.timestamp  = xTaskGetTickCount ( );
+    diagnostics->values.elapsed_ms = ( diagnostics->values.timestamp - prvDiagnosticsStartTick ) * portTICK_PERIOD_MS;
+
+    return MEM_OK;
+}
+
+MemoryManagerStatus memory_manager_get_layout_plan ( char * buffer, size_t xBufferLen, bool apply )
+{
+    if ( buffer == NULL )
     {
         return MEM_ERR;
     }
 
-    return prvMemoryAccessLastDataEntry ( MemoryUserDataSectorFlightEvent, info, dst );
-}
-
+    MemoryManagerConfiguration configuration = prvGlobalConfigurationDiskSnapshot.values.memory;
+    MemoryLayoutPhaseDurations durations     = prvDefaultPhaseDurations;
+    MemoryLayoutPlan           plan;
+    MemoryManagerStatus        fits          = memory_manager_plan_layout ( configuration, durations, &plan );
 
-MemoryManagerStatus memory_manager_get_stats ( char * buffer, size_t xBufferLen )
-{
     int length = 0;
-    length += snprintf ( buffer + length, xBufferLen, "\n----- Memory Statistics -----\r\n" );
-    length += snprintf ( buffer + length, xBufferLen, "signature: %s\r\n", prvGlobalConfigurationDiskSnapshot.values.signature );
-    length += snprintf ( buffer + length, xBufferLen, "Data Sectors: " );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "\n----- Memory Layout Plan -----\r\n" );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "expected phases: pre-launch %lus, pre-apogee %lus, post-apogee %lus, ground %lus\r\n",
+                              ( unsigned long ) durations.pre_launch_s, ( unsigned long ) durations.pre_apogee_s,
+                              ( unsigned long ) durations.post_apogee_s, ( unsigned long ) durations.ground_s );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "sector       needed   planned    in use  configured\r\n" );
 
+    uint32_t coverage = UINT32_MAX;
     for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
     {
-        length += snprintf ( buffer + length, xBufferLen, "%i,", sector );
+        MemorySectorInfo info = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
+        length = prvStatsAppend ( buffer, xBufferLen, length, "%-8s %10lu %9lu %9lu %11lu\r\n",
+                                  prvMemorySectors[ toMemorySector ( sector ) ].label,
+                                  ( unsigned long ) plan.bytes_needed[ sector ],
+                                  ( unsigned long ) plan.sector_sizes[ sector ],
+                                  ( unsigned long ) info.size,
+                                  ( unsigned long ) configuration.user_data_sector_sizes[ sector ] );
+
+        if ( sector != UserDataSectorFlightEvent && plan.bytes_needed[ sector ] > 0 )
+        {
+            uint64_t percent = ( uint64_t ) plan.sector_sizes[ sector ] * 100 / plan.bytes_needed[ sector ];
+            coverage = percent < coverage ? ( uint32_t ) percent : coverage;
+        }
     }
 
-    length += snprintf ( buffer + length, xBufferLen, "\r\n" );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "64KB blocks: %lu needed, %lu available\r\n",
+                              ( unsigned long ) plan.blocks_needed, ( unsigned long ) plan.blocks_available );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "planned layout holds %lu%% of the expected mission\r\n", ( unsigned long ) coverage );
+    length = prvStatsAppend ( buffer, xBufferLen, length, "configured layout: %s\r\n", memory_manager_validate_layout ( configuration ) ? "fits" : "does not fit, the planned one is used on a fresh start" );
 
-    MemorySectorInfo     dataSector;
-    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    if ( ! apply )
     {
-        dataSector = prvMemoryMetaDataFlashSnapshot.values.user_sectors[ sector ];
-        length += snprintf ( buffer + length, xBufferLen, "Sector #%i:\r\n", sector );
-        length += snprintf ( buffer + length, xBufferLen, "--------------------\r\n" );
-        length += snprintf ( buffer + length, xBufferLen, " size:            %lu\r\n", dataSector.size );
-        length += snprintf ( buffer + length, xBufferLen, " begin:           %lu\r\n", dataSector.startAddress );
-        length += snprintf ( buffer + length, xBufferLen, " end:             %lu\r\n", dataSector.endAddress );
-        length += snprintf ( buffer + length, xBufferLen, " size on disk:    %lu\r\n", dataSector.bytesWritten );
-        length += snprintf ( buffer + length, xBufferLen, " pages on disk:   %lu\r\n", dataSector.bytesWritten / PAGE_SIZE );
-        length += snprintf ( buffer + length, xBufferLen, " entries on disk: %lu\r\n", dataSector.bytesWritten / PAGE_SIZE * prvMemorySectorGetDataEntriesPerPage ( toMemorySector( sector ) ) );
-
-//        uint8_t dst [prvMemorySectorGetDataStructSize(sector)];
-//        memset(dst, 0, prvMemorySectorGetDataStructSize(sector));
-//
-//        if( MEM_OK != prvMemoryAccessSectorSingleDataEntry(&dst, sector, 1) )
-//        {
-//            return MEM_ERR;
-//        }
-//        length += snprintf (buffer+length, xBufferLen, " first timestamp: %i\n", common_read_32(&dst[0]));
-//
-//        memset(dst, 0, prvMemorySectorGetDataStructSize(sector));
-//        uint32_t last_index = ( prvImmutableMemorySectorOrdinals[ sector ].info.bytesWritten / PAGE_SIZE * prvMemorySectorGetDataEntriesPerPage(sector) ) - 1;
-//        if( MEM_OK != prvMemoryAccessSectorSingleDataEntry(&dst, sector, last_index) )
-//        {
-//            return MEM_ERR;
-//        }
-//
-//        length += snprintf (buffer+length, xBufferLen, " last timestamp:  %i\n", common_read_32(&dst[0]));
-        length += snprintf ( buffer + length, xBufferLen, "--------------------\r\n" );
+        return MEM_OK;
+    }
+
+    if ( ! fits )
+    {
+        length = prvStatsAppend ( buffer, xBufferLen, length, "rejected: the expected mission does not fit into the flash memory\r\n" );
+        return MEM_ERR;
     }
 
+    memcpy ( configuration.user_data_sector_sizes, plan.sector_sizes, sizeof ( plan.sector_sizes ) );
+    memory_manager_set_memory_configurations ( &configuration );
+
+    length = prvStatsAppend ( buffer, xBufferLen, length, "applied: the data sectors are laid out anew once the flash memory is erased\r\n" );
     return MEM_OK;
 }
 
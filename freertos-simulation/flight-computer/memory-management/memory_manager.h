@@ -2,6 +2,7 @@
 #define MEMORY_MANAGER_MEMORY_MANAGER_H
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include "board/components/recovery.h"
 #include "core/system_configuration.h"
 #include "event-detection/event_detector.h"
@@ -22,44 +23,78 @@ typedef enum MetaDataUpdateFrequencyMode
 
 } MetaDataUpdateFrequencyMode;
 
+// how the user data sectors are filled, chosen for a fresh layout only
+typedef enum MemoryLoggingMode
+{
+
+    MemoryLoggingModeLinear                   = 0, // each sector is written once from its start to its end
+    MemoryLoggingModeCircular                 = 1, // each sector wraps around and overwrites its oldest block
+    MemoryLoggingModeCount
+
+} MemoryLoggingMode;
+
+// The sectors of the flash memory in the order of MemorySector, the system sectors then the user data sectors. The
+// sector enums, the sector descriptor table, the sample rates of the layout planning, the logging of DataContainer and
+// the flight summary channels are all expanded from these two lists: in the firmware a new data channel is one more line
+// here. The compile time planning runs before the compiler, so build-on-linux/layout_planner.py still plans the sector
+// from its own row with the record size and the logging intervals, and memory_manager.c refuses to build until the two agree.
+//
+//   X( name, NAME, entry, label, lane )                        the system sectors
+//   X( name, NAME, entry, label, lane, member, rate, axes )    the user data sectors
+//      name    the enumerators SystemSector<name>, UserDataSector<name>, MemorySystemSector<name> and MemoryUserDataSector<name>
+//      NAME    the prefix of its macros: <NAME>_SECTOR_BASE/_SIZE/_OFFSET in memory_manager.c for a system sector,
+//              userconf_MEM_SECTOR_SIZE_<NAME> and userconf_MEM_SECTOR_ENTRY_SIZE_<NAME> in MemoryLayoutConfig.h for a user data sector
+//      entry   the union of one record, it is defined further down
+//      label   its name in the statistics
+//      lane    the page lane its pages are queued on, see memory_manager.c
+//      member  the member of DataContainer the records come in by
+//      rate    how often the sensor delivers a new sample in Hz, 0 if the records are not sampled
+//      axes    the axes the flight summary keeps the extremes of, 0 for no summary channel. The measurements of the
+//              axes follow the timestamp of the record as signed counts of 16 or 32 bits
+
 // sectors that can be modified only before the flight
+#define MEMORY_SYSTEM_SECTORS( X ) \
+    X( GlobalConfigurationData,     GLOBAL_CONFIGURATION,   GlobalConfigurationU,   "config",   Critical    ) \
+    X( UserDataSectorMetaData,      MEMORY_METADATA,        MemoryLayoutMetaDataU,  "metadata", Critical    )
+
+// sectors that can be modified at any time
+#define MEMORY_USER_DATA_SECTORS( X ) \
+    X( Gyro,                        GYRO,                   IMUDataU,               "gyro",     Inertial,    gyro,  userconf_MEM_SAMPLE_RATE_GYROSCOPE_HZ,     3 ) \
+    X( Accel,                       ACCEL,                  IMUDataU,               "accel",    Inertial,    acc,   userconf_MEM_SAMPLE_RATE_ACCELEROMETER_HZ, 3 ) \
+    X( Mag,                         MAG,                    IMUDataU,               "mag",      Inertial,    mag,   userconf_MEM_SAMPLE_RATE_MAGNETOMETER_HZ,  3 ) \
+    X( Pressure,                    PRESSURE,               PressureDataU,          "press",    Environment, press, userconf_MEM_SAMPLE_RATE_PRESSURE_HZ,      1 ) \
+    X( Temperature,                 TEMPERATURE,            PressureDataU,          "temp",     Environment, temp,  userconf_MEM_SAMPLE_RATE_TEMPERATURE_HZ,   1 ) \
+    X( Continuity,                  CONTINUITY,             ContinuityU,            "cont",     Critical,    cont,  userconf_MEM_SAMPLE_RATE_CONTINUITY_HZ,    0 ) \
+    X( FlightEvent,                 FLIGHT_EVENT,           FlightEventU,           "event",    Critical,    event, 0,                                         0 )
+
+// the expanders of both lists only take the columns they share
+#define MEMORY_SYSTEM_SECTOR_ENUMERATOR( name, NAME, entry, label, lane )           SystemSector##name,
+#define MEMORY_USER_DATA_SECTOR_ENUMERATOR( name, NAME, entry, label, lane, ... )   UserDataSector##name,
+#define MEMORY_SECTOR_SYSTEM_ENUMERATOR( name, NAME, entry, label, lane )           MemorySystemSector##name,
+#define MEMORY_SECTOR_USER_DATA_ENUMERATOR( name, NAME, entry, label, lane, ... )   MemoryUserDataSector##name,
+
 typedef enum SystemSector
 {
 
-    SystemSectorGlobalConfigurationData       = 0,
-    SystemSectorUserDataSectorMetaData        = 1,
+    MEMORY_SYSTEM_SECTORS ( MEMORY_SYSTEM_SECTOR_ENUMERATOR )
     SystemSectorCount
 
 } SystemSector;
 
-// sectors that can be modified at any time
 typedef enum UserDataSector
 {
 
-    UserDataSectorGyro                        = 0,
-    UserDataSectorAccel                       = 1,
-    UserDataSectorMag                         = 2,
-    UserDataSectorPressure                    = 3,
-    UserDataSectorTemperature                 = 4,
-    UserDataSectorContinuity                  = 5,
-    UserDataSectorFlightEvent                 = 6,
+    MEMORY_USER_DATA_SECTORS ( MEMORY_USER_DATA_SECTOR_ENUMERATOR )
     UserDataSectorCount
 
 } UserDataSector;
 
 typedef enum MemorySector
 {
-    
-    MemorySystemSectorGlobalConfigurationData = 0,
-    MemorySystemSectorUserDataSectorMetaData  = 1,
-    MemoryUserDataSectorGyro                  = 2,
-    MemoryUserDataSectorAccel                 = 3,
-    MemoryUserDataSectorMag                   = 4,
-    MemoryUserDataSectorPressure              = 5,
-    MemoryUserDataSectorTemperature           = 6,
-    MemoryUserDataSectorContinuity            = 7,
-    MemoryUserDataSectorFlightEvent           = 8,
-    MemorySectorCount                         = 9
+
+    MEMORY_SYSTEM_SECTORS ( MEMORY_SECTOR_SYSTEM_ENUMERATOR )
+    MEMORY_USER_DATA_SECTORS ( MEMORY_SECTOR_USER_DATA_ENUMERATOR )
+    MemorySectorCount
 
 } MemorySector;
 
@@ -147,7 +182,8 @@ typedef union MemoryLayoutMetaDataU
 {
     struct memory_layout_meta_data_values {
         uint8_t signature              [ 12 ]; // for extra validation (security precaution)
-        MemorySectorInfo user_sectors  [ UserDataSectorCount ];
+        MemorySectorInfo user_sectors  [ UserDataSectorCount ]; // bytesWritten counts every byte ever written in circular mode
+        uint8_t logging_mode;                  // MemoryLoggingMode
     } __attribute__((packed)) values;
 
     uint8_t bytes [ sizeof ( struct memory_layout_meta_data_values ) ];
@@ -190,9 +226,10 @@ typedef struct GlobalConfigurationContainer
 /*-------------------------- IMU -----------------------------*/
 typedef union IMUDataU
 {
+    // the raw counts of IMUSensorData, FlightSystemConfiguration has their scale
     struct imu_values {
         uint32_t timestamp;
-        float data [ 3 ];
+        int16_t  data [ 3 ];
     } __attribute__((packed)) values;
 
     uint8_t bytes [ sizeof ( struct imu_values ) ];
@@ -212,9 +249,10 @@ typedef struct IMUDataContainer
 
 typedef union PressureDataU
 {
+    // the counts of PressureSensorData
     struct pressure_values {
         uint32_t timestamp;
-        float    data;
+        int32_t  data;
     } __attribute__((packed)) values;
     uint8_t bytes [ sizeof ( struct pressure_values ) ];
 
@@ -293,6 +331,157 @@ typedef union
 } GroundDataU;
 
 
+// ---------------------------------------------------------- //
+//-------------------- STORAGE DIAGNOSTICS ------------------- //
+
+// number of buckets in the page flush latency histogram, the bucket bounds are defined in memory_manager.c
+#define MEMORY_FLUSH_LATENCY_BUCKET_COUNT   8
+
+// number of lanes of the page writer, the lanes are defined in memory_manager.c
+#define MEMORY_PAGE_LANE_COUNT              3
+
+// page traffic counters of a single memory sector since memory_manager_start ( )
+typedef struct MemorySectorIOStats
+{
+    uint32_t pagesWritten;      // pages flushed onto the flash memory
+    uint32_t pagesDropped;      // pages that did not fit into the page queue
+    uint32_t pagesOverwritten;  // full pages overwritten in RAM before they could be handed off to their lane
+    uint32_t writeErrors;       // pages the flash memory refused to write
+
+} MemorySectorIOStats;
+
+// page traffic counters of a single lane of the page writer since memory_manager_start ( )
+typedef struct MemoryPageLaneStats
+{
+    uint32_t pagesServed;       // pages the monitor took out of the lane
+    uint32_t pagesDropped;      // pages that did not fit into the lane
+    uint32_t waitTotalMs;       // queued -> taken out by the monitor, summed over the served pages
+    uint32_t waitMaxMs;         // the longest a page has waited in the lane
+
+} MemoryPageLaneStats;
+
+// snapshot of the memory manager throughput and back-pressure counters, stored in the diagnostics sector as is
+typedef union MemoryDiagnosticsU
+{
+    struct memory_diagnostics_values {
+        uint32_t timestamp;                                                 // tick count when the snapshot was taken
+        uint32_t elapsed_ms;                                                // time since memory_manager_start ( )
+        uint32_t queue_high_water_mark;                                     // the most pages ever waiting in the lanes together
+        uint32_t flush_latency [ MEMORY_FLUSH_LATENCY_BUCKET_COUNT ];       // queued -> written onto flash, histogram
+        MemorySectorIOStats sectors [ MemorySectorCount ];
+        uint32_t blocks_erased_ahead;                                       // 64KB blocks erased in the idle gaps between page programs
+        uint32_t erase_stalls;                                              // pages that had to wait for their block to be erased
+        uint32_t erase_time_max_ms;                                         // the longest block erase so far
+        MemoryPageLaneStats lanes [ MEMORY_PAGE_LANE_COUNT ];
+    } __attribute__((packed)) values;
+
+    uint8_t bytes [ sizeof ( struct memory_diagnostics_values ) ];
+
+} MemoryDiagnosticsU;
+
+
+// ---------------------------------------------------------- //
+//-------------------- SESSION DIRECTORY --------------------- //
+
+// reads span every session recorded into the user data sectors, see memory_manager_select_session ( )
+#define MEMORY_SESSION_ALL                  UINT32_MAX
+
+// programmed into the erased tail of the directory entry when the session is stopped, left erased after a power loss
+typedef struct MemorySessionSummary
+{
+    uint8_t  closed;                                // 1 once the summary has been programmed
+    uint8_t  flight_state;                          // the flight state the session ended in
+    uint32_t duration_ms;                           // memory_manager_start ( ) -> memory_manager_stop ( )
+    uint32_t end_bytes [ UserDataSectorCount ];     // bytesWritten of every user data sector when the session ended
+
+} __attribute__((packed)) MemorySessionSummary;
+
+// a session is everything recorded between memory_manager_start ( ) and memory_manager_stop ( ) (or the power loss),
+// its directory entry takes a single page
+typedef union MemorySessionU
+{
+    struct memory_session_values {
+        uint8_t signature [ 12 ];                       // for extra validation (security precaution)
+        uint32_t start_bytes [ UserDataSectorCount ];   // bytesWritten of every user data sector when the session started
+        uint8_t logging_mode;                           // MemoryLoggingMode
+        MemoryManagerConfiguration memory;              // the configuration the session was recorded with
+        FlightSystemConfiguration  system;
+        MemorySessionSummary summary;
+    } __attribute__((packed)) values;
+
+    uint8_t bytes [ sizeof ( struct memory_session_values ) ];
+
+} MemorySessionU;
+
+
+// ---------------------------------------------------------- //
+//-------------------- FLIGHT SUMMARY ------------------------ //
+
+// the user data sectors with summary axes have a channel in the flight summary, in the order of MEMORY_USER_DATA_SECTORS
+#define MEMORY_SUMMARY_CHANNEL_COUNTER( name, NAME, entry, label, lane, member, rate, axes )    + ( ( axes ) > 0 )
+#define MEMORY_SUMMARY_CHANNEL_COUNT        ( 0 MEMORY_USER_DATA_SECTORS ( MEMORY_SUMMARY_CHANNEL_COUNTER ) )
+
+// in the counts of the records of the sector, as the sensors gave them: FlightSystemConfiguration has the scale of the
+// IMU, PRESSURE_SENSOR_PASCAL_PER_COUNT and PRESSURE_SENSOR_CELSIUS_PER_COUNT the ones of the pressure sensor
+typedef struct MemorySummaryChannel
+{
+    int32_t min [ 3 ];      // only the summary axes of the sector are used
+    int32_t max [ 3 ];
+
+} __attribute__((packed)) MemorySummaryChannel;
+
+// maintained at a constant cost per sample during the flight and stored in the summary sector on every flight state
+// change, so that the key numbers of a flight do not need the whole flash memory to be dumped
+typedef union MemoryFlightSummaryU
+{
+    struct memory_flight_summary_values {
+        uint8_t  signature [ 12 ];                                      // for extra validation (security precaution)
+        uint32_t session;                                               // the session the summary was recorded in
+        uint8_t  flight_state;                                          // the last flight state
+        uint32_t state_timestamps [ FLIGHT_STATE_COUNT ];               // ms of every flight state transition, UINT32_MAX if not reached
+        MemorySummaryChannel channels [ MEMORY_SUMMARY_CHANNEL_COUNT ]; // see flight_summary_get_channel ( )
+        float    max_altitude_m;                                        // above the ground
+        uint32_t max_altitude_timestamp;                                // ms
+        float    peak_vertical_velocity_m_s;
+        float    descent_rate_drogue_m_s;                               // mean under the drogue parachute
+        uint32_t descent_samples_drogue;
+        float    descent_rate_main_m_s;                                 // mean under the main parachute
+        uint32_t descent_samples_main;
+    } __attribute__((packed)) values;
+
+    uint8_t bytes [ sizeof ( struct memory_flight_summary_values ) ];
+
+} MemoryFlightSummaryU;
+
+
+// ---------------------------------------------------------- //
+//-------------------- FLASH LAYOUT PLANNER ------------------ //
+
+// how long each flight phase is expected to last, the rate control multipliers follow the same phases
+typedef struct MemoryLayoutPhaseDurations
+{
+    uint32_t pre_launch_s;
+    uint32_t pre_apogee_s;
+    uint32_t post_apogee_s;
+    uint32_t ground_s;
+
+} MemoryLayoutPhaseDurations;
+
+// user data sector sizes planned from the logging rates, see memory_manager_plan_layout ( )
+typedef struct MemoryLayoutPlan
+{
+    uint32_t bytes_needed [ UserDataSectorCount ];  // what the expected mission writes into each sector
+    uint32_t sector_sizes [ UserDataSectorCount ];  // aligned to the 64KB erase blocks
+    uint32_t blocks_needed;                         // 64KB blocks the expected mission needs at least
+    uint32_t blocks_available;                      // 64KB blocks the user data sectors can occupy
+
+} MemoryLayoutPlan;
+
+
+// called with every entry memory_manager_read_range ( ) finds in the time range, returning false stops the read
+typedef bool ( * MemoryRangeCallback ) ( MemorySector sector, const uint8_t * entry, void * arg );
+
+
 MemoryManagerStatus memory_manager_init ( );
 MemoryManagerStatus memory_manager_user_data_update ( DataContainer * _container );
 MemoryManagerStatus memory_manager_start ( );
@@ -303,16 +492,43 @@ MemoryManagerStatus memory_manager_set_system_configurations ( FlightSystemConfi
 MemoryManagerStatus memory_manager_set_memory_configurations ( MemoryManagerConfiguration * memoryConfiguration );
 MemoryManagerConfiguration memory_manager_get_default_memory_configurations ( );
 void memory_manager_set_metadata_update_mode ( MetaDataUpdateFrequencyMode mode );
+void memory_manager_set_flight_state ( FlightState state );
+MemoryManagerStatus memory_manager_set_logging_mode ( MemoryLoggingMode mode );
+MemoryLoggingMode memory_manager_get_logging_mode ( );
 
 
 MemoryManagerStatus memory_manager_get_single_data_entry ( MemorySector sector, void * dst, uint32_t entry_index );
 MemoryManagerStatus memory_manager_get_last_data_entry ( MemorySector sector, void * dst );
+MemoryManagerStatus memory_manager_read_range ( MemorySector sector, uint32_t t_begin, uint32_t t_end, MemoryRangeCallback callback, void * arg );
+
+
+// the timestamp is the one of the pressure sample the altitude comes from, in ms as the entries
+void memory_manager_update_flight_summary ( float altitude_m, float vertical_velocity_m_s, uint32_t timestamp );
+MemoryManagerStatus memory_manager_get_flight_summary ( MemoryFlightSummaryU * summary );
+MemoryManagerStatus memory_manager_get_summary ( char * buffer, size_t xBufferLen, bool previous );
+
+
+uint32_t memory_manager_get_session_count ( );
+MemoryManagerStatus memory_manager_get_session ( uint32_t session, MemorySessionU * entry );
+MemoryManagerStatus memory_manager_select_session ( uint32_t session );
+MemoryManagerStatus memory_manager_get_sessions ( char * buffer, size_t xBufferLen );
 
 
 MemoryManagerStatus memory_manager_get_stats ( char * buffer, size_t xBufferLen );
+void memory_manager_print_stats ( );
+MemoryManagerStatus memory_manager_get_diagnostics ( MemoryDiagnosticsU * diagnostics );
+
+
+MemoryLayoutPhaseDurations memory_manager_get_default_phase_durations ( );
+MemoryManagerStatus memory_manager_plan_layout ( MemoryManagerConfiguration configuration, MemoryLayoutPhaseDurations durations, MemoryLayoutPlan * plan );
+MemoryManagerStatus memory_manager_validate_layout ( MemoryManagerConfiguration configuration );
+MemoryManagerStatus memory_manager_get_layout_plan ( char * buffer, size_t xBufferLen, bool apply );
 
 
 MemoryManagerStatus memory_manager_erase_configuration_section ( );
+// erases the data sectors, their timestamp index and the session directory, and forgets where the data went. Only
+// while the memory manager is initialized and stopped
+MemoryManagerStatus memory_manager_erase_data_section ( );
 MemoryManagerStatus memory_manager_erase_everything ( );
 
 
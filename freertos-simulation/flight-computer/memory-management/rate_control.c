@@ -0,0 +1,192 @@
+#include "rate_control.h"
+
+#include <math.h>
+#include <string.h>
+
+
+static bool prvRateControlAcceptMeasurement ( MemoryRateControl * control, uint32_t interval, UserDataSector sector, float * data, size_t count, uint32_t timestamp );
+
+
+void rate_control_init ( MemoryRateControl * control, uint32_t ticks_per_second )
+{
+    memset ( control, 0, sizeof ( MemoryRateControl ) );
+
+    control->flight_state     = FLIGHT_STATE_LAUNCHPAD;
+    control->ticks_per_second = ticks_per_second;
+}
+
+void rate_control_restart_channel ( MemoryRateControl * control, UserDataSector sector )
+{
+    control->channels [ sector ].samples = 0;
+}
+
+uint32_t rate_control_get_interval ( const MemoryRateControl * control, MemoryManagerConfiguration configuration, UserDataSector sector )
+{
+    uint32_t interval_ms = 0;
+    switch ( sector )
+    {
+        case UserDataSectorGyro:
+            interval_ms = configuration.write_interval_gyroscope_ms;
+            break;
+        case UserDataSectorAccel:
+            interval_ms = configuration.write_interval_accelerometer_ms;
+            break;
+        case UserDataSectorMag:
+            interval_ms = configuration.write_interval_magnetometer_ms;
+            break;
+        case UserDataSectorPressure:
+            interval_ms = configuration.write_interval_pressure_ms;
+            break;
+        case UserDataSectorTemperature:
+            interval_ms = configuration.write_interval_temperature_ms;
+            break;
+        case UserDataSectorContinuity:
+            // both circuits share the same entry, so the more demanding of the two wins
+            interval_ms = configuration.write_drogue_continuity_ms;
+            if ( interval_ms == 0 || ( configuration.write_main_continuity_ms != 0 && configuration.write_main_continuity_ms < interval_ms ) )
+            {
+                interval_ms = configuration.write_main_continuity_ms;
+            }
+            break;
+        case UserDataSectorFlightEvent:
+        case UserDataSectorCount:
+        default:
+            // flight events are sparse and every one of them matters
+            return 0;
+    }
+
+    uint8_t multiplier = 1;
+    switch ( control->flight_state )
+    {
+        case FLIGHT_STATE_LAUNCHPAD:
+            multiplier = configuration.write_pre_launch_multiplier;
+            break;
+        case FLIGHT_STATE_PRE_APOGEE:
+            multiplier = configuration.write_pre_apogee_multiplier;
+            break;
+        case FLIGHT_STATE_APOGEE:
+        case FLIGHT_STATE_POST_APOGEE:
+        case FLIGHT_STATE_MAIN_CHUTE:
+        case FLIGHT_STATE_POST_MAIN:
+            multiplier = configuration.write_post_apogee_multiplier;
+            break;
+        case FLIGHT_STATE_LANDED:
+        case FLIGHT_STATE_EXIT:
+        case FLIGHT_STATE_COUNT:
+        default:
+            multiplier = configuration.write_ground_multiplier;
+            break;
+    }
+
+    // a multiplier that was never configured leaves the interval as is
+    if ( multiplier == 0 )
+    {
+        multiplier = 1;
+    }
+
+    return ( uint32_t ) ( ( uint64_t ) interval_ms * multiplier * control->ticks_per_second / 1000 );
+}
+
+bool rate_control_accept ( MemoryRateControl * control, MemoryManagerConfiguration configuration, UserDataSector sector, uint8_t * entry, uint32_t timestamp )
+{
+    uint32_t interval = rate_control_get_interval ( control, configuration, sector );
+
+    switch ( sector )
+    {
+        case UserDataSectorGyro:
+        case UserDataSectorAccel:
+        case UserDataSectorMag:
+        {
+            // the entry is packed, so the measurements are averaged in an aligned copy, and the average is rounded
+            // back to the counts of the sensor
+            IMUDataU * imu = ( IMUDataU * ) entry;
+            float data [ 3 ] = { imu->values.data [ 0 ], imu->values.data [ 1 ], imu->values.data [ 2 ] };
+
+            if ( ! prvRateControlAcceptMeasurement ( control, interval, sector, data, 3, timestamp ) )
+            {
+                return false;
+            }
+
+            imu->values.data [ 0 ] = ( int16_t ) lroundf ( data [ 0 ] );
+            imu->values.data [ 1 ] = ( int16_t ) lroundf ( data [ 1 ] );
+            imu->values.data [ 2 ] = ( int16_t ) lroundf ( data [ 2 ] );
+
+            return true;
+        }
+        case UserDataSectorPressure:
+        case UserDataSectorTemperature:
+        {
+            PressureDataU * pressure = ( PressureDataU * ) entry;
+            float data = pressure->values.data;
+
+            if ( ! prvRateControlAcceptMeasurement ( control, interval, sector, &data, 1, timestamp ) )
+            {
+                return false;
+            }
+
+            pressure->values.data = ( int32_t ) lroundf ( data );
+
+            return true;
+        }
+        case UserDataSectorContinuity:
+        {
+            // the continuity status is a state, not a measurement: it is decimated instead of averaged, and every
+            // change is logged
+            ContinuityU * continuity = ( ContinuityU * ) entry;
+
+            bool changed = memcmp ( continuity->values.status, control->last_continuity.values.status, sizeof ( continuity->values.status ) ) != 0;
+
+            if ( interval != 0 && ! changed && ( timestamp - control->last_continuity_time ) < interval )
+            {
+                return false;
+            }
+
+            control->last_continuity      = *continuity;
+            control->last_continuity_time = timestamp;
+
+            return true;
+        }
+        case UserDataSectorFlightEvent:
+        case UserDataSectorCount:
+        default:
+            return true;
+    }
+}
+
+// averages the measurements of a channel over its logging interval. Returns true once the interval has elapsed, in
+// which case data holds the average of all the samples of the interval and must be logged. Returns false if the sample
+// was only accumulated
+static bool prvRateControlAcceptMeasurement ( MemoryRateControl * control, uint32_t interval, UserDataSector sector, float * data, size_t count, uint32_t timestamp )
+{
+    if ( interval == 0 )
+    {
+        return true;
+    }
+
+    RateControlChannel * channel = &control->channels [ sector ];
+
+    if ( channel->samples == 0 )
+    {
+        channel->windowStart = timestamp;
+        memset ( channel->sum, 0, sizeof ( channel->sum ) );
+    }
+
+    for ( size_t i = 0; i < count; i++ )
+    {
+        channel->sum [ i ] += data [ i ];
+    }
+    channel->samples++;
+
+    if ( ( timestamp - channel->windowStart ) < interval )
+    {
+        return false;
+    }
+
+    for ( size_t i = 0; i < count; i++ )
+    {
+        data [ i ] = channel->sum [ i ] / channel->samples;
+    }
+    channel->samples = 0;
+
+    return true;
+}
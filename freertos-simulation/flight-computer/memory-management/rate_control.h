@@ -0,0 +1,50 @@
+#ifndef MEMORY_MANAGER_RATE_CONTROL_H
+#define MEMORY_MANAGER_RATE_CONTROL_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include "memory_manager.h"
+
+// The logging rate control engine: decides, per user data sector and flight phase, which samples get logged and
+// averages the ones in between. It holds no global state and does not touch the RTOS, the time comes from the entries
+// in ticks of ticks_per_second (1000 for the ms of the flight computer), so every simulated flight can have its own.
+
+// per-channel state of the rate control, see rate_control_accept ( )
+typedef struct
+{
+    uint32_t windowStart;       // time of the first sample of the current averaging window
+    uint32_t samples;           // number of samples accumulated in the current averaging window
+    float    sum [ 3 ];         // accumulated measurements of the current averaging window
+
+} RateControlChannel;
+
+typedef struct MemoryRateControl
+{
+    RateControlChannel channels [ UserDataSectorCount ];
+
+    // flight phase the logging rates are selected for, follows the flight events that are being logged
+    FlightState        flight_state;
+
+    // the continuity status last logged: a change is logged right away regardless of the interval
+    ContinuityU        last_continuity;
+    uint32_t           last_continuity_time;
+
+    uint32_t           ticks_per_second;
+
+} MemoryRateControl;
+
+
+void rate_control_init ( MemoryRateControl * control, uint32_t ticks_per_second );
+
+// drops the samples accumulated so far in the averaging window of the sector
+void rate_control_restart_channel ( MemoryRateControl * control, UserDataSector sector );
+
+// returns the logging interval of the sector in ticks for the current flight phase, 0 if every sample is to be logged
+uint32_t rate_control_get_interval ( const MemoryRateControl * control, MemoryManagerConfiguration configuration, UserDataSector sector );
+
+// true if the entry is to be logged, in which case the measurements of the entry are replaced by their average over
+// the logging interval. False if the sample was only accumulated. The timestamp is the one of the entry, so that the
+// windows do not depend on when the entry reaches the rate control
+bool rate_control_accept ( MemoryRateControl * control, MemoryManagerConfiguration configuration, UserDataSector sector, uint8_t * entry, uint32_t timestamp );
+
+#endif // MEMORY_MANAGER_RATE_CONTROL_H
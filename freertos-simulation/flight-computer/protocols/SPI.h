@@ -22,9 +22,41 @@ extern "C" {
 #include <inttypes.h>
 
 typedef enum {
-    SPI_OK = 0, SPI_ERR = 1
+    SPI_OK = 0, SPI_ERR = 1, SPI_BUSY = 2
 } SPIStatus;
 
+typedef enum {
+    SPI_BUS_1 = 0, SPI_BUS_2 = 1, SPI_BUS_3 = 2, SPI_BUS_COUNT
+} SPIBus;
+
+// transfers shorter than this are cheaper to poll than to set the DMA up for
+#define SPI_DMA_MIN_SIZE    16
+
+// SCK of the SPI1 transfers with fast_clock, APB2 (84MHz) over 8
+#define SPI_FAST_CLOCK_HZ   10500000
+
+// Description:
+//  An asynchronous transfer. The chip select is lowered, the command bytes are sent, then size bytes are either sent
+//  from tx_buffer or received into rx_buffer (the other one NULL) and the chip select is raised again. The descriptor
+//  and its buffers belong to the driver from spi_transfer_start until spi_transfer_wait returns.
+//
+//  With keep_selected the chip select stays low and the bus stays taken once the transfer is over, the next transfer on
+//  the bus goes on with the same command (its own cmd_buffer is usually empty) until one without keep_selected ends it.
+typedef struct spi_transfer
+{
+    SPIBus              bus;
+    uint8_t             chip_select;        // SPI3 only: 0 for the accelerometer, 1 for the gyroscope
+    uint8_t           * cmd_buffer;
+    uint8_t             cmd_buffer_size;
+    uint8_t           * tx_buffer;
+    uint8_t           * rx_buffer;
+    uint16_t            size;
+    uint8_t             keep_selected;
+    uint8_t             fast_clock;         // SPI1 only: SCK at SPI_FAST_CLOCK_HZ rather than the one of spi1_init
+
+    volatile uint8_t    status;             // SPI_BUSY until the transfer is over, then SPI_OK or SPI_ERR
+} SPITransfer;
+
 
 int spi1_init ( );
 
@@ -32,6 +64,23 @@ int spi2_init ( );
 
 int spi3_init ( );
 
+// Description:
+//  Takes the bus, waiting for the transfer of another task to be over, and starts the transfer. On SPI1 and SPI3 the
+//  data of SPI_DMA_MIN_SIZE bytes or more goes by DMA and the function returns while it is on the wire; the other
+//  transfers, and all of them before the scheduler is started, are over by the time it returns.
+int spi_transfer_start ( SPITransfer * transfer );
+
+// Description:
+//  Sleeps until the transfer the calling task started is over and gives the bus back.
+//
+// Parameters:
+//     transfer         The descriptor given to spi_transfer_start.
+//     timeout          The timeout value in milliseconds, the transfer is aborted past it.
+int spi_transfer_wait ( SPITransfer * transfer, uint32_t timeout );
+
+// spi_transfer_start then spi_transfer_wait, the task sleeps rather than spins during the transfer
+int spi_transfer ( SPITransfer * transfer, uint32_t timeout );
+
 // Description:
 //  This function reads one or more bytes over the SPI bus, by sending multiple address bytes
 //  and then reading multiple bytes.
@@ -69,9 +69,8 @@ int uart6_receive_command ( char * pData );
 int uart2_receive ( uint8_t * buf, size_t size );
 int uart6_receive ( uint8_t * buf, size_t size );
 
-#endif //STM32F4XX_HAL_UART_CLI_H
-
-
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
+
+#endif //STM32F4XX_HAL_UART_CLI_H
\ No newline at end of file
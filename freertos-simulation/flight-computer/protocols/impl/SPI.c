@@ -17,6 +17,8 @@
 #include "board/hardware_definitions.h"
 #include "FreeRTOS.h"
 #include "portable.h"
+#include "task.h"
+#include "semphr.h"
 
 
 #define SPI1_CS_PIN     FLASH_SPI_CS_PIN
@@ -37,10 +39,49 @@
 #define SPI3_CS2_PIN    IMU_SPI_GYRO_CS_PIN
 #define SPI3_CS2_PORT   IMU_SPI_GYRO_CS_PORT
 
+// the polled parts of a transfer: the command bytes, short data and everything before the scheduler is started
+#define SPI_POLL_TIMEOUT_MS     100
+
+// SPI_FAST_CLOCK_HZ on SPI1
+#define SPI_FAST_BAUDRATEPRESCALER  SPI_BAUDRATEPRESCALER_8
+
 static SPI_HandleTypeDef hspi1 = { .Instance = 0 };
 static SPI_HandleTypeDef hspi2 = { .Instance = 0 };
 static SPI_HandleTypeDef hspi3 = { .Instance = 0 };;
 
+// serviced by the DMA stream interrupts in interrupt_handlers.c
+DMA_HandleTypeDef hdma_spi1_rx;
+DMA_HandleTypeDef hdma_spi1_tx;
+DMA_HandleTypeDef hdma_spi3_rx;
+DMA_HandleTypeDef hdma_spi3_tx;
+
+typedef struct
+{
+    SPI_HandleTypeDef     * hspi;
+    SemaphoreHandle_t       mutex;      // held from the start of a transfer until it is waited for
+    SemaphoreHandle_t       done;       // given by the DMA interrupt when a transfer is over
+    uint8_t                 locked;     // the mutex was taken, not so before the scheduler is started
+    TaskHandle_t            owner;      // the task that took the mutex
+    uint8_t                 selected;   // a transfer with keep_selected left the chip select low
+    uint8_t                 fast;       // SCK runs at SPI_FAST_CLOCK_HZ until the chip select is raised
+
+    SPITransfer * volatile  active;
+    GPIO_TypeDef          * port;       // chip select of the active transfer
+    uint16_t                pin;
+} SPIBusState;
+
+static SPIBusState prvBuses [ SPI_BUS_COUNT ] = {
+        [ SPI_BUS_1 ] = { .hspi = &hspi1 },
+        [ SPI_BUS_2 ] = { .hspi = &hspi2 },
+        [ SPI_BUS_3 ] = { .hspi = &hspi3 },
+};
+
+
+static int  prv_spi_bus_init            ( SPIBus bus );
+static int  prv_spi_dma_init            ( DMA_HandleTypeDef * hdma, DMA_Stream_TypeDef * stream, uint32_t channel, uint32_t direction, IRQn_Type irq );
+static void prv_spi_transfer_complete   ( SPIBusState * bus, uint8_t status );
+static void prv_spi_set_prescaler       ( SPI_HandleTypeDef * hspi, uint32_t prescaler );
+
 
 int spi1_init ( void )
 {
@@ -95,7 +136,18 @@ int spi1_init ( void )
     HAL_GPIO_Init ( SPI1_CS_PORT, &GPIO_InitStruct );
     HAL_GPIO_WritePin ( SPI1_CS_PORT, SPI1_CS_PIN, GPIO_PIN_SET );
 
-    return SPI_OK;
+    // DMA2 stream 0 and 3 on channel 3 carry SPI1
+    __HAL_RCC_DMA2_CLK_ENABLE( );
+    if ( SPI_OK != prv_spi_dma_init ( &hdma_spi1_rx, DMA2_Stream0, DMA_CHANNEL_3, DMA_PERIPH_TO_MEMORY, DMA2_Stream0_IRQn ) ||
+         SPI_OK != prv_spi_dma_init ( &hdma_spi1_tx, DMA2_Stream3, DMA_CHANNEL_3, DMA_MEMORY_TO_PERIPH, DMA2_Stream3_IRQn ) )
+    {
+        return SPI_ERR;
+    }
+
+    __HAL_LINKDMA( &hspi1, hdmarx, hdma_spi1_rx );
+    __HAL_LINKDMA( &hspi1, hdmatx, hdma_spi1_tx );
+
+    return prv_spi_bus_init ( SPI_BUS_1 );
 }
 
 int spi2_init ( void )
@@ -148,7 +200,8 @@ int spi2_init ( void )
 
     HAL_GPIO_Init ( SPI2_CS_PORT, &GPIO_InitStruct );
 
-    return SPI_OK;
+    // no DMA, the transfers of the pressure sensor are a few bytes
+    return prv_spi_bus_init ( SPI_BUS_2 );
 }
 
 int spi3_init ( void )
@@ -207,52 +260,305 @@ int spi3_init ( void )
     HAL_GPIO_WritePin ( SPI3_CS1_PORT, SPI3_CS1_PIN, GPIO_PIN_SET );
     HAL_GPIO_WritePin ( SPI3_CS2_PORT, SPI3_CS2_PIN, GPIO_PIN_SET );
 
+    // DMA1 stream 0 and 5 on channel 0 carry SPI3
+    __HAL_RCC_DMA1_CLK_ENABLE( );
+    if ( SPI_OK != prv_spi_dma_init ( &hdma_spi3_rx, DMA1_Stream0, DMA_CHANNEL_0, DMA_PERIPH_TO_MEMORY, DMA1_Stream0_IRQn ) ||
+         SPI_OK != prv_spi_dma_init ( &hdma_spi3_tx, DMA1_Stream5, DMA_CHANNEL_0, DMA_MEMORY_TO_PERIPH, DMA1_Stream5_IRQn ) )
+    {
+        return SPI_ERR;
+    }
+
+    __HAL_LINKDMA( &hspi3, hdmarx, hdma_spi3_rx );
+    __HAL_LINKDMA( &hspi3, hdmatx, hdma_spi3_tx );
+
+    return prv_spi_bus_init ( SPI_BUS_3 );
+}
+
+
+static int prv_spi_bus_init ( SPIBus bus )
+{
+    SPIBusState * state = &prvBuses [ bus ];
+
+    // the sensors may initialize a bus more than once
+    if ( state->mutex == NULL )
+    {
+        state->mutex = xSemaphoreCreateMutex ( );
+        state->done  = xSemaphoreCreateBinary ( );
+    }
+
+    return ( state->mutex != NULL && state->done != NULL ) ? SPI_OK : SPI_ERR;
+}
+
+
+static int prv_spi_dma_init ( DMA_HandleTypeDef * hdma, DMA_Stream_TypeDef * stream, uint32_t channel, uint32_t direction, IRQn_Type irq )
+{
+    hdma->Instance                 = stream;
+    hdma->Init.Channel             = channel;
+    hdma->Init.Direction           = direction;
+    hdma->Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma->Init.MemInc              = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode                = DMA_NORMAL;
+    hdma->Init.Priority            = DMA_PRIORITY_LOW;
+    hdma->Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+    if ( HAL_DMA_Init ( hdma ) != HAL_OK )
+    {
+        return SPI_ERR;
+    }
+
+    // the completion calls into the kernel, so it cannot be above the highest priority the kernel masks
+    HAL_NVIC_SetPriority ( irq, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0 );
+    HAL_NVIC_EnableIRQ ( irq );
+
     return SPI_OK;
 }
 
-static SPIStatus single_transmit_only ( SPI_HandleTypeDef * hspi, uint8_t * addr, uint16_t size, uint32_t timeout )
+
+int spi_transfer_start ( SPITransfer * transfer )
 {
-    GPIO_TypeDef         * port  = SPI1_CS_PORT;
-    uint16_t             pin     = 0;
+    if ( transfer == NULL || transfer->bus >= SPI_BUS_COUNT )
+    {
+        return SPI_ERR;
+    }
 
-    if ( hspi->Instance == SPI1 )
+    SPIBusState * bus = &prvBuses [ transfer->bus ];
+    if ( bus->hspi->Instance == NULL || bus->mutex == NULL )
     {
-        port = SPI1_CS_PORT;
-        pin  = SPI1_CS_PIN;
+        return SPI_ERR;
     }
-    else if ( hspi->Instance == SPI2 )
+
+    const uint8_t scheduled = taskSCHEDULER_RUNNING == xTaskGetSchedulerState ( );
+
+    // a transfer with keep_selected before it, of the same task, already holds the bus and the chip select. Another
+    // task waits for the chip select to be raised, its transfer would go into the one that is still open
+    const uint8_t held = bus->selected && ( ! bus->locked || bus->owner == xTaskGetCurrentTaskHandle ( ) );
+
+    if ( ! held )
     {
-        port = SPI2_CS_PORT;
-        pin  = SPI2_CS_PIN;
+        if ( scheduled && pdTRUE != xSemaphoreTake ( bus->mutex, portMAX_DELAY ) )
+        {
+            return SPI_ERR;
+        }
+
+        bus->locked = scheduled;
+        bus->owner  = scheduled ? xTaskGetCurrentTaskHandle ( ) : NULL;
+
+        if ( bus->hspi->Instance == SPI1 )
+        {
+            bus->port = SPI1_CS_PORT;
+            bus->pin  = SPI1_CS_PIN;
+        }
+        else if ( bus->hspi->Instance == SPI2 )
+        {
+            bus->port = SPI2_CS_PORT;
+            bus->pin  = SPI2_CS_PIN;
+        }
+        else if ( transfer->chip_select == 0 )
+        {
+            bus->port = SPI3_CS1_PORT;
+            bus->pin  = SPI3_CS1_PIN;
+        }
+        else
+        {
+            bus->port = SPI3_CS2_PORT;
+            bus->pin  = SPI3_CS2_PIN;
+        }
+
+        bus->fast = transfer->fast_clock && bus->hspi->Instance == SPI1;
+        if ( bus->fast )
+        {
+            prv_spi_set_prescaler ( bus->hspi, SPI_FAST_BAUDRATEPRESCALER );
+        }
+
+        // Write the CS low (lock)
+        HAL_GPIO_WritePin ( bus->port, bus->pin, GPIO_PIN_RESET );
+    }
+
+    bus->active = transfer;
+    transfer->status = SPI_BUSY;
+
+    /* Send command and parameters to slave first, a few bytes are not worth the DMA */
+    HAL_StatusTypeDef statHAL = HAL_OK;
+    if ( transfer->cmd_buffer_size > 0 )
+    {
+        statHAL = HAL_SPI_Transmit ( bus->hspi, transfer->cmd_buffer, transfer->cmd_buffer_size, SPI_POLL_TIMEOUT_MS );
+    }
+
+    if ( statHAL == HAL_OK && transfer->size > 0 )
+    {
+        if ( scheduled && bus->hspi->hdmarx != NULL && transfer->size >= SPI_DMA_MIN_SIZE )
+        {
+            if ( transfer->tx_buffer != NULL )
+            {
+                statHAL = HAL_SPI_Transmit_DMA ( bus->hspi, transfer->tx_buffer, transfer->size );
+            }
+            else
+            {
+                statHAL = HAL_SPI_Receive_DMA ( bus->hspi, transfer->rx_buffer, transfer->size );
+            }
+
+            // the DMA interrupt completes the transfer
+            if ( statHAL == HAL_OK )
+            {
+                return SPI_OK;
+            }
+        }
+        else if ( transfer->tx_buffer != NULL )
+        {
+            statHAL = HAL_SPI_Transmit ( bus->hspi, transfer->tx_buffer, transfer->size, SPI_POLL_TIMEOUT_MS );
+        }
+        else
+        {
+            statHAL = HAL_SPI_Receive ( bus->hspi, transfer->rx_buffer, transfer->size, SPI_POLL_TIMEOUT_MS );
+        }
     }
-    else if ( hspi->Instance == SPI3 )
+
+    prv_spi_transfer_complete ( bus, statHAL == HAL_OK ? SPI_OK : SPI_ERR );
+
+    return transfer->status;
+}
+
+
+int spi_transfer_wait ( SPITransfer * transfer, uint32_t timeout )
+{
+    if ( transfer == NULL || transfer->bus >= SPI_BUS_COUNT )
     {
-        port = SPI3_CS1_PORT;
-        pin  = SPI3_CS1_PIN;
+        return SPI_ERR;
     }
-    else
+
+    SPIBusState * bus = &prvBuses [ transfer->bus ];
+
+    if ( transfer->status == SPI_BUSY && pdTRUE != xSemaphoreTake ( bus->done, pdMS_TO_TICKS ( timeout ) ) )
     {
+        HAL_SPI_Abort ( bus->hspi );
+        prv_spi_transfer_complete ( bus, SPI_ERR );
+
+        // the interrupt may have come in between
+        xSemaphoreTake ( bus->done, 0 );
+    }
+
+    const int status = transfer->status;
+
+    if ( bus->locked && ! bus->selected )
+    {
+        bus->locked = 0;
+        bus->owner  = NULL;
+        xSemaphoreGive ( bus->mutex );
+    }
+
+    return status;
+}
+
+
+int spi_transfer ( SPITransfer * transfer, uint32_t timeout )
+{
+    if ( SPI_OK != spi_transfer_start ( transfer ) )
+    {
+        // the bus is given back by the wait, whatever the failure
+        spi_transfer_wait ( transfer, 0 );
         return SPI_ERR;
     }
 
-    // Write the CS low (lock)
-    HAL_GPIO_WritePin ( port, pin, GPIO_PIN_RESET );
+    return spi_transfer_wait ( transfer, timeout );
+}
+
+
+// from the DMA interrupt, or from the task when the transfer was polled
+static void prv_spi_transfer_complete ( SPIBusState * bus, uint8_t status )
+{
+    SPITransfer * transfer = bus->active;
+    if ( transfer == NULL )
+    {
+        return;
+    }
+
+    bus->selected = status == SPI_OK && transfer->keep_selected;
+    if ( ! bus->selected )
+    {
+        // Write the CS hi (release)
+        HAL_GPIO_WritePin ( bus->port, bus->pin, GPIO_PIN_SET );
+
+        if ( bus->fast )
+        {
+            bus->fast = 0;
+            prv_spi_set_prescaler ( bus->hspi, bus->hspi->Init.BaudRatePrescaler );
+        }
+    }
+
+    bus->active = NULL;
+    transfer->status = status;
+}
+
+
+// the bus is idle in between transfers, HAL enables it again at the next one
+static void prv_spi_set_prescaler ( SPI_HandleTypeDef * hspi, uint32_t prescaler )
+{
+    __HAL_SPI_DISABLE( hspi );
+    MODIFY_REG( hspi->Instance->CR1, SPI_CR1_BR, prescaler );
+}
+
 
-    HAL_SPI_StateTypeDef statSPI = HAL_SPI_STATE_RESET;
-    HAL_StatusTypeDef    statHAL = HAL_ERROR;
-    statHAL = HAL_SPI_Transmit ( hspi, addr, size, timeout );
-    if ( statHAL != HAL_OK )
+static SPIBusState * prv_spi_bus_of ( SPI_HandleTypeDef * hspi )
+{
+    for ( int bus = 0; bus < SPI_BUS_COUNT; bus++ )
     {
-        while ( statSPI != HAL_SPI_STATE_READY )
+        if ( prvBuses [ bus ].hspi == hspi )
         {
-            statSPI = HAL_SPI_GetState ( hspi );
+            return &prvBuses [ bus ];
         }
     }
 
-    // Write the CS hi (release)
-    HAL_GPIO_WritePin ( port, pin, GPIO_PIN_SET );
+    return NULL;
+}
 
-    return SPI_OK;
+
+static void prv_spi_dma_complete ( SPI_HandleTypeDef * hspi, uint8_t status )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    SPIBusState * bus = prv_spi_bus_of ( hspi );
+    if ( bus == NULL || bus->active == NULL )
+    {
+        return;
+    }
+
+    prv_spi_transfer_complete ( bus, status );
+
+    xSemaphoreGiveFromISR ( bus->done, &xHigherPriorityTaskWoken );
+    portYIELD_FROM_ISR ( xHigherPriorityTaskWoken );
+}
+
+
+void HAL_SPI_TxCpltCallback ( SPI_HandleTypeDef * hspi )
+{
+    prv_spi_dma_complete ( hspi, SPI_OK );
+}
+
+void HAL_SPI_RxCpltCallback ( SPI_HandleTypeDef * hspi )
+{
+    prv_spi_dma_complete ( hspi, SPI_OK );
+}
+
+void HAL_SPI_TxRxCpltCallback ( SPI_HandleTypeDef * hspi )
+{
+    prv_spi_dma_complete ( hspi, SPI_OK );
+}
+
+void HAL_SPI_ErrorCallback ( SPI_HandleTypeDef * hspi )
+{
+    prv_spi_dma_complete ( hspi, SPI_ERR );
+}
+
+static SPIStatus single_transmit_only ( SPIBus bus, uint8_t * addr, uint16_t size, uint32_t timeout )
+{
+    SPITransfer transfer = {
+            .bus        = bus,
+            .tx_buffer  = addr,
+            .size       = size,
+    };
+
+    return spi_transfer ( &transfer, timeout );
 }
 
 
@@ -319,80 +625,19 @@ static SPIStatus single_transmit_only ( SPI_HandleTypeDef * hspi, uint8_t * addr
 //}
 
 
-static int receive ( SPI_HandleTypeDef * hspi, uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * rx_buffer, uint16_t rx_buffer_size, uint32_t timeout )
+// Right now the timeout value selects the chip select of SPI3: 10 for the accelerometer, other for the gyroscope
+static int receive ( SPIBus bus, uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * rx_buffer, uint16_t rx_buffer_size, uint32_t timeout )
 {
-    GPIO_TypeDef         * port  = SPI1_CS_PORT;
-    uint16_t             pin     = 0;
-    HAL_StatusTypeDef    stat;
-
-    if ( hspi->Instance == SPI1 )
-    {
-        port = SPI1_CS_PORT;
-        pin  = SPI1_CS_PIN;
-    }
-    else if ( hspi->Instance == SPI2 )
-    {
-        port = SPI2_CS_PORT;
-        pin  = SPI2_CS_PIN;
-    }
-    else if ( hspi->Instance == SPI3 )
-    {
-
-        if ( timeout == 10 )
-        {
-            port = SPI3_CS1_PORT;
-            pin  = SPI3_CS1_PIN;
-        }
-        else
-        {
-            port = SPI3_CS2_PORT;
-            pin  = SPI3_CS2_PIN;
-        }
-
-    }
-    else
-    {
-        return 1;
-    }
-    //Write the CS low
-    HAL_GPIO_WritePin ( port, pin, GPIO_PIN_RESET );
-
-    //Could also use HAL_TransmitReceive.
-
-    /* Send command and parameters to slave first via a spi_transmit */
-    if ( cmd_buffer_size > 0 )
-    {
-        HAL_SPI_StateTypeDef statSPI = HAL_SPI_STATE_RESET;
-        HAL_StatusTypeDef    statHAL = HAL_ERROR;
-        statHAL = HAL_SPI_Transmit ( hspi, cmd_buffer, cmd_buffer_size, timeout );
-        if ( statHAL != HAL_OK )
-        {
-            while ( statSPI != HAL_SPI_STATE_READY )
-            {
-                statSPI = HAL_SPI_GetState ( hspi );
-            }
-        }
-    }
-
-    // Read in the specified number of bytes.
-    if ( rx_buffer_size > 0 )
-    {
-        HAL_SPI_StateTypeDef statSPI = HAL_SPI_STATE_RESET;
-        HAL_StatusTypeDef    statHAL = HAL_ERROR;
-        statHAL = HAL_SPI_Receive ( hspi, rx_buffer, rx_buffer_size, timeout );
-        if ( statHAL != HAL_OK )
-        {
-            while ( statSPI != HAL_SPI_STATE_READY )
-            {
-                statSPI = HAL_SPI_GetState ( hspi );
-            }
-        }
-    }
-
-    //Write the CS high
-    HAL_GPIO_WritePin ( port, pin, GPIO_PIN_SET );
-
-    return SPI_OK;
+    SPITransfer transfer = {
+            .bus                = bus,
+            .chip_select        = ( timeout == 10 ) ? 0 : 1,
+            .cmd_buffer         = cmd_buffer,
+            .cmd_buffer_size    = cmd_buffer_size,
+            .rx_buffer          = rx_buffer,
+            .size               = rx_buffer_size,
+    };
+
+    return spi_transfer ( &transfer, timeout );
 }
 
 //static SPIStatus read ( SPI_HandleTypeDef * hspi, uint8_t * cmd_buffer, uint8_t * rx_buffer, uint16_t total_size, uint32_t timeout )
@@ -454,89 +699,33 @@ static int receive ( SPI_HandleTypeDef * hspi, uint8_t * cmd_buffer, uint8_t cmd
 //}
 
 
-static int send (SPI_HandleTypeDef * hspi, uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * tx_buffer, uint16_t tx_buffer_size, uint32_t timeout )
+static int send ( SPIBus bus, uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * tx_buffer, uint16_t tx_buffer_size, uint32_t timeout )
 {
-    HAL_SPI_StateTypeDef statSPI = HAL_SPI_STATE_RESET;
-    HAL_StatusTypeDef    statHAL = HAL_ERROR;
-    GPIO_TypeDef         * port  = SPI1_CS_PORT;
-    uint16_t             pin     = 0;
-
-    if ( hspi->Instance == SPI1 )
-    {
-        port = SPI1_CS_PORT;
-        pin  = SPI1_CS_PIN;
-    }
-    else if ( hspi->Instance == SPI2 )
-    {
-        port = SPI2_CS_PORT;
-        pin  = SPI2_CS_PIN;
-    }
-    else if ( hspi->Instance == SPI3 )
-    {
-        if ( timeout == 10 )
-        {
-            port = SPI3_CS1_PORT;
-            pin  = SPI3_CS1_PIN;
-        }
-        else
-        {
-            port = SPI3_CS2_PORT;
-            pin  = SPI3_CS2_PIN;
-        }
-    }
-    else
-    {
-        return SPI_ERR;
-    }
-
-    // Write the CS low (lock)
-    HAL_GPIO_WritePin ( port, pin, GPIO_PIN_RESET );
-
-    /* Send command and parameters to slave first via a spi_transmit */
-    if ( cmd_buffer_size > 0 )
-    {
-        statHAL = HAL_SPI_Transmit (hspi, cmd_buffer, cmd_buffer_size, timeout );
-        if ( statHAL != HAL_OK )
-        {
-            while ( statSPI != HAL_SPI_STATE_READY )
-            {
-                statSPI = HAL_SPI_GetState ( hspi );
-            }
-        }
-    }
-
-    /* Send the tx_buffer to slave */
-    if ( tx_buffer_size > 0 )
-    {
-        statHAL = HAL_SPI_Transmit ( hspi, tx_buffer, tx_buffer_size, timeout );
-        if ( statHAL != HAL_OK )
-        {
-            while ( statSPI != HAL_SPI_STATE_READY )
-            {
-                statSPI = HAL_SPI_GetState ( hspi );
-            }
-        }
-    }
-
-    //Write the CS hi (release)
-    HAL_GPIO_WritePin ( port, pin, GPIO_PIN_SET );
-
-    return SPI_OK;
+    SPITransfer transfer = {
+            .bus                = bus,
+            .chip_select        = ( timeout == 10 ) ? 0 : 1,
+            .cmd_buffer         = cmd_buffer,
+            .cmd_buffer_size    = cmd_buffer_size,
+            .tx_buffer          = tx_buffer,
+            .size               = tx_buffer_size,
+    };
+
+    return spi_transfer ( &transfer, timeout );
 }
 
 int spi1_single_transmit_only ( uint8_t * tx_buffer, uint16_t total_size, uint32_t timeout )
 {
-    return single_transmit_only ( &hspi1, tx_buffer, total_size, timeout );
+    return single_transmit_only ( SPI_BUS_1, tx_buffer, total_size, timeout );
 }
 
 int spi2_single_transmit_only ( uint8_t * tx_buffer, uint16_t total_size, uint32_t timeout )
 {
-    return single_transmit_only ( &hspi2, tx_buffer, total_size, timeout );
+    return single_transmit_only ( SPI_BUS_2, tx_buffer, total_size, timeout );
 }
 
 int spi3_single_transmit_only ( uint8_t * tx_buffer, uint16_t total_size, uint32_t timeout )
 {
-    return single_transmit_only ( &hspi3, tx_buffer, total_size, timeout );
+    return single_transmit_only ( SPI_BUS_3, tx_buffer, total_size, timeout );
 }
 
 //int spi1_transmit ( uint8_t * tx_buffer, uint16_t total_size, uint32_t timeout )
@@ -551,12 +740,12 @@ int spi3_single_transmit_only ( uint8_t * tx_buffer, uint16_t total_size, uint32
 
 int spi1_send (uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * tx_buffer, uint16_t tx_buffer_size, uint32_t timeout )
 {
-    return send (&hspi1, cmd_buffer, cmd_buffer_size, tx_buffer, tx_buffer_size, timeout );
+    return send (SPI_BUS_1, cmd_buffer, cmd_buffer_size, tx_buffer, tx_buffer_size, timeout );
 }
 
 int spi1_receive ( uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * rx_buffer, uint16_t rx_buffer_size, uint32_t timeout )
 {
-    return receive ( &hspi1, cmd_buffer, cmd_buffer_size, rx_buffer, rx_buffer_size, timeout );
+    return receive ( SPI_BUS_1, cmd_buffer, cmd_buffer_size, rx_buffer, rx_buffer_size, timeout );
 }
 
 
@@ -572,12 +761,12 @@ int spi1_receive ( uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * rx_b
 
 int spi2_send ( uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * tx_buffer, uint16_t tx_buffer_size, uint32_t timeout )
 {
-    return send ( &hspi2, cmd_buffer, cmd_buffer_size, tx_buffer, tx_buffer_size, timeout );
+    return send ( SPI_BUS_2, cmd_buffer, cmd_buffer_size, tx_buffer, tx_buffer_size, timeout );
 }
 
 int spi2_receive ( uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * rx_buffer, uint16_t rx_buffer_size, uint32_t timeout )
 {
-    return receive ( &hspi2, cmd_buffer, cmd_buffer_size, rx_buffer, rx_buffer_size, timeout );
+    return receive ( SPI_BUS_2, cmd_buffer, cmd_buffer_size, rx_buffer, rx_buffer_size, timeout );
 }
 
 
@@ -593,12 +782,12 @@ int spi2_receive ( uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * rx_b
 
 int spi3_send ( uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * tx_buffer, uint16_t tx_buffer_size, uint32_t timeout )
 {
-    return send ( &hspi3, cmd_buffer, cmd_buffer_size, tx_buffer, tx_buffer_size, timeout );
+    return send ( SPI_BUS_3, cmd_buffer, cmd_buffer_size, tx_buffer, tx_buffer_size, timeout );
 }
 
 int spi3_receive ( uint8_t * cmd_buffer, uint8_t cmd_buffer_size, uint8_t * rx_buffer, uint16_t rx_buffer_size, uint32_t timeout )
 {
-    return receive ( &hspi3, cmd_buffer, cmd_buffer_size, rx_buffer, rx_buffer_size, timeout );
+    return receive ( SPI_BUS_3, cmd_buffer, cmd_buffer_size, rx_buffer, rx_buffer_size, timeout );
 }
 
 
@@ -0,0 +1,727 @@
+// Microbenchmarks of the hot paths of the flight software.
+//
+// Every kernel is first calibrated to a batch of operations that runs for at least --min-time ms, then the batch is run
+// --warmup times untimed and --repetitions times timed. The time and the cycles per operation are reported with their
+// mean, standard deviation, minimum, median and maximum over the repetitions, on the console and as JSON into --json
+// (benchmark.json by default), so the results of two builds can be compared run to run. The sim flash memory file is
+// kept in a scratch directory that is removed when the benchmark exits.
+//
+//   benchmark [--repetitions N] [--warmup N] [--min-time MS] [--filter TEXT] [--json FILE]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "benchmark.h"
+
+#include "utilities/common.h"
+#include "event-detection/event_detector.h"
+#include "utilities/spsc_ring.h"
+#include "board/components/icm20948_imu_sensor.h"
+#include "board/components/flash.h"
+#include "core/system_configuration.h"
+#include "sim-port/sensor-simulation/trajectory.h"
+
+#define DEFAULT_REPETITIONS     10
+#define DEFAULT_WARMUP          2
+#define DEFAULT_MIN_TIME_MS     20
+
+// the ring the IMU samples go through from the reader to the flight controller
+SPSC_RING( benchmark_imu, IMUSensorData, IMU_SENSOR_RING_LENGTH )
+
+static benchmark_imu_ring prvImuRing;
+#define MAX_REPETITIONS         1000
+
+// the event detector replays this much of a synthetic ascent at 1 kHz, from the ignition on
+#define DETECTOR_REPLAY_SAMPLES 5000
+
+// the sim flash memory is a file, the pages are written away from the sectors the memory manager uses
+#define FLASH_BENCHMARK_ADDRESS 0x1000000
+#define FLASH_FILE_NAME         "myFlash.bin"
+
+
+typedef struct
+{
+    const char * name;
+    void ( * setup ) ( void );
+    void ( * run ) ( uint32_t operations );
+
+} BenchmarkCase;
+
+typedef struct
+{
+    double mean;
+    double stddev;
+    double min;
+    double median;
+    double max;
+
+} BenchmarkStatistics;
+
+typedef struct
+{
+    const char *        name;
+    uint32_t            operations;     // per repetition
+    uint32_t            repetitions;
+    BenchmarkStatistics nanoseconds;    // per operation
+    BenchmarkStatistics cycles;         // per operation
+
+} BenchmarkResult;
+
+
+// the sim flash memory file goes into the scratch directory, the JSON into the directory the benchmark was started in
+static char prvScratchDirectory [ ] = "/tmp/benchmark_XXXXXX";
+static int  prvWorkingDirectory     = -1;
+
+// keeps the compiler from optimizing the kernels away
+static volatile float    prvSinkFloat;
+static volatile uint32_t prvSinkInteger;
+
+static moving_data_buffer prvWindow;
+static IMUSensorData      prvImuSample;
+static IMUSensorData      prvImuBatch [ IMU_SENSOR_RING_LENGTH ];
+static IMUDataU           prvImuEntry;
+static uint8_t            prvPage [ 256 ];
+static EventDetector      prvDetector;
+static DataContainer *    prvDetectorSamples;
+static uint32_t           prvDetectorSampleCount;
+static uint32_t           prvDetectorNextSample;
+static uint32_t           prvDetectorGroundPressure;
+// the counts of the simulated sensors, the replay is converted into them once
+static const EventDetectorScale prvDetectorScale = { 16.0f / 32768, 2000.0f / 32768, PRESSURE_SENSOR_PASCAL_PER_COUNT };
+static float              prvFilterInput  [ EVENT_DETECTOR_BLOCK_SIZE ];
+static float              prvFilterOutput [ EVENT_DETECTOR_BLOCK_SIZE ];
+
+
+// the benchmark does not run memory_manager_init, memory_manager.c only needs this to link
+FlightSystemConfiguration get_default_system_configuration ( )
+{
+    FlightSystemConfiguration configuration = { 0 };
+    return configuration;
+}
+
+// the kernel is linked for its queues, the scheduler is never started
+void vAssertCalled ( unsigned long ulLine, const char * const pcFileName )
+{
+    fprintf ( stderr, "assertion failed: %s:%lu\n", pcFileName, ulLine );
+    abort ( );
+}
+
+void vApplicationMallocFailedHook ( void )
+{
+    vAssertCalled ( __LINE__, __FILE__ );
+}
+
+void vApplicationIdleHook ( void )
+{
+}
+
+void vApplicationGetIdleTaskMemory ( StaticTask_t ** ppxIdleTaskTCBBuffer, StackType_t ** ppxIdleTaskStackBuffer, uint32_t * pulIdleTaskStackSize )
+{
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t  uxIdleTaskStack [ configMINIMAL_STACK_SIZE ];
+
+    *ppxIdleTaskTCBBuffer   = &xIdleTaskTCB;
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+    *pulIdleTaskStackSize   = configMINIMAL_STACK_SIZE;
+}
+
+
+static inline uint64_t prvCycles ( void )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return __builtin_ia32_rdtsc ( );
+#elif defined( __aarch64__ )
+    uint64_t value;
+    __asm__ volatile ( "mrs %0, cntvct_el0" : "=r" ( value ) );
+    return value;
+#else
+    return 0;
+#endif
+}
+
+static const char * prvCycleCounterName ( void )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return "rdtsc";
+#elif defined( __aarch64__ )
+    return "cntvct_el0";
+#else
+    return "none";
+#endif
+}
+
+static inline double prvNanoseconds ( void )
+{
+    struct timespec ts;
+    clock_gettime ( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// KERNELS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void prvDataWindowSetup ( void )
+{
+    data_window_init ( &prvWindow );
+    for ( int i = 0; i < REAL_BUFFER_CAPACITY; i++ )
+    {
+        float value = ( float ) i;
+        data_window_insert ( &prvWindow, &value );
+    }
+}
+
+static void prvDataWindowInsert ( uint32_t operations )
+{
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        float value = ( float ) i;
+        data_window_insert ( &prvWindow, &value );
+    }
+
+    prvSinkFloat = prvWindow.linear_repr[ 0 ];
+}
+
+// what the detector does before apogee on every sample: the averages over the two overlapping halves of the window
+static void prvDataWindowMean ( uint32_t operations )
+{
+    float sum = 0;
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        sum += benchmark_event_detector_mean ( prvWindow.linear_repr, sizeof ( prvWindow.linear_repr ), 0, MOVING_BUFFER_RANGE - 1 );
+        sum -= benchmark_event_detector_mean ( prvWindow.linear_repr, sizeof ( prvWindow.linear_repr ), 1, MOVING_BUFFER_RANGE );
+    }
+
+    prvSinkFloat = sum;
+}
+
+static void prvCalculateAltitude ( uint32_t operations )
+{
+    float sum = 0;
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        sum += benchmark_event_detector_altitude ( 85000.0f + ( float ) ( i & 0x3FF ) );
+    }
+
+    prvSinkFloat = sum;
+}
+
+static void prvRamBufferSetup ( void )
+{
+    benchmark_memory_manager_setup ( );
+    memset ( &prvImuEntry, 0x5A, sizeof ( prvImuEntry ) );
+}
+
+static void prvRamBufferAdd ( uint32_t operations )
+{
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        prvImuEntry.values.timestamp = i;
+        benchmark_memory_manager_add_entry ( UserDataSectorAccel, prvImuEntry.bytes );
+    }
+}
+
+static void prvSpscRingSetup ( void )
+{
+    benchmark_imu_ring_reset ( &prvImuRing );
+    memset ( &prvImuSample, 0x5A, sizeof ( prvImuSample ) );
+}
+
+// one push and one pop, the ring stays half full
+static void prvSpscRingPushPop ( uint32_t operations )
+{
+    for ( int i = 0; i < IMU_SENSOR_RING_LENGTH / 2; i++ )
+    {
+        benchmark_imu_ring_push ( &prvImuRing, &prvImuSample );
+    }
+
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        prvImuSample.timestamp = i;
+        benchmark_imu_ring_push ( &prvImuRing, &prvImuSample );
+        benchmark_imu_ring_pop ( &prvImuRing, &prvImuSample );
+    }
+
+    benchmark_imu_ring_reset ( &prvImuRing );
+
+    prvSinkInteger = prvImuSample.timestamp;
+}
+
+// the reader fills the ring in place, the consumer takes all of it at once: one operation is one sample
+static void prvSpscRingPopBatch ( uint32_t operations )
+{
+    uint32_t taken = 0;
+    while ( taken < operations )
+    {
+        IMUSensorData * sample;
+        while ( ( sample = benchmark_imu_ring_reserve ( &prvImuRing ) ) != NULL )
+        {
+            sample->timestamp = taken;
+            benchmark_imu_ring_commit ( &prvImuRing );
+        }
+
+        taken += benchmark_imu_ring_pop_batch ( &prvImuRing, prvImuBatch, IMU_SENSOR_RING_LENGTH );
+    }
+
+    prvSinkInteger = prvImuBatch[ IMU_SENSOR_RING_LENGTH - 1 ].timestamp;
+}
+
+static void prvEventDetectorSetup ( void )
+{
+    TrajectoryConfiguration configuration;
+    trajectory_get_default_configuration ( &configuration );
+    configuration.pad_time = 0.5f;
+
+    Trajectory       trajectory;
+    TrajectorySample sample;
+    trajectory_init ( &trajectory, &configuration );
+
+    prvDetectorSamples     = calloc ( DETECTOR_REPLAY_SAMPLES, sizeof ( DataContainer ) );
+    prvDetectorSampleCount = 0;
+
+    while ( prvDetectorSampleCount < DETECTOR_REPLAY_SAMPLES && trajectory_next_sample ( &trajectory, &sample ) )
+    {
+        if ( prvDetectorSampleCount == 0 )
+        {
+            prvDetectorGroundPressure = ( uint32_t ) sample.pressure;
+        }
+
+        DataContainer * data = &prvDetectorSamples[ prvDetectorSampleCount++ ];
+        uint32_t        now  = ( uint32_t ) ( sample.time * 1000 );
+
+        data->acc.updated                = sample.imu_updated;
+        data->acc.data.values.timestamp  = now;
+        data->gyro.updated               = sample.imu_updated;
+        data->gyro.data.values.timestamp = now;
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            data->acc.data.values.data[ axis ]  = ( int16_t ) lroundf ( sample.acc[ axis ] / prvDetectorScale.acc );
+            data->gyro.data.values.data[ axis ] = ( int16_t ) lroundf ( sample.gyro[ axis ] / prvDetectorScale.gyro );
+        }
+
+        data->press.updated               = sample.pressure_updated;
+        data->press.data.values.timestamp = now;
+        data->press.data.values.data      = lroundf ( sample.pressure / prvDetectorScale.pressure );
+    }
+
+    prvDetectorNextSample = 0;
+    event_detector_context_init ( &prvDetector, prvDetectorGroundPressure, &prvDetectorScale, FLIGHT_STATE_LAUNCHPAD, 1000 );
+}
+
+// the detection and the flight summary update that event_detector_feed does for every sample
+static void prvEventDetectorFeed ( uint32_t operations )
+{
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        if ( prvDetectorNextSample == prvDetectorSampleCount )
+        {
+            prvDetectorNextSample = 0;
+            event_detector_context_init ( &prvDetector, prvDetectorGroundPressure, &prvDetectorScale, FLIGHT_STATE_LAUNCHPAD, 1000 );
+        }
+
+        DataContainer * data = &prvDetectorSamples[ prvDetectorNextSample++ ];
+        event_detector_context_feed ( &prvDetector, data );
+
+        if ( data->press.updated )
+        {
+            memory_manager_update_flight_summary ( prvDetector.current_altitude, prvDetector.vertical_velocity, data->press.data.values.timestamp );
+        }
+    }
+
+    prvSinkInteger = prvDetector.state;
+}
+
+// a block of the replay per operation, as the flight controller feeds what it read in one pass
+static void prvEventDetectorFeedBlock ( uint32_t operations )
+{
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        if ( prvDetectorSampleCount - prvDetectorNextSample < EVENT_DETECTOR_BLOCK_SIZE )
+        {
+            prvDetectorNextSample = 0;
+            event_detector_context_init ( &prvDetector, prvDetectorGroundPressure, &prvDetectorScale, FLIGHT_STATE_LAUNCHPAD, 1000 );
+        }
+
+        DataContainer * data = &prvDetectorSamples[ prvDetectorNextSample ];
+        event_detector_context_feed_block ( &prvDetector, data, EVENT_DETECTOR_BLOCK_SIZE );
+        prvDetectorNextSample += EVENT_DETECTOR_BLOCK_SIZE;
+    }
+
+    prvSinkInteger = prvDetector.state;
+}
+
+static void prvSignalFilterSetup ( void )
+{
+    // the filters of the detector, as it configures them
+    event_detector_context_init ( &prvDetector, 101325, &prvDetectorScale, FLIGHT_STATE_LAUNCHPAD, 1000 );
+
+    for ( int i = 0; i < EVENT_DETECTOR_BLOCK_SIZE; i++ )
+    {
+        prvFilterInput[ i ] = 1.0f + ( float ) ( i % 7 ) / 7;
+    }
+}
+
+// one block of EVENT_DETECTOR_BLOCK_SIZE samples of a channel per operation
+static void prvSignalFilterBlock ( SignalFilter * filter, uint32_t operations )
+{
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        signal_filter_process ( filter, prvFilterInput, prvFilterOutput, EVENT_DETECTOR_BLOCK_SIZE );
+    }
+
+    prvSinkFloat = prvFilterOutput[ EVENT_DETECTOR_BLOCK_SIZE - 1 ];
+}
+
+static void prvSignalFilterFirBlock ( uint32_t operations )
+{
+    prvSignalFilterBlock ( &prvDetector.filters[ EVENT_DETECTOR_CHANNEL_ACC_X ], operations );
+}
+
+static void prvSignalFilterBiquadBlock ( uint32_t operations )
+{
+    prvSignalFilterBlock ( &prvDetector.filters[ EVENT_DETECTOR_CHANNEL_PRESSURE ], operations );
+}
+
+static void prvMemEmptySetup ( void )
+{
+    // an empty page is the worst case, every byte is looked at
+    memset ( prvPage, 0, sizeof ( prvPage ) );
+}
+
+static void prvMemEmpty ( uint32_t operations )
+{
+    uint32_t empty = 0;
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        empty += common_is_mem_empty ( prvPage, sizeof ( prvPage ) );
+    }
+
+    prvSinkInteger = empty;
+}
+
+static void prvFlashSetup ( void )
+{
+    flash_init ( );
+    memset ( prvPage, 0x5A, sizeof ( prvPage ) );
+}
+
+static void prvFlashWrite ( uint32_t operations )
+{
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        flash_write ( FLASH_BENCHMARK_ADDRESS + ( i & 0xFF ) * sizeof ( prvPage ), prvPage, sizeof ( prvPage ) );
+    }
+}
+
+static void prvFlashRead ( uint32_t operations )
+{
+    for ( uint32_t i = 0; i < operations; i++ )
+    {
+        flash_read ( FLASH_BENCHMARK_ADDRESS + ( i & 0xFF ) * sizeof ( prvPage ), prvPage, sizeof ( prvPage ) );
+    }
+
+    prvSinkInteger = prvPage[ 0 ];
+}
+
+static bool prvFlashStreamSink ( uint32_t address, const uint8_t * data, uint32_t size, void * context )
+{
+    prvSinkInteger = data[ 0 ];
+    return true;
+}
+
+static void prvFlashStream ( uint32_t operations )
+{
+    // one page per operation as flash_read_page, over the same 256 pages
+    while ( operations > 0 )
+    {
+        uint32_t pages = operations < 256 ? operations : 256;
+        flash_read_stream ( FLASH_BENCHMARK_ADDRESS, pages * sizeof ( prvPage ), prvFlashStreamSink, NULL );
+        operations -= pages;
+    }
+}
+
+
+static const BenchmarkCase prvCases [ ] =
+{
+    { "data_window_insert",         prvDataWindowSetup,    prvDataWindowInsert         },
+    { "data_window_mean",           prvDataWindowSetup,    prvDataWindowMean           },
+    { "calculate_altitude",         NULL,                  prvCalculateAltitude        },
+    { "memory_ram_buffer_add",      prvRamBufferSetup,     prvRamBufferAdd             },
+    { "spsc_ring_push_pop",         prvSpscRingSetup,      prvSpscRingPushPop          },
+    { "spsc_ring_pop_batch",        prvSpscRingSetup,      prvSpscRingPopBatch         },
+    { "event_detector_feed",        prvEventDetectorSetup, prvEventDetectorFeed        },
+    { "event_detector_feed_block",  prvEventDetectorSetup, prvEventDetectorFeedBlock   },
+    { "signal_filter_fir_block",    prvSignalFilterSetup,  prvSignalFilterFirBlock     },
+    { "signal_filter_biquad_block", prvSignalFilterSetup,  prvSignalFilterBiquadBlock  },
+    { "common_is_mem_empty_256",    prvMemEmptySetup,      prvMemEmpty                 },
+    { "flash_write_page",           prvFlashSetup,         prvFlashWrite               },
+    { "flash_read_page",            prvFlashSetup,         prvFlashRead                },
+    { "flash_read_stream_page",     prvFlashSetup,         prvFlashStream              },
+};
+
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// HARNESS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static int prvCompareDoubles ( const void * a, const void * b )
+{
+    double x = *( const double * ) a;
+    double y = *( const double * ) b;
+    return ( x > y ) - ( x < y );
+}
+
+static BenchmarkStatistics prvStatistics ( double * values, uint32_t count )
+{
+    BenchmarkStatistics statistics = { 0 };
+
+    double sum = 0;
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        sum += values[ i ];
+    }
+    statistics.mean = sum / count;
+
+    double squares = 0;
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        squares += ( values[ i ] - statistics.mean ) * ( values[ i ] - statistics.mean );
+    }
+    statistics.stddev = count > 1 ? sqrt ( squares / ( count - 1 ) ) : 0;
+
+    qsort ( values, count, sizeof ( double ), prvCompareDoubles );
+    statistics.min    = values[ 0 ];
+    statistics.max    = values[ count - 1 ];
+    statistics.median = count % 2 ? values[ count / 2 ] : 0.5 * ( values[ count / 2 - 1 ] + values[ count / 2 ] );
+
+    return statistics;
+}
+
+static BenchmarkResult prvRun ( const BenchmarkCase * benchmark, uint32_t repetitions, uint32_t warmup, double min_time_ms )
+{
+    BenchmarkResult result = { .name = benchmark->name, .repetitions = repetitions };
+
+    if ( benchmark->setup != NULL )
+    {
+        benchmark->setup ( );
+    }
+
+    // grow the batch until it runs long enough for the clock to resolve it
+    uint32_t operations = 1;
+    for ( ;; )
+    {
+        double start = prvNanoseconds ( );
+        benchmark->run ( operations );
+        double elapsed = prvNanoseconds ( ) - start;
+
+        if ( elapsed >= min_time_ms * 1e6 || operations >= ( UINT32_MAX >> 1 ) )
+        {
+            break;
+        }
+
+        operations = elapsed > 0 && elapsed * 10 > min_time_ms * 1e6 ? ( uint32_t ) ( operations * 1.2 * min_time_ms * 1e6 / elapsed ) : operations * 10;
+    }
+    result.operations = operations;
+
+    for ( uint32_t i = 0; i < warmup; i++ )
+    {
+        benchmark->run ( operations );
+    }
+
+    double nanoseconds [ MAX_REPETITIONS ];
+    double cycles      [ MAX_REPETITIONS ];
+
+    for ( uint32_t i = 0; i < repetitions; i++ )
+    {
+        double   start_ns     = prvNanoseconds ( );
+        uint64_t start_cycles = prvCycles ( );
+        benchmark->run ( operations );
+        uint64_t end_cycles   = prvCycles ( );
+        double   end_ns       = prvNanoseconds ( );
+
+        nanoseconds[ i ] = ( end_ns - start_ns ) / operations;
+        cycles[ i ]      = ( double ) ( end_cycles - start_cycles ) / operations;
+    }
+
+    result.nanoseconds = prvStatistics ( nanoseconds, repetitions );
+    result.cycles      = prvStatistics ( cycles, repetitions );
+
+    return result;
+}
+
+static void prvWriteStatistics ( FILE * file, const char * name, const BenchmarkStatistics * statistics, const char * separator )
+{
+    fprintf ( file, "      \"%s\": { \"mean\": %.4f, \"stddev\": %.4f, \"min\": %.4f, \"median\": %.4f, \"max\": %.4f }%s\n",
+              name, statistics->mean, statistics->stddev, statistics->min, statistics->median, statistics->max, separator );
+}
+
+static bool prvWriteJson ( const char * path, const BenchmarkResult * results, size_t count, uint32_t repetitions, uint32_t warmup, double min_time_ms )
+{
+    FILE * file = fopen ( path, "w" );
+    if ( file == NULL )
+    {
+        perror ( path );
+        return false;
+    }
+
+    fprintf ( file, "{\n" );
+    fprintf ( file, "  \"timestamp\": %lld,\n", ( long long ) time ( NULL ) );
+    fprintf ( file, "  \"cycle_counter\": \"%s\",\n", prvCycleCounterName ( ) );
+    fprintf ( file, "  \"repetitions\": %" PRIu32 ",\n", repetitions );
+    fprintf ( file, "  \"warmup\": %" PRIu32 ",\n", warmup );
+    fprintf ( file, "  \"min_time_ms\": %.1f,\n", min_time_ms );
+    fprintf ( file, "  \"results\": [\n" );
+
+    for ( size_t i = 0; i < count; i++ )
+    {
+        fprintf ( file, "    {\n" );
+        fprintf ( file, "      \"name\": \"%s\",\n", results[ i ].name );
+        fprintf ( file, "      \"operations\": %" PRIu32 ",\n", results[ i ].operations );
+        prvWriteStatistics ( file, "ns_per_op", &results[ i ].nanoseconds, "," );
+        prvWriteStatistics ( file, "cycles_per_op", &results[ i ].cycles, "" );
+        fprintf ( file, "    }%s\n", i + 1 < count ? "," : "" );
+    }
+
+    fprintf ( file, "  ]\n" );
+    fprintf ( file, "}\n" );
+    fclose ( file );
+
+    return true;
+}
+
+
+// back into the directory the benchmark was started in, the scratch directory goes away with the sim flash memory file
+static void prvScratchLeave ( void )
+{
+    if ( prvWorkingDirectory < 0 )
+    {
+        return;
+    }
+
+    if ( fchdir ( prvWorkingDirectory ) != 0 )
+    {
+        perror ( "fchdir" );
+    }
+
+    close ( prvWorkingDirectory );
+    prvWorkingDirectory = -1;
+
+    char path [ sizeof ( prvScratchDirectory ) + sizeof ( FLASH_FILE_NAME ) ];
+    snprintf ( path, sizeof ( path ), "%s/%s", prvScratchDirectory, FLASH_FILE_NAME );
+    unlink ( path );
+    rmdir ( prvScratchDirectory );
+}
+
+static bool prvScratchEnter ( void )
+{
+    if ( mkdtemp ( prvScratchDirectory ) == NULL )
+    {
+        perror ( "mkdtemp" );
+        return false;
+    }
+
+    prvWorkingDirectory = open ( ".", O_RDONLY | O_DIRECTORY );
+    if ( prvWorkingDirectory < 0 || chdir ( prvScratchDirectory ) != 0 )
+    {
+        perror ( prvScratchDirectory );
+        prvScratchLeave ( );
+        return false;
+    }
+
+    // whichever way the benchmark exits
+    atexit ( prvScratchLeave );
+    return true;
+}
+
+int main ( int argc, char ** argv )
+{
+    uint32_t     repetitions = DEFAULT_REPETITIONS;
+    uint32_t     warmup      = DEFAULT_WARMUP;
+    double       min_time_ms = DEFAULT_MIN_TIME_MS;
+    const char * filter      = NULL;
+    const char * json        = "benchmark.json";
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        const char * option = argv[ i ];
+        const char * value  = i + 1 < argc ? argv[ i + 1 ] : NULL;
+
+        if ( value != NULL && strcmp ( option, "--repetitions" ) == 0 )
+        {
+            repetitions = ( uint32_t ) strtoul ( value, NULL, 10 );
+        }
+        else if ( value != NULL && strcmp ( option, "--warmup" ) == 0 )
+        {
+            warmup = ( uint32_t ) strtoul ( value, NULL, 10 );
+        }
+        else if ( value != NULL && strcmp ( option, "--min-time" ) == 0 )
+        {
+            min_time_ms = strtod ( value, NULL );
+        }
+        else if ( value != NULL && strcmp ( option, "--filter" ) == 0 )
+        {
+            filter = value;
+        }
+        else if ( value != NULL && strcmp ( option, "--json" ) == 0 )
+        {
+            json = value;
+        }
+        else
+        {
+            fprintf ( stderr, "usage: %s [--repetitions N] [--warmup N] [--min-time MS] [--filter TEXT] [--json FILE]\n", argv[ 0 ] );
+            return 1;
+        }
+
+        i++;
+    }
+
+    if ( repetitions == 0 || repetitions > MAX_REPETITIONS )
+    {
+        fprintf ( stderr, "--repetitions must be between 1 and %d\n", MAX_REPETITIONS );
+        return 1;
+    }
+
+    if ( ! prvScratchEnter ( ) )
+    {
+        return 1;
+    }
+
+    const size_t    count = sizeof ( prvCases ) / sizeof ( prvCases[ 0 ] );
+    BenchmarkResult results [ sizeof ( prvCases ) / sizeof ( prvCases[ 0 ] ) ];
+    size_t          ran   = 0;
+
+    printf ( "%-26s %12s %12s %10s %12s %12s\n", "benchmark", "ops", "ns/op", "+/-", "cycles/op", "+/-" );
+
+    for ( size_t i = 0; i < count; i++ )
+    {
+        if ( filter != NULL && strstr ( prvCases[ i ].name, filter ) == NULL )
+        {
+            continue;
+        }
+
+        BenchmarkResult * result = &results[ ran++ ];
+        *result = prvRun ( &prvCases[ i ], repetitions, warmup, min_time_ms );
+
+        printf ( "%-26s %12" PRIu32 " %12.2f %10.2f %12.1f %12.1f\n", result->name, result->operations,
+                 result->nanoseconds.mean, result->nanoseconds.stddev, result->cycles.mean, result->cycles.stddev );
+    }
+
+    prvScratchLeave ( );
+
+    if ( ! prvWriteJson ( json, results, ran, repetitions, warmup, min_time_ms ) )
+    {
+        return 1;
+    }
+
+    printf ( "results written to %s\n", json );
+    return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "memory-management/memory_manager.h"
+
+// The kernels the benchmark needs are static to their translation units, benchmark_memory_manager.c and
+// benchmark_event_detector.c build those units again with these entry points added.
+
+// prepares the RAM buffers and the page lanes of the memory manager, without the flash memory nor the monitor task
+void                benchmark_memory_manager_setup     ( void );
+
+// prvMemoryAddNewUserDataSectorEntryToRAMBuffer, with the full pages taken away as the monitor would
+MemoryManagerStatus benchmark_memory_manager_add_entry ( UserDataSector sector, uint8_t * entry );
+
+// prvCalculateAltitude and mean of event_detector_core.c
+float               benchmark_event_detector_altitude  ( float pressure );
+float               benchmark_event_detector_mean      ( float * array, size_t length, size_t start, size_t end );
+
+#endif // __BENCHMARK_H
@@ -0,0 +1,20 @@
+// Builds event_detector_core.c once more for the benchmark, so that its static functions can be reached
+#include "event-detection/event_detector_core.c"
+
+#include "benchmark.h"
+
+
+float benchmark_event_detector_altitude ( float pressure )
+{
+    return prvCalculateAltitude ( pressure );
+}
+
+
+float benchmark_event_detector_mean ( float * array, size_t length, size_t start, size_t end )
+{
+#if ( userconf_EVENT_DETECTION_AVERAGING_SUPPORT_ON == 1 )
+    return mean ( array, length, start, end );
+#else
+    return 0;
+#endif
+}
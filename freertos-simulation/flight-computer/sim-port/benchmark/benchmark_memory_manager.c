@@ -0,0 +1,49 @@
+// Builds memory_manager.c once more for the benchmark, so that its static functions can be reached
+#include "memory-management/memory_manager.c"
+
+#include "benchmark.h"
+
+
+void benchmark_memory_manager_setup ( void )
+{
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].write = &prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].buffers[ 0 ];
+        prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read  = &prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].buffers[ 1 ];
+    }
+
+    if ( prvCriticalPageLane == NULL )
+    {
+        prvCriticalPageLane = xQueueCreate ( PAGE_LANE_CRITICAL_LENGTH, sizeof ( page_buffer_item ) );
+    }
+
+    for ( PageLane lane = PageLaneInertial; lane < MEMORY_PAGE_LANE_COUNT; lane++ )
+    {
+        page_lane_ring_reset ( &prvBulkPageLanes[ lane - PageLaneInertial ] );
+    }
+
+    prvIsInitialized = true;
+}
+
+
+MemoryManagerStatus benchmark_memory_manager_add_entry ( UserDataSector sector, uint8_t * entry )
+{
+    MemoryManagerStatus status = prvMemoryAddNewUserDataSectorEntryToRAMBuffer ( sector, entry );
+
+    // stand in for the monitor: the page that was queued is taken and its RAM buffer is free again
+    MemoryBuffer * read = prvCurrentMemoryUserDataSectorRAMBuffers[ sector ].read;
+    if ( read->info.bytesWritten != 0 )
+    {
+        page_buffer_item item;
+        for ( PageLane lane = PageLaneCritical; lane < MEMORY_PAGE_LANE_COUNT; lane++ )
+        {
+            while ( prvPageLaneTake ( lane, &item ) )
+            {
+            }
+        }
+
+        read->info.bytesWritten = 0;
+    }
+
+    return status;
+}
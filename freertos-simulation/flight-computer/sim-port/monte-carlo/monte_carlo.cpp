@@ -0,0 +1,470 @@
+// Monte Carlo robustness sweep of the event detector.
+//
+// Every run replays one of the recorded COTS flights through its own EventDetector (event_detector_core.c) with
+// randomized sensor imperfections: white noise, a constant bias, dropped samples, jitter of the sample clock and
+// spikes on the pressure readings. The detections are compared against the truth flags embedded in the flight
+// recording (launch_detect, apogee_detect and Bon, the main parachute output), and the distributions of the detection
+// latencies together with the false triggers and the missed events are reported. The truth flags come from the
+// commercial altimeter flown with the recording, so a negative latency is a detection ahead of it; a detection more
+// than --window ms ahead of the flag is a false trigger.
+//
+// The runs are spread over a work-stealing thread pool, every worker owns a deque of runs and steals from the others
+// once it runs dry, so no core idles while long flights are still being replayed elsewhere.
+//
+//   monte_carlo [--runs N] [--threads N] [--seed N] [--noise K] [--bias K] [--dropout P] [--jitter MS]
+//               [--spike-rate P] [--spike PA] [--window MS] [file.csv ...]
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include "sim-port/sensor-simulation/csv.h"
+
+extern "C" {
+#include "memory-management/memory_manager.h"
+#include "event-detection/event_detector.h"
+}
+
+#define MAKE_STR(x) _MAKE_STR(x)
+#define _MAKE_STR(x) #x
+
+namespace
+{
+    // the detector runs on a millisecond clock
+    const uint32_t TICKS_PER_SECOND = 1000;
+
+    enum TruthEvent
+    {
+        TRUTH_LAUNCH = 0,
+        TRUTH_APOGEE,
+        TRUTH_MAIN,
+        TRUTH_EVENT_COUNT
+    };
+
+    const char * const   TRUTH_EVENT_NAMES  [ TRUTH_EVENT_COUNT ] = { "launch", "apogee", "main" };
+    const FlightState    TRUTH_EVENT_STATES [ TRUTH_EVENT_COUNT ] = { FLIGHT_STATE_PRE_APOGEE, FLIGHT_STATE_APOGEE, FLIGHT_STATE_MAIN_CHUTE };
+
+    struct Sample
+    {
+        uint32_t time_ms;
+        float    acc [ 3 ];         // [g], x is the vertical axis
+        float    gyro [ 3 ];        // [deg/s]
+        float    pressure;          // [Pa]
+    };
+
+    struct Flight
+    {
+        std::string           name;
+        std::vector < Sample > samples;
+        int64_t               truth_ms [ TRUTH_EVENT_COUNT ];   // -1 if the recording never flags the event
+    };
+
+    // how badly the sensors behave, the noise and the bias are in multiples of the nominal sigmas below
+    struct Perturbation
+    {
+        double noise       = 1.0;
+        double bias        = 1.0;
+        double dropout     = 0.01;      // probability of losing a sample of a sensor
+        double jitter_ms   = 2.0;       // sigma of the sample clock jitter
+        double spike_rate  = 0.001;     // probability of a pressure spike per sample
+        double spike_pa    = 2000.0;    // amplitude of the pressure spikes
+    };
+
+    const double ACC_NOISE_G        = 0.05;
+    const double GYRO_NOISE_DEG_S   = 0.5;
+    const double PRESSURE_NOISE_PA  = 15.0;
+    const double ACC_BIAS_G         = 0.02;
+    const double GYRO_BIAS_DEG_S    = 1.0;
+    const double PRESSURE_BIAS_PA   = 50.0;
+
+    // the detector is fed counts, as the simulated sensors count
+    const EventDetectorScale SCALE = { 16.0f / 32768, 2000.0f / 32768, PRESSURE_SENSOR_PASCAL_PER_COUNT };
+
+    int16_t to_count ( double value, float scale )
+    {
+        return ( int16_t ) std::max ( -32768.0, std::min ( 32767.0, std::round ( value / scale ) ) );
+    }
+
+    struct RunResult
+    {
+        int64_t  detected_ms [ TRUTH_EVENT_COUNT ];  // -1 if the detector never got there
+        uint64_t samples;
+    };
+
+    struct Job
+    {
+        size_t flight;
+        size_t run;
+    };
+
+
+    bool load_flight ( const std::string & file, Flight & flight )
+    {
+        try
+        {
+            io::CSVReader < 17 > reader ( file );
+
+            // time,acceleration,pres,altMSL,temp,latxacc,latyacc,gyrox,gyroy,gyroz,magx,magy,magz,launch_detect,apogee_detect,Aon,Bon
+            double  timestamp, pressure, altitude, temperature, mag [ 3 ];
+            Sample  sample { };
+            int     flags [ 4 ];
+            double  start = -1;
+
+            flight.name = file;
+            std::fill ( flight.truth_ms, flight.truth_ms + TRUTH_EVENT_COUNT, -1 );
+
+            while ( reader.read_row ( timestamp, sample.acc[ 0 ], pressure, altitude, temperature, sample.acc[ 1 ], sample.acc[ 2 ],
+                                      sample.gyro[ 0 ], sample.gyro[ 1 ], sample.gyro[ 2 ], mag[ 0 ], mag[ 1 ], mag[ 2 ],
+                                      flags[ 0 ], flags[ 1 ], flags[ 2 ], flags[ 3 ] ) )
+            {
+                if ( start < 0 )
+                {
+                    start = timestamp;
+                }
+
+                sample.time_ms  = ( uint32_t ) std::lround ( ( timestamp - start ) * 1000 );
+                sample.pressure = ( float ) pressure;
+                flight.samples.push_back ( sample );
+
+                const int truth [ TRUTH_EVENT_COUNT ] = { flags[ 0 ], flags[ 1 ], flags[ 3 ] };
+                for ( int event = 0; event < TRUTH_EVENT_COUNT; event++ )
+                {
+                    if ( truth[ event ] && flight.truth_ms[ event ] < 0 )
+                    {
+                        flight.truth_ms[ event ] = sample.time_ms;
+                    }
+                }
+            }
+        }
+        catch ( const std::exception & e )
+        {
+            fprintf ( stderr, "%s: %s\n", file.c_str ( ), e.what ( ) );
+            return false;
+        }
+
+        return ! flight.samples.empty ( );
+    }
+
+
+    RunResult run_flight ( const Flight & flight, const Perturbation & perturbation, uint64_t seed )
+    {
+        std::mt19937_64 rng ( seed );
+        std::normal_distribution < double >       gaussian ( 0.0, 1.0 );
+        std::uniform_real_distribution < double > uniform  ( 0.0, 1.0 );
+
+        RunResult result { };
+        std::fill ( result.detected_ms, result.detected_ms + TRUTH_EVENT_COUNT, -1 );
+
+        // the bias of this run's sensors
+        double acc_bias [ 3 ], gyro_bias [ 3 ];
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            acc_bias [ axis ] = gaussian ( rng ) * ACC_BIAS_G * perturbation.bias;
+            gyro_bias[ axis ] = gaussian ( rng ) * GYRO_BIAS_DEG_S * perturbation.bias;
+        }
+        double pressure_bias = gaussian ( rng ) * PRESSURE_BIAS_PA * perturbation.bias;
+
+        // the flight controller takes the first pressure reading as the ground reference
+        EventDetector detector;
+        event_detector_context_init ( &detector, ( uint32_t ) ( flight.samples.front ( ).pressure + pressure_bias ), &SCALE, FLIGHT_STATE_LAUNCHPAD, TICKS_PER_SECOND );
+
+        DataContainer data;
+        uint32_t      now = 0;
+
+        for ( const Sample & sample : flight.samples )
+        {
+            memset ( &data, 0, sizeof ( DataContainer ) );
+
+            // jittered, but the clock never runs backwards
+            int64_t jittered = sample.time_ms + ( int64_t ) std::lround ( gaussian ( rng ) * perturbation.jitter_ms );
+            now = std::max < int64_t > ( now, jittered );
+
+            if ( uniform ( rng ) >= perturbation.dropout )
+            {
+                data.acc.updated = true;
+                data.acc.data.values.timestamp = now;
+                for ( int axis = 0; axis < 3; axis++ )
+                {
+                    data.acc.data.values.data[ axis ] = to_count ( sample.acc[ axis ] + acc_bias[ axis ] + gaussian ( rng ) * ACC_NOISE_G * perturbation.noise, SCALE.acc );
+                }
+            }
+
+            if ( uniform ( rng ) >= perturbation.dropout )
+            {
+                data.gyro.updated = true;
+                data.gyro.data.values.timestamp = now;
+                for ( int axis = 0; axis < 3; axis++ )
+                {
+                    data.gyro.data.values.data[ axis ] = to_count ( sample.gyro[ axis ] + gyro_bias[ axis ] + gaussian ( rng ) * GYRO_NOISE_DEG_S * perturbation.noise, SCALE.gyro );
+                }
+            }
+
+            if ( uniform ( rng ) >= perturbation.dropout )
+            {
+                double pressure = sample.pressure + pressure_bias + gaussian ( rng ) * PRESSURE_NOISE_PA * perturbation.noise;
+                if ( uniform ( rng ) < perturbation.spike_rate )
+                {
+                    pressure += ( uniform ( rng ) < 0.5 ? -1 : 1 ) * perturbation.spike_pa;
+                }
+
+                data.press.updated = true;
+                data.press.data.values.timestamp = now;
+                data.press.data.values.data      = ( int32_t ) std::lround ( pressure / SCALE.pressure );
+            }
+
+            event_detector_context_feed ( &detector, &data );
+            result.samples++;
+
+            if ( data.event.updated )
+            {
+                for ( int event = 0; event < TRUTH_EVENT_COUNT; event++ )
+                {
+                    if ( detector.state == TRUTH_EVENT_STATES[ event ] && result.detected_ms[ event ] < 0 )
+                    {
+                        result.detected_ms[ event ] = now;
+                    }
+                }
+            }
+
+            if ( detector.state >= FLIGHT_STATE_COUNT )
+            {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+
+    // A worker pops its own jobs from the back of its deque and steals from the front of the others' once it is empty
+    class WorkStealingPool
+    {
+    public:
+        explicit WorkStealingPool ( size_t workers ) : queues ( workers ), locks ( workers ) { }
+
+        void push ( size_t worker, const Job & job )
+        {
+            queues[ worker % queues.size ( ) ].push_back ( job );
+        }
+
+        bool next ( size_t worker, Job & job )
+        {
+            {
+                std::lock_guard < std::mutex > guard ( locks[ worker ] );
+                if ( ! queues[ worker ].empty ( ) )
+                {
+                    job = queues[ worker ].back ( );
+                    queues[ worker ].pop_back ( );
+                    return true;
+                }
+            }
+
+            for ( size_t offset = 1; offset < queues.size ( ); offset++ )
+            {
+                size_t victim = ( worker + offset ) % queues.size ( );
+
+                std::lock_guard < std::mutex > guard ( locks[ victim ] );
+                if ( ! queues[ victim ].empty ( ) )
+                {
+                    job = queues[ victim ].front ( );
+                    queues[ victim ].pop_front ( );
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        size_t size ( ) const
+        {
+            return queues.size ( );
+        }
+
+    private:
+        std::vector < std::deque < Job > > queues;
+        std::vector < std::mutex >         locks;
+    };
+
+
+    double percentile ( const std::vector < double > & sorted, double p )
+    {
+        if ( sorted.empty ( ) )
+        {
+            return NAN;
+        }
+
+        double position = p * ( sorted.size ( ) - 1 );
+        size_t lower    = ( size_t ) position;
+        size_t upper    = std::min ( lower + 1, sorted.size ( ) - 1 );
+
+        return sorted[ lower ] + ( position - lower ) * ( sorted[ upper ] - sorted[ lower ] );
+    }
+
+
+    void report ( const std::vector < Flight > & flights, const std::vector < std::vector < RunResult > > & results, int64_t window_ms )
+    {
+        for ( int event = 0; event < TRUTH_EVENT_COUNT; event++ )
+        {
+            std::vector < double > latencies;
+            size_t runs = 0, early = 0, missed = 0;
+
+            for ( size_t flight = 0; flight < flights.size ( ); flight++ )
+            {
+                int64_t truth = flights[ flight ].truth_ms[ event ];
+                if ( truth < 0 )
+                {
+                    continue;
+                }
+
+                for ( const RunResult & result : results[ flight ] )
+                {
+                    runs++;
+
+                    if ( result.detected_ms[ event ] < 0 )
+                    {
+                        missed++;
+                    }
+                    else if ( result.detected_ms[ event ] < truth - window_ms )
+                    {
+                        // too far ahead of the event to be a detection of it
+                        early++;
+                    }
+                    else
+                    {
+                        latencies.push_back ( ( double ) ( result.detected_ms[ event ] - truth ) );
+                    }
+                }
+            }
+
+            if ( runs == 0 )
+            {
+                printf ( "%-7s no truth flag in the recordings\n", TRUTH_EVENT_NAMES[ event ] );
+                continue;
+            }
+
+            std::sort ( latencies.begin ( ), latencies.end ( ) );
+            double mean = latencies.empty ( ) ? NAN : std::accumulate ( latencies.begin ( ), latencies.end ( ), 0.0 ) / latencies.size ( );
+
+            printf ( "%-7s false trigger %6.2f%%  missed %6.2f%%  latency [ms] mean %8.1f  min %8.1f  p5 %8.1f  p50 %8.1f  p95 %8.1f  p99 %8.1f  max %8.1f\n",
+                     TRUTH_EVENT_NAMES[ event ], 100.0 * early / runs, 100.0 * missed / runs, mean,
+                     percentile ( latencies, 0.0 ), percentile ( latencies, 0.05 ), percentile ( latencies, 0.5 ),
+                     percentile ( latencies, 0.95 ), percentile ( latencies, 0.99 ), percentile ( latencies, 1.0 ) );
+        }
+    }
+}
+
+
+int main ( int argc, char ** argv )
+{
+    size_t       runs    = 1000;
+    int64_t      window  = 5000;
+    size_t       threads = std::max ( 1u, std::thread::hardware_concurrency ( ) );
+    uint64_t     seed    = 1;
+    Perturbation perturbation;
+    std::vector < std::string > files;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        std::string option = argv[ i ];
+        bool        hasValue = i + 1 < argc;
+
+        if      ( option == "--runs"       && hasValue ) runs                    = strtoul ( argv[ ++i ], nullptr, 10 );
+        else if ( option == "--threads"    && hasValue ) threads                 = std::max ( 1ul, strtoul ( argv[ ++i ], nullptr, 10 ) );
+        else if ( option == "--seed"       && hasValue ) seed                    = strtoull ( argv[ ++i ], nullptr, 10 );
+        else if ( option == "--noise"      && hasValue ) perturbation.noise      = atof ( argv[ ++i ] );
+        else if ( option == "--bias"       && hasValue ) perturbation.bias       = atof ( argv[ ++i ] );
+        else if ( option == "--dropout"    && hasValue ) perturbation.dropout    = atof ( argv[ ++i ] );
+        else if ( option == "--jitter"     && hasValue ) perturbation.jitter_ms  = atof ( argv[ ++i ] );
+        else if ( option == "--spike-rate" && hasValue ) perturbation.spike_rate = atof ( argv[ ++i ] );
+        else if ( option == "--spike"      && hasValue ) perturbation.spike_pa   = atof ( argv[ ++i ] );
+        else if ( option == "--window"     && hasValue ) window                  = strtoll ( argv[ ++i ], nullptr, 10 );
+        else if ( option.rfind ( "--", 0 ) == 0 )
+        {
+            fprintf ( stderr, "unknown option %s\n", option.c_str ( ) );
+            return 1;
+        }
+        else
+        {
+            files.push_back ( option );
+        }
+    }
+
+    if ( files.empty ( ) )
+    {
+        files.push_back ( MAKE_STR ( COTS_CSV_FILE_PATH ) );
+    }
+
+    std::vector < Flight > flights ( files.size ( ) );
+    for ( size_t flight = 0; flight < files.size ( ); flight++ )
+    {
+        if ( ! load_flight ( files[ flight ], flights[ flight ] ) )
+        {
+            fprintf ( stderr, "cannot load the flight %s\n", files[ flight ].c_str ( ) );
+            return 1;
+        }
+    }
+
+    // the runs of every flight are dealt round-robin to the workers
+    WorkStealingPool pool ( threads );
+    std::vector < std::vector < RunResult > > results ( flights.size ( ), std::vector < RunResult > ( runs ) );
+
+    size_t dealt = 0;
+    for ( size_t flight = 0; flight < flights.size ( ); flight++ )
+    {
+        for ( size_t run = 0; run < runs; run++ )
+        {
+            pool.push ( dealt++, Job { flight, run } );
+        }
+    }
+
+    std::atomic < uint64_t > samples { 0 };
+    auto start = std::chrono::steady_clock::now ( );
+
+    std::vector < std::thread > workers;
+    for ( size_t worker = 0; worker < pool.size ( ); worker++ )
+    {
+        workers.emplace_back ( [ &, worker ] ( )
+        {
+            Job      job;
+            uint64_t processed = 0;
+
+            while ( pool.next ( worker, job ) )
+            {
+                // every run has its own seed, so the sweep is reproducible whatever the scheduling
+                uint64_t runSeed = seed * 0x9E3779B97F4A7C15ull + job.flight * runs + job.run;
+
+                results[ job.flight ][ job.run ] = run_flight ( flights[ job.flight ], perturbation, runSeed );
+                processed += results[ job.flight ][ job.run ].samples;
+            }
+
+            samples += processed;
+        } );
+    }
+
+    for ( std::thread & worker : workers )
+    {
+        worker.join ( );
+    }
+
+    double seconds = std::chrono::duration < double > ( std::chrono::steady_clock::now ( ) - start ).count ( );
+
+    printf ( "%zu flight(s) x %zu runs on %zu threads: %llu samples in %.2f s, %.2f M samples/s\n",
+             flights.size ( ), runs, pool.size ( ), ( unsigned long long ) samples.load ( ), seconds, samples.load ( ) / seconds / 1e6 );
+    printf ( "noise x%.2f, bias x%.2f, dropout %.3f, jitter %.1f ms, pressure spikes %.4f/sample of %.0f Pa\n",
+             perturbation.noise, perturbation.bias, perturbation.dropout, perturbation.jitter_ms, perturbation.spike_rate, perturbation.spike_pa );
+
+    report ( flights, results, window );
+
+    return 0;
+}
@@ -38,6 +38,10 @@
  *
  * The timer interrupt uses SIGALRM and care is taken to ensure that
  * the signal handler runs only on the thread for the current task.
+ * SIGALRM is raised by a dedicated tick thread which sleeps until
+ * absolute CLOCK_MONOTONIC deadlines, so the tick period does not
+ * drift and the host is not kept busy between ticks. Ticks missed
+ * while signals were blocked are caught up in the tick handler.
  *
  * Use of part of the standard C library requires care as some
  * functions can take pthread mutexes internally which can result in
@@ -58,6 +62,7 @@
 #include <sys/time.h>
 #include <sys/times.h>
 #include <time.h>
+#include <unistd.h>
 
 /* Scheduler includes. */
 #include "FreeRTOS.h"
@@ -97,11 +102,21 @@ static pthread_t hMainThread = ( pthread_t )NULL;
 static volatile portBASE_TYPE uxCriticalNesting;
 /*-----------------------------------------------------------*/
 
-static portBASE_TYPE xSchedulerEnd = pdFALSE;
+static volatile portBASE_TYPE xSchedulerEnd = pdFALSE;
+static pthread_t hTickThread;
+
+/*
+ * Thread of the running task as published by the task side on every
+ * switch. The tick thread is not a task and must not read the kernel's
+ * current TCB, it reads this under the mutex instead.
+ */
+static pthread_mutex_t xRunningThreadMutex = PTHREAD_MUTEX_INITIALIZER;
+static Thread_t *pxRunningThread = NULL;
 /*-----------------------------------------------------------*/
 
 static void prvSetupSignalsAndSchedulerPolicy( void );
 static void prvSetupTimerInterrupt( void );
+static void *prvTickThread( void * pvParams );
 static void *prvWaitForStart( void * pvParams );
 static void prvSwitchThread( Thread_t * xThreadToResume,
                              Thread_t *xThreadToSuspend );
@@ -206,18 +221,13 @@ sigset_t xSignals;
 
 void vPortEndScheduler( void )
 {
-struct itimerval itimer;
 struct sigaction sigtick;
 Thread_t *xCurrentThread;
 
-	/* Stop the timer and ignore any pending SIGALRMs that would end
-	 * up running on the main thread when it is resumed. */
-	itimer.it_value.tv_sec = 0;
-	itimer.it_value.tv_usec = 0;
-
-	itimer.it_interval.tv_sec = 0;
-	itimer.it_interval.tv_usec = 0;
-	(void)setitimer( ITIMER_REAL, &itimer, NULL );
+	/* Stop the tick thread (it exits at its next deadline) and ignore any
+	 * pending SIGALRMs that would end up running on the main thread when
+	 * it is resumed. */
+	xSchedulerEnd = pdTRUE;
 
 	sigtick.sa_flags = 0;
 	sigtick.sa_handler = SIG_IGN;
@@ -225,7 +235,6 @@ Thread_t *xCurrentThread;
 	sigaction( SIGALRM, &sigtick, NULL );
 
 	/* Signal the scheduler to exit its loop. */
-	xSchedulerEnd = pdTRUE;
 	(void)pthread_kill( hMainThread, SIG_RESUME );
 
 	xCurrentThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
@@ -318,37 +327,106 @@ static uint64_t prvStartTimeNs;
 static uint64_t prvTickCount;
 
 /*
- * Setup the systick timer to generate the tick interrupts at the required
+ * Setup the tick thread to generate the tick interrupts at the required
  * frequency.
  */
 void prvSetupTimerInterrupt( void )
 {
-struct itimerval itimer;
+pthread_attr_t xThreadAttributes;
+struct sched_param xSchedParam;
 int iRet;
 
-	/* Initialise the structure with the current timer information. */
-	iRet = getitimer( ITIMER_REAL, &itimer );
+	prvStartTimeNs = prvGetTimeNs();
+	prvTickCount = 0;
+
+	/*
+	 * Run the tick thread with a real-time priority when the host allows
+	 * it so that a loaded host delays the tick as little as possible.
+	 * Signals are blocked on the calling thread at this point and the
+	 * tick thread inherits that mask, so SIGALRM is never handled on it.
+	 */
+	pthread_attr_init( &xThreadAttributes );
+	pthread_attr_setinheritsched( &xThreadAttributes, PTHREAD_EXPLICIT_SCHED );
+	pthread_attr_setschedpolicy( &xThreadAttributes, SCHED_FIFO );
+	xSchedParam.sched_priority = sched_get_priority_max( SCHED_FIFO );
+	pthread_attr_setschedparam( &xThreadAttributes, &xSchedParam );
+
+	iRet = pthread_create( &hTickThread, &xThreadAttributes, prvTickThread, NULL );
+	if ( iRet == EPERM )
+	{
+		/* Not privileged, fall back to the default scheduling policy. */
+		iRet = pthread_create( &hTickThread, NULL, prvTickThread, NULL );
+	}
 	if ( iRet )
 	{
-		prvFatalError( "getitimer", errno );
+		prvFatalError( "pthread_create", iRet );
 	}
 
-	/* Set the interval between timer events. */
-	itimer.it_interval.tv_sec = 0;
-	itimer.it_interval.tv_usec = portTICK_RATE_MICROSECONDS;
+	pthread_attr_destroy( &xThreadAttributes );
+}
+/*-----------------------------------------------------------*/
 
-	/* Set the current count-down. */
-	itimer.it_value.tv_sec = 0;
-	itimer.it_value.tv_usec = portTICK_RATE_MICROSECONDS;
+static void *prvTickThread( void * pvParams )
+{
+struct timespec xDeadline;
+uint64_t ullNextTickNs;
+uint64_t ullNowNs;
+Thread_t *pxThread;
 
-	/* Set-up the timer interrupt. */
-	iRet = setitimer( ITIMER_REAL, &itimer, NULL );
-	if ( iRet )
+	( void ) pvParams;
+
+	ullNextTickNs = prvStartTimeNs + portTICK_RATE_NANOSECONDS;
+
+	while ( !xSchedulerEnd )
 	{
-		prvFatalError( "setitimer", errno );
+		/* Sleep until an absolute deadline so that the time spent raising
+		 * the signal does not accumulate into the tick period. */
+		xDeadline.tv_sec = ullNextTickNs / 1000000000ull;
+		xDeadline.tv_nsec = ullNextTickNs % 1000000000ull;
+
+		if ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xDeadline, NULL ) != 0 )
+		{
+			continue;
+		}
+
+		if ( xSchedulerEnd )
+		{
+			break;
+		}
+
+		/* The handler must run on the thread of the running task. Hold
+		 * the mutex over the kill so that no switch is published between
+		 * the read and the signal. */
+		pthread_mutex_lock( &xRunningThreadMutex );
+		pxThread = pxRunningThread;
+		if ( pxThread != NULL )
+		{
+			(void)pthread_kill( pxThread->pthread, SIGALRM );
+		}
+		pthread_mutex_unlock( &xRunningThreadMutex );
+
+		/* If the host stalled past several deadlines only raise one signal,
+		 * the handler accounts for the missed ticks. */
+		ullNextTickNs += portTICK_RATE_NANOSECONDS;
+		ullNowNs = prvGetTimeNs();
+		if ( ullNowNs > ullNextTickNs )
+		{
+			ullNextTickNs += ( ( ullNowNs - ullNextTickNs ) / portTICK_RATE_NANOSECONDS + 1 ) * portTICK_RATE_NANOSECONDS;
+		}
 	}
 
-	prvStartTimeNs = prvGetTimeNs();
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Sleep the calling task's thread until it is interrupted by the next tick.
+ * Intended to be called from the idle hook so that an idle simulation does
+ * not spin a host core.
+ */
+void vPortIdleSleep( void )
+{
+	(void)usleep( portTICK_RATE_MICROSECONDS );
 }
 /*-----------------------------------------------------------*/
 
@@ -357,6 +435,7 @@ static void vPortSystemTickHandler( int sig )
 Thread_t *pxThreadToSuspend;
 Thread_t *pxThreadToResume;
 uint64_t xExpectedTicks;
+BaseType_t xSwitchRequired = pdFALSE;
 
 	uxCriticalNesting++; /* Signals are blocked in this signal handler. */
 
@@ -365,24 +444,31 @@ uint64_t xExpectedTicks;
 #endif
 
 	/* Tick Increment, accounting for any lost signals or drift in
-	 * the timer. */
-/*
- *      Comment code to adjust timing according to full demo requirements
- *      xExpectedTicks = (prvGetTimeNs() - prvStartTimeNs)
- *		/ (portTICK_RATE_MICROSECONDS * 1000);
- * do { */
-		xTaskIncrementTick();
-/*		prvTickCount++;
- *	} while (prvTickCount < xExpectedTicks);
-*/
+	 * the timer. A signal that was left pending on a thread which has
+	 * since been suspended is delivered late and increments nothing. */
+	xExpectedTicks = ( prvGetTimeNs() - prvStartTimeNs ) / portTICK_RATE_NANOSECONDS;
+	while ( prvTickCount < xExpectedTicks )
+	{
+		if ( xTaskIncrementTick() != pdFALSE )
+		{
+			xSwitchRequired = pdTRUE;
+		}
+		prvTickCount++;
+	}
 
 #if ( configUSE_PREEMPTION == 1 )
-	/* Select Next Task. */
-	vTaskSwitchContext();
+	/* Select Next Task, only paying for a thread switch when the tick
+	 * unblocked a task or a time slice expired. */
+	if ( xSwitchRequired != pdFALSE )
+	{
+		vTaskSwitchContext();
 
-	pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+		pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
 
-	prvSwitchThread(pxThreadToResume, pxThreadToSuspend);
+		prvSwitchThread(pxThreadToResume, pxThreadToSuspend);
+	}
+#else
+	( void ) xSwitchRequired;
 #endif
 
 	uxCriticalNesting--;
@@ -478,6 +564,12 @@ int iSig;
 
 static void prvResumeThread( Thread_t *xThreadId )
 {
+	/* Always called with signals blocked, so the tick handler can not
+	 * interrupt the holder of the mutex. */
+	pthread_mutex_lock( &xRunningThreadMutex );
+	pxRunningThread = xThreadId;
+	pthread_mutex_unlock( &xRunningThreadMutex );
+
 	if ( pthread_self() != xThreadId->pthread )
 	{
 		event_signal(xThreadId->ev);
@@ -71,6 +71,7 @@ typedef unsigned long TickType_t;
 #define portHAS_STACK_OVERFLOW_CHECKING	( 1 )
 #define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
 #define portTICK_RATE_MICROSECONDS	( ( portTickType ) 1000000 / configTICK_RATE_HZ )
+#define portTICK_RATE_NANOSECONDS	( 1000000000ull / configTICK_RATE_HZ )
 #define portBYTE_ALIGNMENT			8
 /*-----------------------------------------------------------*/
 
@@ -125,6 +126,8 @@ extern void vPortCancelThread( void *pxTaskToDelete );
 
 extern unsigned long ulPortGetRunTime( void );
 
+extern void vPortIdleSleep( void );
+
 #ifdef __cplusplus
 }
 #endif
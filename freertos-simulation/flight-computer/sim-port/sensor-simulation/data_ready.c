@@ -0,0 +1,88 @@
+#include "data_ready.h"
+
+#include <stddef.h>
+#include "board/board.h"
+
+
+typedef struct
+{
+    volatile TaskHandle_t   task;
+    uint32_t                edges;      // the edges already delivered
+    volatile uint32_t       timestamp;
+
+} DataReadyLine;
+
+static DataReadyLine prvLines [ DATAFEEDER_DATA_READY_COUNT ];
+static TaskHandle_t  prvHandle = NULL;
+
+
+static void prv_data_ready_task ( void * pvParameters );
+
+
+
+int data_ready_attach ( DataFeederDataReady line, TaskHandle_t task )
+{
+    DataReadyLine * state = &prvLines [ line ];
+
+    // the edges from before the task was attached are not its own
+    taskENTER_CRITICAL ( );
+    state->edges = datafeeder_get_data_ready ( line, NULL );
+    state->task  = task;
+    taskEXIT_CRITICAL ( );
+
+    // above the sensor tasks, as an interrupt would be
+    if ( prvHandle == NULL && pdFALSE == xTaskCreate ( prv_data_ready_task, "sim-data-ready", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, &prvHandle ) )
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+void data_ready_detach ( DataFeederDataReady line )
+{
+    prvLines [ line ].task = NULL;
+}
+
+
+
+uint32_t data_ready_get_timestamp ( DataFeederDataReady line )
+{
+    return prvLines [ line ].timestamp;
+}
+
+
+
+static void prv_data_ready_task ( void * pvParameters )
+{
+    TickType_t wakeup = xTaskGetTickCount ( );
+
+    for ( ; ; )
+    {
+        vTaskDelayUntil ( &wakeup, 1 );
+
+        for ( int line = 0; line < DATAFEEDER_DATA_READY_COUNT; line++ )
+        {
+            DataReadyLine * state = &prvLines [ line ];
+
+            taskENTER_CRITICAL ( );
+            TaskHandle_t task = state->task;
+            uint32_t timestamp;
+            const uint32_t latest = datafeeder_get_data_ready ( ( DataFeederDataReady ) line, &timestamp );
+            taskEXIT_CRITICAL ( );
+
+            if ( task == NULL )
+            {
+                continue;
+            }
+
+            for ( ; state->edges != latest; state->edges++ )
+            {
+                state->timestamp = timestamp;
+                xTaskNotifyGive ( task );
+            }
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef __DATA_READY_H
+#define __DATA_READY_H
+
+#include <inttypes.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "datafeeder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Stands in for the EXTI of the data ready lines. The POSIX port cannot interrupt a task, so a task above the sensor
+// tasks looks every tick for the edges the data feeder made and, like the interrupt handlers of the board, notifies
+// the task attached to the line once per edge. The edges of one tick are delivered together.
+
+// from now on every edge of the line notifies the task, the emulation is started on the first call
+int      data_ready_attach          ( DataFeederDataReady line, TaskHandle_t task );
+void     data_ready_detach          ( DataFeederDataReady line );
+
+// board_get_timestamp_us of the latest edge delivered on the line
+uint32_t data_ready_get_timestamp   ( DataFeederDataReady line );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DATA_READY_H
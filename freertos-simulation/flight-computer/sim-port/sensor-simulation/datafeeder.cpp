@@ -6,6 +6,8 @@
 #include <thread>
 #include <mutex>
 #include <deque>
+#include <algorithm>
+#include <cmath>
 #include <unistd.h>
 #include <stddef.h>
 #include <iostream>
@@ -17,6 +19,8 @@
 
 #include "csv.h"
 #include "flight-computer/protocols/UART.h"
+#include "board/components/icm20948_imu_sensor.h"
+#include "board/board.h"
 
 namespace
 {
@@ -29,6 +33,14 @@ namespace
     static std::deque < press_data > press_queue;
     static std::string               csv_file_name;
 
+    static std::deque < uint8_t >    imu_fifo;
+    static uint32_t                  imu_rate            = 0;
+    static uint32_t                  imu_fifo_overflows  = 0;
+
+    // edges of the data ready lines so far and the board_get_timestamp_us of the latest one
+    static uint32_t                  data_ready_edges      [ DATAFEEDER_DATA_READY_COUNT ] = { };
+    static uint32_t                  data_ready_timestamps [ DATAFEEDER_DATA_READY_COUNT ] = { };
+
     xTaskHandle                     handle;
 
     int msleep( long msec )
@@ -54,6 +66,72 @@ namespace
     }
 
     static int isRunning = 0;
+
+    // samples overwritten because the consumers did not keep up
+    static uint32_t overflows = 0;
+
+    static TrajectoryConfiguration   trajectory_configuration;
+    static void * ( * worker_entry )( void * ) = nullptr;
+
+    // to be called in a critical section: when the consumer falls behind the oldest sample is lost
+    template < typename T >
+    void push( std::deque < T > & queue, const T & item )
+    {
+        if ( queue.size( ) >= MAX_ITEMS )
+        {
+            queue.pop_front( );
+            overflows++;
+        }
+        queue.push_back( item );
+    }
+
+    // to be called in a critical section: the sensor raises its data ready line for the sample just written
+    void data_ready_edge( DataFeederDataReady line )
+    {
+        data_ready_edges[ line ]++;
+        data_ready_timestamps[ line ] = board_get_timestamp_us( );
+    }
+
+    void imu_fifo_write_axis( float value, float full_scale )
+    {
+        float counts = value / full_scale * 32768;
+        counts = counts >  32767 ?  32767 : counts;
+        counts = counts < -32768 ? -32768 : counts;
+
+        const int16_t raw = ( int16_t ) lrintf( counts );
+        imu_fifo.push_back( ( uint8_t ) ( ( uint16_t ) raw >> 8 ) );
+        imu_fifo.push_back( ( uint8_t ) ( raw & 0xFF ) );
+    }
+
+    // to be called in a critical section: the frame the sensor would write at its output data rate, in g and deg/s,
+    // with the edge of its data ready line
+    void imu_fifo_write( const float acc [ 3 ], const float gyro [ 3 ] )
+    {
+        data_ready_edge( DATAFEEDER_IMU_DATA_READY );
+
+        if ( imu_fifo.size( ) + IMU_SENSOR_FIFO_FRAME_SIZE > IMU_SENSOR_FIFO_SIZE )
+        {
+            imu_fifo.erase( imu_fifo.begin( ), imu_fifo.begin( ) + IMU_SENSOR_FIFO_FRAME_SIZE );
+            imu_fifo_overflows++;
+        }
+
+        for ( int i = 0; i < 3; i++ )
+        {
+            imu_fifo_write_axis( acc[ i ], DATAFEEDER_IMU_ACC_FULL_SCALE );
+        }
+
+        for ( int i = 0; i < 3; i++ )
+        {
+            imu_fifo_write_axis( gyro[ i ], DATAFEEDER_IMU_GYRO_FULL_SCALE );
+        }
+    }
+
+    double wall_clock( )
+    {
+        struct timespec ts { };
+        clock_gettime( CLOCK_MONOTONIC, &ts );
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
 }
 
 #ifdef __cplusplus
@@ -79,6 +157,7 @@ void * worker_function( void * arg )
 
     DEBUG_LINE("C++ DataFeeder has successfully started.");
     isRunning = 1;
+    imu_rate = 1000 / 5;
     while (isRunning && reader.read_row(timestamp, acc.x, press.pressure, altMSL, press.temperature, acc.y, acc.z, gyro.x, gyro.y, gyro.z, mag.x, mag.y, mag.z, flags[0], flags[1], flags[2], flags[3]))
     {
         timestamp_uint += 50;
@@ -88,17 +167,14 @@ void * worker_function( void * arg )
 
         taskENTER_CRITICAL( );
 
-        if ( acc_queue.size( ) >= MAX_ITEMS )
-            acc_queue.pop_front( );
-        acc_queue.push_back( acc );
+        push( acc_queue, acc );
+        push( gyro_queue, gyro );
+        push( press_queue, press );
+        data_ready_edge( DATAFEEDER_PRESS_DATA_READY );
 
-        if ( gyro_queue.size( ) >= MAX_ITEMS )
-            gyro_queue.pop_front( );
-        gyro_queue.push_back( gyro );
-
-        if ( press_queue.size( ) >= MAX_ITEMS )
-            press_queue.pop_front( );
-        press_queue.push_back( press );
+        const float acc_g [ 3 ]     = { acc.x, acc.y, acc.z };
+        const float gyro_dps [ 3 ]  = { gyro.x, gyro.y, gyro.z };
+        imu_fifo_write( acc_g, gyro_dps );
 
         taskEXIT_CRITICAL( );
 
@@ -129,6 +205,7 @@ void * worker_function( void * arg )
     // time,accx,accy,accz,rotx,roty,rotz,temp,pres,alt,Flags
     DEBUG_LINE("C++ DataFeeder has successfully started.");
     isRunning = 1;
+    imu_rate = 1000 / 50;
 
     while (isRunning && reader.read_row(timestamp, acc.x, acc.y, acc.z, gyro.x, gyro.y, gyro.z, press.data, press.temperature))
     {
@@ -139,17 +216,15 @@ void * worker_function( void * arg )
 
         taskENTER_CRITICAL( );
 
-        if ( acc_queue.size( ) >= MAX_ITEMS )
-            acc_queue.pop_front( );
-        acc_queue.push_back( acc );
-
-        if ( gyro_queue.size( ) >= MAX_ITEMS )
-            gyro_queue.pop_front( );
-        gyro_queue.push_back( gyro );
+        push( acc_queue, acc );
+        push( gyro_queue, gyro );
+        push( press_queue, press );
+        data_ready_edge( DATAFEEDER_PRESS_DATA_READY );
 
-        if ( press_queue.size( ) >= MAX_ITEMS )
-            press_queue.pop_front( );
-        press_queue.push_back( press );
+        // milli-g in the recording
+        const float acc_g [ 3 ]     = { acc.x / 1000.0f, acc.y / 1000.0f, acc.z / 1000.0f };
+        const float gyro_dps [ 3 ]  = { ( float ) gyro.x, ( float ) gyro.y, ( float ) gyro.z };
+        imu_fifo_write( acc_g, gyro_dps );
 
         taskEXIT_CRITICAL( );
 
@@ -163,6 +238,81 @@ void * worker_function( void * arg )
 }
 #endif
 
+// Feeds a synthetic flight instead of a recording, at the sample rates of the trajectory configuration
+void * synthetic_worker_function( void * arg )
+{
+    Trajectory trajectory;
+    TrajectorySample sample;
+    TrajectoryPhase phase = TRAJECTORY_PHASE_PAD;
+    xyz_data gyro, acc;
+    press_data press;
+
+    trajectory_init( &trajectory, &trajectory_configuration );
+
+    DEBUG_LINE("C++ DataFeeder has successfully started a synthetic flight: IMU at %" PRIu32 " Hz, pressure at %" PRIu32 " Hz.",
+               trajectory_configuration.imu_rate, trajectory_configuration.pressure_rate);
+    isRunning = 1;
+    overflows = 0;
+    imu_rate = trajectory_configuration.imu_rate;
+
+    const double time_scale = trajectory_configuration.time_scale;
+    const double start = wall_clock( );
+
+    while ( isRunning && trajectory_next_sample( &trajectory, &sample ) )
+    {
+        if ( sample.phase != phase )
+        {
+            phase = sample.phase;
+            DEBUG_LINE("Synthetic flight: %s at %.3f s, altitude %.1f m.", trajectory_phase_name( phase ), sample.time, sample.altitude);
+        }
+
+#if (userconf_USE_COTS_DATA == 1)
+        // the units of the COTS recording: seconds, g, deg/s and Pa
+        acc   = { sample.time, sample.acc[ 0 ], sample.acc[ 1 ], sample.acc[ 2 ] };
+        gyro  = { sample.time, sample.gyro[ 0 ], sample.gyro[ 1 ], sample.gyro[ 2 ] };
+        press = { sample.time, sample.temperature, ( int64_t ) sample.pressure };
+#else
+        // milliseconds, milli-g, deg/s and the hundredths of deg C and Pa of the SRAD recording
+        uint32_t timestamp = ( uint32_t ) ( sample.time * 1000 );
+        acc   = { timestamp, ( int16_t ) ( sample.acc[ 0 ] * 1000 ), ( int16_t ) ( sample.acc[ 1 ] * 1000 ), ( int16_t ) ( sample.acc[ 2 ] * 1000 ) };
+        gyro  = { timestamp, ( int16_t ) sample.gyro[ 0 ], ( int16_t ) sample.gyro[ 1 ], ( int16_t ) sample.gyro[ 2 ] };
+        press = { timestamp, ( int64_t ) ( sample.temperature * 100 ), ( int64_t ) ( sample.pressure * 100 ) };
+#endif
+
+        taskENTER_CRITICAL( );
+
+        if ( sample.imu_updated )
+        {
+            push( acc_queue, acc );
+            push( gyro_queue, gyro );
+            imu_fifo_write( sample.acc, sample.gyro );
+        }
+
+        if ( sample.pressure_updated )
+        {
+            push( press_queue, press );
+            data_ready_edge( DATAFEEDER_PRESS_DATA_READY );
+        }
+
+        taskEXIT_CRITICAL( );
+
+        // keep to the simulated time, sleeping in steps of at least a millisecond
+        if ( time_scale > 0 )
+        {
+            double ahead = sample.time / time_scale - ( wall_clock( ) - start );
+            if ( ahead >= 0.001 )
+            {
+                msleep( ( long ) ( ahead * 1000 ) );
+            }
+        }
+    }
+
+    DEBUG_LINE("C++ DataFeeder has successfully exited the synthetic flight: %" PRIu32 " samples were overwritten before being read.", overflows);
+
+    isRunning = 0;
+    return nullptr;
+}
+
 int data_feeder_is_running( )
 {
     return isRunning;
@@ -173,6 +323,11 @@ void data_feeder_stop()
     isRunning = false;
 }
 
+uint32_t data_feeder_get_overflows( )
+{
+    return overflows;
+}
+
 
 #ifdef __cplusplus
 }
@@ -191,7 +346,7 @@ void prv_task_fnc( void * pvParams )
 {
     try
     {
-        if ( pthread_create( &worker, nullptr, worker_function, nullptr ) )
+        if ( pthread_create( &worker, nullptr, worker_entry, nullptr ) )
         {
             fprintf( stderr, "Error creating thread\n" );
             return;
@@ -211,6 +366,23 @@ int data_feeder_start( const char * file )
     if( ! isRunning )
     {
         csv_file_name = std::string(file, strlen(file));
+        worker_entry = worker_function;
+        if (pdFALSE == xTaskCreate(prv_task_fnc, "fake-sensor-data", configMINIMAL_STACK_SIZE, nullptr, 5, &handle)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+
+int data_feeder_start_synthetic( const TrajectoryConfiguration * configuration )
+{
+    if( ! isRunning )
+    {
+        trajectory_configuration = *configuration;
+        worker_entry = synthetic_worker_function;
         if (pdFALSE == xTaskCreate(prv_task_fnc, "fake-sensor-data", configMINIMAL_STACK_SIZE, nullptr, 5, &handle)) {
             return 1;
         }
@@ -289,6 +461,63 @@ int datafeeder_get_press( press_data * data )
 
 
 
+int datafeeder_get_imu_fifo_count( )
+{
+    taskENTER_CRITICAL( );
+    int count = ( int ) imu_fifo.size( );
+    taskEXIT_CRITICAL( );
+
+    return count;
+}
+
+
+
+int datafeeder_read_imu_fifo( uint8_t * buffer, int length )
+{
+    taskENTER_CRITICAL( );
+
+    int count = std::min( length, ( int ) imu_fifo.size( ) );
+    std::copy( imu_fifo.begin( ), imu_fifo.begin( ) + count, buffer );
+    imu_fifo.erase( imu_fifo.begin( ), imu_fifo.begin( ) + count );
+
+    taskEXIT_CRITICAL( );
+
+    return count;
+}
+
+
+
+uint32_t datafeeder_get_imu_rate( )
+{
+    return imu_rate;
+}
+
+
+
+uint32_t datafeeder_get_imu_fifo_overflows( )
+{
+    return imu_fifo_overflows;
+}
+
+
+
+uint32_t datafeeder_get_data_ready( DataFeederDataReady line, uint32_t * timestamp )
+{
+    taskENTER_CRITICAL( );
+
+    uint32_t edges = data_ready_edges[ line ];
+    if ( timestamp != nullptr )
+    {
+        *timestamp = data_ready_timestamps[ line ];
+    }
+
+    taskEXIT_CRITICAL( );
+
+    return edges;
+}
+
+
+
 void data_feeder_join( )
 {
     pthread_join( worker, nullptr );
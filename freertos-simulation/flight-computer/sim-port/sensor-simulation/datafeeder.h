@@ -3,6 +3,7 @@
 
 #include <inttypes.h>
 #include "configurations/UserConfig.h"
+#include "trajectory.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,9 +58,38 @@ int datafeeder_get_gyro(xyz_data * data);
 int datafeeder_get_acc(xyz_data * data);
 int datafeeder_get_press(press_data * data);
 
+// The FIFO of the simulated IMU, filled by the feeder as the sensor fills its own: IMU_SENSOR_FIFO_FRAME_SIZE bytes
+// frames of the accelerometer then the gyroscope, in counts of the ranges below, the oldest frame overwritten when full
+#define DATAFEEDER_IMU_ACC_FULL_SCALE   16      // [g]
+#define DATAFEEDER_IMU_GYRO_FULL_SCALE  2000    // [deg/s]
+
+// bytes in the FIFO, as FIFO_COUNTH would read
+int datafeeder_get_imu_fifo_count();
+// takes up to length bytes out of the FIFO, returns how many were read
+int datafeeder_read_imu_fifo(uint8_t * buffer, int length);
+// the rate the FIFO is filled at [Hz]
+uint32_t datafeeder_get_imu_rate();
+// frames overwritten before being read
+uint32_t datafeeder_get_imu_fifo_overflows();
+// The data ready lines of the simulated sensors, one edge per sample: IMU samples are also queued for
+// datafeeder_get_acc and datafeeder_get_gyro, pressure samples for datafeeder_get_press
+typedef enum
+{
+    DATAFEEDER_IMU_DATA_READY = 0,
+    DATAFEEDER_PRESS_DATA_READY,
+    DATAFEEDER_DATA_READY_COUNT
+} DataFeederDataReady;
+
+// edges of the line so far, timestamp (if not NULL) receives the board_get_timestamp_us of the latest one
+uint32_t datafeeder_get_data_ready(DataFeederDataReady line, uint32_t * timestamp);
+
 int data_feeder_start(const char * file);
+// a synthetic flight instead of the recording, see trajectory.h
+int data_feeder_start_synthetic(const TrajectoryConfiguration * configuration);
 int data_feeder_is_running();
 void data_feeder_stop();
+// samples dropped so far because the queues were full
+uint32_t data_feeder_get_overflows();
 
 void data_feeder_join();
 
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <unistd.h>
 
 
@@ -53,11 +54,17 @@ static inline void initialize_flash_disk( void )
         if ( !writePrt )
         {
             perror( "fopen" );
+            return;
         }
 
-        // Create or over write the file with all 0xff for the specified size
-        fseek( writePrt, FLASH_SIZE, SEEK_SET );
-        fputc( '\0', writePrt );
+        // Create the file with all 0xff for the specified size, as a new flash memory comes erased
+        uint8_t erased[ FLASH_64KB_SECTOR_SIZE ];
+        memset( erased, 0xFF, sizeof( erased ) );
+        for ( uint32_t written = 0; written <= FLASH_SIZE; written += sizeof( erased ) )
+        {
+            size_t size = FLASH_SIZE + 1 - written < sizeof( erased ) ? FLASH_SIZE + 1 - written : sizeof( erased );
+            fwrite( erased, sizeof( uint8_t ), size, writePrt );
+        }
         fclose( writePrt );
     }
 }
@@ -107,8 +114,6 @@ static inline uint32_t read_page( uint32_t address, uint8_t * data_buffer, uint1
 
     fclose( readPrt );
 
-    perror("read");
-
     // Return operation flag
     return bytesRead == num_bytes ? FLASH_OK : FLASH_ERR;
 }
@@ -159,18 +164,130 @@ FlashReturnType flash_read( uint32_t address, uint8_t * data_buffer, uint16_t nu
 
 
 
+FlashStatus flash_read_stream( uint32_t address, uint32_t length, FlashStreamSink sink, void * context )
+{
+    static uint8_t chunk[ FLASH_STREAM_CHUNK_SIZE ];
+
+    if ( sink == NULL || address > FLASH_SIZE )
+    {
+        return FLASH_ERR;
+    }
+
+    if ( length > FLASH_SIZE - address )
+    {
+        length = FLASH_SIZE - address;
+    }
+
+    // one open for the whole stream, as the one command on the board
+    FILE * readPrt = fopen( FILE_NAME, "rb" );
+    if ( !readPrt )
+    {
+        return FLASH_ERR;
+    }
+
+    fseek( readPrt, address, SEEK_SET );
+
+    FlashStatus status = FLASH_OK;
+    for ( uint32_t offset = 0; offset < length; offset += FLASH_STREAM_CHUNK_SIZE )
+    {
+        uint32_t size = length - offset < FLASH_STREAM_CHUNK_SIZE ? length - offset : FLASH_STREAM_CHUNK_SIZE;
+        if ( fread( chunk, sizeof( uint8_t ), size, readPrt ) != size )
+        {
+            status = FLASH_ERR;
+            break;
+        }
+
+        if ( !sink( address + offset, chunk, size, context ) )
+        {
+            break;
+        }
+    }
+
+    fclose( readPrt );
+
+    return status;
+}
+
+
+
+typedef struct
+{
+    const uint8_t * expected;
+    bool match;
+} VerifyContext;
+
+
+
+static bool verify_chunk( uint32_t address, const uint8_t * data, uint32_t size, void * context )
+{
+    VerifyContext * verify = context;
+
+    for ( uint32_t i = 0; i < size && verify->match; i++ )
+    {
+        verify->match = data[ i ] == ( verify->expected == NULL ? 0xFF : verify->expected[ i ] );
+    }
+
+    if ( verify->expected != NULL )
+    {
+        verify->expected += size;
+    }
+
+    return verify->match;
+}
+
+
+
+FlashStatus flash_verify( uint32_t address, const uint8_t * expected, uint32_t length )
+{
+    VerifyContext verify = { .expected = expected, .match = true };
+
+    if ( FLASH_OK != flash_read_stream( address, length, verify_chunk, &verify ) )
+    {
+        return FLASH_ERR;
+    }
+
+    return verify.match ? FLASH_OK : FLASH_ERR;
+}
+
+
+
 FlashStatus flash_erase_device( )
 {
     return prvExecuteCommand(0, FLASH_ERASE_DEVICE, NULL, 0);
 }
 
 
-FlashStatus flash_erase_4Kb_subsector(uint32_t address)
+static FlashStatus erase_block( uint32_t address, uint32_t size )
 {
+    // erased NOR flash reads all ones
+    uint8_t erased[ PAGE_SIZE ];
+    memset( erased, 0xFF, PAGE_SIZE );
+
+    address -= address % size;
+    for ( uint32_t offset = 0; offset < size; offset += PAGE_SIZE )
+    {
+        if ( FLASH_OK != program_page( address + offset, erased, PAGE_SIZE ) )
+        {
+            return FLASH_ERR;
+        }
+    }
+
     return FLASH_OK;
 }
 
 
+FlashStatus flash_erase_4Kb_subsector(uint32_t address)
+{
+    return erase_block( address, FLASH_4KB_SECTOR_SIZE );
+}
+
+
+FlashStatus flash_erase_64kb_sector( uint32_t address )
+{
+    return erase_block( address, FLASH_64KB_SECTOR_SIZE );
+}
+
+
 FlashStatus flash_check_id( )
 {
     return FLASH_OK;
@@ -187,7 +304,38 @@ FlashStatus flash_init( )
 
 
 
+// the stream starts on a page, so do the chunks. An erased page reads all ones, as on the flash memory
+static bool scan_chunk( uint32_t address, const uint8_t * data, uint32_t size, void * context )
+{
+    for ( uint32_t page = 0; page + PAGE_SIZE <= size; page += PAGE_SIZE )
+    {
+        bool ones = true;
+        for ( uint32_t i = 0; i < PAGE_SIZE && ones; i++ )
+        {
+            ones = data[ page + i ] == 0xFF;
+        }
+
+        if ( ones )
+        {
+            *( size_t * ) context = address + page;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
 size_t flash_scan( )
 {
-    return FLASH_SIZE;
+    // a full flash memory has no empty page
+    size_t result = FLASH_SIZE;
+
+    if ( FLASH_OK != flash_read_stream( 0, FLASH_SIZE, scan_chunk, &result ) )
+    {
+        return FLASH_ERR;
+    }
+
+    return result;
 }
\ No newline at end of file
@@ -0,0 +1,317 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// imu_sensor.c
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS > Avionics 2019
+//
+// File Description:
+//  Simulated ICM-20948 inside of RTOS task. The data feeder fills the FIFO of the sensor at its output data rate and
+//  the task drains it in one read per wake-up, as the flight computer does in FIFO mode.
+//
+//  With the BMI088 data synchronization backend the task is woken once per sample instead, by the emulated data ready
+//  interrupt of data_ready.h.
+//
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "board/components/icm20948_imu_sensor.h"
+#include <stdbool.h>
+#include <string.h>
+#include <board/board.h>
+
+#include "protocols/UART.h"
+#include "utilities/spsc_ring.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "datafeeder.h"
+#include "data_ready.h"
+
+
+SPSC_RING( imu_sample, IMUSensorData, IMU_SENSOR_RING_LENGTH )
+
+static imu_sample_ring s_ring;
+static xTaskHandle handle;
+static uint8_t s_desired_processing_data_rate = 50;
+static bool s_is_running = false;
+static uint32_t s_fifo_overflows = 0;
+
+static const struct imu_sensor_configuration s_default_configuration = { 0 };
+static struct imu_sensor_configuration s_current_configuration = { 0 };
+
+
+
+// counts of the full scales the data feeder runs at
+#define IMU_SENSOR_ACC_G_PER_COUNT          ( ( float ) DATAFEEDER_IMU_ACC_FULL_SCALE / 32768 )
+#define IMU_SENSOR_GYRO_DEG_PER_SEC_PER_COUNT ( ( float ) DATAFEEDER_IMU_GYRO_FULL_SCALE / 32768 )
+
+static void prv_imu_sensor_fifo_drain ( uint32_t timestamp );
+static void prv_imu_sensor_read_synchronized ( uint32_t timestamp );
+
+
+
+int imu_sensor_init ( )
+{
+    imu_sample_ring_reset( &s_ring );
+
+    return IMU_OK;
+}
+
+
+
+static void prv_imu_sensor_start ( void * pvParameters )
+{
+    TickType_t wakeup = xTaskGetTickCount( );
+
+    // the samples are time stamped in ms since board_init ( )
+    BoardMillisecondClock clock;
+
+    // what the sensor buffered before the task was started is not of this run
+    while ( datafeeder_get_imu_fifo_count( ) != 0 )
+    {
+        static uint8_t discarded [ IMU_SENSOR_FIFO_SIZE ];
+        datafeeder_read_imu_fifo( discarded, sizeof( discarded ) );
+    }
+
+    s_is_running = true;
+    DEBUG_LINE("IMU sensor task has been successfully started.");
+
+    if ( s_current_configuration.backend == IMU_SENSOR_BACKEND_BMI088_DATA_SYNC )
+    {
+        xyz_data discarded;
+        while ( datafeeder_get_acc( &discarded ) || datafeeder_get_gyro( &discarded ) )
+        {
+        }
+
+        board_ms_clock_start( &clock );
+        if ( 0 != data_ready_attach( DATAFEEDER_IMU_DATA_READY, handle ) )
+        {
+            board_error_handler( __FILE__, __LINE__ );
+        }
+
+        while ( s_is_running )
+        {
+            // one notification per data ready, the edges of a tick come together
+            uint32_t pending = ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( 100 ) );
+            while ( pending-- > 0 )
+            {
+                const uint32_t edge_us = data_ready_get_timestamp( DATAFEEDER_IMU_DATA_READY );
+                prv_imu_sensor_read_synchronized( board_ms_clock_update( &clock, edge_us ) );
+            }
+        }
+
+        data_ready_detach( DATAFEEDER_IMU_DATA_READY );
+    }
+    else
+    {
+        board_ms_clock_start( &clock );
+
+        while ( s_is_running )
+        {
+            // drained at the period the output data rate of the data feeder needs, before its FIFO fills
+            const uint32_t rate = datafeeder_get_imu_rate( );
+            const TickType_t period = pdMS_TO_TICKS( rate != 0 ? IMU_SENSOR_FIFO_DRAIN_PERIOD_MS( rate ) : 100 );
+            configASSERT( period != 0 );
+
+            vTaskDelayUntil( &wakeup, period );
+
+            prv_imu_sensor_fifo_drain( board_ms_clock_update( &clock, board_get_timestamp_us( ) ) );
+        }
+    }
+
+    DEBUG_LINE("IMU sensor task has successfully exited.");
+    vTaskDelete( NULL );
+}
+
+
+
+// the recordings are in units, the sensor would have given the count closest to them
+static int16_t prv_imu_sensor_to_count ( float value, float scale )
+{
+    float count = value / scale;
+
+    if ( count >  32767 ) count =  32767;
+    if ( count < -32768 ) count = -32768;
+
+    return ( int16_t ) ( count < 0 ? count - 0.5f : count + 0.5f );
+}
+
+
+
+// what the reader does after the interrupt: one synchronized sample
+static void prv_imu_sensor_read_synchronized ( uint32_t timestamp )
+{
+    xyz_data acc, gyro;
+    if ( ! datafeeder_get_acc( &acc ) || ! datafeeder_get_gyro( &gyro ) )
+    {
+        return;
+    }
+
+    IMUSensorData dataStruct;
+#if (userconf_USE_COTS_DATA == 1)
+    const float accScale = IMU_SENSOR_ACC_G_PER_COUNT;
+#else
+    // milli-g in the recording
+    const float accScale = IMU_SENSOR_ACC_G_PER_COUNT * 1000.0f;
+#endif
+    dataStruct.acc_x  = prv_imu_sensor_to_count( acc.x, accScale );
+    dataStruct.acc_y  = prv_imu_sensor_to_count( acc.y, accScale );
+    dataStruct.acc_z  = prv_imu_sensor_to_count( acc.z, accScale );
+    dataStruct.gyro_x = prv_imu_sensor_to_count( gyro.x, IMU_SENSOR_GYRO_DEG_PER_SEC_PER_COUNT );
+    dataStruct.gyro_y = prv_imu_sensor_to_count( gyro.y, IMU_SENSOR_GYRO_DEG_PER_SEC_PER_COUNT );
+    dataStruct.gyro_z = prv_imu_sensor_to_count( gyro.z, IMU_SENSOR_GYRO_DEG_PER_SEC_PER_COUNT );
+    dataStruct.timestamp = timestamp;
+
+    if ( ! imu_add_measurement( &dataStruct ) )
+    {
+        s_fifo_overflows++;
+    }
+}
+
+
+
+// Takes every complete frame out of the FIFO, the time stamps are counted back from the wake-up at the rate of the feeder
+static void prv_imu_sensor_fifo_drain ( uint32_t timestamp )
+{
+    static uint8_t frames [ IMU_SENSOR_FIFO_SIZE ];
+
+    int bytes = datafeeder_get_imu_fifo_count( );
+    bytes = datafeeder_read_imu_fifo( frames, bytes - bytes % IMU_SENSOR_FIFO_FRAME_SIZE );
+
+    const uint32_t rate = datafeeder_get_imu_rate( );
+    const uint32_t frameCount = bytes / IMU_SENSOR_FIFO_FRAME_SIZE;
+
+    if ( rate == 0 || frameCount == 0 )
+    {
+        return;
+    }
+
+    s_fifo_overflows = datafeeder_get_imu_fifo_overflows( );
+
+    for ( uint32_t frame = 0; frame < frameCount; frame++ )
+    {
+        const uint8_t * raw = &frames [ frame * IMU_SENSOR_FIFO_FRAME_SIZE ];
+
+        IMUSensorData * sample = imu_sample_ring_reserve( &s_ring );
+        if ( sample == NULL )
+        {
+            continue;
+        }
+
+        int16_t values [ IMU_SENSOR_FIFO_FRAME_SIZE / 2 ];
+        for ( int i = 0; i < IMU_SENSOR_FIFO_FRAME_SIZE / 2; i++ )
+        {
+            values [ i ] = ( int16_t ) ( ( ( ( uint16_t ) raw [ 2 * i ] ) << 8 ) | raw [ 2 * i + 1 ] );
+        }
+
+        sample->acc_x     = values [ 0 ];
+        sample->acc_y     = values [ 1 ];
+        sample->acc_z     = values [ 2 ];
+        sample->gyro_x    = values [ 3 ];
+        sample->gyro_y    = values [ 4 ];
+        sample->gyro_z    = values [ 5 ];
+        sample->timestamp = timestamp - ( uint64_t ) ( frameCount - 1 - frame ) * 1000 / rate;
+
+        imu_sample_ring_commit( &s_ring );
+    }
+}
+
+
+
+int imu_sensor_start ( void * const param )
+{
+    if ( ! s_is_running )
+    {
+        if ( pdFALSE == xTaskCreate( prv_imu_sensor_start, "imu-manager", configMINIMAL_STACK_SIZE, param, 5, &handle ) )
+        {
+            board_error_handler( __FILE__, __LINE__ );
+        }
+    }
+    else
+    {
+        DISPLAY_LINE("IMU Sensor task is already running");
+    }
+
+    return IMU_OK;
+}
+
+bool imu_sensor_is_running     ()
+{
+    return s_is_running;
+}
+
+void imu_sensor_stop           ()
+{
+    s_is_running = false;
+}
+
+
+
+bool imu_sensor_test ( )
+{
+    return true;
+}
+
+
+
+bool imu_read ( IMUSensorData * buffer )
+{
+    return imu_sample_ring_pop( &s_ring, buffer );
+}
+
+
+bool imu_add_measurement ( IMUSensorData * _data )
+{
+    return imu_sample_ring_push( &s_ring, _data );
+}
+
+int imu_sensor_configure ( IMUSensorConfiguration * parameters )
+{
+    if ( parameters == NULL )
+    {
+        s_current_configuration = s_default_configuration;
+        return IMU_OK;
+    }
+
+    s_current_configuration = *parameters;
+    return IMU_OK;
+}
+
+
+IMUSensorConfiguration imu_sensor_get_default_configuration ( )
+{
+    return s_default_configuration;
+}
+
+IMUSensorConfiguration imu_sensor_get_current_configuration ( )
+{
+    return s_current_configuration;
+}
+
+IMUSensorScale imu_sensor_get_scale ( )
+{
+    IMUSensorScale scale = { IMU_SENSOR_ACC_G_PER_COUNT, IMU_SENSOR_GYRO_DEG_PER_SEC_PER_COUNT };
+    return scale;
+}
+
+void imu_sensor_set_desired_processing_data_rate ( uint32_t rate )
+{
+    s_desired_processing_data_rate = rate;
+}
+
+uint32_t imu_sensor_get_fifo_overflows ( )
+{
+    return s_fifo_overflows;
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
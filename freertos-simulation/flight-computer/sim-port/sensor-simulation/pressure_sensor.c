@@ -29,9 +29,10 @@ extern "C" {
 #include "core/system_configuration.h"
 #include "protocols/UART.h"
 #include "utilities/common.h"
+#include "utilities/spsc_ring.h"
 #include "FreeRTOS.h"
-#include "queue.h"
 #include "datafeeder.h"
+#include "data_ready.h"
 
 #include "memory-management/memory_manager.h"
 #include "event-detection/event_detector.h"
@@ -40,6 +41,9 @@ extern "C" {
 #define PRES_TYPE           0x200000
 #define TEMP_TYPE           0x100000
 
+// longest wait for a data ready before the task checks whether it was stopped
+#define DATA_READY_TIMEOUT_MS   100
+
 #define GND_ALT             0
 #define GND_PRES            101325
 
@@ -48,9 +52,10 @@ extern "C" {
 #define CONFIG_PRESSURE_SENSOR_DEFAULT_TEMPERATURE_OVERSAMPLING  UINT8_C(0x02)
 #define CONFIG_PRESSURE_SENSOR_DEFAULT_IIR_FILTER_COEFF          UINT8_C(0x04)
 
-static QueueHandle_t s_queue;
+SPSC_RING( pressure_sample, PressureSensorData, PRESSURE_SENSOR_RING_LENGTH )
+
+static pressure_sample_ring s_ring;
 static xTaskHandle handle;
-static uint8_t dataNeedsToBeConverted = 0;
 static uint8_t s_desired_processing_data_rate = 50;
 static bool s_is_running = false;
 static const struct pressure_sensor_configuration s_default_configuration = {
@@ -84,13 +89,7 @@ int pressure_sensor_init( FlightSystemConfiguration * parameters )
         return PRESS_SENSOR_ERR;
     }
 
-    s_queue = xQueueCreate( 10, sizeof( PressureSensorData ) );
-    if ( s_queue == NULL )
-    {
-        return PRESS_SENSOR_ERR;
-    }
-
-    vQueueAddToRegistry( s_queue, "bmp3_queue" );
+    pressure_sample_ring_reset( &s_ring );
 
     return PRESS_SENSOR_OK;
 }
@@ -99,12 +98,6 @@ int pressure_sensor_init( FlightSystemConfiguration * parameters )
 
 void prv_pressure_sensor_start( void * pvParameters )
 {
-    if(pvParameters != NULL)
-    {
-        FlightSystemConfiguration * systemConfiguration = ( FlightSystemConfiguration * ) pvParameters;
-        dataNeedsToBeConverted = systemConfiguration->pressure_data_needs_to_be_converted;
-    }
-
     bool result_flag;
     press_data cxx_press_data;
     /* Variable used to store the compensated data */
@@ -114,32 +107,44 @@ void prv_pressure_sensor_start( void * pvParameters )
     s_is_running = true;
     DEBUG_LINE("Pressure sensor task has been successfully started.");
 
+    BoardMillisecondClock clock;
+    board_ms_clock_start( &clock );
+    if ( 0 != data_ready_attach( DATAFEEDER_PRESS_DATA_READY, handle ) )
+    {
+        board_error_handler( __FILE__, __LINE__ );
+    }
+
     while ( s_is_running )
     {
-        result_flag = datafeeder_get_press ( &cxx_press_data );
-        if ( ! result_flag )
+        // asleep until the feeder has a measurement, as the board sleeps until the interrupt of the sensor
+        if ( 0 == ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( DATA_READY_TIMEOUT_MS ) ) )
         {
             continue;
         }
 
-        dataStruct.pressure     = cxx_press_data.pressure;
-        dataStruct.temperature  = cxx_press_data.temperature;
-        dataStruct.timestamp    = cxx_press_data.timestamp;
-
-//        dataStruct.time_ticks   = xTaskGetTickCount() - time_start;
-
-//        DISPLAY( "NEW PRESS data: %d\n", dataStruct.time_ticks);
-
-        if(dataNeedsToBeConverted)
+        // the edges of a tick come together, so whatever is queued is taken
+        while ( ( result_flag = datafeeder_get_press ( &cxx_press_data ) ) )
         {
-            dataStruct.pressure = (dataStruct.pressure / 100);
-        }
+#if (userconf_USE_COTS_DATA == 1)
+            // Pa and deg C in the recording, the sensor gives hundredths of them
+            dataStruct.pressure     = ( int32_t ) ( cxx_press_data.pressure / PRESSURE_SENSOR_PASCAL_PER_COUNT );
+            dataStruct.temperature  = ( int32_t ) lroundf( cxx_press_data.temperature / PRESSURE_SENSOR_CELSIUS_PER_COUNT );
+#else
+            dataStruct.pressure     = ( int32_t ) cxx_press_data.pressure;
+            dataStruct.temperature  = ( int32_t ) cxx_press_data.temperature;
+#endif
+            // in ms, from the time of the data ready rather than of the read
+            dataStruct.timestamp    = board_ms_clock_update( &clock, data_ready_get_timestamp( DATAFEEDER_PRESS_DATA_READY ) );
 
-        pressure_sensor_add_measurement( &dataStruct );
-        memset(&dataStruct, 0, sizeof(PressureSensorData));
+            pressure_sensor_add_measurement( &dataStruct );
+            memset(&dataStruct, 0, sizeof(PressureSensorData));
+        }
     }
 
+    data_ready_detach( DATAFEEDER_PRESS_DATA_READY );
+
     DEBUG_LINE("Pressure sensor task has successfully exited.");
+    vTaskDelete( NULL );
 }
 
 bool pressure_sensor_is_running     ()
@@ -203,13 +208,13 @@ bool pressure_sensor_test ( void )
 
 bool pressure_sensor_read ( PressureSensorData * buffer )
 {
-    return pdPASS == xQueueReceive ( s_queue, buffer, 0 );
+    return pressure_sample_ring_pop ( &s_ring, buffer );
 }
 
 
 bool pressure_sensor_add_measurement ( PressureSensorData * _data )
 {
-    return pdTRUE == xQueueSend ( s_queue, _data, 0 );
+    return pressure_sample_ring_push ( &s_ring, _data );
 }
 
 int pressure_sensor_configure (PressureSensorConfiguration * parameters )
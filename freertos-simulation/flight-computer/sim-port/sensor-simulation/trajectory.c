@@ -0,0 +1,392 @@
+#include "trajectory.h"
+
+#include <math.h>
+#include <string.h>
+
+#define GRAVITY                 9.80665     // [m/s^2]
+#define SEA_LEVEL_PRESSURE      101325.0    // [Pa]
+#define SEA_LEVEL_TEMPERATURE   288.15      // [K]
+#define TEMPERATURE_LAPSE_RATE  -0.0065     // [K/m]
+#define GAS_CONSTANT            8.31432     // [J/(mol K)]
+#define AIR_MOLAR_MASS          0.0289644   // [kg/mol]
+
+// the flight is integrated in steps of at most this long, whatever the sensor rates are
+#define MAX_INTEGRATION_STEP    0.001       // [s]
+
+// the rocket sways under the parachutes, otherwise nothing would tell a descent from a landing to the gyroscope
+#define DROGUE_SWAY_AMPLITUDE   10.0        // [deg]
+#define MAIN_SWAY_AMPLITUDE     5.0         // [deg]
+#define SWAY_FREQUENCY          0.5         // [Hz]
+
+#define DEG_TO_RAD              ( M_PI / 180.0 )
+#define RAD_TO_DEG              ( 180.0 / M_PI )
+
+
+// roughly a 6000 N s L/M class motor
+static const TrajectoryThrustPoint prvDefaultThrustCurve [ ] =
+{
+    { 0.00f,    0.0f },
+    { 0.05f, 2600.0f },
+    { 0.50f, 2400.0f },
+    { 1.50f, 2200.0f },
+    { 2.50f, 1900.0f },
+    { 2.90f,  600.0f },
+    { 3.10f,    0.0f },
+};
+
+static const char * prvPhaseNames [ ] =
+{
+    [ TRAJECTORY_PHASE_PAD      ] = "pad",
+    [ TRAJECTORY_PHASE_ASCENT   ] = "ascent",
+    [ TRAJECTORY_PHASE_DROGUE   ] = "drogue",
+    [ TRAJECTORY_PHASE_MAIN     ] = "main",
+    [ TRAJECTORY_PHASE_LANDED   ] = "landed",
+    [ TRAJECTORY_PHASE_FINISHED ] = "finished",
+};
+
+
+static void   prvStep            ( Trajectory * trajectory, double dt );
+static double prvThrust          ( const TrajectoryConfiguration * configuration, double time );
+static double prvTemperatureAt   ( double altitude );
+static double prvPressureAt      ( double altitude );
+static double prvGaussian        ( Trajectory * trajectory );
+
+
+void trajectory_get_default_configuration ( TrajectoryConfiguration * configuration )
+{
+    memset ( configuration, 0, sizeof ( TrajectoryConfiguration ) );
+
+    configuration->dry_mass             = 15.0f;
+    configuration->propellant_mass      = 3.5f;
+    configuration->drag_coefficient     = 0.5f;
+    configuration->reference_area       = 0.0154f;  // 140 mm airframe
+    configuration->drogue_drag_area     = 0.45f;    // ~25 m/s
+    configuration->main_drag_area       = 6.5f;     // ~6 m/s
+    configuration->main_deploy_altitude = 381.0f;   // 1250 ft
+
+    configuration->thrust_curve         = prvDefaultThrustCurve;
+    configuration->thrust_curve_length  = sizeof ( prvDefaultThrustCurve ) / sizeof ( prvDefaultThrustCurve[ 0 ] );
+
+    configuration->launch_angle         = 4.0f;
+    configuration->rail_length          = 5.0f;
+    configuration->launch_altitude      = 1420.0f;
+    configuration->pad_time             = 10.0f;
+    configuration->landed_time          = 10.0f;
+
+    configuration->imu_rate             = 1000;
+    configuration->pressure_rate        = 100;
+    configuration->acc_noise            = 0.02f;
+    configuration->acc_bias             = 0.0f;
+    configuration->gyro_noise           = 0.5f;
+    configuration->gyro_bias            = 0.0f;
+    configuration->pressure_noise       = 8.0f;
+    configuration->pressure_bias        = 0.0f;
+    configuration->seed                 = 1;
+
+    configuration->time_scale           = 1.0f;
+}
+
+
+void trajectory_init ( Trajectory * trajectory, const TrajectoryConfiguration * configuration )
+{
+    memset ( trajectory, 0, sizeof ( Trajectory ) );
+
+    trajectory->configuration = *configuration;
+    trajectory->phase         = TRAJECTORY_PHASE_PAD;
+    trajectory->mass          = configuration->dry_mass + configuration->propellant_mass;
+    trajectory->pitch         = configuration->launch_angle * DEG_TO_RAD;
+
+    // the rocket sits on the pad: the accelerometers feel the ground holding it up
+    trajectory->specific_force[ 0 ] = 0;
+    trajectory->specific_force[ 1 ] = GRAVITY;
+
+    for ( size_t i = 1; i < configuration->thrust_curve_length; i++ )
+    {
+        const TrajectoryThrustPoint * a = &configuration->thrust_curve[ i - 1 ];
+        const TrajectoryThrustPoint * b = &configuration->thrust_curve[ i ];
+        trajectory->total_impulse += 0.5 * ( a->thrust + b->thrust ) * ( b->time - a->time );
+    }
+
+    trajectory->next_imu      = configuration->imu_rate      ? 0 : INFINITY;
+    trajectory->next_pressure = configuration->pressure_rate ? 0 : INFINITY;
+
+    // splitmix64 of the seed, a xorshift state must not be 0
+    uint64_t z = ( uint64_t ) configuration->seed + 0x9E3779B97F4A7C15ull;
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+    trajectory->random = ( z ^ ( z >> 31 ) ) | 1;
+}
+
+
+bool trajectory_next_sample ( Trajectory * trajectory, TrajectorySample * sample )
+{
+    const TrajectoryConfiguration * configuration = &trajectory->configuration;
+
+    if ( trajectory->phase == TRAJECTORY_PHASE_FINISHED )
+    {
+        return false;
+    }
+
+    double target = fmin ( trajectory->next_imu, trajectory->next_pressure );
+    if ( isinf ( target ) )
+    {
+        return false;
+    }
+
+    while ( target - trajectory->time > 1e-9 && trajectory->phase != TRAJECTORY_PHASE_FINISHED )
+    {
+        double dt = fmin ( MAX_INTEGRATION_STEP, target - trajectory->time );
+        prvStep ( trajectory, dt );
+        trajectory->time += dt;
+    }
+    trajectory->time = target;
+
+    memset ( sample, 0, sizeof ( TrajectorySample ) );
+    sample->time              = ( float ) trajectory->time;
+    sample->altitude          = ( float ) trajectory->z;
+    sample->vertical_velocity = ( float ) trajectory->vz;
+    sample->phase             = trajectory->phase;
+
+    if ( trajectory->next_imu - trajectory->time <= 1e-9 )
+    {
+        trajectory->next_imu += 1.0 / configuration->imu_rate;
+        sample->imu_updated = true;
+
+        // specific force into the body frame: x along the rocket axis, y across it in the plane of the flight
+        double sin_pitch = sin ( trajectory->pitch );
+        double cos_pitch = cos ( trajectory->pitch );
+        double axial     = trajectory->specific_force[ 0 ] * sin_pitch + trajectory->specific_force[ 1 ] * cos_pitch;
+        double normal    = trajectory->specific_force[ 0 ] * cos_pitch - trajectory->specific_force[ 1 ] * sin_pitch;
+
+        sample->acc[ 0 ]  = ( float ) ( axial  / GRAVITY + configuration->acc_bias + configuration->acc_noise * prvGaussian ( trajectory ) );
+        sample->acc[ 1 ]  = ( float ) ( normal / GRAVITY + configuration->acc_bias + configuration->acc_noise * prvGaussian ( trajectory ) );
+        sample->acc[ 2 ]  = ( float ) (                    configuration->acc_bias + configuration->acc_noise * prvGaussian ( trajectory ) );
+
+        sample->gyro[ 0 ] = ( float ) (                                        configuration->gyro_bias + configuration->gyro_noise * prvGaussian ( trajectory ) );
+        sample->gyro[ 1 ] = ( float ) ( trajectory->pitch_rate * RAD_TO_DEG + configuration->gyro_bias + configuration->gyro_noise * prvGaussian ( trajectory ) );
+        sample->gyro[ 2 ] = ( float ) (                                        configuration->gyro_bias + configuration->gyro_noise * prvGaussian ( trajectory ) );
+    }
+
+    if ( trajectory->next_pressure - trajectory->time <= 1e-9 )
+    {
+        trajectory->next_pressure += 1.0 / configuration->pressure_rate;
+        sample->pressure_updated = true;
+
+        double altitude = configuration->launch_altitude + trajectory->z;
+        sample->pressure    = ( float ) ( prvPressureAt ( altitude ) + configuration->pressure_bias + configuration->pressure_noise * prvGaussian ( trajectory ) );
+        sample->temperature = ( float ) ( prvTemperatureAt ( altitude ) - 273.15 );
+    }
+
+    return true;
+}
+
+
+const char * trajectory_phase_name ( TrajectoryPhase phase )
+{
+    if ( phase > TRAJECTORY_PHASE_FINISHED )
+    {
+        return "unknown";
+    }
+
+    return prvPhaseNames[ phase ];
+}
+
+
+static void prvStep ( Trajectory * trajectory, double dt )
+{
+    const TrajectoryConfiguration * configuration = &trajectory->configuration;
+
+    switch ( trajectory->phase )
+    {
+        case TRAJECTORY_PHASE_PAD:
+        {
+            if ( trajectory->time >= configuration->pad_time )
+            {
+                trajectory->phase         = TRAJECTORY_PHASE_ASCENT;
+                trajectory->ignition_time = trajectory->time;
+            }
+
+            return;
+        }
+
+        case TRAJECTORY_PHASE_LANDED:
+        {
+            if ( trajectory->time - trajectory->touchdown_time >= configuration->landed_time )
+            {
+                trajectory->phase = TRAJECTORY_PHASE_FINISHED;
+            }
+
+            return;
+        }
+
+        case TRAJECTORY_PHASE_FINISHED:
+            return;
+
+        default:
+            break;
+    }
+
+    TrajectoryPhase phase     = trajectory->phase;
+    double          burn_time = trajectory->time - trajectory->ignition_time;
+    double          thrust    = phase == TRAJECTORY_PHASE_ASCENT ? prvThrust ( configuration, burn_time ) : 0;
+
+    double altitude  = configuration->launch_altitude + trajectory->z;
+    double density   = prvPressureAt ( altitude ) * AIR_MOLAR_MASS / ( GAS_CONSTANT * prvTemperatureAt ( altitude ) );
+    double speed     = hypot ( trajectory->vx, trajectory->vz );
+
+    double drag_area = configuration->drag_coefficient * configuration->reference_area;
+    if ( trajectory->phase == TRAJECTORY_PHASE_DROGUE || trajectory->phase == TRAJECTORY_PHASE_MAIN )
+    {
+        drag_area += configuration->drogue_drag_area;
+    }
+    if ( trajectory->phase == TRAJECTORY_PHASE_MAIN )
+    {
+        drag_area += configuration->main_drag_area;
+    }
+
+    // the thrust is along the rocket axis, the drag against the velocity
+    double axis_x = sin ( trajectory->pitch );
+    double axis_z = cos ( trajectory->pitch );
+    double drag   = 0.5 * density * speed * drag_area;
+    double force_x = thrust * axis_x - drag * trajectory->vx;
+    double force_z = thrust * axis_z - drag * trajectory->vz;
+
+    if ( trajectory->total_impulse > 0 && thrust > 0 )
+    {
+        trajectory->delivered_impulse += thrust * dt;
+        double burnt = fmin ( 1.0, trajectory->delivered_impulse / trajectory->total_impulse );
+        trajectory->mass = configuration->dry_mass + configuration->propellant_mass * ( 1.0 - burnt );
+    }
+
+    double ax = force_x / trajectory->mass;
+    double az = force_z / trajectory->mass - GRAVITY;
+
+    // on the rail the rocket can only move along it, and not below where it stands
+    bool on_rail = trajectory->phase == TRAJECTORY_PHASE_ASCENT && hypot ( trajectory->x, trajectory->z ) < configuration->rail_length;
+    if ( on_rail )
+    {
+        double along = ax * axis_x + az * axis_z;
+        if ( along < 0 && speed == 0 )
+        {
+            along = 0;
+        }
+
+        ax = along * axis_x;
+        az = along * axis_z;
+    }
+
+    // what the accelerometers feel is everything but the gravity
+    trajectory->specific_force[ 0 ] = ax;
+    trajectory->specific_force[ 1 ] = az + GRAVITY;
+
+    trajectory->vx += ax * dt;
+    trajectory->vz += az * dt;
+    trajectory->x  += trajectory->vx * dt;
+    trajectory->z  += trajectory->vz * dt;
+
+    double pitch = trajectory->pitch;
+    switch ( trajectory->phase )
+    {
+        case TRAJECTORY_PHASE_ASCENT:
+        {
+            // off the rail the rocket weathercocks into the relative wind
+            if ( ! on_rail && speed > 1.0 )
+            {
+                pitch = atan2 ( trajectory->vx, trajectory->vz );
+            }
+
+            bool burnt_out = thrust == 0 && burn_time > 0;
+            if ( burnt_out && trajectory->vz <= 0 )
+            {
+                trajectory->phase = TRAJECTORY_PHASE_DROGUE;
+            }
+            break;
+        }
+
+        case TRAJECTORY_PHASE_DROGUE:
+        {
+            pitch = DROGUE_SWAY_AMPLITUDE * DEG_TO_RAD * sin ( 2 * M_PI * SWAY_FREQUENCY * trajectory->time );
+            if ( trajectory->z <= configuration->main_deploy_altitude )
+            {
+                trajectory->phase = TRAJECTORY_PHASE_MAIN;
+            }
+            break;
+        }
+
+        case TRAJECTORY_PHASE_MAIN:
+        {
+            pitch = MAIN_SWAY_AMPLITUDE * DEG_TO_RAD * sin ( 2 * M_PI * SWAY_FREQUENCY * trajectory->time );
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    // the swing into the parachute at a deployment is left out, the gyroscope only feels the turn and the sway
+    trajectory->pitch_rate = phase == trajectory->phase ? ( pitch - trajectory->pitch ) / dt : 0;
+    trajectory->pitch      = pitch;
+
+    if ( trajectory->z <= 0 && trajectory->vz < 0 )
+    {
+        trajectory->phase          = TRAJECTORY_PHASE_LANDED;
+        trajectory->touchdown_time = trajectory->time;
+
+        trajectory->z     = 0;
+        trajectory->vx    = 0;
+        trajectory->vz    = 0;
+        trajectory->pitch_rate = 0;
+
+        trajectory->specific_force[ 0 ] = 0;
+        trajectory->specific_force[ 1 ] = GRAVITY;
+    }
+}
+
+
+static double prvThrust ( const TrajectoryConfiguration * configuration, double time )
+{
+    const TrajectoryThrustPoint * curve = configuration->thrust_curve;
+
+    for ( size_t i = 1; i < configuration->thrust_curve_length; i++ )
+    {
+        if ( time <= curve[ i ].time )
+        {
+            double fraction = ( time - curve[ i - 1 ].time ) / ( curve[ i ].time - curve[ i - 1 ].time );
+            return curve[ i - 1 ].thrust + fraction * ( curve[ i ].thrust - curve[ i - 1 ].thrust );
+        }
+    }
+
+    return 0;
+}
+
+
+static double prvTemperatureAt ( double altitude )
+{
+    return SEA_LEVEL_TEMPERATURE + TEMPERATURE_LAPSE_RATE * altitude;
+}
+
+
+static double prvPressureAt ( double altitude )
+{
+    // the inverse of the barometric formula the event detector uses
+    return SEA_LEVEL_PRESSURE * pow ( prvTemperatureAt ( altitude ) / SEA_LEVEL_TEMPERATURE,
+                                      -GRAVITY * AIR_MOLAR_MASS / ( GAS_CONSTANT * TEMPERATURE_LAPSE_RATE ) );
+}
+
+
+static double prvGaussian ( Trajectory * trajectory )
+{
+    double u [ 2 ];
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        // xorshift64*
+        trajectory->random ^= trajectory->random >> 12;
+        trajectory->random ^= trajectory->random << 25;
+        trajectory->random ^= trajectory->random >> 27;
+        u[ i ] = ( ( trajectory->random * 0x2545F4914F6CDD1Dull ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+    }
+
+    // Box-Muller, one of the pair is enough
+    return sqrt ( -2.0 * log ( u[ 0 ] + 1e-300 ) ) * cos ( 2 * M_PI * u[ 1 ] );
+}
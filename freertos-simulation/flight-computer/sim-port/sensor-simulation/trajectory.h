@@ -0,0 +1,133 @@
+#ifndef __TRAJECTORY_H
+#define __TRAJECTORY_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Synthetic flights for the simulator. A 3DOF model (downrange, altitude and pitch) of a single stage rocket: a thrust
+// curve, a mass that burns down with the delivered impulse, drag in the standard atmosphere, a drogue at apogee and a
+// main parachute at a set altitude. The sensors sample it at any rate, with their own noise and bias, so the rest of
+// the flight computer can be fed well beyond the rates of the recorded flights.
+
+typedef struct
+{
+    float time;                         // [s] since ignition
+    float thrust;                       // [N]
+
+} TrajectoryThrustPoint;
+
+typedef struct TrajectoryConfiguration
+{
+    // vehicle
+    float dry_mass;                     // [kg]
+    float propellant_mass;              // [kg]
+    float drag_coefficient;
+    float reference_area;               // [m^2]
+    float drogue_drag_area;             // Cd * A of the drogue [m^2]
+    float main_drag_area;               // Cd * A of the main parachute [m^2]
+    float main_deploy_altitude;         // [m] above the ground
+
+    // thrust curve, linearly interpolated, no thrust past the last point
+    const TrajectoryThrustPoint * thrust_curve;
+    size_t                        thrust_curve_length;
+
+    // launch site
+    float launch_angle;                 // [deg] off the vertical
+    float rail_length;                  // [m]
+    float launch_altitude;              // [m] above the sea level
+    float pad_time;                     // [s] on the pad before the ignition
+    float landed_time;                  // [s] of data after the touchdown
+
+    // sensors
+    uint32_t imu_rate;                  // [Hz]
+    uint32_t pressure_rate;             // [Hz]
+    float    acc_noise;                 // standard deviation [g]
+    float    acc_bias;                  // [g]
+    float    gyro_noise;                // standard deviation [deg/s]
+    float    gyro_bias;                 // [deg/s]
+    float    pressure_noise;            // standard deviation [Pa]
+    float    pressure_bias;             // [Pa]
+    uint32_t seed;
+
+    // simulated seconds per second of wall time, 0 feeds the samples as fast as they can be generated
+    float    time_scale;
+
+} TrajectoryConfiguration;
+
+// the events of the flight as they really happened, to compare the detections against
+typedef enum
+{
+    TRAJECTORY_PHASE_PAD = 0,
+    TRAJECTORY_PHASE_ASCENT,
+    TRAJECTORY_PHASE_DROGUE,
+    TRAJECTORY_PHASE_MAIN,
+    TRAJECTORY_PHASE_LANDED,
+    TRAJECTORY_PHASE_FINISHED,
+
+} TrajectoryPhase;
+
+typedef struct
+{
+    float time;                         // [s] since the start of the simulation
+    bool  imu_updated;
+    bool  pressure_updated;
+
+    float acc [ 3 ];                    // [g] body frame, x along the rocket axis
+    float gyro [ 3 ];                   // [deg/s]
+    float pressure;                     // [Pa]
+    float temperature;                  // [C]
+
+    // truth
+    float           altitude;           // [m] above the ground
+    float           vertical_velocity;  // [m/s]
+    TrajectoryPhase phase;
+
+} TrajectorySample;
+
+typedef struct Trajectory
+{
+    TrajectoryConfiguration configuration;
+
+    TrajectoryPhase phase;
+    double          time;               // [s] since the start of the simulation
+    double          ignition_time;
+    double          touchdown_time;
+    double          step;               // [s] of the integration
+
+    double          x, z;               // [m] downrange and above the ground
+    double          vx, vz;             // [m/s]
+    double          pitch;              // [rad] off the vertical
+    double          pitch_rate;         // [rad/s]
+    double          mass;               // [kg]
+    double          total_impulse;      // [N s]
+    double          delivered_impulse;  // [N s]
+    double          specific_force [ 2 ];
+
+    double          next_imu;
+    double          next_pressure;
+
+    uint64_t        random;
+
+} Trajectory;
+
+
+// a rocket close to the recorded COTS flight, IMU at 1 kHz and barometer at 100 Hz
+void trajectory_get_default_configuration ( TrajectoryConfiguration * configuration );
+
+void trajectory_init ( Trajectory * trajectory, const TrajectoryConfiguration * configuration );
+
+// advances the flight up to the next sensor sample; false once the flight is over
+bool trajectory_next_sample ( Trajectory * trajectory, TrajectorySample * sample );
+
+const char * trajectory_phase_name ( TrajectoryPhase phase );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TRAJECTORY_H
@@ -0,0 +1,29 @@
+#ifndef AVIONICS_TEST_H
+#define AVIONICS_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+// The host tests count their failed expectations and carry on, test_report ( ) gives the exit status ctest looks at.
+
+static int test_failures = 0;
+
+#define TEST_EXPECT( condition )                                                            \
+    do                                                                                      \
+    {                                                                                       \
+        if ( ! ( condition ) )                                                              \
+        {                                                                                   \
+            fprintf ( stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition );     \
+            test_failures++;                                                                \
+        }                                                                                   \
+    } while ( 0 )
+
+static inline int test_report ( const char * name )
+{
+    printf ( "%s: %s\n", name, test_failures == 0 ? "OK" : "FAILED" );
+    return test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+#endif //AVIONICS_TEST_H
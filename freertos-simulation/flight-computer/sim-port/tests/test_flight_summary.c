@@ -0,0 +1,122 @@
+// The sensor channels of the flight summary, on the host.
+//
+// Known records go through flight_summary_update_channel ( ): the IMU ones as their int16 counts on every axis, the
+// pressure and the temperature ones as their int32 counts, and every channel has to keep their exact extremes. The
+// sectors without summary axes in MEMORY_USER_DATA_SECTORS have no channel.
+
+#include <string.h>
+
+#include "memory-management/flight_summary.h"
+
+#include "test.h"
+
+
+static void prvFeedIMU ( MemoryFlightSummaryU * summary, UserDataSector sector, int16_t x, int16_t y, int16_t z )
+{
+    IMUDataU record = { 0 };
+
+    record.values.timestamp = 1000;
+    record.values.data[ 0 ] = x;
+    record.values.data[ 1 ] = y;
+    record.values.data[ 2 ] = z;
+
+    flight_summary_update_channel ( summary, sector, record.bytes );
+}
+
+static void prvFeedPressure ( MemoryFlightSummaryU * summary, UserDataSector sector, int32_t value )
+{
+    PressureDataU record = { 0 };
+
+    record.values.timestamp = 1000;
+    record.values.data      = value;
+
+    flight_summary_update_channel ( summary, sector, record.bytes );
+}
+
+static void prvExpectChannel ( const MemoryFlightSummaryU * summary, UserDataSector sector, size_t axis, int32_t min, int32_t max )
+{
+    MemorySummaryChannel channel = { 0 };
+
+    TEST_EXPECT ( flight_summary_get_channel ( summary, sector, &channel ) );
+    TEST_EXPECT ( channel.min[ axis ] == min );
+    TEST_EXPECT ( channel.max[ axis ] == max );
+}
+
+static void prvTestEmpty ( void )
+{
+    MemoryFlightSummaryU summary;
+    flight_summary_reset ( &summary, 1, FLIGHT_STATE_LAUNCHPAD );
+
+    size_t channels = 0;
+    for ( UserDataSector sector = UserDataSectorGyro; sector < UserDataSectorCount; sector++ )
+    {
+        MemorySummaryChannel channel;
+        if ( flight_summary_get_channel ( &summary, sector, &channel ) )
+        {
+            TEST_EXPECT ( channel.min[ 0 ] > channel.max[ 0 ] );
+            channels++;
+        }
+    }
+
+    TEST_EXPECT ( channels == MEMORY_SUMMARY_CHANNEL_COUNT );
+    TEST_EXPECT ( flight_summary_channel_axes ( UserDataSectorGyro ) == 3 );
+    TEST_EXPECT ( flight_summary_channel_axes ( UserDataSectorTemperature ) == 1 );
+    TEST_EXPECT ( flight_summary_channel_axes ( UserDataSectorContinuity ) == 0 );
+    TEST_EXPECT ( flight_summary_channel_axes ( UserDataSectorFlightEvent ) == 0 );
+}
+
+static void prvTestIMU ( void )
+{
+    MemoryFlightSummaryU summary;
+    flight_summary_reset ( &summary, 1, FLIGHT_STATE_LAUNCHPAD );
+
+    prvFeedIMU ( &summary, UserDataSectorGyro, -5, 7, 300 );
+    prvFeedIMU ( &summary, UserDataSectorGyro, 10, -20, 5 );
+    prvFeedIMU ( &summary, UserDataSectorAccel, INT16_MIN, 0, INT16_MAX );
+
+    prvExpectChannel ( &summary, UserDataSectorGyro, 0, -5, 10 );
+    prvExpectChannel ( &summary, UserDataSectorGyro, 1, -20, 7 );
+    prvExpectChannel ( &summary, UserDataSectorGyro, 2, 5, 300 );
+
+    prvExpectChannel ( &summary, UserDataSectorAccel, 0, INT16_MIN, INT16_MIN );
+    prvExpectChannel ( &summary, UserDataSectorAccel, 1, 0, 0 );
+    prvExpectChannel ( &summary, UserDataSectorAccel, 2, INT16_MAX, INT16_MAX );
+
+    // fed to no other channel
+    MemorySummaryChannel mag;
+    TEST_EXPECT ( flight_summary_get_channel ( &summary, UserDataSectorMag, &mag ) );
+    TEST_EXPECT ( mag.min[ 0 ] > mag.max[ 0 ] );
+}
+
+static void prvTestPressure ( void )
+{
+    MemoryFlightSummaryU summary;
+    flight_summary_reset ( &summary, 1, FLIGHT_STATE_LAUNCHPAD );
+
+    prvFeedPressure ( &summary, UserDataSectorPressure, 101325 );
+    prvFeedPressure ( &summary, UserDataSectorPressure, 8540000 );
+    prvFeedPressure ( &summary, UserDataSectorTemperature, -1234 );
+
+    prvExpectChannel ( &summary, UserDataSectorPressure, 0, 101325, 8540000 );
+    prvExpectChannel ( &summary, UserDataSectorTemperature, 0, -1234, -1234 );
+
+    // the other axes of a single axis channel are left empty
+    MemorySummaryChannel pressure;
+    TEST_EXPECT ( flight_summary_get_channel ( &summary, UserDataSectorPressure, &pressure ) );
+    TEST_EXPECT ( pressure.min[ 1 ] > pressure.max[ 1 ] );
+
+    // the sectors without a channel are ignored
+    MemoryFlightSummaryU before = summary;
+    prvFeedPressure ( &summary, UserDataSectorContinuity, 42 );
+    TEST_EXPECT ( memcmp ( before.bytes, summary.bytes, sizeof ( MemoryFlightSummaryU ) ) == 0 );
+    TEST_EXPECT ( ! flight_summary_get_channel ( &summary, UserDataSectorContinuity, &pressure ) );
+}
+
+int main ( void )
+{
+    prvTestEmpty ( );
+    prvTestIMU ( );
+    prvTestPressure ( );
+
+    return test_report ( "flight summary" );
+}
@@ -0,0 +1,138 @@
+// Session directory across restarts, on the sim flash backend.
+//
+// A session is opened by memory_manager_start ( ) and closed by memory_manager_stop ( ), the next power-on must find it
+// closed with its summary programmed. memory_manager_erase_data_section ( ) leaves no session behind. The restart is reproduced by running memory_manager_init ( ) once more over the
+// same flash file, in a scratch directory that is removed at the end.
+
+// Builds memory_manager.c once more for the test, so that its state can be reset like on a power-on
+#include "memory-management/memory_manager.c"
+
+#include <unistd.h>
+
+#include "test.h"
+
+
+static char prvDirectory [ ] = "/tmp/test_memory_session_XXXXXX";
+
+
+// the test does not configure the system, memory_manager.c only needs this to link
+FlightSystemConfiguration get_default_system_configuration ( )
+{
+    FlightSystemConfiguration configuration = { 0 };
+    return configuration;
+}
+
+void vAssertCalled ( unsigned long ulLine, const char * const pcFileName )
+{
+    fprintf ( stderr, "assertion failed: %s:%lu\n", pcFileName, ulLine );
+    abort ( );
+}
+
+void vApplicationMallocFailedHook ( void )
+{
+    vAssertCalled ( __LINE__, __FILE__ );
+}
+
+void vApplicationIdleHook ( void )
+{
+    vPortIdleSleep ( );
+}
+
+void vApplicationGetIdleTaskMemory ( StaticTask_t ** ppxIdleTaskTCBBuffer, StackType_t ** ppxIdleTaskStackBuffer, uint32_t * pulIdleTaskStackSize )
+{
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t  uxIdleTaskStack [ configMINIMAL_STACK_SIZE ];
+
+    *ppxIdleTaskTCBBuffer   = &xIdleTaskTCB;
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+    *pulIdleTaskStackSize   = configMINIMAL_STACK_SIZE;
+}
+
+
+// what a power-on finds in RAM: nothing but what memory_manager_init ( ) reads back from the flash memory
+static void prvPowerCycle ( void )
+{
+    prvIsInitialized  = false;
+    prvSessionCurrent = MEMORY_SESSION_ALL;
+    memset ( prvSessionCurrentEntry.bytes, 0, sizeof ( MemorySessionU ) );
+}
+
+static bool prvSessionIsClosed ( uint32_t session )
+{
+    MemorySessionU entry;
+    return memory_manager_get_session ( session, &entry ) == MEM_OK && entry.values.summary.closed == 1;
+}
+
+static void prvTestTask ( void * arg )
+{
+    ( void ) arg;
+
+    TEST_EXPECT ( flash_init ( ) == FLASH_OK );
+
+    // first flight
+    TEST_EXPECT ( memory_manager_init ( ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_stop ( ) == MEM_ERR );
+    TEST_EXPECT ( memory_manager_start ( NULL ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_start ( NULL ) == MEM_ERR );
+    TEST_EXPECT ( memory_manager_stop ( ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_stop ( ) == MEM_ERR );
+
+    TEST_EXPECT ( memory_manager_get_session_count ( ) == 1 );
+    TEST_EXPECT ( prvSessionIsClosed ( 0 ) );
+
+    // second flight, after a power-on
+    prvPowerCycle ( );
+    TEST_EXPECT ( memory_manager_init ( ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_get_session_count ( ) == 1 );
+    TEST_EXPECT ( prvSessionIsClosed ( 0 ) );
+
+    TEST_EXPECT ( memory_manager_start ( NULL ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_get_session_count ( ) == 2 );
+    TEST_EXPECT ( prvSessionIsClosed ( 0 ) );
+    TEST_EXPECT ( ! prvSessionIsClosed ( 1 ) );
+    TEST_EXPECT ( memory_manager_stop ( ) == MEM_OK );
+
+    // and the one after it
+    prvPowerCycle ( );
+    TEST_EXPECT ( memory_manager_init ( ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_get_session_count ( ) == 2 );
+    TEST_EXPECT ( prvSessionIsClosed ( 0 ) );
+    TEST_EXPECT ( prvSessionIsClosed ( 1 ) );
+
+    // erasing the data section forgets the sessions, not only until the next power-on
+    TEST_EXPECT ( memory_manager_start ( NULL ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_erase_data_section ( ) == MEM_ERR );
+    TEST_EXPECT ( memory_manager_stop ( ) == MEM_OK );
+
+    TEST_EXPECT ( memory_manager_erase_data_section ( ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_get_session_count ( ) == 0 );
+
+    prvPowerCycle ( );
+    TEST_EXPECT ( memory_manager_init ( ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_get_session_count ( ) == 0 );
+
+    TEST_EXPECT ( memory_manager_start ( NULL ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_stop ( ) == MEM_OK );
+    TEST_EXPECT ( memory_manager_get_session_count ( ) == 1 );
+    TEST_EXPECT ( prvSessionIsClosed ( 0 ) );
+
+    unlink ( "myFlash.bin" );
+    rmdir ( prvDirectory );
+
+    exit ( test_report ( "memory session" ) );
+}
+
+int main ( void )
+{
+    // the sim flash memory is a file in the working directory
+    if ( mkdtemp ( prvDirectory ) == NULL || chdir ( prvDirectory ) != 0 )
+    {
+        perror ( "scratch directory" );
+        return EXIT_FAILURE;
+    }
+
+    xTaskCreate ( prvTestTask, "test", configMINIMAL_STACK_SIZE * 4, NULL, 1, NULL );
+    vTaskStartScheduler ( );
+
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,183 @@
+// The lock-free ring of utilities/spsc_ring.h, on the host.
+//
+// Empty and full rings, the wrap around of the items and of the free running indices, then a producer and a consumer
+// thread passing a sequence through a small ring: every item has to come out once and in order.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#include "utilities/spsc_ring.h"
+
+#include "test.h"
+
+#define TEST_RING_LENGTH        8
+#define TEST_THREADED_ITEMS     2000000
+
+SPSC_RING( test, uint32_t, TEST_RING_LENGTH )
+
+static test_ring prvRing;
+
+
+static void prvTestEmpty ( void )
+{
+    uint32_t item  = 0;
+    uint32_t batch [ TEST_RING_LENGTH ];
+
+    test_ring_reset ( &prvRing );
+
+    TEST_EXPECT ( test_ring_count ( &prvRing ) == 0 );
+    TEST_EXPECT ( test_ring_peek ( &prvRing ) == NULL );
+    TEST_EXPECT ( ! test_ring_pop ( &prvRing, &item ) );
+    TEST_EXPECT ( test_ring_pop_batch ( &prvRing, batch, TEST_RING_LENGTH ) == 0 );
+    TEST_EXPECT ( test_ring_reserve ( &prvRing ) != NULL );
+}
+
+static void prvTestFull ( void )
+{
+    test_ring_reset ( &prvRing );
+
+    // free running indices: the ring holds all of its length
+    for ( uint32_t i = 0; i < TEST_RING_LENGTH; i++ )
+    {
+        TEST_EXPECT ( test_ring_push ( &prvRing, &i ) );
+    }
+
+    uint32_t item = 0;
+    TEST_EXPECT ( test_ring_count ( &prvRing ) == TEST_RING_LENGTH );
+    TEST_EXPECT ( test_ring_reserve ( &prvRing ) == NULL );
+    TEST_EXPECT ( ! test_ring_push ( &prvRing, &item ) );
+
+    // one out makes room for one in
+    TEST_EXPECT ( test_ring_pop ( &prvRing, &item ) && item == 0 );
+    TEST_EXPECT ( test_ring_reserve ( &prvRing ) != NULL );
+    TEST_EXPECT ( test_ring_push ( &prvRing, &item ) );
+    TEST_EXPECT ( test_ring_reserve ( &prvRing ) == NULL );
+}
+
+static void prvTestWrap ( uint32_t start )
+{
+    uint32_t next  = 0;
+    uint32_t taken = 0;
+    uint32_t batch [ TEST_RING_LENGTH ];
+
+    // both indices start wherever the caller wants them, e.g. right before they overflow
+    prvRing.head = start;
+    prvRing.tail = start;
+
+    // pushes and pops of uneven sizes, so the runs cross the end of the items over and over
+    for ( uint32_t round = 0; round < 4 * TEST_RING_LENGTH; round++ )
+    {
+        for ( uint32_t i = 0; i < round % TEST_RING_LENGTH + 1 && test_ring_push ( &prvRing, &next ); i++ )
+        {
+            next++;
+        }
+
+        uint32_t count = test_ring_pop_batch ( &prvRing, batch, round % 3 + 1 );
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            TEST_EXPECT ( batch [ i ] == taken + i );
+        }
+        taken += count;
+
+        uint32_t * item = test_ring_peek ( &prvRing );
+        if ( item != NULL )
+        {
+            TEST_EXPECT ( *item == taken );
+            test_ring_release ( &prvRing );
+            taken++;
+        }
+
+        TEST_EXPECT ( test_ring_count ( &prvRing ) == next - taken );
+    }
+
+    taken += test_ring_pop_batch ( &prvRing, batch, TEST_RING_LENGTH );
+    TEST_EXPECT ( taken == next );
+    TEST_EXPECT ( test_ring_count ( &prvRing ) == 0 );
+}
+
+
+static void * prvProducer ( void * arg )
+{
+    ( void ) arg;
+
+    for ( uint32_t next = 0; next < TEST_THREADED_ITEMS; )
+    {
+        // filled in place every other item, copied in the others
+        uint32_t * slot = next % 2 ? test_ring_reserve ( &prvRing ) : NULL;
+        if ( slot != NULL )
+        {
+            *slot = next++;
+            test_ring_commit ( &prvRing );
+        }
+        else if ( next % 2 == 0 && test_ring_push ( &prvRing, &next ) )
+        {
+            next++;
+        }
+        else
+        {
+            // full: on a single core the consumer only runs once the producer gives up the processor
+            sched_yield ( );
+        }
+    }
+
+    return NULL;
+}
+
+static void prvTestThreads ( void )
+{
+    uint32_t  expected  = 0;
+    uint32_t  misplaced = 0;
+    uint32_t  batch [ TEST_RING_LENGTH ];
+    pthread_t producer;
+
+    test_ring_reset ( &prvRing );
+
+    if ( pthread_create ( &producer, NULL, prvProducer, NULL ) != 0 )
+    {
+        TEST_EXPECT ( ! "the producer thread could not be started" );
+        return;
+    }
+
+    // taken one at a time and in batches, as the flight controller and the monitor do
+    while ( expected < TEST_THREADED_ITEMS )
+    {
+        uint32_t count = 0;
+        if ( expected % 3 == 0 )
+        {
+            count = test_ring_pop_batch ( &prvRing, batch, TEST_RING_LENGTH );
+        }
+        else
+        {
+            count = test_ring_pop ( &prvRing, batch ) ? 1 : 0;
+        }
+
+        for ( uint32_t i = 0; i < count; i++, expected++ )
+        {
+            misplaced += batch [ i ] != expected;
+        }
+
+        if ( count == 0 )
+        {
+            sched_yield ( );
+        }
+    }
+
+    pthread_join ( producer, NULL );
+
+    TEST_EXPECT ( misplaced == 0 );
+    TEST_EXPECT ( test_ring_count ( &prvRing ) == 0 );
+}
+
+
+int main ( void )
+{
+    prvTestEmpty ( );
+    prvTestFull ( );
+    prvTestWrap ( 0 );
+    prvTestWrap ( 3 );
+    prvTestWrap ( UINT32_MAX - TEST_RING_LENGTH / 2 );
+    prvTestThreads ( );
+
+    return test_report ( "spsc ring" );
+}
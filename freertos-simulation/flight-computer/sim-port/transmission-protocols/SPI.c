@@ -17,6 +17,8 @@
 #include "board/hardware_definitions.h"
 #include "FreeRTOS.h"
 #include "portable.h"
+#include "task.h"
+#include "semphr.h"
 
 
 #define SPI1_CS_PIN     FLASH_SPI_CS_PIN
@@ -41,6 +43,42 @@ static SPI_HandleTypeDef hspi1 = {.Instance = NULL, .pRxBuffPtr = NULL, .pTxBuff
 static SPI_HandleTypeDef hspi2 = {.Instance = NULL, .pRxBuffPtr = NULL, .pTxBuffPtr = NULL,  .hdmarx = NULL,  .hdmatx = NULL, .ErrorCode = 0};
 static SPI_HandleTypeDef hspi3 = {.Instance = NULL, .pRxBuffPtr = NULL, .pTxBuffPtr = NULL,  .hdmarx = NULL,  .hdmatx = NULL, .ErrorCode = 0};
 
+// SCK of the board, 84MHz APB2 for SPI1 and 42MHz APB1 for SPI2/3, over the prescaler of 256
+#define SPI1_CLOCK_HZ   (84000000 / 256)
+#define SPI2_CLOCK_HZ   (42000000 / 256)
+#define SPI3_CLOCK_HZ   (42000000 / 256)
+
+// There is no wire here, the transfers take the time they would on the board so the tasks give the CPU away for as
+// long as the DMA would keep the bus. The time is counted in microseconds and slept in whole ticks, the rest is carried
+// over to the next transfer of the bus.
+typedef struct
+{
+    SPI_HandleTypeDef *hspi;
+    uint32_t clock;
+    SemaphoreHandle_t mutex;
+    uint8_t locked;
+    uint8_t selected;
+    uint8_t fast;
+    uint32_t pending_us;
+    uint32_t carry_us;
+} SPIBusState;
+
+static SPIBusState prvBuses[SPI_BUS_COUNT] = {
+        [SPI_BUS_1] = {.hspi = &hspi1, .clock = SPI1_CLOCK_HZ},
+        [SPI_BUS_2] = {.hspi = &hspi2, .clock = SPI2_CLOCK_HZ},
+        [SPI_BUS_3] = {.hspi = &hspi3, .clock = SPI3_CLOCK_HZ},
+};
+
+static int prv_spi_bus_init(SPIBus bus)
+{
+    if(prvBuses[bus].mutex == NULL)
+    {
+        prvBuses[bus].mutex = xSemaphoreCreateMutex();
+    }
+
+    return prvBuses[bus].mutex != NULL ? SPI_OK : SPI_ERR;
+}
+
 
 int spi1_init(void)
 {
@@ -95,7 +133,7 @@ int spi1_init(void)
     HAL_GPIO_Init(SPI1_CS_PORT, &GPIO_InitStruct);
     HAL_GPIO_WritePin(SPI1_CS_PORT, SPI1_CS_PIN, GPIO_PIN_SET);
 
-    return SPI_OK;
+    return prv_spi_bus_init(SPI_BUS_1);
 }
 int spi2_init(void)
 {
@@ -147,7 +185,7 @@ int spi2_init(void)
     
     HAL_GPIO_Init(SPI2_CS_PORT, &GPIO_InitStruct);
 
-    return SPI_OK;
+    return prv_spi_bus_init(SPI_BUS_2);
 }
 int spi3_init(void)
 {
@@ -205,9 +243,123 @@ int spi3_init(void)
     HAL_GPIO_WritePin(SPI3_CS1_PORT, SPI3_CS1_PIN, GPIO_PIN_SET);
     HAL_GPIO_WritePin(SPI3_CS2_PORT, SPI3_CS2_PIN, GPIO_PIN_SET);
 
+    return prv_spi_bus_init(SPI_BUS_3);
+}
+
+int spi_transfer_start(SPITransfer *transfer)
+{
+    if(transfer == NULL || transfer->bus >= SPI_BUS_COUNT)
+    {
+        return SPI_ERR;
+    }
+
+    SPIBusState *bus = &prvBuses[transfer->bus];
+    if(bus->hspi->Instance == NULL || bus->mutex == NULL)
+    {
+        return SPI_ERR;
+    }
+
+    const uint8_t scheduled = taskSCHEDULER_RUNNING == xTaskGetSchedulerState();
+    if(!bus->selected)
+    {
+        if(scheduled && pdTRUE != xSemaphoreTake(bus->mutex, portMAX_DELAY))
+        {
+            return SPI_ERR;
+        }
+
+        bus->locked = scheduled;
+        bus->fast = transfer->fast_clock && transfer->bus == SPI_BUS_1;
+    }
+
+    if(transfer->cmd_buffer_size > 0)
+    {
+        HAL_SPI_Transmit(bus->hspi, transfer->cmd_buffer, transfer->cmd_buffer_size, 0);
+    }
+    if(transfer->size > 0 && transfer->tx_buffer != NULL)
+    {
+        HAL_SPI_Transmit(bus->hspi, transfer->tx_buffer, transfer->size, 0);
+    }
+    else if(transfer->size > 0)
+    {
+        HAL_SPI_Receive(bus->hspi, transfer->rx_buffer, transfer->size, 0);
+    }
+
+    // the board polls the short ones, the time of those is not worth a context switch
+    const uint32_t bits = 8 * ((uint32_t) transfer->cmd_buffer_size + transfer->size);
+    if(scheduled && transfer->bus != SPI_BUS_2 && transfer->size >= SPI_DMA_MIN_SIZE)
+    {
+        bus->pending_us = (uint32_t) ((uint64_t) bits * 1000000 / (bus->fast ? SPI_FAST_CLOCK_HZ : bus->clock));
+        transfer->status = SPI_BUSY;
+    }
+    else
+    {
+        bus->pending_us = 0;
+        transfer->status = SPI_OK;
+    }
+
     return SPI_OK;
 }
 
+int spi_transfer_wait(SPITransfer *transfer, uint32_t timeout)
+{
+    if(transfer == NULL || transfer->bus >= SPI_BUS_COUNT)
+    {
+        return SPI_ERR;
+    }
+
+    SPIBusState *bus = &prvBuses[transfer->bus];
+
+    if(transfer->status == SPI_BUSY)
+    {
+        const uint32_t tick_us = 1000000 / configTICK_RATE_HZ;
+        uint32_t elapsed = bus->pending_us + bus->carry_us;
+
+        if(elapsed / tick_us > pdMS_TO_TICKS(timeout))
+        {
+            bus->carry_us = 0;
+            vTaskDelay(pdMS_TO_TICKS(timeout));
+            transfer->status = SPI_ERR;
+        }
+        else
+        {
+            bus->carry_us = elapsed % tick_us;
+            if(elapsed >= tick_us)
+            {
+                vTaskDelay(elapsed / tick_us);
+            }
+            transfer->status = SPI_OK;
+        }
+        bus->pending_us = 0;
+    }
+
+    const int status = transfer->status;
+
+    bus->selected = status == SPI_OK && transfer->keep_selected;
+    if(!bus->selected)
+    {
+        bus->fast = 0;
+    }
+
+    if(bus->locked && !bus->selected)
+    {
+        bus->locked = 0;
+        xSemaphoreGive(bus->mutex);
+    }
+
+    return status;
+}
+
+int spi_transfer(SPITransfer *transfer, uint32_t timeout)
+{
+    // nothing is taken when the start fails here
+    if(SPI_OK != spi_transfer_start(transfer))
+    {
+        return SPI_ERR;
+    }
+
+    return spi_transfer_wait(transfer, timeout);
+}
+
 static int transmit(SPI_HandleTypeDef *hspi, uint8_t *reg_addr, uint8_t *tx_buffer, uint16_t size, uint32_t timeout)
 {
     if(hspi == NULL)
@@ -324,146 +476,43 @@ static int read(SPI_HandleTypeDef *hspi, uint8_t *addr_buffer, uint8_t *rx_buffe
     return SPI_OK;
 }
 
-static int receive(SPI_HandleTypeDef *hspi, uint8_t *addr_buffer, uint8_t addr_buffer_size, uint8_t *rx_buffer, uint16_t rx_buffer_size, uint32_t timeout)
+static int receive(SPIBus bus, uint8_t *addr_buffer, uint8_t addr_buffer_size, uint8_t *rx_buffer, uint16_t rx_buffer_size, uint32_t timeout)
 {
-    if(hspi == NULL)
-    {
-        return SPI_ERR;
-    }
-
-    if(hspi->Instance == NULL)
-    {
-        return SPI_ERR;
-    }
-
-    GPIO_TypeDef *port = SPI1_CS_PORT;
-    uint16_t pin = 0;
-    HAL_StatusTypeDef stat;
-    
-    if(hspi->Instance == SPI1)
-    {
-        port = SPI1_CS_PORT;
-        pin = SPI1_CS_PIN;
-    }
-    else if(hspi->Instance == SPI2)
-    {
-        port = SPI2_CS_PORT;
-        pin = SPI2_CS_PIN;
-    }
-    else if(hspi->Instance == SPI3)
-    {
-        
-        if(timeout == 10)
-        {
-            port = SPI3_CS1_PORT;
-            pin = SPI3_CS1_PIN;
-        }else
-        {
-            port = SPI3_CS2_PORT;
-            pin = SPI3_CS2_PIN;
-        }
-        
-    }
-    else
-    {
-        return SPI_ERR;
-    }
-
-    //Write the CS low
-    HAL_GPIO_WritePin(port, pin, GPIO_PIN_RESET);
-    
-    //Could also use HAL_TransmittReceive.
-    
-    //Send the address to read from.
-    if(addr_buffer_size > 0)
-    {
-        stat = HAL_SPI_Transmit(hspi, addr_buffer, addr_buffer_size, timeout);
-        while(stat != HAL_OK)
-        {
-            stat = HAL_SPI_GetState(hspi);
-        }
-    }
-    //Read in the specified number of bytes.
-    if(rx_buffer_size > 0)
-    {
-        stat = HAL_SPI_Receive(hspi, rx_buffer, rx_buffer_size, timeout);
-        while(stat != HAL_OK)
-        {
-            stat = HAL_SPI_GetState(hspi);
-        }
-    }
-    HAL_GPIO_WritePin(port, pin, GPIO_PIN_SET);
-
-
-    return SPI_OK;
+    SPITransfer transfer = {
+            .bus = bus,
+            .chip_select = (timeout == 10) ? 0 : 1,
+            .cmd_buffer = addr_buffer,
+            .cmd_buffer_size = addr_buffer_size,
+            .rx_buffer = rx_buffer,
+            .size = rx_buffer_size,
+    };
+
+    return spi_transfer(&transfer, timeout);
 }
 
-static int spi_send(SPI_HandleTypeDef *hspi, uint8_t *reg_addr, uint8_t reg_addr_size, uint8_t *tx_buffer, uint16_t tx_buffer_size, uint32_t timeout)
+static int spi_send(SPIBus bus, uint8_t *reg_addr, uint8_t reg_addr_size, uint8_t *tx_buffer, uint16_t tx_buffer_size, uint32_t timeout)
 {
-    if(hspi == NULL)
-    {
-        return SPI_ERR;
-    }
-
-    if(hspi->Instance == NULL)
-    {
-        return SPI_ERR;
-    }
-
-    HAL_StatusTypeDef stat;
-    GPIO_TypeDef *port = SPI1_CS_PORT;
-    uint16_t pin = 0;
-    
-    if(hspi->Instance == SPI1)
-    {
-        port = SPI1_CS_PORT;
-        pin = SPI1_CS_PIN;
-    }else if(hspi->Instance == SPI2)
-    {
-        port = SPI2_CS_PORT;
-        pin = SPI2_CS_PIN;
-    }else if(hspi->Instance == SPI3)
-    {
-        if(timeout == 10)
-        {
-            port = SPI3_CS1_PORT;
-            pin = SPI3_CS1_PIN;
-        }else
-        {
-            port = SPI3_CS2_PORT;
-            pin = SPI3_CS2_PIN;
-        }
-    }
-    else
-    {
-        return SPI_ERR;
-    }
+    SPITransfer transfer = {
+            .bus = bus,
+            .chip_select = (timeout == 10) ? 0 : 1,
+            .cmd_buffer = reg_addr,
+            .cmd_buffer_size = reg_addr_size,
+            .tx_buffer = tx_buffer,
+            .size = tx_buffer_size,
+    };
+
+    return spi_transfer(&transfer, timeout);
+}
 
-    //Write the CS low (lock)
-    HAL_GPIO_WritePin(port, pin, GPIO_PIN_RESET);
-    
-    /* Select the slave register (**1 byte address**) first via a uart_transmit */
-    if(reg_addr_size > 0)
-    {
-        stat = HAL_SPI_Transmit(hspi, reg_addr, reg_addr_size, timeout);
-        while(stat != HAL_OK)
-        {
-            stat = HAL_SPI_GetState(hspi);
-        }
-    }
-    /* Send the tx_buffer to slave */
-    if(tx_buffer_size > 0)
-    {
-        stat = HAL_SPI_Transmit(hspi, tx_buffer, tx_buffer_size, timeout);
-        while(stat != HAL_OK)
-        {
-            stat = HAL_SPI_GetState(hspi);
-        }
-    }
-    //Write the CS hi (release)
-    HAL_GPIO_WritePin(port, pin, GPIO_PIN_SET);
+static int single_transmit_only(SPIBus bus, uint8_t *tx_buffer, uint16_t size, uint32_t timeout)
+{
+    SPITransfer transfer = {
+            .bus = bus,
+            .tx_buffer = tx_buffer,
+            .size = size,
+    };
 
-    return SPI_OK;
+    return spi_transfer(&transfer, timeout);
 }
 
 int spi1_transmit(uint8_t *addr_buffer, uint8_t *tx_buffer, uint16_t total_size, uint32_t timeout)
@@ -478,12 +527,17 @@ int spi1_read(uint8_t *addr_buffer, uint8_t *rx_buffer, uint16_t total_size, uin
 
 int spi1_send(uint8_t *reg_addr, uint8_t reg_addr_size, uint8_t *tx_buffer, uint16_t tx_buffer_size, uint32_t timeout)
 {
-    return spi_send(&hspi1, reg_addr, reg_addr_size, tx_buffer, tx_buffer_size, timeout);
+    return spi_send(SPI_BUS_1, reg_addr, reg_addr_size, tx_buffer, tx_buffer_size, timeout);
 }
 
 int spi1_receive(uint8_t *addr_buffer, uint8_t addr_buffer_size, uint8_t *rx_buffer, uint16_t rx_buffer_size, uint32_t timeout)
 {
-    return receive(&hspi1, addr_buffer, addr_buffer_size, rx_buffer, rx_buffer_size, timeout);
+    return receive(SPI_BUS_1, addr_buffer, addr_buffer_size, rx_buffer, rx_buffer_size, timeout);
+}
+
+int spi1_single_transmit_only(uint8_t *tx_buffer, uint16_t total_size, uint32_t timeout)
+{
+    return single_transmit_only(SPI_BUS_1, tx_buffer, total_size, timeout);
 }
 
 
@@ -503,12 +557,17 @@ int spi2_read(uint8_t *addr_buffer, uint8_t *rx_buffer, uint16_t total_size, uin
 
 int spi2_send(uint8_t *reg_addr, uint8_t reg_addr_size, uint8_t *tx_buffer, uint16_t tx_buffer_size, uint32_t timeout)
 {
-    return spi_send(&hspi2, reg_addr, reg_addr_size, tx_buffer, tx_buffer_size, timeout);
+    return spi_send(SPI_BUS_2, reg_addr, reg_addr_size, tx_buffer, tx_buffer_size, timeout);
 }
 
 int spi2_receive(uint8_t *addr_buffer, uint8_t addr_buffer_size, uint8_t *rx_buffer, uint16_t rx_buffer_size, uint32_t timeout)
 {
-    return receive(&hspi2, addr_buffer, addr_buffer_size, rx_buffer, rx_buffer_size, timeout);
+    return receive(SPI_BUS_2, addr_buffer, addr_buffer_size, rx_buffer, rx_buffer_size, timeout);
+}
+
+int spi2_single_transmit_only(uint8_t *tx_buffer, uint16_t total_size, uint32_t timeout)
+{
+    return single_transmit_only(SPI_BUS_2, tx_buffer, total_size, timeout);
 }
 
 
@@ -525,12 +584,17 @@ int spi3_read(uint8_t *addr_buffer, uint8_t *rx_buffer, uint16_t total_size, uin
 
 int spi3_send(uint8_t *reg_addr, uint8_t reg_addr_size, uint8_t *tx_buffer, uint16_t tx_buffer_size, uint32_t timeout)
 {
-    return spi_send(&hspi3, reg_addr, reg_addr_size, tx_buffer, tx_buffer_size, timeout);
+    return spi_send(SPI_BUS_3, reg_addr, reg_addr_size, tx_buffer, tx_buffer_size, timeout);
 }
 
 int spi3_receive(uint8_t *addr_buffer, uint8_t addr_buffer_size, uint8_t *rx_buffer, uint16_t rx_buffer_size, uint32_t timeout)
 {
-    return receive(&hspi3, addr_buffer, addr_buffer_size, rx_buffer, rx_buffer_size, timeout);
+    return receive(SPI_BUS_3, addr_buffer, addr_buffer_size, rx_buffer, rx_buffer_size, timeout);
+}
+
+int spi3_single_transmit_only(uint8_t *tx_buffer, uint16_t total_size, uint32_t timeout)
+{
+    return single_transmit_only(SPI_BUS_3, tx_buffer, total_size, timeout);
 }
 
 
@@ -85,13 +85,10 @@ static inline uint16_t common_read_16 ( const uint8_t * src )
            ( ( ( ( uint8_t ) src[ 1 ] ) << 0 ) & 0xFF );
 }
 
+// erased flash memory reads all ones, the flash file of the simulator included
 static inline bool common_is_mem_empty ( uint8_t * buffer, size_t size )
 {
-#if ( userconf_FREE_RTOS_SIMULATOR_MODE_ON == 1 )
-    const int EMPTY_VALUE = 0;
-#else
     const uint8_t EMPTY_VALUE = 0xFF;
-#endif
 
     uint16_t     emptyByteCounter = 0;
     for ( size_t i                = 0; i < size; i++ )
@@ -0,0 +1,130 @@
+#ifndef AVIONICS_SPSC_RING_H
+#define AVIONICS_SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+
+// Lock-free ring for a single producer and a single consumer, any of them an interrupt. SPSC_RING( name, type, length )
+// defines the ring type name_ring of length items (a power of two) and its functions:
+//
+//  name_ring_reset         empties the ring, while neither side uses it
+//  name_ring_count         items in the ring
+//  name_ring_reserve       the free item at the head, filled in place by the producer, NULL if the ring is full
+//  name_ring_commit        publishes the reserved item to the consumer
+//  name_ring_push          reserve, copy and commit
+//  name_ring_peek          the item at the tail, read in place by the consumer, NULL if the ring is empty
+//  name_ring_release       gives the peeked item back to the producer
+//  name_ring_pop           peek, copy and release
+//  name_ring_pop_batch     pops up to count items, the tail moves once for all of them
+//
+// The head is only written by the producer and the tail only by the consumer. Both are free running, so the ring holds
+// length items and not length - 1. The index of the other side is loaded with acquire and the own one stored with
+// release semantics, a DMB on the Cortex-M4: an item is complete before the head that publishes it moves, and it is
+// read before the tail that gives it back moves.
+
+#define SPSC_RING_LOAD_ACQUIRE( index )             __atomic_load_n ( &( index ), __ATOMIC_ACQUIRE )
+#define SPSC_RING_LOAD_RELAXED( index )             __atomic_load_n ( &( index ), __ATOMIC_RELAXED )
+#define SPSC_RING_STORE_RELEASE( index, value )     __atomic_store_n ( &( index ), ( value ), __ATOMIC_RELEASE )
+
+#define SPSC_RING( name, type, length )                                                                         \
+    _Static_assert ( ( length ) > 0 && ( ( length ) & ( ( length ) - 1 ) ) == 0, #name " ring length must be a power of two" ); \
+                                                                                                                \
+    typedef struct                                                                                              \
+    {                                                                                                           \
+        uint32_t head;                                                                                          \
+        uint32_t tail;                                                                                          \
+        type     items [ length ];                                                                              \
+    } name##_ring;                                                                                              \
+                                                                                                                \
+    static inline void name##_ring_reset ( name##_ring * ring )                                                 \
+    {                                                                                                           \
+        SPSC_RING_STORE_RELEASE ( ring->head, 0 );                                                              \
+        SPSC_RING_STORE_RELEASE ( ring->tail, 0 );                                                              \
+    }                                                                                                           \
+                                                                                                                \
+    static inline uint32_t name##_ring_count ( name##_ring * ring )                                             \
+    {                                                                                                           \
+        return SPSC_RING_LOAD_ACQUIRE ( ring->head ) - SPSC_RING_LOAD_ACQUIRE ( ring->tail );                   \
+    }                                                                                                           \
+                                                                                                                \
+    static inline type * name##_ring_reserve ( name##_ring * ring )                                             \
+    {                                                                                                           \
+        const uint32_t head = SPSC_RING_LOAD_RELAXED ( ring->head );                                            \
+        if ( head - SPSC_RING_LOAD_ACQUIRE ( ring->tail ) == ( length ) )                                       \
+        {                                                                                                       \
+            return NULL;                                                                                        \
+        }                                                                                                       \
+                                                                                                                \
+        return &ring->items [ head & ( ( length ) - 1 ) ];                                                      \
+    }                                                                                                           \
+                                                                                                                \
+    static inline void name##_ring_commit ( name##_ring * ring )                                                \
+    {                                                                                                           \
+        SPSC_RING_STORE_RELEASE ( ring->head, SPSC_RING_LOAD_RELAXED ( ring->head ) + 1 );                      \
+    }                                                                                                           \
+                                                                                                                \
+    static inline bool name##_ring_push ( name##_ring * ring, const type * item )                               \
+    {                                                                                                           \
+        type * slot = name##_ring_reserve ( ring );                                                             \
+        if ( slot == NULL )                                                                                     \
+        {                                                                                                       \
+            return false;                                                                                       \
+        }                                                                                                       \
+                                                                                                                \
+        memcpy ( slot, item, sizeof ( type ) );                                                                 \
+        name##_ring_commit ( ring );                                                                            \
+        return true;                                                                                            \
+    }                                                                                                           \
+                                                                                                                \
+    static inline type * name##_ring_peek ( name##_ring * ring )                                                \
+    {                                                                                                           \
+        const uint32_t tail = SPSC_RING_LOAD_RELAXED ( ring->tail );                                            \
+        if ( tail == SPSC_RING_LOAD_ACQUIRE ( ring->head ) )                                                    \
+        {                                                                                                       \
+            return NULL;                                                                                        \
+        }                                                                                                       \
+                                                                                                                \
+        return &ring->items [ tail & ( ( length ) - 1 ) ];                                                      \
+    }                                                                                                           \
+                                                                                                                \
+    static inline void name##_ring_release ( name##_ring * ring )                                               \
+    {                                                                                                           \
+        SPSC_RING_STORE_RELEASE ( ring->tail, SPSC_RING_LOAD_RELAXED ( ring->tail ) + 1 );                      \
+    }                                                                                                           \
+                                                                                                                \
+    static inline bool name##_ring_pop ( name##_ring * ring, type * item )                                      \
+    {                                                                                                           \
+        const type * slot = name##_ring_peek ( ring );                                                          \
+        if ( slot == NULL )                                                                                     \
+        {                                                                                                       \
+            return false;                                                                                       \
+        }                                                                                                       \
+                                                                                                                \
+        memcpy ( item, slot, sizeof ( type ) );                                                                 \
+        name##_ring_release ( ring );                                                                           \
+        return true;                                                                                            \
+    }                                                                                                           \
+                                                                                                                \
+    static inline uint32_t name##_ring_pop_batch ( name##_ring * ring, type * items, uint32_t count )           \
+    {                                                                                                           \
+        const uint32_t tail      = SPSC_RING_LOAD_RELAXED ( ring->tail );                                       \
+        const uint32_t available = SPSC_RING_LOAD_ACQUIRE ( ring->head ) - tail;                                \
+        if ( count > available )                                                                                \
+        {                                                                                                       \
+            count = available;                                                                                  \
+        }                                                                                                       \
+                                                                                                                \
+        /* at most two runs, up to the end of the items and from their start */                                 \
+        const uint32_t start = tail & ( ( length ) - 1 );                                                       \
+        const uint32_t first = count < ( length ) - start ? count : ( length ) - start;                         \
+        memcpy ( items, &ring->items [ start ], first * sizeof ( type ) );                                      \
+        memcpy ( &items [ first ], ring->items, ( count - first ) * sizeof ( type ) );                          \
+                                                                                                                \
+        SPSC_RING_STORE_RELEASE ( ring->tail, tail + count );                                                   \
+        return count;                                                                                           \
+    }                                                                                                           \
+
+
+#endif //AVIONICS_SPSC_RING_H